@@ -131,6 +131,43 @@ std::shared_ptr<IBlob> MediaFileSystem::readFile(const std::filesystem::path & n
 	return nullptr;
 }
 
+BlobFuture MediaFileSystem::readFileAsync(const std::filesystem::path & name)
+{
+	// resolve the file in the same order as readFile, then let that file system read it on its own cache
+	for (const auto& fs : m_FileSystems)
+		if (fs->fileExists(name))
+			return fs->readFileAsync(name);
+	return makeReadyBlobFuture(nullptr);
+}
+
+void MediaFileSystem::prefetch(const std::vector<std::filesystem::path>& names)
+{
+	std::vector<std::vector<std::filesystem::path>> namesPerFS(m_FileSystems.size());
+	for (const auto& name : names)
+	{
+		for (size_t index = 0; index < m_FileSystems.size(); ++index)
+		{
+			if (m_FileSystems[index]->fileExists(name))
+			{
+				namesPerFS[index].push_back(name);
+				break;
+			}
+		}
+	}
+
+	for (size_t index = 0; index < m_FileSystems.size(); ++index)
+		if (!namesPerFS[index].empty())
+			m_FileSystems[index]->prefetch(namesPerFS[index]);
+}
+
+uint64_t MediaFileSystem::getFileVersion(const std::filesystem::path & name)
+{
+	for (const auto& fs : m_FileSystems)
+		if (fs->fileExists(name))
+			return fs->getFileVersion(name);
+	return 0;
+}
+
 bool MediaFileSystem::writeFile(const std::filesystem::path & name, const void* data, size_t size)
 {
 	for (const auto& fs : m_FileSystems)
@@ -72,6 +72,9 @@ namespace donut::app
 		bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
 		int enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, vfs::enumerate_callback_t callback, bool allowDuplicates = false) override;
 		int enumerateDirectories(const std::filesystem::path& path, vfs::enumerate_callback_t callback, bool allowDuplicates = false) override;
+		vfs::BlobFuture readFileAsync(const std::filesystem::path& name) override;
+		void prefetch(const std::vector<std::filesystem::path>& names) override;
+		uint64_t getFileVersion(const std::filesystem::path& name) override;
 
 	private:
 		std::vector<std::shared_ptr<vfs::IFileSystem>> m_FileSystems;
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace donut_benchmark
+{
+    // Runs 'func' 'repeat' times and returns the fastest run in milliseconds.
+    // The first run warms up the caches and the allocator and is not measured.
+    template<typename Func>
+    double measureBest(int repeat, Func&& func)
+    {
+        func();
+        double best = 1e30;
+        for (int i = 0; i < repeat; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    inline void reportThroughput(const char* name, size_t bytes, double ms)
+    {
+        std::printf("  %-44s %8.1f MB %10.3f ms %9.1f MB/s\n", name, double(bytes) / 1e6, ms, double(bytes) / 1e3 / ms);
+    }
+
+    // Records a failure if the optimized path disagrees with its reference. main returns 1 if anything failed.
+    inline int g_FailureCount = 0;
+    inline void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("  FAILED: %s\n", what);
+            ++g_FailureCount;
+        }
+    }
+
+    void runCompressionBenchmark();
+}
@@ -0,0 +1,200 @@
+// Parallel LZ4 block decompression in CompressionLayer against a sequential LZ4F decode of the same frame.
+// The sequential decode is what CompressionLayer::readFile did for every frame before independent
+// blocks were decompressed on the ThreadPool. Both paths verify the block and content checksums.
+
+#include "pch.h"
+#include "BenchmarkCommon.h"
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#ifdef DONUT_WITH_LZ4
+#include <lz4frame.h>
+#endif
+
+using namespace donut::vfs;
+
+namespace
+{
+    using namespace donut_benchmark;
+
+#ifdef DONUT_WITH_LZ4
+    // Keeps written files in memory so that the benchmark measures decompression and not disk reads.
+    class MemoryFileSystem : public IFileSystem
+    {
+    private:
+        std::mutex m_Mutex;
+        std::unordered_map<std::string, std::shared_ptr<IBlob>> m_Files;
+
+    public:
+        bool folderExists(const std::filesystem::path& name) override { (void)name; return false; }
+
+        bool fileExists(const std::filesystem::path& name) override
+        {
+            std::lock_guard<std::mutex> lockGuard(m_Mutex);
+            return m_Files.find(name.generic_string()) != m_Files.end();
+        }
+
+        std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override
+        {
+            std::lock_guard<std::mutex> lockGuard(m_Mutex);
+            auto it = m_Files.find(name.generic_string());
+            return it != m_Files.end() ? it->second : nullptr;
+        }
+
+        bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override
+        {
+            void* copy = malloc(size);
+            if (!copy)
+                return false;
+            memcpy(copy, data, size);
+
+            std::lock_guard<std::mutex> lockGuard(m_Mutex);
+            m_Files[name.generic_string()] = std::make_shared<Blob>(copy, size);
+            return true;
+        }
+
+        int enumerateFiles(const std::filesystem::path&, const std::vector<std::string>&, enumerate_callback_t, bool) override { return status::NotImplemented; }
+        int enumerateDirectories(const std::filesystem::path&, enumerate_callback_t, bool) override { return status::NotImplemented; }
+    };
+
+    // Slowly changing bytes mixed with noise; LZ4 shrinks it to about 70%, similar to packed texture data.
+    std::vector<uint8_t> makeContent(size_t size)
+    {
+        std::vector<uint8_t> content(size);
+        uint32_t random = 1;
+        for (size_t i = 0; i < size; ++i)
+        {
+            random = random * 1664525u + 1013904223u;
+            content[i] = (i % 3 == 0) ? uint8_t(random >> 24) : uint8_t(i / 4096);
+        }
+        return content;
+    }
+
+    std::vector<uint8_t> decompressSequential(const IBlob& compressed, size_t contentSize)
+    {
+        std::vector<uint8_t> result(contentSize);
+
+        LZ4F_dctx* context = nullptr;
+        LZ4F_createDecompressionContext(&context, LZ4F_VERSION);
+
+        size_t readPtr = 0;
+        size_t writePtr = 0;
+        size_t err = 1;
+        while (err != 0 && !LZ4F_isError(err) && readPtr < compressed.size())
+        {
+            size_t dstSize = result.size() - writePtr;
+            size_t srcSize = compressed.size() - readPtr;
+            err = LZ4F_decompress(context, result.data() + writePtr, &dstSize,
+                static_cast<const uint8_t*>(compressed.data()) + readPtr, &srcSize, nullptr);
+            writePtr += dstSize;
+            readPtr += srcSize;
+        }
+
+        LZ4F_freeDecompressionContext(context);
+        if (err != 0 || writePtr != contentSize)
+            result.clear();
+        return result;
+    }
+
+    void runThroughput(size_t size)
+    {
+        auto memoryFS = std::make_shared<MemoryFileSystem>();
+        CompressionLayer compression(memoryFS);
+        compression.setCompressionLevel(1);
+
+        const std::vector<uint8_t> content = makeContent(size);
+        compression.writeFile("/content.bin.lz4", content.data(), content.size());
+        std::shared_ptr<IBlob> compressed = memoryFS->readFile("/content.bin.lz4");
+
+        std::printf(" %zu MB content, %zu MB compressed, %u pool threads\n", size >> 20, compressed->size() >> 20,
+            donut::ThreadPool::get().getThreadCount());
+
+        std::vector<uint8_t> sequential;
+        double sequentialMs = measureBest(5, [&]() { sequential = decompressSequential(*compressed, size); });
+        reportThroughput("sequential LZ4F_decompress", size, sequentialMs);
+
+        std::shared_ptr<IBlob> parallel;
+        double parallelMs = measureBest(5, [&]() { parallel = compression.readFile("/content.bin"); });
+        reportThroughput("CompressionLayer::readFile (ThreadPool)", size, parallelMs);
+
+        std::shared_ptr<StreamingBlob> streaming;
+        double firstBlockMs = measureBest(5, [&]() {
+            streaming = compression.readFileStreaming("/content.bin");
+            streaming->waitForBlock(0);
+        });
+        std::printf("  %-44s %10.3f ms\n", "readFileStreaming, first block ready", firstBlockMs);
+
+        check(sequential == content, "sequential decode matches the input");
+        check(parallel && parallel->size() == size && memcmp(parallel->data(), content.data(), size) == 0, "parallel decode matches the input");
+        check(streaming && streaming->waitForAll() && memcmp(streaming->data(), content.data(), size) == 0, "streaming decode matches the input");
+    }
+
+    // Several files decoded at once share the pool instead of each starting its own threads.
+    void runConcurrentReads(size_t fileCount, size_t size)
+    {
+        auto memoryFS = std::make_shared<MemoryFileSystem>();
+        CompressionLayer compression(memoryFS);
+        compression.setCompressionLevel(1);
+
+        const std::vector<uint8_t> content = makeContent(size);
+        for (size_t i = 0; i < fileCount; ++i)
+            compression.writeFile("/file" + std::to_string(i) + ".bin.lz4", content.data(), content.size());
+
+        std::vector<std::shared_ptr<IBlob>> results(fileCount);
+        double ms = measureBest(3, [&]() {
+            std::vector<std::thread> readers;
+            for (size_t i = 0; i < fileCount; ++i)
+                readers.emplace_back([&, i]() { results[i] = compression.readFile("/file" + std::to_string(i) + ".bin"); });
+            for (auto& reader : readers)
+                reader.join();
+        });
+        std::printf(" %zu concurrent readers\n", fileCount);
+        reportThroughput("CompressionLayer::readFile x readers", size * fileCount, ms);
+
+        bool allMatch = true;
+        for (const auto& result : results)
+            allMatch = allMatch && result && result->size() == size && memcmp(result->data(), content.data(), size) == 0;
+        check(allMatch, "concurrent reads match the input");
+    }
+
+    void runCorruption()
+    {
+        auto memoryFS = std::make_shared<MemoryFileSystem>();
+        CompressionLayer compression(memoryFS);
+
+        const size_t size = 8 << 20;
+        const std::vector<uint8_t> content = makeContent(size);
+        compression.writeFile("/valid.bin.lz4", content.data(), content.size());
+        std::shared_ptr<IBlob> compressed = memoryFS->readFile("/valid.bin.lz4");
+        const uint8_t* bytes = static_cast<const uint8_t*>(compressed->data());
+
+        // a flipped byte inside a block is caught by the block checksum
+        std::vector<uint8_t> corruptBlock(bytes, bytes + compressed->size());
+        corruptBlock[corruptBlock.size() / 2] ^= 0x5a;
+        memoryFS->writeFile("/block.bin.lz4", corruptBlock.data(), corruptBlock.size());
+        check(compression.readFile("/block.bin") == nullptr, "corrupted block is rejected");
+
+        // a wrong content checksum is only visible once all blocks are hashed
+        std::vector<uint8_t> corruptContent(bytes, bytes + compressed->size());
+        corruptContent.back() ^= 0x01;
+        memoryFS->writeFile("/content.bin.lz4", corruptContent.data(), corruptContent.size());
+        check(compression.readFile("/content.bin") == nullptr, "content checksum mismatch is rejected");
+
+        auto streaming = compression.readFileStreaming("/content.bin");
+        check(streaming && streaming->waitForRange(0, size) && !streaming->waitForAll(), "streaming blob reports the content checksum in waitForAll");
+    }
+#endif
+}
+
+void donut_benchmark::runCompressionBenchmark()
+{
+    std::printf("[Compression] sequential LZ4F vs parallel block decode\n");
+#ifdef DONUT_WITH_LZ4
+    runThroughput(256 << 20);
+    runConcurrentReads(8, 32 << 20);
+    runCorruption();
+#else
+    std::printf("  skipped: DonutCore was built without DONUT_WITH_LZ4\n");
+#endif
+}
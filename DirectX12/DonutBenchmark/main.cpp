@@ -0,0 +1,13 @@
+// DonutBenchmark: micro-benchmarks for the DonutCore file system and decompression paths.
+// Build Release|x64 and run; every benchmark also checks the optimized path against a reference.
+
+#include "pch.h"
+#include "BenchmarkCommon.h"
+
+int main()
+{
+    donut_benchmark::runCompressionBenchmark();
+
+    std::printf("%s\n", donut_benchmark::g_FailureCount == 0 ? "All checks passed." : "Some checks FAILED.");
+    return donut_benchmark::g_FailureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#ifdef _DEBUG
+#pragma comment(lib, "..\\Libraries\\Libs\\DonutCore\\Debug\\DonutCore.lib")
+#else
+#pragma comment(lib, "..\\Libraries\\Libs\\DonutCore\\Release\\DonutCore.lib")
+#endif
+
+#include "../DonutCore/DonutCorePch.h"
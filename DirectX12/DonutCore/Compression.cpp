@@ -21,14 +21,364 @@
 */
 
 #include "pch.h"
+#include <algorithm>
+#include <cstring>
 #include <unordered_set>
 
 #ifdef DONUT_WITH_LZ4
+#include <lz4.h>
 #include <lz4frame.h>
 #endif
 
 using namespace donut::vfs;
 
+namespace
+{
+    uint32_t readU32(const uint8_t* data)
+    {
+        return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+    }
+
+    constexpr uint32_t XxhPrime1 = 0x9E3779B1u;
+    constexpr uint32_t XxhPrime2 = 0x85EBCA77u;
+    constexpr uint32_t XxhPrime3 = 0xC2B2AE3Du;
+    constexpr uint32_t XxhPrime4 = 0x27D4EB2Fu;
+    constexpr uint32_t XxhPrime5 = 0x165667B1u;
+
+    uint32_t rotl32(uint32_t x, int r)
+    {
+        return (x << r) | (x >> (32 - r));
+    }
+
+    uint32_t xxhRound(uint32_t lane, uint32_t input)
+    {
+        return rotl32(lane + input * XxhPrime2, 13) * XxhPrime1;
+    }
+
+    // Splits an LZ4 frame into its blocks without decompressing them.
+    // Only frames that can be decompressed block by block into known offsets are accepted:
+    // independent blocks, stored content size, no dictionary, and a single frame in the file.
+    // The checksums are recorded here and verified by StreamingBlob while decompressing.
+    bool parseIndependentFrame(const uint8_t* data, size_t size, StreamingBlob::FrameLayout& layout)
+    {
+        constexpr uint32_t FrameMagic = 0x184D2204;
+
+        // magic, FLG, BD, content size, header checksum
+        constexpr size_t HeaderSize = 4 + 1 + 1 + 8 + 1;
+        if (size < HeaderSize || readU32(data) != FrameMagic)
+            return false;
+
+        const uint8_t flg = data[4];
+        const uint8_t bd = data[5];
+        const bool independentBlocks = (flg & 0x20) != 0;
+        const bool hasContentSize = (flg & 0x08) != 0;
+        const bool hasDictID = (flg & 0x01) != 0;
+        layout.blockChecksums = (flg & 0x10) != 0;
+        layout.contentChecksum = (flg & 0x04) != 0;
+
+        if ((flg >> 6) != 1 || !independentBlocks || !hasContentSize || hasDictID)
+            return false;
+
+        const uint32_t blockSizeID = (bd >> 4) & 7;
+        if (blockSizeID < 4)
+            return false;
+        layout.blockSize = size_t(1) << (8 + 2 * blockSizeID);
+
+        uint64_t storedContentSize = 0;
+        for (int i = 7; i >= 0; --i)
+            storedContentSize = (storedContentSize << 8) | data[6 + i];
+        if (storedContentSize == 0 || storedContentSize > SIZE_MAX)
+            return false;
+        layout.contentSize = size_t(storedContentSize);
+
+        size_t pos = HeaderSize;
+        for (;;)
+        {
+            if (size - pos < 4)
+                return false;
+            uint32_t word = readU32(data + pos);
+            pos += 4;
+
+            if (word == 0)
+                break; // end mark
+
+            StreamingBlob::BlockRef block;
+            block.uncompressed = (word & 0x80000000u) != 0;
+            block.size = word & 0x7FFFFFFFu;
+            block.offset = pos;
+
+            size_t blockEnd = block.size + (layout.blockChecksums ? 4 : 0);
+            if (blockEnd > size - pos)
+                return false;
+            pos += blockEnd;
+            layout.blocks.push_back(block);
+        }
+
+        if (layout.contentChecksum)
+        {
+            if (size - pos != 4)
+                return false;
+            layout.expectedContentChecksum = readU32(data + pos);
+        }
+        else if (pos != size)
+            return false;
+
+        // every block except the last one must decompress to exactly blockSize bytes
+        return layout.blocks.size() == (layout.contentSize + layout.blockSize - 1) / layout.blockSize;
+    }
+
+    std::shared_ptr<StreamingBlob> createStreamingBlob(const std::shared_ptr<IBlob>& compressedBlob, const std::filesystem::path& name)
+    {
+        StreamingBlob::FrameLayout layout;
+        if (!parseIndependentFrame(static_cast<const uint8_t*>(compressedBlob->data()), compressedBlob->size(), layout))
+            return nullptr;
+
+        return std::make_shared<StreamingBlob>(compressedBlob, std::move(layout), name.generic_string());
+    }
+}
+
+void StreamingBlob::ContentHash::update(const uint8_t* data, size_t size)
+{
+    length += size;
+
+    if (tailSize + size < sizeof(tail))
+    {
+        memcpy(tail + tailSize, data, size);
+        tailSize += size;
+        return;
+    }
+
+    auto consumeStripe = [this](const uint8_t* stripe) {
+        for (int i = 0; i < 4; ++i)
+            lanes[i] = xxhRound(lanes[i], readU32(stripe + i * 4));
+    };
+
+    if (tailSize > 0)
+    {
+        size_t fill = sizeof(tail) - tailSize;
+        memcpy(tail + tailSize, data, fill);
+        consumeStripe(tail);
+        data += fill;
+        size -= fill;
+        tailSize = 0;
+    }
+
+    for (; size >= sizeof(tail); data += sizeof(tail), size -= sizeof(tail))
+        consumeStripe(data);
+
+    memcpy(tail, data, size);
+    tailSize = size;
+}
+
+uint32_t StreamingBlob::ContentHash::digest() const
+{
+    uint32_t hash = length >= sizeof(tail)
+        ? rotl32(lanes[0], 1) + rotl32(lanes[1], 7) + rotl32(lanes[2], 12) + rotl32(lanes[3], 18)
+        : XxhPrime5; // seed 0
+    hash += uint32_t(length);
+
+    size_t pos = 0;
+    for (; pos + 4 <= tailSize; pos += 4)
+        hash = rotl32(hash + readU32(tail + pos) * XxhPrime3, 17) * XxhPrime4;
+    for (; pos < tailSize; ++pos)
+        hash = rotl32(hash + tail[pos] * XxhPrime5, 11) * XxhPrime1;
+
+    hash ^= hash >> 15;
+    hash *= XxhPrime2;
+    hash ^= hash >> 13;
+    hash *= XxhPrime3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+StreamingBlob::StreamingBlob(std::shared_ptr<IBlob> compressed, FrameLayout layout, std::string name)
+    : m_Compressed(std::move(compressed))
+    , m_Layout(std::move(layout))
+    , m_Name(std::move(name))
+    , m_BlockStates(std::make_unique<std::atomic<BlockState>[]>(m_Layout.blocks.size()))
+{
+    m_Data = (uint8_t*)malloc(m_Layout.contentSize);
+    if (!m_Data)
+    {
+        log::warning("Failed to decompress file '%s': couldn't allocate %llu bytes of memory",
+            m_Name.c_str(), (unsigned long long)m_Layout.contentSize);
+
+        for (size_t i = 0; i < m_Layout.blocks.size(); ++i)
+            m_BlockStates[i].store(BlockState::Failed);
+        m_NextBlock.store(m_Layout.blocks.size());
+    }
+}
+
+StreamingBlob::~StreamingBlob()
+{
+    // the pool tasks only run while they hold a reference, so nothing is decompressing into m_Data here
+    free(m_Data);
+}
+
+void StreamingBlob::start()
+{
+    const size_t taskCount = std::min<size_t>(ThreadPool::get().getThreadCount(), m_Layout.blocks.size());
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        ThreadPool::get().submit([weakSelf = weak_from_this()]() {
+            // blocks are handed out in file order so that the beginning of the file completes first
+            while (auto self = weakSelf.lock())
+            {
+                if (!self->decompressNextBlock())
+                    break;
+            }
+        });
+    }
+}
+
+bool StreamingBlob::decompressNextBlock() const
+{
+    size_t index = m_NextBlock.fetch_add(1);
+    if (index >= m_Layout.blocks.size())
+        return false;
+
+    bool success = decompressBlock(index);
+    m_BlockStates[index].store(success ? BlockState::Done : BlockState::Failed, std::memory_order_release);
+
+    {
+        // the waiters check the block state under the mutex, so taking it here prevents lost wake-ups
+        std::lock_guard<std::mutex> lockGuard(m_Mutex);
+    }
+    m_BlockDone.notify_all();
+
+    // Hash the blocks that are now complete in file order, unless another thread is already doing it.
+    // Whatever is left when the last block completes is hashed by waitForAll.
+    if (m_Layout.contentChecksum)
+    {
+        std::unique_lock<std::mutex> hashLock(m_HashMutex, std::try_to_lock);
+        if (hashLock.owns_lock())
+            advanceContentHashLocked();
+    }
+
+    return true;
+}
+
+bool StreamingBlob::decompressBlock(size_t index) const
+{
+    const BlockRef& block = m_Layout.blocks[index];
+    const uint8_t* src = static_cast<const uint8_t*>(m_Compressed->data()) + block.offset;
+    const size_t dstOffset = index * m_Layout.blockSize;
+    const size_t dstSize = std::min(m_Layout.blockSize, m_Layout.contentSize - dstOffset);
+
+    if (m_Layout.blockChecksums)
+    {
+        ContentHash blockHash;
+        blockHash.update(src, block.size);
+        if (blockHash.digest() != readU32(src + block.size))
+        {
+            log::warning("Checksum mismatch in LZ4 block %llu of file '%s'", (unsigned long long)index, m_Name.c_str());
+            return false;
+        }
+    }
+
+    if (block.uncompressed)
+    {
+        if (block.size != dstSize)
+            return false;
+
+        memcpy(m_Data + dstOffset, src, dstSize);
+        return true;
+    }
+
+#ifdef DONUT_WITH_LZ4
+    int decompressedSize = LZ4_decompress_safe((const char*)src, (char*)m_Data + dstOffset, int(block.size), int(dstSize));
+    if (decompressedSize != int(dstSize))
+    {
+        log::warning("Failed to decompress LZ4 block %llu of file '%s'", (unsigned long long)index, m_Name.c_str());
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool StreamingBlob::advanceContentHashLocked() const
+{
+    const size_t blockCount = m_Layout.blocks.size();
+    while (m_ContentValid && m_HashedBlocks < blockCount)
+    {
+        BlockState state = m_BlockStates[m_HashedBlocks].load(std::memory_order_acquire);
+        if (state == BlockState::Pending)
+            return true;
+
+        if (state == BlockState::Failed)
+        {
+            m_ContentValid = false;
+            break;
+        }
+
+        const size_t offset = m_HashedBlocks * m_Layout.blockSize;
+        m_ContentHash.update(m_Data + offset, std::min(m_Layout.blockSize, m_Layout.contentSize - offset));
+
+        if (++m_HashedBlocks == blockCount && m_ContentHash.digest() != m_Layout.expectedContentChecksum)
+        {
+            log::warning("Content checksum mismatch in LZ4 file '%s'", m_Name.c_str());
+            m_ContentValid = false;
+        }
+    }
+
+    return m_ContentValid;
+}
+
+bool StreamingBlob::waitForBlock(size_t index) const
+{
+    if (index >= m_Layout.blocks.size())
+        return false;
+
+    // decompress on this thread instead of waiting for a pool thread to pick up the block
+    while (m_NextBlock.load() <= index && decompressNextBlock())
+        ;
+
+    BlockState state = m_BlockStates[index].load(std::memory_order_acquire);
+    if (state == BlockState::Pending)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_BlockDone.wait(lock, [this, index, &state]() {
+            state = m_BlockStates[index].load(std::memory_order_acquire);
+            return state != BlockState::Pending;
+        });
+    }
+
+    return state == BlockState::Done;
+}
+
+bool StreamingBlob::waitForRange(size_t offset, size_t size) const
+{
+    if (size == 0)
+        return true;
+    if (offset > m_Layout.contentSize || size > m_Layout.contentSize - offset)
+        return false;
+
+    bool success = true;
+    for (size_t index = offset / m_Layout.blockSize; index <= (offset + size - 1) / m_Layout.blockSize; ++index)
+        success = waitForBlock(index) && success;
+
+    return success;
+}
+
+bool StreamingBlob::waitForAll() const
+{
+    if (!waitForRange(0, m_Layout.contentSize))
+        return false;
+
+    if (!m_Layout.contentChecksum)
+        return true;
+
+    std::lock_guard<std::mutex> hashLock(m_HashMutex);
+    return advanceContentHashLocked();
+}
+
+const void* StreamingBlob::data() const
+{
+    return waitForAll() ? m_Data : nullptr;
+}
+
 bool CompressionLayer::folderExists(const std::filesystem::path& name)
 {
     return m_fs->folderExists(name);
@@ -52,6 +402,16 @@ std::shared_ptr<IBlob> CompressionLayer::readFile(const std::filesystem::path& n
     if (compressedBlob->size() == 0)
         return compressedBlob;
 
+    // frames with independent blocks are decompressed in parallel, one block per task
+    if (auto streamingBlob = createStreamingBlob(compressedBlob, name); streamingBlob && streamingBlob->getBlockCount() > 1)
+    {
+        streamingBlob->start();
+        if (!streamingBlob->waitForAll())
+            return nullptr;
+
+        return std::static_pointer_cast<IBlob>(streamingBlob);
+    }
+
     // initialize the decompression context
     LZ4F_dctx* context = nullptr;
     LZ4F_errorCode_t err = LZ4F_createDecompressionContext(&context, LZ4F_VERSION);
@@ -168,6 +528,27 @@ std::shared_ptr<IBlob> CompressionLayer::readFile(const std::filesystem::path& n
 #endif
 }
 
+std::shared_ptr<StreamingBlob> CompressionLayer::readFileStreaming(const std::filesystem::path& name)
+{
+#ifdef DONUT_WITH_LZ4
+    std::filesystem::path nameWithExt = name;
+    nameWithExt += ".lz4";
+    auto compressedBlob = m_fs->readFile(nameWithExt);
+
+    if (!compressedBlob)
+        return nullptr;
+
+    auto streamingBlob = createStreamingBlob(compressedBlob, name);
+    if (streamingBlob)
+        streamingBlob->start();
+
+    return streamingBlob;
+#else // DONUT_WITH_LZ4
+    (void)name;
+    return nullptr;
+#endif
+}
+
 bool CompressionLayer::writeFile(const std::filesystem::path& name, const void* data, size_t size)
 {
 #ifdef DONUT_WITH_LZ4
@@ -196,6 +577,10 @@ bool CompressionLayer::writeFile(const std::filesystem::path& name, const void*
     LZ4F_preferences_t preferences{};
     preferences.frameInfo.contentSize = uncompressedSize;
     preferences.frameInfo.blockChecksumFlag = LZ4F_blockChecksumEnabled;
+    preferences.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    // independent blocks allow readFile to decompress the file in parallel
+    preferences.frameInfo.blockMode = LZ4F_blockIndependent;
+    preferences.frameInfo.blockSizeID = LZ4F_max1MB;
     preferences.compressionLevel = m_CompressionLevel;
 
     // get the maximum size 
@@ -23,6 +23,9 @@
 #pragma once
 
 #include "../DonutCore/VFS.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <utility>
 
 namespace donut::vfs
@@ -55,7 +58,114 @@ namespace donut::vfs
     very fast decompression of individual .lz4 compressed files within a tar archive.
     To create such an archive, one can use the existing tar and lz4 Unix utilities,
     or the 'scripts/lz4_tar.py' Python script provided with Donut.
+
+    Parallel decompression:
+
+    Frames with independent blocks and a stored content size are decompressed
+    in parallel on the shared ThreadPool, one LZ4 block per task. Files written by this layer
+    use such frames; 'lz4 -BD' produces linked blocks, which are decompressed sequentially.
+    readFileStreaming returns the file as soon as decompression has started, and
+    the caller can consume it block by block while the rest is still being inflated.
+    */
+
+    /*
+    A blob that is filled by the shared ThreadPool, one LZ4 block at a time.
+    Blocks are decompressed in file order, so the beginning of the file is usually
+    available first. data() waits for the whole file; use waitForRange or waitForBlock
+    to start parsing earlier. A thread that waits for a block that no pool thread has
+    started yet decompresses the pending blocks itself, so waiting never depends on
+    the pool having a free thread.
+
+    Block checksums are verified before each block is decompressed. The content checksum
+    is computed over the blocks in file order while they complete, and is checked by
+    waitForAll and data(); waitForRange and waitForBlock only guarantee the block checksums.
+
+    Must be owned by a std::shared_ptr: the pool tasks hold weak references, so destroying
+    the blob stops the decompression of the remaining blocks.
     */
+    class StreamingBlob : public IBlob, public std::enable_shared_from_this<StreamingBlob>
+    {
+    public:
+        struct BlockRef
+        {
+            size_t offset = 0;      // in the compressed data
+            size_t size = 0;        // compressed size
+            bool uncompressed = false;
+        };
+
+        struct FrameLayout
+        {
+            std::vector<BlockRef> blocks;
+            size_t blockSize = 0;
+            size_t contentSize = 0;
+            bool blockChecksums = false;
+            bool contentChecksum = false;
+            uint32_t expectedContentChecksum = 0;
+        };
+
+    private:
+        // Incremental XXH32 with seed 0, as used by the LZ4 frame format.
+        struct ContentHash
+        {
+            uint32_t lanes[4] = { 0x9E3779B1u + 0x85EBCA77u, 0x85EBCA77u, 0u, 0u - 0x9E3779B1u };
+            uint64_t length = 0;
+            uint8_t tail[16] = {};
+            size_t tailSize = 0;
+
+            void update(const uint8_t* data, size_t size);
+            [[nodiscard]] uint32_t digest() const;
+        };
+
+        enum class BlockState : uint8_t { Pending, Done, Failed };
+
+        std::shared_ptr<IBlob> m_Compressed;
+        FrameLayout m_Layout;
+        std::string m_Name;
+        uint8_t* m_Data = nullptr;
+
+        std::unique_ptr<std::atomic<BlockState>[]> m_BlockStates;
+        mutable std::atomic<size_t> m_NextBlock = 0;
+        mutable std::mutex m_Mutex;
+        mutable std::condition_variable m_BlockDone;
+
+        mutable std::mutex m_HashMutex;
+        mutable ContentHash m_ContentHash;
+        mutable size_t m_HashedBlocks = 0;
+        mutable bool m_ContentValid = true;
+
+        // Claims and decompresses the next block in file order. Returns false if all blocks have been claimed.
+        bool decompressNextBlock() const;
+        bool decompressBlock(size_t index) const;
+
+        // Feeds the completed blocks that follow the already hashed ones into the content hash.
+        // Returns false if a block failed or the finished hash does not match. Call with m_HashMutex held.
+        bool advanceContentHashLocked() const;
+
+    public:
+        StreamingBlob(std::shared_ptr<IBlob> compressed, FrameLayout layout, std::string name);
+        ~StreamingBlob() override;
+
+        // Starts decompression on the shared ThreadPool.
+        void start();
+
+        [[nodiscard]] const void* data() const override;
+        [[nodiscard]] size_t size() const override { return m_Layout.contentSize; }
+
+        [[nodiscard]] size_t getBlockSize() const { return m_Layout.blockSize; }
+        [[nodiscard]] size_t getBlockCount() const { return m_Layout.blocks.size(); }
+
+        // Returns the output buffer without waiting. Only the blocks that have completed contain valid data.
+        [[nodiscard]] const uint8_t* getBytes() const { return m_Data; }
+
+        // Waits until the block is decompressed. Returns false if decompression failed.
+        bool waitForBlock(size_t index) const;
+
+        // Waits until every block overlapping [offset, offset + size) is decompressed.
+        bool waitForRange(size_t offset, size_t size) const;
+
+        // Waits for all blocks and checks the content checksum. Returns false if any of them failed.
+        bool waitForAll() const;
+    };
     
     class CompressionLayer : public IFileSystem
     {
@@ -69,6 +179,11 @@ namespace donut::vfs
         { }
 
         void setCompressionLevel(int level) { m_CompressionLevel = level; }
+
+        // Starts decompressing 'name'.lz4 in parallel and returns immediately.
+        // Returns nullptr if there is no such file or its frame cannot be split into independent blocks;
+        // use readFile in that case.
+        std::shared_ptr<StreamingBlob> readFileStreaming(const std::filesystem::path& name);
         
         bool folderExists(const std::filesystem::path& name) override;
         bool fileExists(const std::filesystem::path& name) override;
@@ -14,10 +14,12 @@
 #include "../DonutCore/chunkDescs.h"
 
 #include "../DonutCore/circular_buffer.h"
+#include "../DonutCore/ThreadPool.h"
 
 #include "../DonutCore/VFS.h"
 #include "../DonutCore/Compression.h"
 #include "../DonutCore/TarFile.h"
+#include "../DonutCore/PackFile.h"
 #include "../DonutCore/WinResFS.h"
 #include "../DonutCore/ZipFile.h"
 
@@ -0,0 +1,468 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include <algorithm>
+#include <cstring>
+#include <regex>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef DONUT_WITH_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+using namespace donut::vfs;
+
+namespace donut::vfs
+{
+    // Read-only mapping of an entire archive file.
+    // Shared between PackFile and the blobs it returns, so that blobs stay valid after the PackFile is destroyed.
+    class MappedArchive
+    {
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+#ifdef _WIN32
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        HANDLE m_Mapping = nullptr;
+#endif
+
+    public:
+        explicit MappedArchive(const std::string& path)
+        {
+#ifdef _WIN32
+            m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+            if (m_File == INVALID_HANDLE_VALUE)
+                return;
+
+            LARGE_INTEGER fileSize{};
+            if (!GetFileSizeEx(m_File, &fileSize) || fileSize.QuadPart == 0)
+                return;
+
+            m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_Mapping)
+                return;
+
+            m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+            if (m_Data)
+                m_Size = size_t(fileSize.QuadPart);
+#else
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+
+            struct stat st {};
+            if (fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+                if (data != MAP_FAILED)
+                {
+                    m_Data = static_cast<const uint8_t*>(data);
+                    m_Size = size_t(st.st_size);
+                }
+            }
+            close(fd);
+#endif
+        }
+
+        ~MappedArchive()
+        {
+#ifdef _WIN32
+            if (m_Data)
+                UnmapViewOfFile(m_Data);
+            if (m_Mapping)
+                CloseHandle(m_Mapping);
+            if (m_File != INVALID_HANDLE_VALUE)
+                CloseHandle(m_File);
+#else
+            if (m_Data)
+                munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+        }
+
+        MappedArchive(const MappedArchive&) = delete;
+        MappedArchive& operator=(const MappedArchive&) = delete;
+
+        [[nodiscard]] const uint8_t* data() const { return m_Data; }
+        [[nodiscard]] size_t size() const { return m_Size; }
+    };
+}
+
+namespace
+{
+    // A blob that points into a mapped archive and does not own the data.
+    class MappedBlob : public IBlob
+    {
+    private:
+        std::shared_ptr<MappedArchive> m_Archive;
+        const void* m_Data;
+        size_t m_Size;
+
+    public:
+        MappedBlob(std::shared_ptr<MappedArchive> archive, const void* data, size_t size)
+            : m_Archive(std::move(archive))
+            , m_Data(data)
+            , m_Size(size)
+        { }
+
+        [[nodiscard]] const void* data() const override { return m_Data; }
+        [[nodiscard]] size_t size() const override { return m_Size; }
+    };
+
+    constexpr char PackMagic[4] = { 'D', 'P', 'A', 'K' };
+
+    std::string normalizeName(const std::filesystem::path& name)
+    {
+        return name.lexically_normal().relative_path().generic_string();
+    }
+
+    bool entryLess(const PackFile::PackEntry& a, uint64_t hash, std::string_view aName, std::string_view name)
+    {
+        if (a.nameHash != hash)
+            return a.nameHash < hash;
+        return aName < name;
+    }
+}
+
+uint64_t PackFile::hashName(std::string_view name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name)
+    {
+        hash ^= uint8_t(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+PackFile::PackFile(const std::filesystem::path& archivePath)
+{
+    m_ArchivePath = archivePath.lexically_normal().generic_string();
+
+    auto archive = std::make_shared<MappedArchive>(m_ArchivePath);
+    const uint8_t* data = archive->data();
+    const size_t archiveSize = archive->size();
+
+    if (!data)
+        return;
+
+    if (archiveSize < sizeof(PackHeader))
+    {
+        log::warning("Malformed pack archive '%s': file is too small", m_ArchivePath.c_str());
+        return;
+    }
+
+    PackHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, PackMagic, sizeof(PackMagic)) != 0 || header.version != Version)
+    {
+        log::warning("'%s' is not a pack archive of version %u", m_ArchivePath.c_str(), Version);
+        return;
+    }
+
+    const uint64_t tocSize = uint64_t(header.fileCount) * sizeof(PackEntry);
+    if (header.tocOffset % alignof(PackEntry) != 0 || header.tocOffset > archiveSize || tocSize > archiveSize - header.tocOffset ||
+        header.namesOffset > archiveSize || header.namesSize > archiveSize - header.namesOffset)
+    {
+        log::warning("Malformed pack archive '%s': table of contents exceeds the archive range", m_ArchivePath.c_str());
+        return;
+    }
+
+    const PackEntry* entries = reinterpret_cast<const PackEntry*>(data + header.tocOffset);
+    const char* names = reinterpret_cast<const char*>(data + header.namesOffset);
+
+    // validate every entry once here so that lookups don't need any range checks
+    for (uint32_t i = 0; i < header.fileCount; ++i)
+    {
+        const PackEntry& entry = entries[i];
+        bool valid = uint64_t(entry.nameOffset) + entry.nameLength <= header.namesSize
+            && entry.dataOffset <= archiveSize && entry.storedSize <= archiveSize - entry.dataOffset
+            && ((entry.flags & EntryFlagLZ4) != 0 || entry.storedSize == entry.size);
+
+        std::string_view name(names + (valid ? entry.nameOffset : 0), valid ? entry.nameLength : 0);
+        if (valid && i > 0)
+        {
+            const PackEntry& prev = entries[i - 1];
+            std::string_view prevName(names + prev.nameOffset, prev.nameLength);
+            valid = entryLess(prev, entry.nameHash, prevName, name);
+        }
+
+        if (!valid || entry.nameHash != hashName(name))
+        {
+            log::warning("Malformed pack archive '%s': invalid entry %u", m_ArchivePath.c_str(), i);
+            m_Directories.clear();
+            return;
+        }
+
+        std::filesystem::path filePath = name;
+        if (filePath.has_parent_path())
+            m_Directories.insert(filePath.parent_path().generic_string());
+    }
+
+    m_Archive = std::move(archive);
+    m_Entries = entries;
+    m_FileCount = header.fileCount;
+    m_Names = names;
+}
+
+bool PackFile::isOpen() const
+{
+    return m_Archive != nullptr;
+}
+
+std::string_view PackFile::getName(const PackEntry& entry) const
+{
+    return std::string_view(m_Names + entry.nameOffset, entry.nameLength);
+}
+
+const PackFile::PackEntry* PackFile::findEntry(const std::filesystem::path& name) const
+{
+    std::string normalizedName = normalizeName(name);
+    if (normalizedName.empty() || !m_Entries)
+        return nullptr;
+
+    uint64_t hash = hashName(normalizedName);
+    const PackEntry* end = m_Entries + m_FileCount;
+    const PackEntry* entry = std::lower_bound(m_Entries, end, normalizedName,
+        [this, hash](const PackEntry& e, const std::string& n) { return entryLess(e, hash, getName(e), n); });
+
+    if (entry != end && entry->nameHash == hash && getName(*entry) == normalizedName)
+        return entry;
+
+    return nullptr;
+}
+
+bool PackFile::folderExists(const std::filesystem::path& name)
+{
+    return m_Directories.find(normalizeName(name)) != m_Directories.end();
+}
+
+bool PackFile::fileExists(const std::filesystem::path& name)
+{
+    return findEntry(name) != nullptr;
+}
+
+std::shared_ptr<IBlob> PackFile::readFile(const std::filesystem::path& name)
+{
+    const PackEntry* entry = findEntry(name);
+    if (!entry)
+        return nullptr;
+
+    const uint8_t* storedData = m_Archive->data() + entry->dataOffset;
+
+    if ((entry->flags & EntryFlagLZ4) == 0)
+        return std::make_shared<MappedBlob>(m_Archive, storedData, size_t(entry->size));
+
+#ifdef DONUT_WITH_LZ4
+    void* data = malloc(size_t(entry->size));
+    if (!data)
+        return nullptr;
+
+    int decompressedSize = LZ4_decompress_safe(reinterpret_cast<const char*>(storedData), static_cast<char*>(data),
+        int(entry->storedSize), int(entry->size));
+
+    if (decompressedSize < 0 || uint64_t(decompressedSize) != entry->size)
+    {
+        log::warning("Failed to decompress file '%s' from pack archive '%s'",
+            std::string(getName(*entry)).c_str(), m_ArchivePath.c_str());
+        free(data);
+        return nullptr;
+    }
+
+    return std::make_shared<Blob>(data, size_t(entry->size));
+#else
+    log::warning("Cannot read compressed file '%s' from pack archive '%s': LZ4 support is not enabled",
+        std::string(getName(*entry)).c_str(), m_ArchivePath.c_str());
+    return nullptr;
+#endif
+}
+
+bool PackFile::writeFile(const std::filesystem::path&, const void*, size_t)
+{
+    // pack files are mounted read-only
+    return false;
+}
+
+int PackFile::enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, enumerate_callback_t callback, bool allowDuplicates)
+{
+    (void)allowDuplicates;
+    std::basic_regex<char> regex(getFileSearchRegex(path.relative_path(), extensions));
+
+    int numEntries = 0;
+    for (uint32_t i = 0; i < m_FileCount; ++i)
+    {
+        std::string_view name = getName(m_Entries[i]);
+        if (std::regex_match(name.begin(), name.end(), regex))
+        {
+            std::filesystem::path filePath = name;
+            callback(filePath.filename().generic_string());
+            ++numEntries;
+        }
+    }
+
+    return numEntries;
+}
+
+int PackFile::enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates)
+{
+    (void)allowDuplicates;
+    std::filesystem::path normalizedPath = path.relative_path().lexically_normal();
+
+    int numEntries = 0;
+    for (const auto& name : m_Directories)
+    {
+        std::filesystem::path dirPath = name;
+        if (dirPath.parent_path() == normalizedPath)
+        {
+            callback(dirPath.filename().generic_string());
+            ++numEntries;
+        }
+    }
+
+    return numEntries;
+}
+
+bool PackFileWriter::addFile(const std::filesystem::path& name, std::shared_ptr<IBlob> data, bool compress)
+{
+    std::string normalizedName = normalizeName(name);
+    if (normalizedName.empty())
+        return false;
+
+    for (const auto& file : m_Files)
+    {
+        if (file.name == normalizedName)
+            return false;
+    }
+
+    m_Files.push_back({ std::move(normalizedName), std::move(data), compress });
+    return true;
+}
+
+bool PackFileWriter::write(const std::filesystem::path& archivePath) const
+{
+    using PackEntry = PackFile::PackEntry;
+    using PackHeader = PackFile::PackHeader;
+
+    // sort by (hash, name) so that PackFile can binary search the table of contents
+    std::vector<PackEntry> entries(m_Files.size());
+    std::vector<size_t> order(m_Files.size());
+    std::string names;
+    for (size_t i = 0; i < m_Files.size(); ++i)
+    {
+        entries[i].nameHash = PackFile::hashName(m_Files[i].name);
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return entryLess(entries[a], entries[b].nameHash, m_Files[a].name, m_Files[b].name);
+    });
+
+    FILE* file = fopen(archivePath.generic_string().c_str(), "wb");
+    if (!file)
+    {
+        log::warning("Cannot open '%s' for writing", archivePath.generic_string().c_str());
+        return false;
+    }
+
+    static const uint8_t padding[PackFile::PackAlignment] = {};
+    uint64_t writePtr = 0;
+    bool success = true;
+    auto writeBytes = [&](const void* data, size_t size) {
+        if (size != 0 && fwrite(data, 1, size, file) != size)
+            success = false;
+        writePtr += size;
+    };
+    auto alignTo = [&](uint64_t alignment) {
+        writeBytes(padding, size_t((alignment - writePtr % alignment) % alignment));
+    };
+
+    // the header is patched at the end
+    PackHeader header{};
+    writeBytes(&header, sizeof(header));
+
+    std::vector<PackEntry> sortedEntries;
+    sortedEntries.reserve(m_Files.size());
+    for (size_t index : order)
+    {
+        const PendingFile& pending = m_Files[index];
+        const void* storedData = pending.data ? pending.data->data() : nullptr;
+        size_t size = pending.data ? pending.data->size() : 0;
+
+        PackEntry entry = entries[index];
+        entry.size = size;
+        entry.storedSize = size;
+        entry.nameOffset = uint32_t(names.size());
+        entry.nameLength = uint32_t(pending.name.size());
+        names += pending.name;
+
+#ifdef DONUT_WITH_LZ4
+        std::vector<char> compressed;
+        if (pending.compress && size > 0 && size <= LZ4_MAX_INPUT_SIZE)
+        {
+            compressed.resize(size_t(LZ4_compressBound(int(size))));
+            int compressedSize = LZ4_compress_HC(static_cast<const char*>(storedData), compressed.data(),
+                int(size), int(compressed.size()), m_CompressionLevel);
+            if (compressedSize > 0 && size_t(compressedSize) < size)
+            {
+                storedData = compressed.data();
+                entry.storedSize = uint64_t(compressedSize);
+                entry.flags |= PackFile::EntryFlagLZ4;
+            }
+        }
+#endif
+
+        alignTo(PackFile::PackAlignment);
+        entry.dataOffset = writePtr;
+        writeBytes(storedData, size_t(entry.storedSize));
+        sortedEntries.push_back(entry);
+    }
+
+    alignTo(alignof(PackEntry));
+    memcpy(header.magic, PackMagic, sizeof(PackMagic));
+    header.version = PackFile::Version;
+    header.fileCount = uint32_t(sortedEntries.size());
+    header.tocOffset = writePtr;
+    writeBytes(sortedEntries.data(), sortedEntries.size() * sizeof(PackEntry));
+    header.namesOffset = writePtr;
+    header.namesSize = names.size();
+    writeBytes(names.data(), names.size());
+
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1)
+        success = false;
+
+    if (fclose(file) != 0)
+        success = false;
+
+    if (!success)
+        log::warning("Error writing pack archive '%s'", archivePath.generic_string().c_str());
+
+    return success;
+}
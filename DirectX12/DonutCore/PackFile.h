@@ -0,0 +1,135 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "../DonutCore/VFS.h"
+#include <cstdint>
+#include <unordered_set>
+
+namespace donut::vfs
+{
+    class MappedArchive;
+
+    /*
+    A read-only file system that provides access to files in a pack archive.
+
+    Pack layout:
+        PackHeader
+        file payloads, each aligned to PackAlignment (4 KB)
+        PackEntry table of contents, sorted by (nameHash, name)
+        file names, not null-terminated
+
+    The whole archive is memory-mapped when PackFile is created. Uncompressed files are
+    returned as blobs that point directly into the mapping, without copying or locking,
+    so any number of threads can read concurrently. The blobs keep the mapping alive.
+    Files stored with per-file LZ4 block compression are decompressed into a new blob;
+    reading them requires DONUT_WITH_LZ4.
+
+    Use PackFileWriter to create pack archives.
+    */
+    class PackFile : public IFileSystem
+    {
+    public:
+        static constexpr uint32_t Version = 1;
+        static constexpr size_t PackAlignment = 4096;
+        static constexpr uint32_t EntryFlagLZ4 = 1;
+
+        struct PackHeader
+        {
+            char magic[4];          // "DPAK"
+            uint32_t version;
+            uint32_t fileCount;
+            uint32_t reserved;
+            uint64_t tocOffset;
+            uint64_t namesOffset;
+            uint64_t namesSize;
+        };
+
+        struct PackEntry
+        {
+            uint64_t nameHash;
+            uint64_t dataOffset;
+            uint64_t storedSize;    // size in the archive
+            uint64_t size;          // size after decompression
+            uint32_t nameOffset;    // relative to namesOffset
+            uint32_t nameLength;
+            uint32_t flags;         // EntryFlagLZ4
+            uint32_t reserved;
+        };
+
+        static_assert(sizeof(PackHeader) == 40);
+        static_assert(sizeof(PackEntry) == 48);
+
+        // FNV-1a hash of a normalized path, used to sort and search the table of contents.
+        static uint64_t hashName(std::string_view name);
+
+    private:
+        std::string m_ArchivePath;
+        std::shared_ptr<MappedArchive> m_Archive;
+        const PackEntry* m_Entries = nullptr;
+        uint32_t m_FileCount = 0;
+        const char* m_Names = nullptr;
+        std::unordered_set<std::string> m_Directories;
+
+        [[nodiscard]] std::string_view getName(const PackEntry& entry) const;
+        [[nodiscard]] const PackEntry* findEntry(const std::filesystem::path& name) const;
+
+    public:
+        PackFile(const std::filesystem::path& archivePath);
+
+        [[nodiscard]] bool isOpen() const;
+
+        bool folderExists(const std::filesystem::path& name) override;
+        bool fileExists(const std::filesystem::path& name) override;
+        std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+        bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+        int enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, enumerate_callback_t callback, bool allowDuplicates = false) override;
+        int enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates = false) override;
+    };
+
+    // Builds a pack archive that can be mounted with PackFile.
+    class PackFileWriter
+    {
+    private:
+        struct PendingFile
+        {
+            std::string name;
+            std::shared_ptr<IBlob> data;
+            bool compress = false;
+        };
+
+        std::vector<PendingFile> m_Files;
+        int m_CompressionLevel = 9;
+
+    public:
+        void setCompressionLevel(int level) { m_CompressionLevel = level; }
+
+        // Adds a file to the archive. If 'compress' is true and the build has DONUT_WITH_LZ4,
+        // the file is stored LZ4-compressed unless compression does not reduce its size.
+        // Returns false if a file with the same name has already been added.
+        bool addFile(const std::filesystem::path& name, std::shared_ptr<IBlob> data, bool compress = false);
+
+        // Writes the archive. Returns false if the file cannot be written.
+        bool write(const std::filesystem::path& archivePath) const;
+    };
+}
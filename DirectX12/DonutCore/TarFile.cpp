@@ -150,6 +150,9 @@ TarFile::TarFile(const std::filesystem::path& archivePath)
 
 TarFile::~TarFile()
 {
+    // wait for the reads and prefetches queued by this archive
+    IoQueue::drainGlobal(this);
+
     // make sure we're not closing the file while some other thread is reading from it
     std::lock_guard<std::mutex> lockGuard(m_Mutex);
 
@@ -180,43 +183,70 @@ bool TarFile::fileExists(const std::filesystem::path& name)
 }
 
 std::shared_ptr<IBlob> TarFile::readFile(const std::filesystem::path& name)
+{
+    return readFileCached(name, BlobCache::ReadMode::Immediate).get();
+}
+
+BlobFuture TarFile::readFileAsync(const std::filesystem::path& name)
+{
+    return readFileCached(name, BlobCache::ReadMode::Async);
+}
+
+void TarFile::prefetch(const std::vector<std::filesystem::path>& names)
+{
+    for (const auto& name : names)
+        readFileCached(name, BlobCache::ReadMode::Prefetch);
+}
+
+BlobFuture TarFile::readFileCached(const std::filesystem::path& name, BlobCache::ReadMode mode)
 {
     std::string normalizedName = name.lexically_normal().relative_path().generic_string();
     
     if (normalizedName.empty())
-        return nullptr;
+        return makeReadyBlobFuture(nullptr);
     
     auto entry = m_Files.find(normalizedName);
 
     if (entry == m_Files.end())
-        return nullptr;
+        return makeReadyBlobFuture(nullptr);
 
+    // a prefetched file that does not fit into the cache would only be read twice
+    if (mode == BlobCache::ReadMode::Prefetch && !m_Cache.canCache(entry->second.size))
+        return BlobFuture();
+
+    // the archive is read-only, so cached entries never go stale
+    return m_Cache.read(normalizedName, 0,
+        [this, entry]() { return readEntry(entry->first, entry->second); }, this, mode);
+}
+
+std::shared_ptr<IBlob> TarFile::readEntry(const std::string& normalizedName, const FileEntry& entry)
+{
     // prevent concurrent file operations from multiple threads from this point on
     std::lock_guard<std::mutex> lockGuard(m_Mutex);
     
-    if (fseeko(m_ArchiveFile, entry->second.offset, SEEK_SET) != 0)
+    if (fseeko(m_ArchiveFile, entry.offset, SEEK_SET) != 0)
     {
         log::warning("Error seeking to offset %ull for file '%s' in tar archive '%s'",
-            entry->second.offset, normalizedName.c_str(), m_ArchivePath.c_str());
+            entry.offset, normalizedName.c_str(), m_ArchivePath.c_str());
         return nullptr;
     }
 
-    void* data = malloc(entry->second.size);
+    void* data = malloc(entry.size);
 
     if (!data)
         return nullptr;
 
-    size_t sizeRead = fread(data, 1, entry->second.size, m_ArchiveFile);
+    size_t sizeRead = fread(data, 1, entry.size, m_ArchiveFile);
 
-    if (sizeRead != entry->second.size)
+    if (sizeRead != entry.size)
     {
         log::warning("Error reading file '%s' (%ull bytes) from tar archive '%s'", 
-            entry->second.size, normalizedName.c_str(), m_ArchivePath.c_str());
+            entry.size, normalizedName.c_str(), m_ArchivePath.c_str());
         free(data);
         return nullptr;
     }
 
-    std::shared_ptr<Blob> blob = std::make_shared<Blob>(data, entry->second.size);
+    std::shared_ptr<Blob> blob = std::make_shared<Blob>(data, entry.size);
 
     return std::static_pointer_cast<IBlob>(blob);
 }
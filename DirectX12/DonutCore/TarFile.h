@@ -34,6 +34,7 @@ namespace donut::vfs
     The archive is partially read to enumerate the files when TarFile is created.
     TarFile can only operate on real files, i.e. underlying virtual file systems are not supported.
     Designed to work in combination with CompressionLayer to store packaged assets.
+    Files that have been read are kept in a BlobCache; the archive is not expected to change while mounted.
     */
     class TarFile : public IFileSystem
     {
@@ -50,12 +51,17 @@ namespace donut::vfs
 
         std::unordered_map<std::string, FileEntry> m_Files;
         std::unordered_set<std::string> m_Directories;
+        BlobCache m_Cache;
+
+        std::shared_ptr<IBlob> readEntry(const std::string& normalizedName, const FileEntry& entry);
+        BlobFuture readFileCached(const std::filesystem::path& name, BlobCache::ReadMode mode);
         
     public:
         TarFile(const std::filesystem::path& archivePath);
         ~TarFile() override;
 
         [[nodiscard]] bool isOpen() const;
+        [[nodiscard]] BlobCache& getCache() { return m_Cache; }
         
         bool folderExists(const std::filesystem::path& name) override;
         bool fileExists(const std::filesystem::path& name) override;
@@ -63,5 +69,7 @@ namespace donut::vfs
         bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
         int enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, enumerate_callback_t callback, bool allowDuplicates = false) override;
         int enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates = false) override;
+        BlobFuture readFileAsync(const std::filesystem::path& name) override;
+        void prefetch(const std::vector<std::filesystem::path>& names) override;
     };
 }
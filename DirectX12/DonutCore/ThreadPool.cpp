@@ -0,0 +1,149 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+using namespace donut;
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+    m_Threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+        m_Threads.emplace_back(&ThreadPool::threadProc, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_Mutex);
+        m_Terminate = true;
+    }
+    m_TaskAdded.notify_all();
+
+    // the threads complete the remaining tasks before exiting
+    for (auto& thread : m_Threads)
+        thread.join();
+}
+
+ThreadPool& ThreadPool::get()
+{
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+    m_TaskAdded.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count == 0)
+        return;
+
+    if (count == 1)
+    {
+        func(0);
+        return;
+    }
+
+    // The helpers may start after all items have been taken and parallelFor has returned,
+    // so they only touch 'func' after claiming an item, and the state is shared with them.
+    struct State
+    {
+        const std::function<void(size_t)>* func = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> completed = 0;
+        std::mutex mutex;
+        std::condition_variable allCompleted;
+        std::exception_ptr exception;
+
+        void run()
+        {
+            for (size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1))
+            {
+                try
+                {
+                    (*func)(index);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lockGuard(mutex);
+                    if (!exception)
+                        exception = std::current_exception();
+                }
+
+                if (completed.fetch_add(1) + 1 == count)
+                {
+                    std::lock_guard<std::mutex> lockGuard(mutex);
+                    allCompleted.notify_all();
+                }
+            }
+        }
+    };
+
+    auto state = std::make_shared<State>();
+    state->func = &func;
+    state->count = count;
+
+    const size_t helperCount = std::min<size_t>(m_Threads.size(), count - 1);
+    for (size_t i = 0; i < helperCount; i++)
+        submit([state]() { state->run(); });
+
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->allCompleted.wait(lock, [&state]() { return state->completed.load() == state->count; });
+
+    if (state->exception)
+        std::rethrow_exception(state->exception);
+}
+
+void ThreadPool::threadProc()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_TaskAdded.wait(lock, [this]() { return m_Terminate || !m_Tasks.empty(); });
+
+            if (m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,75 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace donut
+{
+    /*
+    A process-wide pool of worker threads for CPU-bound work such as decompressing
+    LZ4 blocks or decoding glTF primitives when no tf::Executor is provided.
+    Unlike spawning threads per request, the number of threads stays fixed no matter
+    how many files or models are being loaded at the same time.
+
+    parallelFor runs part of the work on the calling thread and never waits for a task
+    that only a pool thread could run, so it can be called from a pool thread, from an
+    IoQueue thread, or while the pool is busy with other requests.
+    */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(uint32_t threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // The process-wide pool with one thread less than the hardware concurrency, created on first use.
+        static ThreadPool& get();
+
+        [[nodiscard]] uint32_t getThreadCount() const { return uint32_t(m_Threads.size()); }
+
+        // Runs 'task' on a pool thread. The task must not throw.
+        void submit(std::function<void()> task);
+
+        // Calls func(i) for every i in [0, count) on the pool threads and the calling thread,
+        // and returns when all calls have completed. The first exception thrown by 'func'
+        // is rethrown after that.
+        void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+    private:
+        std::mutex m_Mutex;
+        std::condition_variable m_TaskAdded;
+        std::deque<std::function<void()>> m_Tasks;
+        std::vector<std::thread> m_Threads;
+        bool m_Terminate = false;
+
+        void threadProc();
+    };
+}
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <utility>
 #include <sstream>
+#include <atomic>
 
 #ifdef _WIN32
 #include <Shlwapi.h>
@@ -43,6 +44,363 @@ Blob::~Blob()
     m_size = 0;
 }
 
+BlobFuture donut::vfs::makeReadyBlobFuture(std::shared_ptr<IBlob> blob)
+{
+    std::promise<std::shared_ptr<IBlob>> promise;
+    promise.set_value(std::move(blob));
+    return promise.get_future().share();
+}
+
+static std::atomic<IoQueue*> g_IoQueue = nullptr;
+static thread_local bool t_IsIoQueueThread = false;
+
+// the modification time and size identify the version of a native file
+static uint64_t makeNativeFileVersion(std::filesystem::file_time_type writeTime, uintmax_t fileSize)
+{
+    uint64_t version = uint64_t(writeTime.time_since_epoch().count()) ^ (uint64_t(fileSize) << 40);
+
+    // 0 means that the version is unknown
+    return version ? version : 1;
+}
+
+IoQueue::IoQueue(uint32_t threadCount, size_t queueDepth)
+    : m_QueueDepth(std::max<size_t>(queueDepth, 1))
+{
+    threadCount = std::max(threadCount, 1u);
+    m_Threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+        m_Threads.emplace_back(&IoQueue::threadProc, this);
+}
+
+IoQueue::~IoQueue()
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_Mutex);
+        m_Terminate = true;
+    }
+    m_RequestAdded.notify_all();
+
+    // the threads complete the remaining requests before exiting
+    for (auto& thread : m_Threads)
+        thread.join();
+
+    IoQueue* self = this;
+    g_IoQueue.compare_exchange_strong(self, nullptr);
+}
+
+IoQueue& IoQueue::get()
+{
+    static IoQueue queue(DefaultThreadCount, DefaultQueueDepth);
+    g_IoQueue.store(&queue);
+    return queue;
+}
+
+void IoQueue::drainGlobal(const void* owner)
+{
+    // do not create the queue and its threads only to find out that it is empty
+    if (IoQueue* queue = g_IoQueue.load())
+        queue->drain(owner);
+}
+
+bool IoQueue::enqueue(std::function<void()>&& request, const void* owner, bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (m_Requests.size() >= m_QueueDepth)
+    {
+        if (!wait)
+            return false;
+
+        m_RequestTaken.wait(lock, [this]() { return m_Requests.size() < m_QueueDepth; });
+    }
+
+    m_Requests.push_back({ std::move(request), owner });
+    ++m_PendingByOwner[owner];
+    lock.unlock();
+
+    m_RequestAdded.notify_one();
+    return true;
+}
+
+void IoQueue::submit(std::function<void()> request, const void* owner)
+{
+    enqueue(std::move(request), owner, true);
+}
+
+bool IoQueue::trySubmit(std::function<void()> request, const void* owner)
+{
+    return enqueue(std::move(request), owner, false);
+}
+
+void IoQueue::drain(const void* owner)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_RequestCompleted.wait(lock, [this, owner]() { return m_PendingByOwner.find(owner) == m_PendingByOwner.end(); });
+}
+
+bool IoQueue::isQueueThread()
+{
+    return t_IsIoQueueThread;
+}
+
+void IoQueue::threadProc()
+{
+    t_IsIoQueueThread = true;
+
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_RequestAdded.wait(lock, [this]() { return m_Terminate || !m_Requests.empty(); });
+
+            if (m_Requests.empty())
+                return;
+
+            request = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+        m_RequestTaken.notify_one();
+
+        request.function();
+
+        {
+            std::lock_guard<std::mutex> lockGuard(m_Mutex);
+            auto it = m_PendingByOwner.find(request.owner);
+            if (--it->second == 0)
+                m_PendingByOwner.erase(it);
+        }
+        m_RequestCompleted.notify_all();
+    }
+}
+
+BlobCache::BlobCache(size_t capacity)
+    : m_Capacity(capacity)
+{
+}
+
+std::shared_ptr<IBlob> BlobCache::find(const std::string& key, uint64_t version)
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+    auto it = m_Lookup.find(key);
+    if (it == m_Lookup.end())
+        return nullptr;
+
+    if (it->second->version != version)
+    {
+        // the file has changed since it was cached
+        eraseLocked(it->second);
+        return nullptr;
+    }
+
+    m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+    return it->second->blob;
+}
+
+void BlobCache::insert(const std::string& key, std::shared_ptr<IBlob> blob, uint64_t version)
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+    auto it = m_Lookup.find(key);
+    if (it != m_Lookup.end())
+        eraseLocked(it->second);
+
+    if (!blob || blob->size() > m_Capacity / 4)
+        return;
+
+    m_Entries.push_front({ key, std::move(blob), version });
+    m_Lookup[key] = m_Entries.begin();
+    m_Size += m_Entries.front().blob->size();
+
+    evictLocked();
+}
+
+void BlobCache::erase(const std::string& key)
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+    auto it = m_Lookup.find(key);
+    if (it != m_Lookup.end())
+        eraseLocked(it->second);
+}
+
+void BlobCache::clear()
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+    m_Entries.clear();
+    m_Lookup.clear();
+    m_Size = 0;
+}
+
+void BlobCache::setCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+    m_Capacity = capacity;
+    evictLocked();
+}
+
+size_t BlobCache::getCapacity() const
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+    return m_Capacity;
+}
+
+size_t BlobCache::getSize() const
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+    return m_Size;
+}
+
+bool BlobCache::canCache(size_t size) const
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+    return size <= m_Capacity / 4;
+}
+
+void BlobCache::eraseLocked(std::list<Entry>::iterator it)
+{
+    m_Size -= it->blob->size();
+    m_Lookup.erase(it->key);
+    m_Entries.erase(it);
+}
+
+void BlobCache::evictLocked()
+{
+    while (m_Size > m_Capacity && !m_Entries.empty())
+        eraseLocked(std::prev(m_Entries.end()));
+}
+
+BlobFuture BlobCache::read(const std::string& key, uint64_t version, reader_t reader, const void* owner, ReadMode mode)
+{
+    if (std::shared_ptr<IBlob> blob = find(key, version))
+        return makeReadyBlobFuture(std::move(blob));
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<IBlob>>>();
+    BlobFuture future = promise->get_future().share();
+
+    bool readDirectly = false;
+    {
+        std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+        auto it = m_InFlight.find(key);
+        if (it == m_InFlight.end())
+            m_InFlight[key] = future;
+        else if (mode == ReadMode::Immediate && IoQueue::isQueueThread())
+        {
+            // An I/O thread must not wait for a read that can still be queued behind it,
+            // or the queue deadlocks once every I/O thread does that. It reads the file itself instead.
+            readDirectly = true;
+        }
+        else
+            return it->second;
+    }
+
+    if (readDirectly)
+    {
+        try
+        {
+            promise->set_value(reader());
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+        return future;
+    }
+
+    auto request = [this, key, version, reader = std::move(reader), promise]()
+    {
+        std::shared_ptr<IBlob> blob;
+        try
+        {
+            blob = reader();
+        }
+        catch (...)
+        {
+            // leave no in-flight entry behind, or every later read of the key would wait forever
+            {
+                std::lock_guard<std::mutex> lockGuard(m_Mutex);
+                m_InFlight.erase(key);
+            }
+            promise->set_exception(std::current_exception());
+            return;
+        }
+
+        insert(key, blob, version);
+        {
+            std::lock_guard<std::mutex> lockGuard(m_Mutex);
+            m_InFlight.erase(key);
+        }
+
+        promise->set_value(std::move(blob));
+    };
+
+    switch (mode)
+    {
+    case ReadMode::Immediate:
+        request();
+        break;
+
+    case ReadMode::Async:
+        IoQueue::get().submit(std::move(request), owner);
+        break;
+
+    case ReadMode::Prefetch:
+        if (!IoQueue::get().trySubmit(std::move(request), owner))
+        {
+            std::lock_guard<std::mutex> lockGuard(m_Mutex);
+            m_InFlight.erase(key);
+            return BlobFuture();
+        }
+        break;
+    }
+
+    return future;
+}
+
+BlobFuture IFileSystem::readFileAsync(const std::filesystem::path& name)
+{
+    // a file system that is not owned by a shared_ptr cannot be kept alive by the request
+    std::weak_ptr<IFileSystem> weakThis = weak_from_this();
+    if (weakThis.expired())
+        return makeReadyBlobFuture(readFile(name));
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<IBlob>>>();
+    BlobFuture future = promise->get_future().share();
+
+    // The request holds a weak reference, so a file system destroyed in the meantime resolves the
+    // future to nullptr instead of being used after free. The request is not tagged with this object:
+    // the last reference may be released on an I/O thread, and draining there would wait for itself.
+    IoQueue::get().submit([weakThis, name, promise]()
+    {
+        std::shared_ptr<IFileSystem> self = weakThis.lock();
+        if (!self)
+        {
+            promise->set_value(nullptr);
+            return;
+        }
+
+        try
+        {
+            promise->set_value(self->readFile(name));
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    }, nullptr);
+
+    return future;
+}
+
+NativeFileSystem::~NativeFileSystem()
+{
+    IoQueue::drainGlobal(this);
+}
+
 bool NativeFileSystem::folderExists(const std::filesystem::path& name)
 {
 	return std::filesystem::exists(name) && std::filesystem::is_directory(name);
@@ -54,6 +412,57 @@ bool NativeFileSystem::fileExists(const std::filesystem::path& name)
 }
 
 std::shared_ptr<IBlob> NativeFileSystem::readFile(const std::filesystem::path& name)
+{
+    return readFileCached(name, BlobCache::ReadMode::Immediate).get();
+}
+
+BlobFuture NativeFileSystem::readFileAsync(const std::filesystem::path& name)
+{
+    return readFileCached(name, BlobCache::ReadMode::Async);
+}
+
+void NativeFileSystem::prefetch(const std::vector<std::filesystem::path>& names)
+{
+    for (const auto& name : names)
+        readFileCached(name, BlobCache::ReadMode::Prefetch);
+}
+
+BlobFuture NativeFileSystem::readFileCached(const std::filesystem::path& name, BlobCache::ReadMode mode)
+{
+    std::error_code ec;
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(name, ec);
+    if (ec)
+    {
+        // file does not exist
+        return makeReadyBlobFuture(nullptr);
+    }
+
+    uintmax_t fileSize = std::filesystem::file_size(name, ec);
+
+    // a prefetched file that does not fit into the cache would only be read twice
+    if (mode == BlobCache::ReadMode::Prefetch && (ec || !m_Cache.canCache(size_t(fileSize))))
+        return BlobFuture();
+    uint64_t version = makeNativeFileVersion(writeTime, fileSize);
+
+    return m_Cache.read(name.lexically_normal().generic_string(), version,
+        [this, name]() { return readFileUncached(name); }, this, mode);
+}
+
+uint64_t NativeFileSystem::getFileVersion(const std::filesystem::path& name)
+{
+    std::error_code ec;
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(name, ec);
+    if (ec)
+        return 0;
+
+    uintmax_t fileSize = std::filesystem::file_size(name, ec);
+    if (ec)
+        return 0;
+
+    return makeNativeFileVersion(writeTime, fileSize);
+}
+
+std::shared_ptr<IBlob> NativeFileSystem::readFileUncached(const std::filesystem::path& name)
 {
     // TODO: better error reporting
 
@@ -100,6 +509,8 @@ std::shared_ptr<IBlob> NativeFileSystem::readFile(const std::filesystem::path& n
 
 bool NativeFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
 {
+    m_Cache.erase(name.lexically_normal().generic_string());
+
     // TODO: better error reporting
 
     std::ofstream file(name, std::ios::binary);
@@ -248,6 +659,26 @@ std::shared_ptr<IBlob> RelativeFileSystem::readFile(const std::filesystem::path&
     return m_UnderlyingFS->readFile(m_BasePath / name.relative_path());
 }
 
+BlobFuture RelativeFileSystem::readFileAsync(const std::filesystem::path& name)
+{
+    return m_UnderlyingFS->readFileAsync(m_BasePath / name.relative_path());
+}
+
+void RelativeFileSystem::prefetch(const std::vector<std::filesystem::path>& names)
+{
+    std::vector<std::filesystem::path> underlyingNames;
+    underlyingNames.reserve(names.size());
+    for (const auto& name : names)
+        underlyingNames.push_back(m_BasePath / name.relative_path());
+
+    m_UnderlyingFS->prefetch(underlyingNames);
+}
+
+uint64_t RelativeFileSystem::getFileVersion(const std::filesystem::path& name)
+{
+    return m_UnderlyingFS->getFileVersion(m_BasePath / name.relative_path());
+}
+
 bool RelativeFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
 {
     return m_UnderlyingFS->writeFile(m_BasePath / name.relative_path(), data, size);
@@ -360,6 +791,56 @@ std::shared_ptr<IBlob> RootFileSystem::readFile(const std::filesystem::path& nam
     return nullptr;
 }
 
+BlobFuture RootFileSystem::readFileAsync(const std::filesystem::path& name)
+{
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+
+    if (findMountPoint(name, &relativePath, &fs))
+    {
+        return fs->readFileAsync(relativePath);
+    }
+
+    return makeReadyBlobFuture(nullptr);
+}
+
+void RootFileSystem::prefetch(const std::vector<std::filesystem::path>& names)
+{
+    // group the files by mount point so that every file system gets a single request
+    std::vector<std::pair<IFileSystem*, std::vector<std::filesystem::path>>> requests;
+
+    for (const auto& name : names)
+    {
+        std::filesystem::path relativePath;
+        IFileSystem* fs = nullptr;
+
+        if (!findMountPoint(name, &relativePath, &fs))
+            continue;
+
+        auto it = std::find_if(requests.begin(), requests.end(), [fs](const auto& request) { return request.first == fs; });
+        if (it == requests.end())
+            it = requests.insert(requests.end(), { fs, {} });
+
+        it->second.push_back(std::move(relativePath));
+    }
+
+    for (const auto& [fs, relativePaths] : requests)
+        fs->prefetch(relativePaths);
+}
+
+uint64_t RootFileSystem::getFileVersion(const std::filesystem::path& name)
+{
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+
+    if (findMountPoint(name, &relativePath, &fs))
+    {
+        return fs->getFileVersion(relativePath);
+    }
+
+    return 0;
+}
+
 bool RootFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
 {
     std::filesystem::path relativePath;
@@ -27,6 +27,13 @@
 #include <filesystem>
 #include <functional>
 #include <vector>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <list>
+#include <unordered_map>
 
 /* 
 Donut Virtual File System (VFS) main classes.
@@ -83,8 +90,143 @@ namespace donut::vfs
         [[nodiscard]] size_t size() const override;
     };
 
+    // The result of an asynchronous read. Resolves to nullptr if the file cannot be read.
+    typedef std::shared_future<std::shared_ptr<IBlob>> BlobFuture;
+
+    BlobFuture makeReadyBlobFuture(std::shared_ptr<IBlob> blob);
+
+    /*
+    A small pool of I/O threads shared by all file systems, fed by a bounded request queue.
+    The bound keeps a burst of prefetch requests from queueing up an unbounded amount of
+    reads and memory: submit() waits for space in the queue, trySubmit() drops the request.
+
+    Requests are tagged with an owner, normally the file system that issued them.
+    A file system that issues requests referencing 'this', such as BlobCache reads, must call
+    IoQueue::drainGlobal(this) in its destructor so that no request can run on a destroyed object.
+    Requests from the default IFileSystem::readFileAsync hold a weak reference instead and need no drain. Requests must not submit further requests
+    and wait for them, because that can deadlock when the queue is full. For the same reason, an Immediate
+    BlobCache read on an I/O thread does not join a read of the same file that is in flight.
+    */
+    class IoQueue
+    {
+    public:
+        static constexpr uint32_t DefaultThreadCount = 4;
+        static constexpr size_t DefaultQueueDepth = 256;
+
+        IoQueue(uint32_t threadCount, size_t queueDepth);
+        ~IoQueue();
+
+        IoQueue(const IoQueue&) = delete;
+        IoQueue& operator=(const IoQueue&) = delete;
+
+        // The process-wide queue, created with the default settings on first use.
+        static IoQueue& get();
+
+        // Adds a request to the queue, waiting for space if the queue is full.
+        void submit(std::function<void()> request, const void* owner);
+
+        // Adds a request to the queue unless the queue is full.
+        // Returns false if the request was dropped.
+        bool trySubmit(std::function<void()> request, const void* owner);
+
+        // Waits until all requests submitted by 'owner' have completed.
+        void drain(const void* owner);
+
+        // Calls drain on the process-wide queue if it has been created.
+        static void drainGlobal(const void* owner);
+
+        // Returns true on the threads of any IoQueue.
+        static bool isQueueThread();
+
+    private:
+        struct Request
+        {
+            std::function<void()> function;
+            const void* owner = nullptr;
+        };
+
+        std::mutex m_Mutex;
+        std::condition_variable m_RequestAdded;
+        std::condition_variable m_RequestTaken;
+        std::condition_variable m_RequestCompleted;
+        std::deque<Request> m_Requests;
+        std::unordered_map<const void*, uint32_t> m_PendingByOwner;
+        std::vector<std::thread> m_Threads;
+        size_t m_QueueDepth;
+        bool m_Terminate = false;
+
+        bool enqueue(std::function<void()>&& request, const void* owner, bool wait);
+        void threadProc();
+    };
+
+    /*
+    A thread-safe LRU cache of file contents, bounded by the total size of the cached blobs.
+    Lets repeated reads of the same file, e.g. a texture referenced by several models, hit memory.
+
+    Every entry stores a version supplied by the file system, such as the file modification time.
+    A lookup with a different version misses and drops the stale entry.
+    Blobs larger than a quarter of the capacity are not cached so that a single large file
+    does not evict everything else. A capacity of 0 disables caching.
+
+    read() also tracks the reads that are in flight, so concurrent requests for the same file
+    share one read instead of hitting the file system several times.
+    */
+    class BlobCache
+    {
+    public:
+        static constexpr size_t DefaultCapacity = 64ull << 20;
+
+        enum class ReadMode
+        {
+            Immediate,  // read on the calling thread
+            Async,      // read on the IoQueue, waiting for space in the queue
+            Prefetch    // read on the IoQueue, or do nothing if the queue is full
+        };
+
+        typedef std::function<std::shared_ptr<IBlob>()> reader_t;
+
+        explicit BlobCache(size_t capacity = DefaultCapacity);
+
+        [[nodiscard]] std::shared_ptr<IBlob> find(const std::string& key, uint64_t version = 0);
+        void insert(const std::string& key, std::shared_ptr<IBlob> blob, uint64_t version = 0);
+        void erase(const std::string& key);
+        void clear();
+
+        void setCapacity(size_t capacity);
+        [[nodiscard]] size_t getCapacity() const;
+        [[nodiscard]] size_t getSize() const;
+
+        // Returns true if a blob of 'size' bytes would be kept in the cache.
+        [[nodiscard]] bool canCache(size_t size) const;
+
+        // Returns the cached blob for 'key' as a ready future, or joins a read of the same key
+        // that is already in flight, or starts a new read with 'reader' according to 'mode'.
+        // An Immediate read on an IoQueue thread does not join, it calls 'reader' without caching the result.
+        // The result of a new read is added to the cache.
+        // In the Prefetch mode, returns an invalid future if the request was dropped.
+        BlobFuture read(const std::string& key, uint64_t version, reader_t reader, const void* owner, ReadMode mode);
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            std::shared_ptr<IBlob> blob;
+            uint64_t version = 0;
+        };
+
+        mutable std::mutex m_Mutex;
+        std::list<Entry> m_Entries; // most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> m_Lookup;
+        std::unordered_map<std::string, BlobFuture> m_InFlight;
+        size_t m_Capacity;
+        size_t m_Size = 0;
+
+        void eraseLocked(std::list<Entry>::iterator it);
+        void evictLocked();
+    };
+
     // Basic interface for the virtual file system.
-    class IFileSystem
+    class IFileSystem : public std::enable_shared_from_this<IFileSystem>
     {
     public:
         virtual ~IFileSystem() = default;
@@ -113,18 +255,48 @@ namespace donut::vfs
         // Returns the number of directories found, or a negative number on errors - see donut::vfs::status.
         // The directory names, relative to the 'path', are passed to 'callback' in no particular order.
         virtual int enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates = false) = 0;
+
+        // Read the entire file on the I/O queue, see IoQueue.
+        // The default implementation calls readFile on an I/O thread while the file system is owned
+        // by a shared_ptr; the future resolves to nullptr if the file system is destroyed first.
+        // A file system that is not owned by a shared_ptr reads synchronously.
+        virtual BlobFuture readFileAsync(const std::filesystem::path& name);
+
+        // Hint that the files will be read soon. Implementations with a blob cache start
+        // reading the files in the background; requests that do not fit into the I/O queue are dropped.
+        // The default implementation does nothing.
+        virtual void prefetch(const std::vector<std::filesystem::path>& names) { (void)names; }
+
+        // Returns a value that changes whenever the file changes, such as a combination of its
+        // modification time and size, without reading the file.
+        // Returns 0 if the file does not exist or the file system cannot tell, which is the default.
+        virtual uint64_t getFileVersion(const std::filesystem::path& name) { (void)name; return 0; }
     };
 
     // An implementation of virtual file system that directly maps to the OS files.
+    // Reads go through a BlobCache that is validated with the file modification time.
     class NativeFileSystem : public IFileSystem
     {
+    private:
+        BlobCache m_Cache;
+
+        std::shared_ptr<IBlob> readFileUncached(const std::filesystem::path& name);
+        BlobFuture readFileCached(const std::filesystem::path& name, BlobCache::ReadMode mode);
+
     public:
+        ~NativeFileSystem() override;
+
+        [[nodiscard]] BlobCache& getCache() { return m_Cache; }
+
 		bool folderExists(const std::filesystem::path& name) override;
         bool fileExists(const std::filesystem::path& name) override;
         std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
         bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
         int enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, enumerate_callback_t callback, bool allowDuplicates = false) override;
         int enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates = false) override;
+        BlobFuture readFileAsync(const std::filesystem::path& name) override;
+        void prefetch(const std::vector<std::filesystem::path>& names) override;
+        uint64_t getFileVersion(const std::filesystem::path& name) override;
     };
 
     // A layer that represents some path in the underlying file system as an entire FS.
@@ -146,6 +318,9 @@ namespace donut::vfs
         bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
         int enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, enumerate_callback_t callback, bool allowDuplicates = false) override;
         int enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates = false) override;
+        BlobFuture readFileAsync(const std::filesystem::path& name) override;
+        void prefetch(const std::vector<std::filesystem::path>& names) override;
+        uint64_t getFileVersion(const std::filesystem::path& name) override;
     };
 
     // A virtual file system that allows mounting, or attaching, other VFS objects to paths.
@@ -167,6 +342,9 @@ namespace donut::vfs
         bool writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
         int enumerateFiles(const std::filesystem::path& path, const std::vector<std::string>& extensions, enumerate_callback_t callback, bool allowDuplicates = false) override;
         int enumerateDirectories(const std::filesystem::path& path, enumerate_callback_t callback, bool allowDuplicates = false) override;
+        BlobFuture readFileAsync(const std::filesystem::path& name) override;
+        void prefetch(const std::vector<std::filesystem::path>& names) override;
+        uint64_t getFileVersion(const std::filesystem::path& name) override;
     };
 
     std::string getFileSearchRegex(const std::filesystem::path& path, const std::vector<std::string>& extensions);
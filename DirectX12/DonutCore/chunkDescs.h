@@ -48,6 +48,16 @@ enum ChunkType : uint32_t
 
     CHUNKTYPE_MATERIALS     = 0x400,
     CHUNKTYPE_LIGHTS        = 0x500,
+
+    // cooked glTF models, see donut::engine::GltfImporter
+    CHUNKTYPE_COOKED_MODEL  = 0x600,
+    CHUNKTYPE_COOKED_STREAM,
+    CHUNKTYPE_COOKED_STRINGS,
+    CHUNKTYPE_COOKED_DEPENDENCIES,
+    CHUNKTYPE_COOKED_MESHES,
+    CHUNKTYPE_COOKED_GEOMETRIES,
+    CHUNKTYPE_COOKED_MATERIALS,
+    CHUNKTYPE_COOKED_NODES,
 };
 
 
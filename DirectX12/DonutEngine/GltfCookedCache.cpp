@@ -0,0 +1,833 @@
+/*
+* Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "pch.h"
+#include <cstring>
+#include <list>
+
+using namespace donut::math;
+using namespace donut::vfs;
+using namespace donut::engine;
+using namespace donut::chunk;
+
+// Cooked model files are ChunkFiles with the following chunks:
+//
+//   CHUNKTYPE_COOKED_MODEL         file version and content hash of the glTF file, buffer sizes
+//   CHUNKTYPE_COOKED_STRINGS       all names and paths, referenced by CookedString
+//   CHUNKTYPE_COOKED_DEPENDENCIES  external buffer files, their file versions and content hashes
+//   CHUNKTYPE_COOKED_STREAM        one chunk per non-empty BufferGroup stream
+//   CHUNKTYPE_COOKED_MESHES        MeshInfo table
+//   CHUNKTYPE_COOKED_GEOMETRIES    MeshGeometry table, referenced by range from the meshes
+//   CHUNKTYPE_COOKED_MATERIALS     Material table
+//   CHUNKTYPE_COOKED_NODES         scene graph nodes in depth-first order, parents before children
+//
+// The chunk data is not aligned in the file, so it is always copied out with memcpy.
+
+namespace
+{
+    struct CookedString
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    enum class CookedStream : uint32_t
+    {
+        Indices,
+        Positions,
+        Normals,
+        Tangents,
+        TexCoord1,
+        Joints,
+        Weights
+    };
+
+    enum class CookedTexture : uint32_t
+    {
+        BaseOrDiffuse,
+        MetalRoughOrSpecular,
+        Normal,
+        Emissive,
+        Occlusion,
+        Transmission,
+
+        Count
+    };
+
+    struct CookedModel_ChunkDesc_0x101
+    {
+        static constexpr uint32_t const version = 0x101;
+        static constexpr ChunkType const chunktype = CHUNKTYPE_COOKED_MODEL;
+
+        static constexpr uint32_t const FLAG_HAS_JOINTS = 1;
+
+        uint64_t fileVersion;
+        uint64_t contentHash;
+        uint64_t totalIndices;
+        uint64_t totalVertices;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    struct CookedStream_ChunkDesc_0x100
+    {
+        static constexpr uint32_t const version = 0x100;
+        static constexpr ChunkType const chunktype = CHUNKTYPE_COOKED_STREAM;
+
+        CookedStream stream;
+        uint32_t elemSize;
+        uint64_t elemCount;
+
+        // data starts here
+    };
+
+    struct CookedStrings_ChunkDesc_0x100
+    {
+        static constexpr uint32_t const version = 0x100;
+        static constexpr ChunkType const chunktype = CHUNKTYPE_COOKED_STRINGS;
+    };
+
+    struct CookedDependency
+    {
+        CookedString path;
+        uint64_t fileVersion;
+        uint64_t contentHash;
+    };
+
+    struct CookedMesh
+    {
+        CookedString name;
+        uint32_t indexOffset;
+        uint32_t vertexOffset;
+        uint32_t totalIndices;
+        uint32_t totalVertices;
+        uint32_t firstGeometry;
+        uint32_t numGeometries;
+        uint32_t isSkinPrototype;
+        uint32_t reserved;
+        box3 bounds;
+    };
+
+    struct CookedGeometry
+    {
+        int32_t materialIndex;  // -1 for geometries without a material
+        uint32_t indexOffsetInMesh;
+        uint32_t vertexOffsetInMesh;
+        uint32_t numIndices;
+        uint32_t numVertices;
+        box3 bounds;
+    };
+
+    struct CookedMaterial
+    {
+        CookedString name;
+        CookedString textures[size_t(CookedTexture::Count)];
+        int32_t materialIndexInModel;
+        uint32_t domain;
+        float3 baseOrDiffuseColor;
+        float3 specularColor;
+        float3 emissiveColor;
+        float emissiveIntensity;
+        float metalness;
+        float roughness;
+        float opacity;
+        float alphaCutoff;
+        float transmissionFactor;
+        float normalTextureScale;
+        float occlusionStrength;
+        uint32_t useSpecularGlossModel;
+        uint32_t doubleSided;
+    };
+
+    struct CookedNode
+    {
+        CookedString name;
+        int32_t parentIndex;    // -1 for the root
+        int32_t meshIndex;      // -1 for nodes without a mesh instance
+        uint32_t hasTransform;
+        uint32_t reserved;
+        double3 translation;
+        dquat rotation;
+        double3 scaling;
+    };
+
+    template<ChunkType Type>
+    struct CookedTable_ChunkDesc_0x100
+    {
+        static constexpr uint32_t const version = 0x100;
+        static constexpr ChunkType const chunktype = Type;
+
+        uint32_t count;
+        uint32_t elemSize;
+
+        // data starts here
+    };
+
+    typedef CookedTable_ChunkDesc_0x100<CHUNKTYPE_COOKED_DEPENDENCIES> CookedDependencies_ChunkDesc_0x100;
+    typedef CookedTable_ChunkDesc_0x100<CHUNKTYPE_COOKED_MESHES> CookedMeshes_ChunkDesc_0x100;
+    typedef CookedTable_ChunkDesc_0x100<CHUNKTYPE_COOKED_GEOMETRIES> CookedGeometries_ChunkDesc_0x100;
+    typedef CookedTable_ChunkDesc_0x100<CHUNKTYPE_COOKED_MATERIALS> CookedMaterials_ChunkDesc_0x100;
+    typedef CookedTable_ChunkDesc_0x100<CHUNKTYPE_COOKED_NODES> CookedNodes_ChunkDesc_0x100;
+
+    // Owns the data of the chunks until the ChunkFile is serialized.
+    class CookedChunkBuilder
+    {
+    public:
+        explicit CookedChunkBuilder(ChunkFile& file) : m_File(file) { }
+
+        CookedString addString(const std::string& s)
+        {
+            CookedString result = { uint32_t(m_Strings.size()), uint32_t(s.size()) };
+            m_Strings.insert(m_Strings.end(), s.begin(), s.end());
+            return result;
+        }
+
+        template<typename ChunkDesc>
+        void addChunk(const ChunkDesc& desc, const void* data = nullptr, size_t size = 0)
+        {
+            std::vector<uint8_t>& chunk = m_Chunks.emplace_back(sizeof(ChunkDesc) + size);
+            memcpy(chunk.data(), &desc, sizeof(ChunkDesc));
+            if (size)
+                memcpy(chunk.data() + sizeof(ChunkDesc), data, size);
+            m_File.addChunk<ChunkDesc>(chunk.data(), chunk.size());
+        }
+
+        template<typename ChunkDesc, typename T>
+        void addTable(const std::vector<T>& table)
+        {
+            ChunkDesc desc{};
+            desc.count = uint32_t(table.size());
+            desc.elemSize = uint32_t(sizeof(T));
+            addChunk(desc, table.data(), table.size() * sizeof(T));
+        }
+
+        template<typename T>
+        void addStream(CookedStream stream, const std::vector<T>& data)
+        {
+            if (data.empty())
+                return;
+
+            CookedStream_ChunkDesc_0x100 desc{};
+            desc.stream = stream;
+            desc.elemSize = uint32_t(sizeof(T));
+            desc.elemCount = data.size();
+            addChunk(desc, data.data(), data.size() * sizeof(T));
+        }
+
+        void addStrings()
+        {
+            // the ChunkFile reader rejects empty chunks
+            m_Strings.push_back(0);
+            addChunk(CookedStrings_ChunkDesc_0x100{}, m_Strings.data(), m_Strings.size());
+        }
+
+    private:
+        ChunkFile& m_File;
+        std::list<std::vector<uint8_t>> m_Chunks;
+        std::vector<char> m_Strings;
+    };
+
+    // Validated read access to the chunks of a cooked model file.
+    class CookedChunkReader
+    {
+    public:
+        explicit CookedChunkReader(const ChunkFile& file) : m_File(file) { }
+
+        template<typename ChunkDesc>
+        const Chunk* findChunk() const
+        {
+            std::vector<const Chunk*> chunks;
+            m_File.getChunks(ChunkDesc::chunktype, chunks);
+            if (chunks.size() != 1 || !m_File.validateChunk<ChunkDesc>(chunks[0]) || chunks[0]->size < sizeof(ChunkDesc))
+                return nullptr;
+            return chunks[0];
+        }
+
+        template<typename ChunkDesc>
+        bool readDesc(ChunkDesc& desc) const
+        {
+            const Chunk* chunk = findChunk<ChunkDesc>();
+            if (!chunk)
+                return false;
+            memcpy(&desc, chunk->data, sizeof(ChunkDesc));
+            return true;
+        }
+
+        template<typename ChunkDesc, typename T>
+        bool readTable(std::vector<T>& table) const
+        {
+            const Chunk* chunk = findChunk<ChunkDesc>();
+            if (!chunk)
+                return false;
+
+            ChunkDesc desc;
+            memcpy(&desc, chunk->data, sizeof(ChunkDesc));
+            if (desc.elemSize != sizeof(T) || chunk->size != sizeof(ChunkDesc) + size_t(desc.count) * sizeof(T))
+                return false;
+
+            table.resize(desc.count);
+            memcpy(table.data(), static_cast<const uint8_t*>(chunk->data) + sizeof(ChunkDesc), table.size() * sizeof(T));
+            return true;
+        }
+
+        bool readStrings()
+        {
+            const Chunk* chunk = findChunk<CookedStrings_ChunkDesc_0x100>();
+            if (!chunk)
+                return false;
+            m_Strings = static_cast<const char*>(chunk->data) + sizeof(CookedStrings_ChunkDesc_0x100);
+            m_StringsSize = chunk->size - sizeof(CookedStrings_ChunkDesc_0x100);
+            return true;
+        }
+
+        bool getString(const CookedString& s, std::string& result) const
+        {
+            if (size_t(s.offset) + s.length > m_StringsSize)
+                return false;
+            result.assign(m_Strings + s.offset, s.length);
+            return true;
+        }
+
+        // Copies the stream into 'data'. Missing streams leave 'data' empty.
+        template<typename T>
+        bool readStream(CookedStream stream, std::vector<T>& data) const
+        {
+            std::vector<const Chunk*> chunks;
+            m_File.getChunks(CHUNKTYPE_COOKED_STREAM, chunks);
+
+            for (const Chunk* chunk : chunks)
+            {
+                if (!m_File.validateChunk<CookedStream_ChunkDesc_0x100>(chunk) || chunk->size < sizeof(CookedStream_ChunkDesc_0x100))
+                    return false;
+
+                CookedStream_ChunkDesc_0x100 desc;
+                memcpy(&desc, chunk->data, sizeof(desc));
+                if (desc.stream != stream)
+                    continue;
+
+                // elemCount comes from the file, so compare it without multiplying it
+                const size_t dataSize = chunk->size - sizeof(desc);
+                if (desc.elemSize != sizeof(T) || dataSize % sizeof(T) != 0 || desc.elemCount != dataSize / sizeof(T))
+                    return false;
+
+                data.resize(desc.elemCount);
+                memcpy(data.data(), static_cast<const uint8_t*>(chunk->data) + sizeof(desc), data.size() * sizeof(T));
+                return true;
+            }
+
+            data.clear();
+            return true;
+        }
+
+    private:
+        const ChunkFile& m_File;
+        const char* m_Strings = nullptr;
+        size_t m_StringsSize = 0;
+    };
+
+    bool IsTextureSRGB(CookedTexture slot, bool useSpecularGlossModel)
+    {
+        switch (slot)
+        {
+        case CookedTexture::BaseOrDiffuse:
+        case CookedTexture::Emissive:
+            return true;
+        case CookedTexture::MetalRoughOrSpecular:
+            return useSpecularGlossModel;
+        default:
+            return false;
+        }
+    }
+
+    std::shared_ptr<LoadedTexture>* GetMaterialTexture(Material& material, CookedTexture slot)
+    {
+        switch (slot)
+        {
+        case CookedTexture::BaseOrDiffuse: return &material.baseOrDiffuseTexture;
+        case CookedTexture::MetalRoughOrSpecular: return &material.metalRoughOrSpecularTexture;
+        case CookedTexture::Normal: return &material.normalTexture;
+        case CookedTexture::Emissive: return &material.emissiveTexture;
+        case CookedTexture::Occlusion: return &material.occlusionTexture;
+        case CookedTexture::Transmission: return &material.transmissionTexture;
+        default: return nullptr;
+        }
+    }
+}
+
+std::filesystem::path GltfImporter::GetCookedFileName(const std::filesystem::path& fileName)
+{
+    std::filesystem::path cookedFileName = fileName;
+    cookedFileName += ".cooked";
+    return cookedFileName;
+}
+
+uint64_t GltfImporter::HashContent(const void* data, size_t size)
+{
+    // Four independent multiply-rotate lanes over 32-byte blocks, then the tail.
+    // The constants are the 64-bit primes used by xxHash.
+    constexpr uint64_t c_Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t c_Prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t c_Prime3 = 0x165667B19E3779F9ull;
+
+    auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto round = [rotl](uint64_t acc, uint64_t input) { return rotl(acc + input * c_Prime2, 31) * c_Prime1; };
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint8_t* end = bytes + size;
+
+    uint64_t lanes[4] = { c_Prime1 + c_Prime2, c_Prime2, 0, 0ull - c_Prime1 };
+
+    while (end - bytes >= 32)
+    {
+        for (uint64_t& lane : lanes)
+        {
+            uint64_t input;
+            memcpy(&input, bytes, sizeof(input));
+            lane = round(lane, input);
+            bytes += sizeof(input);
+        }
+    }
+
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    hash += uint64_t(size);
+
+    while (end - bytes >= 8)
+    {
+        uint64_t input;
+        memcpy(&input, bytes, sizeof(input));
+        hash = rotl(hash ^ round(0, input), 27) * c_Prime1 + c_Prime3;
+        bytes += sizeof(input);
+    }
+
+    while (bytes < end)
+    {
+        hash = rotl(hash ^ (*bytes * c_Prime1), 11) * c_Prime2;
+        ++bytes;
+    }
+
+    hash ^= hash >> 33;
+    hash *= c_Prime2;
+    hash ^= hash >> 29;
+    hash *= c_Prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+void GltfImporter::SaveCooked(const std::filesystem::path& fileName, const GltfCookedModel& model) const
+{
+    const BufferGroup& buffers = *model.buffers;
+
+    ChunkFile file;
+    CookedChunkBuilder builder(file);
+
+    std::unordered_map<const MeshInfo*, int32_t> meshIndices;
+    for (size_t mesh_idx = 0; mesh_idx < model.meshes.size(); mesh_idx++)
+        meshIndices[model.meshes[mesh_idx].get()] = int32_t(mesh_idx);
+
+    std::unordered_map<const Material*, int32_t> materialIndices;
+    for (size_t mat_idx = 0; mat_idx < model.materials.size(); mat_idx++)
+        materialIndices[model.materials[mat_idx].get()] = int32_t(mat_idx);
+
+    // nodes, depth first with the parents before the children
+    std::vector<CookedNode> nodes;
+    std::vector<std::pair<const SceneGraphNode*, int32_t>> stack = { { model.rootNode.get(), -1 } };
+    while (!stack.empty())
+    {
+        auto [src, parentIndex] = stack.back();
+        stack.pop_back();
+
+        CookedNode node{};
+        node.name = builder.addString(src->GetName());
+        node.parentIndex = parentIndex;
+        node.meshIndex = -1;
+        node.translation = src->GetTranslation();
+        node.rotation = src->GetRotation();
+        node.scaling = src->GetScaling();
+        node.hasTransform = any(node.translation != 0.0) || any(node.scaling != 1.0) || any(node.rotation != dquat::identity());
+
+        if (const auto& leaf = src->GetLeaf())
+        {
+            // only plain mesh instances are cooked, see the GltfImporter comment
+            const auto* meshInstance = dynamic_cast<const MeshInstance*>(leaf.get());
+            auto found = meshInstance ? meshIndices.find(meshInstance->GetMesh().get()) : meshIndices.end();
+            if (found == meshIndices.end() || dynamic_cast<const SkinnedMeshInstance*>(leaf.get()))
+            {
+                log::info("Not writing a cooked model file for '%s': node '%s' has a leaf that is not a plain mesh instance",
+                    fileName.generic_string().c_str(), src->GetName().c_str());
+                return;
+            }
+
+            node.meshIndex = found->second;
+        }
+
+        int32_t nodeIndex = int32_t(nodes.size());
+        nodes.push_back(node);
+
+        // push the children in reverse to keep their order
+        for (size_t child_idx = src->GetNumChildren(); child_idx > 0; child_idx--)
+            stack.push_back({ src->GetChild(child_idx - 1), nodeIndex });
+    }
+
+    std::vector<CookedMesh> meshes;
+    std::vector<CookedGeometry> geometries;
+    for (const auto& minfo : model.meshes)
+    {
+        CookedMesh mesh{};
+        mesh.name = builder.addString(minfo->name);
+        mesh.indexOffset = minfo->indexOffset;
+        mesh.vertexOffset = minfo->vertexOffset;
+        mesh.totalIndices = minfo->totalIndices;
+        mesh.totalVertices = minfo->totalVertices;
+        mesh.firstGeometry = uint32_t(geometries.size());
+        mesh.numGeometries = uint32_t(minfo->geometries.size());
+        mesh.isSkinPrototype = minfo->isSkinPrototype;
+        mesh.bounds = minfo->objectSpaceBounds;
+        meshes.push_back(mesh);
+
+        for (const auto& src : minfo->geometries)
+        {
+            CookedGeometry geometry{};
+            auto found = materialIndices.find(src->material.get());
+            geometry.materialIndex = (found != materialIndices.end()) ? found->second : -1;
+            geometry.indexOffsetInMesh = src->indexOffsetInMesh;
+            geometry.vertexOffsetInMesh = src->vertexOffsetInMesh;
+            geometry.numIndices = src->numIndices;
+            geometry.numVertices = src->numVertices;
+            geometry.bounds = src->objectSpaceBounds;
+            geometries.push_back(geometry);
+        }
+    }
+
+    std::vector<CookedMaterial> materials;
+    for (const auto& src : model.materials)
+    {
+        CookedMaterial material{};
+        material.name = builder.addString(src->name);
+        for (uint32_t slot = 0; slot < uint32_t(CookedTexture::Count); slot++)
+        {
+            const auto& texture = *GetMaterialTexture(*src, CookedTexture(slot));
+            material.textures[slot] = builder.addString(texture ? texture->path : std::string());
+        }
+        material.materialIndexInModel = src->materialIndexInModel;
+        material.domain = uint32_t(src->domain);
+        material.baseOrDiffuseColor = src->baseOrDiffuseColor;
+        material.specularColor = src->specularColor;
+        material.emissiveColor = src->emissiveColor;
+        material.emissiveIntensity = src->emissiveIntensity;
+        material.metalness = src->metalness;
+        material.roughness = src->roughness;
+        material.opacity = src->opacity;
+        material.alphaCutoff = src->alphaCutoff;
+        material.transmissionFactor = src->transmissionFactor;
+        material.normalTextureScale = src->normalTextureScale;
+        material.occlusionStrength = src->occlusionStrength;
+        material.useSpecularGlossModel = src->useSpecularGlossModel;
+        material.doubleSided = src->doubleSided;
+        materials.push_back(material);
+    }
+
+    std::vector<CookedDependency> dependencies;
+    for (const auto& dependency : model.dependencies)
+        dependencies.push_back({ builder.addString(dependency.path), dependency.fileVersion, dependency.contentHash });
+
+    CookedModel_ChunkDesc_0x101 header{};
+    header.fileVersion = model.fileVersion;
+    header.contentHash = model.contentHash;
+    header.totalIndices = buffers.indexData.size();
+    header.totalVertices = buffers.positionData.size();
+    header.flags = buffers.jointData.empty() ? 0 : CookedModel_ChunkDesc_0x101::FLAG_HAS_JOINTS;
+
+    builder.addChunk(header);
+    builder.addTable<CookedDependencies_ChunkDesc_0x100>(dependencies);
+    builder.addStream(CookedStream::Indices, buffers.indexData);
+    builder.addStream(CookedStream::Positions, buffers.positionData);
+    builder.addStream(CookedStream::Normals, buffers.normalData);
+    builder.addStream(CookedStream::Tangents, buffers.tangentData);
+    builder.addStream(CookedStream::TexCoord1, buffers.texcoord1Data);
+    builder.addStream(CookedStream::Joints, buffers.jointData);
+    builder.addStream(CookedStream::Weights, buffers.weightData);
+    builder.addTable<CookedMeshes_ChunkDesc_0x100>(meshes);
+    builder.addTable<CookedGeometries_ChunkDesc_0x100>(geometries);
+    builder.addTable<CookedMaterials_ChunkDesc_0x100>(materials);
+    builder.addTable<CookedNodes_ChunkDesc_0x100>(nodes);
+    builder.addStrings();
+
+    std::filesystem::path cookedFileName = GetCookedFileName(fileName);
+
+    auto blob = file.serialize();
+    if (!blob || !m_fs->writeFile(cookedFileName, blob->data(), blob->size()))
+        log::info("Couldn't write the cooked model file '%s'", cookedFileName.generic_string().c_str());
+}
+
+bool GltfImporter::LoadCooked(
+    const std::filesystem::path& fileName,
+    TextureCache& textureCache,
+    tf::Executor* executor,
+    SceneImportResult& result) const
+{
+    std::filesystem::path cookedFileName = GetCookedFileName(fileName);
+    std::string cookedFileNameString = cookedFileName.generic_string();
+
+    std::shared_ptr<IBlob> blob = m_fs->readFile(cookedFileName);
+    if (!blob)
+        return false;
+
+    auto file = ChunkFile::deserialize(blob, cookedFileNameString.c_str());
+    if (!file)
+        return false;
+
+    CookedChunkReader reader(*file);
+
+    CookedModel_ChunkDesc_0x101 header;
+    if (!reader.readDesc(header))
+        return false;
+
+    std::vector<CookedDependency> dependencies;
+    std::vector<CookedMesh> meshes;
+    std::vector<CookedGeometry> geometries;
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedNode> nodes;
+
+    if (!reader.readStrings() ||
+        !reader.readTable<CookedDependencies_ChunkDesc_0x100>(dependencies) ||
+        !reader.readTable<CookedMeshes_ChunkDesc_0x100>(meshes) ||
+        !reader.readTable<CookedGeometries_ChunkDesc_0x100>(geometries) ||
+        !reader.readTable<CookedMaterials_ChunkDesc_0x100>(materials) ||
+        !reader.readTable<CookedNodes_ChunkDesc_0x100>(nodes) ||
+        nodes.empty())
+    {
+        log::warning("Cooked model file '%s' is malformed, ignoring it", cookedFileNameString.c_str());
+        return false;
+    }
+
+    // The glTF file and the external buffers must be unchanged. Files with the same version are not read,
+    // the others are compared by content, because the version also changes when a file is only touched.
+    {
+        std::vector<std::filesystem::path> changedPaths;
+        std::vector<uint64_t> changedHashes;
+
+        auto checkVersion = [this, &changedPaths, &changedHashes](const std::filesystem::path& path, uint64_t fileVersion, uint64_t contentHash)
+        {
+            uint64_t currentVersion = m_fs->getFileVersion(path);
+            if (currentVersion == 0 || currentVersion != fileVersion)
+            {
+                changedPaths.push_back(path);
+                changedHashes.push_back(contentHash);
+            }
+        };
+
+        checkVersion(fileName.lexically_normal(), header.fileVersion, header.contentHash);
+
+        for (const CookedDependency& dependency : dependencies)
+        {
+            std::string path;
+            if (!reader.getString(dependency.path, path))
+            {
+                log::warning("Cooked model file '%s' is malformed, ignoring it", cookedFileNameString.c_str());
+                return false;
+            }
+            checkVersion(path, dependency.fileVersion, dependency.contentHash);
+        }
+
+        if (changedPaths.size() > 1)
+            m_fs->prefetch(changedPaths);
+
+        for (size_t path_idx = 0; path_idx < changedPaths.size(); path_idx++)
+        {
+            std::shared_ptr<IBlob> source = m_fs->readFile(changedPaths[path_idx]);
+            if (!source || HashContent(source->data(), source->size()) != changedHashes[path_idx])
+                return false; // stale, a source file has changed
+        }
+    }
+
+    auto buffers = std::make_shared<BufferGroup>();
+    if (!reader.readStream(CookedStream::Indices, buffers->indexData) ||
+        !reader.readStream(CookedStream::Positions, buffers->positionData) ||
+        !reader.readStream(CookedStream::Normals, buffers->normalData) ||
+        !reader.readStream(CookedStream::Tangents, buffers->tangentData) ||
+        !reader.readStream(CookedStream::TexCoord1, buffers->texcoord1Data) ||
+        !reader.readStream(CookedStream::Joints, buffers->jointData) ||
+        !reader.readStream(CookedStream::Weights, buffers->weightData) ||
+        buffers->indexData.size() != header.totalIndices ||
+        buffers->positionData.size() != header.totalVertices)
+    {
+        log::warning("Cooked model file '%s' has invalid buffers, ignoring it", cookedFileNameString.c_str());
+        return false;
+    }
+
+    std::string normalizedFileName = fileName.lexically_normal().generic_string();
+    bool valid = true;
+    auto getString = [&reader, &valid](const CookedString& s)
+    {
+        std::string result;
+        valid = reader.getString(s, result) && valid;
+        return result;
+    };
+
+    // the textures are loaded only after the whole file has been validated
+    struct TextureRequest
+    {
+        std::shared_ptr<LoadedTexture>* texture;
+        std::string path;
+        bool sRGB;
+    };
+    std::vector<TextureRequest> textureRequests;
+
+    std::vector<std::shared_ptr<Material>> materialList;
+    for (const CookedMaterial& src : materials)
+    {
+        std::shared_ptr<Material> matinfo = m_SceneTypeFactory->CreateMaterial();
+        matinfo->name = getString(src.name);
+        matinfo->modelFileName = normalizedFileName;
+        matinfo->materialIndexInModel = src.materialIndexInModel;
+        matinfo->domain = MaterialDomain(src.domain);
+        matinfo->baseOrDiffuseColor = src.baseOrDiffuseColor;
+        matinfo->specularColor = src.specularColor;
+        matinfo->emissiveColor = src.emissiveColor;
+        matinfo->emissiveIntensity = src.emissiveIntensity;
+        matinfo->metalness = src.metalness;
+        matinfo->roughness = src.roughness;
+        matinfo->opacity = src.opacity;
+        matinfo->alphaCutoff = src.alphaCutoff;
+        matinfo->transmissionFactor = src.transmissionFactor;
+        matinfo->normalTextureScale = src.normalTextureScale;
+        matinfo->occlusionStrength = src.occlusionStrength;
+        matinfo->useSpecularGlossModel = src.useSpecularGlossModel != 0;
+        matinfo->doubleSided = src.doubleSided != 0;
+
+        for (uint32_t slot = 0; slot < uint32_t(CookedTexture::Count); slot++)
+        {
+            std::string path = getString(src.textures[slot]);
+            if (path.empty())
+                continue;
+
+            bool sRGB = IsTextureSRGB(CookedTexture(slot), matinfo->useSpecularGlossModel);
+            textureRequests.push_back({ GetMaterialTexture(*matinfo, CookedTexture(slot)), std::move(path), sRGB });
+        }
+
+        materialList.push_back(matinfo);
+    }
+
+    std::shared_ptr<Material> emptyMaterial;
+    std::vector<std::shared_ptr<MeshInfo>> meshList;
+    for (const CookedMesh& src : meshes)
+    {
+        if (size_t(src.firstGeometry) + src.numGeometries > geometries.size() ||
+            size_t(src.indexOffset) + src.totalIndices > buffers->indexData.size() ||
+            size_t(src.vertexOffset) + src.totalVertices > buffers->positionData.size())
+        {
+            valid = false;
+            break;
+        }
+
+        std::shared_ptr<MeshInfo> minfo = m_SceneTypeFactory->CreateMesh();
+        minfo->name = getString(src.name);
+        minfo->buffers = buffers;
+        minfo->indexOffset = src.indexOffset;
+        minfo->vertexOffset = src.vertexOffset;
+        minfo->totalIndices = src.totalIndices;
+        minfo->totalVertices = src.totalVertices;
+        minfo->isSkinPrototype = src.isSkinPrototype != 0;
+        minfo->objectSpaceBounds = src.bounds;
+
+        for (uint32_t geom_idx = 0; geom_idx < src.numGeometries; geom_idx++)
+        {
+            const CookedGeometry& srcGeometry = geometries[src.firstGeometry + geom_idx];
+
+            auto geometry = m_SceneTypeFactory->CreateMeshGeometry();
+            if (srcGeometry.materialIndex >= 0 && size_t(srcGeometry.materialIndex) < materialList.size())
+            {
+                geometry->material = materialList[srcGeometry.materialIndex];
+            }
+            else
+            {
+                if (!emptyMaterial)
+                {
+                    emptyMaterial = std::make_shared<Material>();
+                    emptyMaterial->name = "(empty)";
+                }
+                geometry->material = emptyMaterial;
+            }
+            geometry->indexOffsetInMesh = srcGeometry.indexOffsetInMesh;
+            geometry->vertexOffsetInMesh = srcGeometry.vertexOffsetInMesh;
+            geometry->numIndices = srcGeometry.numIndices;
+            geometry->numVertices = srcGeometry.numVertices;
+            geometry->objectSpaceBounds = srcGeometry.bounds;
+            minfo->geometries.push_back(geometry);
+        }
+
+        meshList.push_back(minfo);
+    }
+
+    std::shared_ptr<SceneGraph> graph = std::make_shared<SceneGraph>();
+    std::vector<std::shared_ptr<SceneGraphNode>> nodeList;
+    nodeList.reserve(nodes.size());
+
+    for (size_t node_idx = 0; node_idx < nodes.size() && valid; node_idx++)
+    {
+        const CookedNode& src = nodes[node_idx];
+
+        // the root has no parent, and every other node comes after its parent
+        if ((node_idx == 0) != (src.parentIndex < 0) || (src.parentIndex >= 0 && size_t(src.parentIndex) >= node_idx) ||
+            (src.meshIndex >= 0 && size_t(src.meshIndex) >= meshList.size()))
+        {
+            valid = false;
+            break;
+        }
+
+        auto dst = std::make_shared<SceneGraphNode>();
+        dst->SetName(getString(src.name));
+
+        if (src.hasTransform)
+            dst->SetTransform(&src.translation, &src.rotation, &src.scaling);
+
+        if (src.parentIndex >= 0)
+            graph->Attach(nodeList[src.parentIndex], dst);
+
+        if (src.meshIndex >= 0)
+            dst->SetLeaf(m_SceneTypeFactory->CreateMeshInstance(meshList[src.meshIndex]));
+
+        nodeList.push_back(dst);
+    }
+
+    if (!valid)
+    {
+        log::warning("Cooked model file '%s' is malformed, ignoring it", cookedFileNameString.c_str());
+        return false;
+    }
+
+    for (TextureRequest& request : textureRequests)
+    {
+#ifdef DONUT_WITH_TASKFLOW
+        if (executor)
+            *request.texture = textureCache.LoadTextureFromFileAsync(request.path, request.sRGB, *executor);
+        else
+#endif
+            *request.texture = textureCache.LoadTextureFromFileDeferred(request.path, request.sRGB);
+    }
+    (void)executor;
+
+    result.rootNode = nodeList[0];
+    return true;
+}
@@ -21,6 +21,7 @@
 */
 
 #include "pch.h"
+#include <numeric>
 
 using namespace donut::math;
 using namespace donut::vfs;
@@ -66,6 +67,7 @@ struct cgltf_vfs_context
 {
     std::shared_ptr<donut::vfs::IFileSystem> fs;
     std::vector<std::shared_ptr<IBlob>> blobs;
+    std::vector<std::string> paths; // parallel to blobs, empty for the model file itself
 };
 
 static cgltf_result cgltf_read_file_vfs(const struct cgltf_memory_options* memory_options,
@@ -79,6 +81,7 @@ static cgltf_result cgltf_read_file_vfs(const struct cgltf_memory_options* memor
         return cgltf_result_file_not_found;
 
     context->blobs.push_back(blob);
+    context->paths.push_back(path);
 
     if (size) *size = blob->size();
     if (data) *data = (void*)blob->data();  // NOLINT(clang-diagnostic-cast-qual)
@@ -199,6 +202,418 @@ static std::pair<const uint8_t*, size_t> cgltf_buffer_iterator(const cgltf_acces
     return std::make_pair(data, stride);
 }
 
+// Accessors and destination ranges of one triangle primitive, gathered before the vertex data is decoded.
+struct GltfPrimitiveDecodeJob
+{
+    const cgltf_primitive* prim = nullptr;
+    const cgltf_accessor* positions = nullptr;
+    const cgltf_accessor* normals = nullptr;
+    const cgltf_accessor* tangents = nullptr;
+    const cgltf_accessor* texcoords = nullptr;
+    const cgltf_accessor* joint_weights = nullptr;
+    const cgltf_accessor* joint_indices = nullptr;
+    size_t indexOffset = 0;
+    size_t vertexOffset = 0;
+    size_t indexCount = 0;
+    MeshGeometry* geometry = nullptr;
+};
+
+template<typename T>
+static void cgltf_copy_indices(const uint8_t* src, size_t stride, size_t count, uint32_t* dst)
+{
+    if (!stride) stride = sizeof(T);
+
+    if (stride == sizeof(T))
+    {
+        // Tightly packed indices: a plain widening loop that the compiler vectorizes.
+        if constexpr (std::is_same_v<T, uint32_t>)
+        {
+            memcpy(dst, src, count * sizeof(uint32_t));
+        }
+        else
+        {
+            const T* typedSrc = (const T*)src;
+            for (size_t i_idx = 0; i_idx < count; i_idx++)
+                dst[i_idx] = typedSrc[i_idx];
+        }
+        return;
+    }
+
+    for (size_t i_idx = 0; i_idx < count; i_idx++)
+    {
+        *dst = *(const T*)src;
+
+        src += stride;
+        dst++;
+    }
+}
+
+// Decodes the indices and vertex attributes of one primitive into its precomputed ranges of the buffer group.
+// Primitives write disjoint ranges, so any number of them can be decoded concurrently.
+static void DecodeGltfPrimitive(const GltfPrimitiveDecodeJob& job, BufferGroup& buffers, bool forceRebuildTangents)
+{
+    const cgltf_primitive& prim = *job.prim;
+    const cgltf_accessor* positions = job.positions;
+    const cgltf_accessor* normals = job.normals;
+    const cgltf_accessor* tangents = job.tangents;
+    const cgltf_accessor* texcoords = job.texcoords;
+    const cgltf_accessor* joint_weights = job.joint_weights;
+    const cgltf_accessor* joint_indices = job.joint_indices;
+    const size_t vertexCount = positions->count;
+    const size_t indexCount = job.indexCount;
+
+    uint32_t* const indexData = buffers.indexData.data() + job.indexOffset;
+
+    if (prim.indices)
+    {
+        // copy the indices
+        auto [indexSrc, indexStride] = cgltf_buffer_iterator(prim.indices, 0);
+
+        switch(prim.indices->component_type)
+        {
+        case cgltf_component_type_r_8u:
+            cgltf_copy_indices<uint8_t>(indexSrc, indexStride, indexCount, indexData);
+            break;
+        case cgltf_component_type_r_16u:
+            cgltf_copy_indices<uint16_t>(indexSrc, indexStride, indexCount, indexData);
+            break;
+        case cgltf_component_type_r_32u:
+            cgltf_copy_indices<uint32_t>(indexSrc, indexStride, indexCount, indexData);
+            break;
+        default: 
+            assert(false);
+        }
+    }
+    else
+    {
+        // generate the indices
+        std::iota(indexData, indexData + indexCount, 0u);
+    }
+
+    float3* const positionData = buffers.positionData.data() + job.vertexOffset;
+
+    {
+        auto [positionSrc, positionStride] = cgltf_buffer_iterator(positions, sizeof(float) * 3);
+
+        if (positionStride == sizeof(float3))
+        {
+            memcpy(positionData, positionSrc, vertexCount * sizeof(float3));
+        }
+        else
+        {
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                positionData[v_idx] = (const float*)positionSrc;
+                positionSrc += positionStride;
+            }
+        }
+
+        dm::box3 bounds = dm::box3::empty();
+        if (vertexCount > 0)
+        {
+            float3 mins = positionData[0];
+            float3 maxs = positionData[0];
+            for (size_t v_idx = 1; v_idx < vertexCount; v_idx++)
+            {
+                mins = min(mins, positionData[v_idx]);
+                maxs = max(maxs, positionData[v_idx]);
+            }
+            bounds = dm::box3(mins, maxs);
+        }
+        job.geometry->objectSpaceBounds = bounds;
+    }
+
+    if (normals)
+    {
+        assert(normals->count == vertexCount);
+
+        auto [normalSrc, normalStride] = cgltf_buffer_iterator(normals, sizeof(float) * 3);
+        uint32_t* normalDst = buffers.normalData.data() + job.vertexOffset;
+
+        for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+        {
+            float3 normal = (const float*)normalSrc;
+            *normalDst = vectorToSnorm8(normal);
+
+            normalSrc += normalStride;
+            ++normalDst;
+        }
+    }
+
+    if (tangents)
+    {
+        assert(tangents->count == vertexCount);
+
+        auto [tangentSrc, tangentStride] = cgltf_buffer_iterator(tangents, sizeof(float) * 4);
+        uint32_t* tangentDst = buffers.tangentData.data() + job.vertexOffset;
+        
+        for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+        {
+            float4 tangent = (const float*)tangentSrc;
+            *tangentDst = vectorToSnorm8(tangent);
+
+            tangentSrc += tangentStride;
+            ++tangentDst;
+        }
+    }
+
+    float2* const texcoordData = buffers.texcoord1Data.data() + job.vertexOffset;
+
+    if (texcoords)
+    {
+        assert(texcoords->count == vertexCount);
+
+        auto [texcoordSrc, texcoordStride] = cgltf_buffer_iterator(texcoords, sizeof(float) * 2);
+
+        if (texcoordStride == sizeof(float2))
+        {
+            memcpy(texcoordData, texcoordSrc, vertexCount * sizeof(float2));
+        }
+        else
+        {
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                texcoordData[v_idx] = (const float*)texcoordSrc;
+                texcoordSrc += texcoordStride;
+            }
+        }
+    }
+    else
+    {
+        std::fill(texcoordData, texcoordData + vertexCount, float2(0.f));
+    }
+
+    if (normals && texcoords && (!tangents || forceRebuildTangents))
+    {
+        // The positions and texture coordinates have been decoded above, read them from the buffer group.
+        auto [normalSrc, normalStride] = cgltf_buffer_iterator(normals, sizeof(float) * 3);
+        const uint32_t* indexSrc = indexData;
+
+        std::vector<float3> computedTangents(vertexCount, float3(0.f));
+        std::vector<float3> computedBitangents(vertexCount, float3(0.f));
+
+        for (size_t t_idx = 0; t_idx < indexCount / 3; t_idx++)
+        {
+            uint3 tri = indexSrc;
+            indexSrc += 3;
+
+            float3 p0 = positionData[tri.x];
+            float3 p1 = positionData[tri.y];
+            float3 p2 = positionData[tri.z];
+
+            float2 t0 = texcoordData[tri.x];
+            float2 t1 = texcoordData[tri.y];
+            float2 t2 = texcoordData[tri.z];
+
+            float3 dPds = p1 - p0;
+            float3 dPdt = p2 - p0;
+
+            float2 dTds = t1 - t0;
+            float2 dTdt = t2 - t0;
+            float r = 1.0f / (dTds.x * dTdt.y - dTds.y * dTdt.x);
+            float3 tangent = r * (dPds * dTdt.y - dPdt * dTds.y);
+            float3 bitangent = r * (dPdt * dTds.x - dPds * dTdt.x);
+
+            float tangentLength = length(tangent);
+            float bitangentLength = length(bitangent);
+            if (tangentLength > 0 && bitangentLength > 0)
+            {
+                tangent /= tangentLength;
+                bitangent /= bitangentLength;
+
+                computedTangents[tri.x] += tangent;
+                computedTangents[tri.y] += tangent;
+                computedTangents[tri.z] += tangent;
+                computedBitangents[tri.x] += bitangent;
+                computedBitangents[tri.y] += bitangent;
+                computedBitangents[tri.z] += bitangent;
+            }
+        }
+
+        // With forceRebuildTangents the rebuilt tangents are also written back into the source accessor, which is
+        // saved by GltfImporter::Load. The accessor can be shared by several primitives, so the decoding is serial then.
+        uint8_t* tangentSrc = nullptr;
+        size_t tangentStride = 0;
+        if (forceRebuildTangents && tangents)
+        {
+            auto pair = cgltf_buffer_iterator(tangents, sizeof(float) * 4);
+            tangentSrc = const_cast<uint8_t*>(pair.first);
+            tangentStride = pair.second;
+        }
+
+        uint32_t* tangentDst = buffers.tangentData.data() + job.vertexOffset;
+
+        for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+        {
+            float3 normal = (const float*)normalSrc;
+            float3 tangent = computedTangents[v_idx];
+            float3 bitangent = computedBitangents[v_idx];
+
+            float sign = 0;
+            float tangentLength = length(tangent);
+            float bitangentLength = length(bitangent);
+            if (tangentLength > 0 && bitangentLength > 0)
+            {
+                tangent /= tangentLength;
+                bitangent /= bitangentLength;
+                float3 cross_b = cross(normal, tangent);
+                sign = (dot(cross_b, bitangent) > 0) ? -1.f : 1.f;
+            }
+
+            *tangentDst = vectorToSnorm8(float4(tangent, sign));
+
+            if (tangentSrc)
+            {
+                *(float4*)tangentSrc = float4(tangent, sign);
+                tangentSrc += tangentStride;
+            }
+
+            normalSrc += normalStride;
+            ++tangentDst;
+        }
+    }
+
+    if (joint_indices)
+    {
+        assert(joint_indices->count == vertexCount);
+
+        auto [jointSrc, jointStride] = cgltf_buffer_iterator(joint_indices, 0);
+        vector<uint16_t, 4>* jointDst = buffers.jointData.data() + job.vertexOffset;
+
+        if (joint_indices->component_type == cgltf_component_type_r_8u)
+        {
+            if (!jointStride) jointStride = sizeof(uint8_t) * 4;
+
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                *jointDst = dm::vector<uint16_t, 4>(jointSrc[0], jointSrc[1], jointSrc[2], jointSrc[3]);
+
+                jointSrc += jointStride;
+                ++jointDst;
+            }
+        }
+        else
+        {
+            assert(joint_indices->component_type == cgltf_component_type_r_16u);
+
+            if (!jointStride) jointStride = sizeof(uint16_t) * 4;
+
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                const uint16_t* jointSrcUshort = (const uint16_t*)jointSrc;
+                *jointDst = dm::vector<uint16_t, 4>(jointSrcUshort[0], jointSrcUshort[1], jointSrcUshort[2], jointSrcUshort[3]);
+
+                jointSrc += jointStride;
+                ++jointDst;
+            }
+        }
+    }
+
+    if (joint_weights)
+    {
+        assert(joint_weights->count == vertexCount);
+
+        auto [weightSrc, weightStride] = cgltf_buffer_iterator(joint_weights, 0);
+        float4* weightDst = buffers.weightData.data() + job.vertexOffset;
+
+        if (joint_weights->component_type == cgltf_component_type_r_8u)
+        {
+            if (!weightStride) weightStride = sizeof(uint8_t) * 4;
+
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                *weightDst = dm::float4(
+                    float(weightSrc[0]) / 255.f,
+                    float(weightSrc[1]) / 255.f,
+                    float(weightSrc[2]) / 255.f,
+                    float(weightSrc[3]) / 255.f);
+
+                weightSrc += weightStride;
+                ++weightDst;
+            }
+        }
+        else if (joint_weights->component_type == cgltf_component_type_r_16u)
+        {
+            if (!weightStride) weightStride = sizeof(uint16_t) * 4;
+
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                const uint16_t* weightSrcUshort = (const uint16_t*)weightSrc;
+                *weightDst = dm::float4(
+                    float(weightSrcUshort[0]) / 65535.f,
+                    float(weightSrcUshort[1]) / 65535.f,
+                    float(weightSrcUshort[2]) / 65535.f,
+                    float(weightSrcUshort[3]) / 65535.f);
+                
+                weightSrc += weightStride;
+                ++weightDst;
+            }
+        }
+        else
+        {
+            assert(joint_weights->component_type == cgltf_component_type_r_32f);
+
+            if (!weightStride) weightStride = sizeof(float) * 4;
+
+            for (size_t v_idx = 0; v_idx < vertexCount; v_idx++)
+            {
+                *weightDst = (const float*)weightSrc;
+
+                weightSrc += weightStride;
+                ++weightDst;
+            }
+        }
+    }
+}
+
+// Decodes all primitives of a model. Large models are decoded in parallel, on the executor if there is one,
+// or on the shared ThreadPool otherwise. The largest primitives are started first to balance the load.
+// Rebuilding tangents writes into the source accessors, which primitives can share, so it is always serial.
+static void DecodeGltfPrimitives(const std::vector<GltfPrimitiveDecodeJob>& jobs, BufferGroup& buffers,
+    bool forceRebuildTangents, size_t totalVertices, tf::Executor* executor)
+{
+    // Below this size, starting the workers costs more than the decoding.
+    constexpr size_t c_MinVerticesForParallelDecode = 65536;
+
+    if (forceRebuildTangents || jobs.size() < 2 || totalVertices < c_MinVerticesForParallelDecode)
+    {
+        for (const auto& job : jobs)
+            DecodeGltfPrimitive(job, buffers, forceRebuildTangents);
+        return;
+    }
+
+    std::vector<size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&jobs](size_t a, size_t b)
+    {
+        return jobs[a].indexCount + jobs[a].positions->count > jobs[b].indexCount + jobs[b].positions->count;
+    });
+
+    auto decode = [&jobs, &order, &buffers, forceRebuildTangents](size_t index)
+    {
+        DecodeGltfPrimitive(jobs[order[index]], buffers, forceRebuildTangents);
+    };
+
+#ifdef DONUT_WITH_TASKFLOW
+    if (executor)
+    {
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t(0), jobs.size(), size_t(1), decode);
+
+        // Models are usually loaded on an executor worker: help with the work instead of blocking the worker.
+        if (executor->this_worker_id() >= 0)
+            executor->corun(taskflow);
+        else
+            executor->run(taskflow).wait();
+        return;
+    }
+#else
+    (void)executor;
+#endif
+
+    donut::ThreadPool::get().parallelFor(jobs.size(), decode);
+}
+
 bool GltfImporter::Load(
     const std::filesystem::path& fileName,
     TextureCache& textureCache,
@@ -226,14 +641,53 @@ bool GltfImporter::Load(
 
     std::string normalizedFileName = fileName.lexically_normal().generic_string();
 
+    if (m_CookedCacheEnabled && LoadCooked(fileName, textureCache, executor, result))
+        return true;
+
+    // Query the version before reading, so that a change during the import makes the cooked file stale.
+    const uint64_t fileVersion = m_CookedCacheEnabled ? m_fs->getFileVersion(normalizedFileName) : 0;
+
+    std::shared_ptr<IBlob> modelBlob = m_fs->readFile(normalizedFileName);
+    if (!modelBlob)
+    {
+        log::error("Couldn't load glTF file '%s': %s", normalizedFileName.c_str(), cgltf_error_to_string(cgltf_result_file_not_found));
+        return false;
+    }
+
+    // The model blob must stay alive until the import is complete: GLB buffers and images point into it.
+    vfsContext.blobs.push_back(modelBlob);
+    vfsContext.paths.emplace_back();
+
     cgltf_data* objects = nullptr;
-    cgltf_result res = cgltf_parse_file(&options, normalizedFileName.c_str(), &objects);
+    cgltf_result res = cgltf_parse(&options, modelBlob->data(), modelBlob->size(), &objects);
     if (res != cgltf_result_success)
     {
         log::error("Couldn't load glTF file '%s': %s", normalizedFileName.c_str(), cgltf_error_to_string(res));
         return false;
     }
 
+    // Start reading the external buffers and images while the buffers are loaded and the materials are processed.
+    {
+        std::vector<std::filesystem::path> dependencies;
+        auto addDependency = [&dependencies, &fileName](const char* uri)
+        {
+            if (!uri || strncmp(uri, "data:", 5) == 0 || strstr(uri, "://"))
+                return;
+
+            std::string decodedUri = uri;
+            cgltf_decode_uri(decodedUri.data());
+            dependencies.push_back(fileName.parent_path() / decodedUri.c_str());
+        };
+
+        for (size_t i = 0; i < objects->buffers_count; i++)
+            addDependency(objects->buffers[i].uri);
+        for (size_t i = 0; i < objects->images_count; i++)
+            addDependency(objects->images[i].uri);
+
+        if (!dependencies.empty())
+            m_fs->prefetch(dependencies);
+    }
+
     res = cgltf_load_buffers(&options, objects, normalizedFileName.c_str());
     if (res != cgltf_result_success)
     {
@@ -243,7 +697,10 @@ bool GltfImporter::Load(
 
     std::unordered_map<const cgltf_image*, std::shared_ptr<LoadedTexture>> textures;
 
-    auto load_texture = [this, &textures, &textureCache, executor, &fileName, objects, &vfsContext, c_SearchForDds](const cgltf_texture* texture, bool sRGB)
+    // Embedded images cannot be loaded from a cooked model.
+    bool hasEmbeddedImages = false;
+
+    auto load_texture = [this, &textures, &textureCache, executor, &fileName, objects, &vfsContext, &hasEmbeddedImages, c_SearchForDds](const cgltf_texture* texture, bool sRGB)
     {
         if (!texture)
             return std::shared_ptr<LoadedTexture>(nullptr);
@@ -266,6 +723,7 @@ bool GltfImporter::Load(
         if (activeImage->buffer_view)
         {
             // If the image has inline data, like coming from a GLB container, use that.
+            hasEmbeddedImages = true;
 
             const uint8_t* dataPtr = static_cast<const uint8_t*>(activeImage->buffer_view->buffer->data) + activeImage->buffer_view->offset;
             const size_t dataSize = activeImage->buffer_view->size;
@@ -470,11 +928,11 @@ bool GltfImporter::Load(
 
     std::unordered_map<const cgltf_mesh*, std::shared_ptr<MeshInfo>> meshMap;
 
-    std::vector<float3> computedTangents;
-    std::vector<float3> computedBitangents;
     std::vector<std::shared_ptr<MeshInfo>> meshes;
+    std::vector<GltfPrimitiveDecodeJob> decodeJobs;
     std::shared_ptr<Material> emptyMaterial;
 
+    // Lay out all primitives in the buffer group first, then decode them independently.
     for (size_t mesh_idx = 0; mesh_idx < objects->meshes_count; mesh_idx++)
     {
         const cgltf_mesh& mesh = objects->meshes[mesh_idx];
@@ -504,12 +962,8 @@ bool GltfImporter::Load(
                 assert(prim.indices->type == cgltf_type_scalar);
             }
 
-            const cgltf_accessor* positions = nullptr;
-            const cgltf_accessor* normals = nullptr;
-            const cgltf_accessor* tangents = nullptr;
-            const cgltf_accessor* texcoords = nullptr;
-            const cgltf_accessor* joint_weights = nullptr;
-            const cgltf_accessor* joint_indices = nullptr;
+            GltfPrimitiveDecodeJob job;
+            job.prim = &prim;
             
             for (size_t attr_idx = 0; attr_idx < prim.attributes_count; attr_idx++)
             {
@@ -520,365 +974,47 @@ bool GltfImporter::Load(
                 case cgltf_attribute_type_position:
                     assert(attr.data->type == cgltf_type_vec3);
                     assert(attr.data->component_type == cgltf_component_type_r_32f);
-                    positions = attr.data;
+                    job.positions = attr.data;
                     break;
                 case cgltf_attribute_type_normal:
                     assert(attr.data->type == cgltf_type_vec3);
                     assert(attr.data->component_type == cgltf_component_type_r_32f);
-                    normals = attr.data;
+                    job.normals = attr.data;
                     break;
                 case cgltf_attribute_type_tangent:
                     assert(attr.data->type == cgltf_type_vec4);
                     assert(attr.data->component_type == cgltf_component_type_r_32f);
-                    tangents = attr.data;
+                    job.tangents = attr.data;
                     break;
                 case cgltf_attribute_type_texcoord:
                     assert(attr.data->type == cgltf_type_vec2);
                     assert(attr.data->component_type == cgltf_component_type_r_32f);
                     if (attr.index == 0)
-                        texcoords = attr.data;
+                        job.texcoords = attr.data;
                     break;
                 case cgltf_attribute_type_joints:
                     assert(attr.data->type == cgltf_type_vec4);
                     assert(attr.data->component_type == cgltf_component_type_r_8u || attr.data->component_type == cgltf_component_type_r_16u);
-                    joint_indices = attr.data;
+                    job.joint_indices = attr.data;
                     break;
                 case cgltf_attribute_type_weights:
                     assert(attr.data->type == cgltf_type_vec4);
                     assert(attr.data->component_type == cgltf_component_type_r_8u || attr.data->component_type == cgltf_component_type_r_16u || attr.data->component_type == cgltf_component_type_r_32f);
-                    joint_weights = attr.data;
+                    job.joint_weights = attr.data;
                     break;
                 default:
                     break;
                 }
             }
 
-            assert(positions);
-
-            size_t indexCount = 0;
-
-            if (prim.indices)
-            {
-                indexCount = prim.indices->count;
-
-                // copy the indices
-                auto [indexSrc, indexStride] = cgltf_buffer_iterator(prim.indices, 0);
-
-                uint32_t* indexDst = buffers->indexData.data() + totalIndices;
-
-                switch(prim.indices->component_type)
-                {
-                case cgltf_component_type_r_8u:
-                    if (!indexStride) indexStride = sizeof(uint8_t);
-                    for (size_t i_idx = 0; i_idx < indexCount; i_idx++)
-                    {
-                        *indexDst = *(const uint8_t*)indexSrc;
-
-                        indexSrc += indexStride;
-                        indexDst++;
-                    }
-                    break;
-                case cgltf_component_type_r_16u:
-                    if (!indexStride) indexStride = sizeof(uint16_t);
-                    for (size_t i_idx = 0; i_idx < indexCount; i_idx++)
-                    {
-                        *indexDst = *(const uint16_t*)indexSrc;
-
-                        indexSrc += indexStride;
-                        indexDst++;
-                    }
-                    break;
-                case cgltf_component_type_r_32u:
-                    if (!indexStride) indexStride = sizeof(uint32_t);
-                    for (size_t i_idx = 0; i_idx < indexCount; i_idx++)
-                    {
-                        *indexDst = *(const uint32_t*)indexSrc;
-
-                        indexSrc += indexStride;
-                        indexDst++;
-                    }
-                    break;
-                default: 
-                    assert(false);
-                }
-            }
-            else
-            {
-                indexCount = positions->count;
-
-                // generate the indices
-                uint32_t* indexDst = buffers->indexData.data() + totalIndices;
-                for (size_t i_idx = 0; i_idx < indexCount; i_idx++)
-                {
-                    *indexDst = (uint32_t)i_idx;
-                    indexDst++;
-                }
-            }
-
-            dm::box3 bounds = dm::box3::empty();
-
-            if (positions)
-            {
-                auto [positionSrc, positionStride] = cgltf_buffer_iterator(positions, sizeof(float) * 3);
-                float3* positionDst = buffers->positionData.data() + totalVertices;
-
-                for (size_t v_idx = 0; v_idx < positions->count; v_idx++)
-                {
-                    *positionDst = (const float*)positionSrc;
-
-                    bounds |= *positionDst;
-
-                    positionSrc += positionStride;
-                    ++positionDst;
-                }
-            }
-
-            if (normals)
-            {
-                assert(normals->count == positions->count);
-
-                auto [normalSrc, normalStride] = cgltf_buffer_iterator(normals, sizeof(float) * 3);
-                uint32_t* normalDst = buffers->normalData.data() + totalVertices;
-
-                for (size_t v_idx = 0; v_idx < normals->count; v_idx++)
-                {
-                    float3 normal = (const float*)normalSrc;
-                    *normalDst = vectorToSnorm8(normal);
-
-                    normalSrc += normalStride;
-                    ++normalDst;
-                }
-            }
-
-            if (tangents)
-            {
-                assert(tangents->count == positions->count);
-
-                auto [tangentSrc, tangentStride] = cgltf_buffer_iterator(tangents, sizeof(float) * 4);
-                uint32_t* tangentDst = buffers->tangentData.data() + totalVertices;
-                
-                for (size_t v_idx = 0; v_idx < tangents->count; v_idx++)
-                {
-                    float4 tangent = (const float*)tangentSrc;
-                    *tangentDst = vectorToSnorm8(tangent);
+            assert(job.positions);
 
-                    tangentSrc += tangentStride;
-                    ++tangentDst;
-                }
-            }
-
-            if (texcoords)
-            {
-                assert(texcoords->count == positions->count);
-
-                auto [texcoordSrc, texcoordStride] = cgltf_buffer_iterator(texcoords, sizeof(float) * 2);
-                float2* texcoordDst = buffers->texcoord1Data.data() + totalVertices;
-
-                for (size_t v_idx = 0; v_idx < texcoords->count; v_idx++)
-                {
-                    *texcoordDst = (const float*)texcoordSrc;
-
-                    texcoordSrc += texcoordStride;
-                    ++texcoordDst;
-                }
-            }
-            else
-            {
-                float2* texcoordDst = buffers->texcoord1Data.data() + totalVertices;
-                for (size_t v_idx = 0; v_idx < positions->count; v_idx++)
-                {
-                    *texcoordDst = float2(0.f);
-                    ++texcoordDst;
-                }
-            }
-
-            if (normals && texcoords && (!tangents || c_ForceRebuildTangents))
-            {
-                auto [positionSrc, positionStride] = cgltf_buffer_iterator(positions, sizeof(float) * 3);
-                auto [texcoordSrc, texcoordStride] = cgltf_buffer_iterator(texcoords, sizeof(float) * 2);
-                auto [normalSrc, normalStride] = cgltf_buffer_iterator(normals, sizeof(float) * 3);
-                const uint32_t* indexSrc = buffers->indexData.data() + totalIndices;
-
-                computedTangents.resize(positions->count);
-                std::fill(computedTangents.begin(), computedTangents.end(), float3(0.f));
-
-                computedBitangents.resize(positions->count);
-                std::fill(computedBitangents.begin(), computedBitangents.end(), float3(0.f));
-
-                for (size_t t_idx = 0; t_idx < indexCount / 3; t_idx++)
-                {
-                    uint3 tri = indexSrc;
-                    indexSrc += 3;
-
-                    float3 p0 = (const float*)(positionSrc + positionStride * tri.x);
-                    float3 p1 = (const float*)(positionSrc + positionStride * tri.y);
-                    float3 p2 = (const float*)(positionSrc + positionStride * tri.z);
-
-                    float2 t0 = (const float*)(texcoordSrc + texcoordStride * tri.x);
-                    float2 t1 = (const float*)(texcoordSrc + texcoordStride * tri.y);
-                    float2 t2 = (const float*)(texcoordSrc + texcoordStride * tri.z);
-
-                    float3 dPds = p1 - p0;
-                    float3 dPdt = p2 - p0;
-
-                    float2 dTds = t1 - t0;
-                    float2 dTdt = t2 - t0;
-                    float r = 1.0f / (dTds.x * dTdt.y - dTds.y * dTdt.x);
-                    float3 tangent = r * (dPds * dTdt.y - dPdt * dTds.y);
-                    float3 bitangent = r * (dPdt * dTds.x - dPds * dTdt.x);
-
-                    float tangentLength = length(tangent);
-                    float bitangentLength = length(bitangent);
-                    if (tangentLength > 0 && bitangentLength > 0)
-                    {
-                        tangent /= tangentLength;
-                        bitangent /= bitangentLength;
-
-                        computedTangents[tri.x] += tangent;
-                        computedTangents[tri.y] += tangent;
-                        computedTangents[tri.z] += tangent;
-                        computedBitangents[tri.x] += bitangent;
-                        computedBitangents[tri.y] += bitangent;
-                        computedBitangents[tri.z] += bitangent;
-                    }
-                }
-
-                uint8_t* tangentSrc = nullptr;
-                size_t tangentStride = 0;
-                if (tangents)
-                {
-                    auto pair = cgltf_buffer_iterator(tangents, sizeof(float) * 4);
-                    tangentSrc = const_cast<uint8_t*>(pair.first);
-                    tangentStride = pair.second;
-                }
-
-                uint32_t* tangentDst = buffers->tangentData.data() + totalVertices;
-
-                for (size_t v_idx = 0; v_idx < positions->count; v_idx++)
-                {
-                    float3 normal = (const float*)normalSrc;
-                    float3 tangent = computedTangents[v_idx];
-                    float3 bitangent = computedBitangents[v_idx];
-
-                    float sign = 0;
-                    float tangentLength = length(tangent);
-                    float bitangentLength = length(bitangent);
-                    if (tangentLength > 0 && bitangentLength > 0)
-                    {
-                        tangent /= tangentLength;
-                        bitangent /= bitangentLength;
-                        float3 cross_b = cross(normal, tangent);
-                        sign = (dot(cross_b, bitangent) > 0) ? -1.f : 1.f;
-                    }
-
-                    *tangentDst = vectorToSnorm8(float4(tangent, sign));
-
-                    if (c_ForceRebuildTangents && tangents)
-                    {
-                        *(float4*)tangentSrc = float4(tangent, sign);
-                        tangentSrc += tangentStride;
-                    }
-                    
-                    normalSrc += normalStride;
-                    ++tangentDst;
-                }
-            }
-
-            if (joint_indices)
-            {
+            if (job.joint_indices || job.joint_weights)
                 minfo->isSkinPrototype = true;
 
-                assert(joint_indices->count == positions->count);
-
-                auto [jointSrc, jointStride] = cgltf_buffer_iterator(joint_indices, 0);
-                vector<uint16_t, 4>* jointDst = buffers->jointData.data() + totalVertices;
-
-                if (joint_indices->component_type == cgltf_component_type_r_8u)
-                {
-                    if (!jointStride) jointStride = sizeof(uint8_t) * 4;
-
-                    for (size_t v_idx = 0; v_idx < joint_indices->count; v_idx++)
-                    {
-                        *jointDst = dm::vector<uint16_t, 4>(jointSrc[0], jointSrc[1], jointSrc[2], jointSrc[3]);
-
-                        jointSrc += jointStride;
-                        ++jointDst;
-                    }
-                }
-                else
-                {
-                    assert(joint_indices->component_type == cgltf_component_type_r_16u);
-
-                    if (!jointStride) jointStride = sizeof(uint16_t) * 4;
-
-                    for (size_t v_idx = 0; v_idx < joint_indices->count; v_idx++)
-                    {
-                        const uint16_t* jointSrcUshort = (const uint16_t*)jointSrc;
-                        *jointDst = dm::vector<uint16_t, 4>(jointSrcUshort[0], jointSrcUshort[1], jointSrcUshort[2], jointSrcUshort[3]);
-
-                        jointSrc += jointStride;
-                        ++jointDst;
-                    }
-                }
-            }
-
-            if (joint_weights)
-            {
-                minfo->isSkinPrototype = true;
-
-                assert(joint_weights->count == positions->count);
-
-                auto [weightSrc, weightStride] = cgltf_buffer_iterator(joint_weights, 0);
-                float4* weightDst = buffers->weightData.data() + totalVertices;
-
-                if (joint_weights->component_type == cgltf_component_type_r_8u)
-                {
-                    if (!weightStride) weightStride = sizeof(uint8_t) * 4;
-
-                    for (size_t v_idx = 0; v_idx < joint_indices->count; v_idx++)
-                    {
-                        *weightDst = dm::float4(
-                            float(weightSrc[0]) / 255.f,
-                            float(weightSrc[1]) / 255.f,
-                            float(weightSrc[2]) / 255.f,
-                            float(weightSrc[3]) / 255.f);
-
-                        weightSrc += weightStride;
-                        ++weightDst;
-                    }
-                }
-                else if (joint_weights->component_type == cgltf_component_type_r_16u)
-                {
-                    if (!weightStride) weightStride = sizeof(uint16_t) * 4;
-
-                    for (size_t v_idx = 0; v_idx < joint_indices->count; v_idx++)
-                    {
-                        const uint16_t* weightSrcUshort = (const uint16_t*)weightSrc;
-                        *weightDst = dm::float4(
-                            float(weightSrcUshort[0]) / 65535.f,
-                            float(weightSrcUshort[1]) / 65535.f,
-                            float(weightSrcUshort[2]) / 65535.f,
-                            float(weightSrcUshort[3]) / 65535.f);
-                        
-                        weightSrc += weightStride;
-                        ++weightDst;
-                    }
-                }
-                else
-                {
-                    assert(joint_weights->component_type == cgltf_component_type_r_32f);
-
-                    if (!weightStride) weightStride = sizeof(float) * 4;
-
-                    for (size_t v_idx = 0; v_idx < joint_indices->count; v_idx++)
-                    {
-                        *weightDst = (const float*)weightSrc;
-
-                        weightSrc += weightStride;
-                        ++weightDst;
-                    }
-                }
-            }
+            job.indexCount = prim.indices ? prim.indices->count : job.positions->count;
+            job.indexOffset = totalIndices;
+            job.vertexOffset = totalVertices;
 
             auto geometry = m_SceneTypeFactory->CreateMeshGeometry();
             if (prim.material)
@@ -898,19 +1034,28 @@ bool GltfImporter::Load(
 
             geometry->indexOffsetInMesh = minfo->totalIndices;
             geometry->vertexOffsetInMesh = minfo->totalVertices;
-            geometry->numIndices = (uint32_t)indexCount;
-            geometry->numVertices = (uint32_t)positions->count;
-            geometry->objectSpaceBounds = bounds;
-            minfo->objectSpaceBounds |= bounds;
+            geometry->numIndices = (uint32_t)job.indexCount;
+            geometry->numVertices = (uint32_t)job.positions->count;
             minfo->totalIndices += geometry->numIndices;
             minfo->totalVertices += geometry->numVertices;
             minfo->geometries.push_back(geometry);
 
+            job.geometry = geometry.get();
+            decodeJobs.push_back(job);
+
             totalIndices += geometry->numIndices;
             totalVertices += geometry->numVertices;
         }
     }
 
+    DecodeGltfPrimitives(decodeJobs, *buffers, c_ForceRebuildTangents, totalVertices, executor);
+
+    for (const auto& minfo : meshes)
+    {
+        for (const auto& geometry : minfo->geometries)
+            minfo->objectSpaceBounds |= geometry->objectSpaceBounds;
+    }
+
     std::unordered_map<const cgltf_camera*, std::shared_ptr<SceneCamera>> cameraMap;
     for (size_t camera_idx = 0; camera_idx < objects->cameras_count; camera_idx++)
     {
@@ -1294,6 +1439,31 @@ bool GltfImporter::Load(
         }
     }
 
+    if (m_CookedCacheEnabled && !c_ForceRebuildTangents && !hasEmbeddedImages &&
+        objects->skins_count == 0 && objects->animations_count == 0 &&
+        objects->cameras_count == 0 && objects->lights_count == 0)
+    {
+        GltfCookedModel cookedModel;
+        cookedModel.fileVersion = fileVersion;
+        cookedModel.contentHash = HashContent(modelBlob->data(), modelBlob->size());
+        cookedModel.buffers = buffers;
+        cookedModel.meshes = meshes;
+        cookedModel.rootNode = root;
+
+        for (size_t mat_idx = 0; mat_idx < objects->materials_count; mat_idx++)
+            cookedModel.materials.push_back(materials[&objects->materials[mat_idx]]);
+
+        for (size_t blob_idx = 0; blob_idx < vfsContext.blobs.size(); blob_idx++)
+        {
+            const auto& blob = vfsContext.blobs[blob_idx];
+            const std::string& path = vfsContext.paths[blob_idx];
+            if (!path.empty())
+                cookedModel.dependencies.push_back({ path, m_fs->getFileVersion(path), HashContent(blob->data(), blob->size()) });
+        }
+
+        SaveCooked(fileName, cookedModel);
+    }
+
     if (c_ForceRebuildTangents)
     {
         for (size_t buffer_idx = 0; buffer_idx < objects->buffers_count; buffer_idx++)
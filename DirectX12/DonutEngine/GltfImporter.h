@@ -24,6 +24,9 @@
 
 #include <memory>
 #include <filesystem>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace donut::vfs
 {
@@ -33,6 +36,9 @@ namespace donut::vfs
 
 namespace donut::engine
 {
+    struct BufferGroup;
+    struct MeshInfo;
+    struct Material;
     struct SceneImportResult;
     struct SceneLoadingStats;
     class TextureCache;
@@ -48,14 +54,65 @@ namespace tf
 
 namespace donut::engine
 {
+    // A source file of a cooked model, see vfs::IFileSystem::getFileVersion.
+    struct GltfCookedDependency
+    {
+        std::string path;
+        uint64_t fileVersion = 0;
+        uint64_t contentHash = 0;
+    };
+
+    // The parts of an imported glTF model that are stored in the cooked cache.
+    struct GltfCookedModel
+    {
+        uint64_t fileVersion = 0;
+        uint64_t contentHash = 0;
+        std::vector<GltfCookedDependency> dependencies; // external buffer files
+        std::shared_ptr<BufferGroup> buffers;
+        std::vector<std::shared_ptr<MeshInfo>> meshes;
+        std::vector<std::shared_ptr<Material>> materials; // in the order of the glTF file
+        std::shared_ptr<SceneGraphNode> rootNode;
+    };
+
+    /*
+    Imports glTF models into scene graphs.
+
+    The cooked cache is disabled by default. When it is enabled with SetCookedCacheEnabled,
+    every successful import also writes a cooked model file next to the glTF file, named
+    "<model>.cooked", so the model directory must be writable. It is a donut::chunk::ChunkFile with
+    the BufferGroup streams, the mesh and geometry tables, the materials and the node hierarchy.
+    Later loads of the same model read the cooked file instead of parsing and converting the glTF.
+    The cooked file stores the file version and a content hash of the glTF file and of its external
+    buffers. A source file whose version is unchanged is not read again; otherwise its content hash
+    is compared, and the cooked file is ignored when any of the sources has changed.
+
+    Models with skins, animations, cameras, lights or embedded images are always imported from glTF.
+    */
     class GltfImporter
     {   
     protected:
         std::shared_ptr<vfs::IFileSystem> m_fs;
         std::shared_ptr<SceneTypeFactory> m_SceneTypeFactory;
+        bool m_CookedCacheEnabled = false;
+
+        bool LoadCooked(
+            const std::filesystem::path& fileName,
+            TextureCache& textureCache,
+            tf::Executor* executor,
+            SceneImportResult& result) const;
+
+        void SaveCooked(const std::filesystem::path& fileName, const GltfCookedModel& model) const;
+
+        // Fast 64-bit hash used to detect changes to the source files of a cooked model.
+        static uint64_t HashContent(const void* data, size_t size);
         
     public:
         explicit GltfImporter(std::shared_ptr<vfs::IFileSystem> fs, std::shared_ptr<SceneTypeFactory> sceneTypeFactory);
+
+        void SetCookedCacheEnabled(bool enabled) { m_CookedCacheEnabled = enabled; }
+        [[nodiscard]] bool IsCookedCacheEnabled() const { return m_CookedCacheEnabled; }
+
+        static std::filesystem::path GetCookedFileName(const std::filesystem::path& fileName);
         
         bool Load(
             const std::filesystem::path& fileName,
@@ -37,10 +37,152 @@ this software is released into the Public Domain.
 #include "pch.h"
 #include <cassert>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DONUT_ANIMATION_SSE 1
+#else
+#define DONUT_ANIMATION_SSE 0
+#endif
+
 using namespace donut::math;
 using namespace donut::engine;
 using namespace donut::engine::animation;
 
+namespace
+{
+    // The number of keyframe pairs that a cursor steps over before the search falls back to a binary search.
+    constexpr uint32_t c_MaxCursorSteps = 4;
+
+    // Locates the keyframe pair (b, c) so that (b.time <= time < c.time), trying the pairs starting at 'hint' first.
+    // Assumes that the keyframes are sorted by time and that (first.time < time < last.time).
+    template<typename GetTime>
+    uint32_t FindKeyframe(GetTime getTime, uint32_t count, float time, uint32_t hint)
+    {
+        uint32_t left = 0;
+        uint32_t right = count - 2;
+
+        if (hint <= right && getTime(hint) <= time)
+        {
+            for (uint32_t step = 0; step < c_MaxCursorSteps; ++step, ++hint)
+            {
+                if (time < getTime(hint + 1))
+                    return hint;
+            }
+
+            left = hint;
+        }
+
+        // Find the last keyframe with (b.time <= time); the one after it is later than the required time.
+        while (left < right)
+        {
+            uint32_t const middle = (left + right + 1) / 2;
+
+            if (getTime(middle) <= time)
+                left = middle;
+            else
+                right = middle - 1;
+        }
+
+        return left;
+    }
+
+    // Versions of the Interpolate cases that work on the keyframe arrays of a CompiledClip. The SSE paths
+    // keep the order of operations of the scalar code, so both produce the same results.
+
+#if DONUT_ANIMATION_SSE
+    __m128 Load(const float4& v) { return _mm_loadu_ps(&v.x); }
+    __m128 Splat(float f) { return _mm_set1_ps(f); }
+    __m128 Negate(__m128 v) { return _mm_xor_ps(v, _mm_set1_ps(-0.f)); }
+
+    float4 Store(__m128 v)
+    {
+        float4 result;
+        _mm_storeu_ps(&result.x, v);
+        return result;
+    }
+#endif
+
+    float4 InterpolateLinear(const float4& b, const float4& c, float t)
+    {
+#if DONUT_ANIMATION_SSE
+        __m128 vb = Load(b);
+        return Store(_mm_add_ps(vb, _mm_mul_ps(_mm_sub_ps(Load(c), vb), Splat(t))));
+#else
+        return lerp(b, c, t);
+#endif
+    }
+
+    float4 InterpolateSlerp(const float4& b, const float4& c, float t)
+    {
+        // the weights as in dm::slerp, applied to the 4 components at once
+        float sign = 1.f;
+        float fb = 1.f - t;
+        float fc = t;
+        float dp = b.w * c.w + b.x * c.x + b.y * c.y + b.z * c.z;
+        if (dp < 0.f)
+        {
+            sign = -1.f;
+            dp = -dp;
+        }
+        if (1.f - dp > 0.001f)
+        {
+            float theta = std::acos(dp);
+            fb = std::sin(theta * fb) / std::sin(theta);
+            fc = std::sin(theta * fc) / std::sin(theta);
+        }
+
+#if DONUT_ANIMATION_SSE
+        return Store(_mm_add_ps(_mm_mul_ps(Splat(fb), Load(b)), _mm_mul_ps(Splat(sign * fc), Load(c))));
+#else
+        return fb * b + sign * fc * c;
+#endif
+    }
+
+    float4 InterpolateCatmullRom(const float4& a, const float4& b, const float4& c, const float4& d, float t)
+    {
+#if DONUT_ANIMATION_SSE
+        __m128 va = Load(a);
+        __m128 vb = Load(b);
+        __m128 vc = Load(c);
+        __m128 vd = Load(d);
+        __m128 vt = Splat(t);
+
+        __m128 i = _mm_add_ps(_mm_sub_ps(_mm_add_ps(Negate(va), _mm_mul_ps(Splat(3.f), vb)), _mm_mul_ps(Splat(3.f), vc)), vd);
+        __m128 j = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(Splat(2.f), va), _mm_mul_ps(Splat(5.f), vb)), _mm_mul_ps(Splat(4.f), vc)), vd);
+        __m128 k = _mm_add_ps(Negate(va), vc);
+        __m128 r = _mm_add_ps(_mm_mul_ps(i, vt), j);
+        r = _mm_add_ps(_mm_mul_ps(r, vt), k);
+        r = _mm_mul_ps(Splat(0.5f), r);
+        return Store(_mm_add_ps(_mm_mul_ps(r, vt), vb));
+#else
+        float4 i = -a + 3.f * b - 3.f * c + d;
+        float4 j = 2.f * a - 5.f * b + 4.f * c - d;
+        float4 k = -a + c;
+        return 0.5f * ((i * t + j) * t + k) * t + b;
+#endif
+    }
+
+    float4 InterpolateHermite(const float4& b, const float4& bOutTangent, const float4& c, const float4& cInTangent, float t, float dt)
+    {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+
+#if DONUT_ANIMATION_SSE
+        __m128 vdt = Splat(dt);
+        __m128 r = _mm_mul_ps(Splat(2.f * t3 - 3.f * t2 + 1.f), Load(b));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(Splat(t3 - 2.f * t2 + t), Load(bOutTangent)), vdt));
+        r = _mm_add_ps(r, _mm_mul_ps(Splat(-2.f * t3 + 3.f * t2), Load(c)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(Splat(t3 - t2), Load(cInTangent)), vdt));
+        return Store(r);
+#else
+        return (2.f * t3 - 3.f * t2 + 1.f) * b
+             + (t3 - 2.f * t2 + t) * bOutTangent * dt
+             + (-2.f * t3 + 3.f * t2) * c
+             + (t3 - t2) * cInTangent * dt;
+#endif
+    }
+}
+
 float4 donut::engine::animation::Interpolate(const InterpolationMode mode,
     const Keyframe& a, const Keyframe& b, const Keyframe& c, const Keyframe& d, const float t, const float dt)
 {
@@ -86,13 +228,22 @@ float4 donut::engine::animation::Interpolate(const InterpolationMode mode,
 
 std::optional<dm::float4> Sampler::Evaluate(float time, bool extrapolateLastValues) const
 {
-    const size_t count = m_Keyframes.size();
+    SamplerCursor cursor;
+    return Evaluate(time, cursor, extrapolateLastValues);
+}
+
+std::optional<dm::float4> Sampler::Evaluate(float time, SamplerCursor& cursor, bool extrapolateLastValues) const
+{
+    const uint32_t count = uint32_t(m_Keyframes.size());
 
     if (count == 0)
         return std::optional<float4>();
 
     if (time <= m_Keyframes[0].time)
+    {
+        cursor.keyframe = 0;
         return std::optional(m_Keyframes[0].value);
+    }
 
     if (count == 1 || time >= m_Keyframes[count - 1].time)
     {
@@ -102,33 +253,13 @@ std::optional<dm::float4> Sampler::Evaluate(float time, bool extrapolateLastValu
             return std::optional<float4>();
     }
     
-    // Use binary search to locate the pair of keyframes (b, c) so that (b.time <= time < c.time).
+    // Locate the pair of keyframes (b, c) so that (b.time <= time < c.time), starting from the previous position.
     // Assume that the keyframe vector is sorted by time.
-    // Right limit starts at (count - 2) because we're always looking at consecutive pairs of items, not single items.
-    size_t left = 0;
-    size_t right = count - 2;
-    while (left <= right)
-    {
-        size_t const middle = (left + right) / 2;
-
-        const float tb = m_Keyframes[middle].time;
-        const float tc = m_Keyframes[middle + 1].time;
-
-        if (time < tb)
-            right = middle - 1;
-        else if (time >= tc)
-            left = middle + 1;
-        else
-        {
-            // Found the pair containing the required time, stop.
-            left = right = middle;
-            break;
-        }
-    }
+    cursor.keyframe = FindKeyframe([this](uint32_t index) { return m_Keyframes[index].time; }, count, time, cursor.keyframe);
 
     // Load 4 keyframes around the required time.
     // The outside keyframes (a) and (d) are needed for higher-order interpolation.
-    size_t const offset = left;
+    uint32_t const offset = cursor.keyframe;
     const Keyframe& b = m_Keyframes[offset];
     const Keyframe& c = m_Keyframes[offset + 1];
     const Keyframe& a = (offset > 0) ? m_Keyframes[offset - 1] : b;
@@ -217,6 +348,161 @@ void Sampler::Load(Json::Value& node)
     }
 }
 
+CompiledClip::CompiledClip(const std::vector<const Sampler*>& samplers)
+{
+    m_Tracks.resize(samplers.size());
+
+    uint32_t modeCounts[ModeCount] = {};
+    for (size_t trackIndex = 0; trackIndex < samplers.size(); trackIndex++)
+    {
+        Track& track = m_Tracks[trackIndex];
+        track.firstKeyframe = uint32_t(m_Times.size());
+
+        const Sampler* sampler = samplers[trackIndex];
+        if (!sampler)
+            continue;
+
+        const auto& keyframes = sampler->GetKeyframes();
+        track.keyframeCount = uint32_t(keyframes.size());
+        for (const Keyframe& keyframe : keyframes)
+        {
+            m_Times.push_back(keyframe.time);
+            m_Values.push_back(keyframe.value);
+            m_InTangents.push_back(keyframe.inTangent);
+            m_OutTangents.push_back(keyframe.outTangent);
+        }
+
+        m_Duration = std::max(m_Duration, sampler->GetEndTime());
+        ++modeCounts[uint32_t(sampler->GetMode())];
+    }
+
+    // group the tracks by interpolation mode, so that each mode is interpolated in one loop
+    m_ModeOffsets[0] = 0;
+    for (uint32_t mode = 0; mode < ModeCount; mode++)
+        m_ModeOffsets[mode + 1] = m_ModeOffsets[mode] + modeCounts[mode];
+
+    uint32_t modeFill[ModeCount];
+    std::copy(m_ModeOffsets, m_ModeOffsets + ModeCount, modeFill);
+
+    m_TracksByMode.resize(m_ModeOffsets[ModeCount]);
+    for (size_t trackIndex = 0; trackIndex < samplers.size(); trackIndex++)
+    {
+        if (samplers[trackIndex])
+            m_TracksByMode[modeFill[uint32_t(samplers[trackIndex]->GetMode())]++] = uint32_t(trackIndex);
+    }
+}
+
+void CompiledClip::Evaluate(float time, ClipCursor& cursor, bool extrapolateLastValues, dm::float4* values, uint8_t* validTracks) const
+{
+    const uint32_t trackCount = uint32_t(m_Tracks.size());
+    cursor.keyframes.resize(trackCount, 0);
+    cursor.segmentTimes.resize(trackCount);
+    cursor.segmentLengths.resize(trackCount);
+
+    // Locate the keyframe pair of every track. Tracks that are outside of their keyframe range get their
+    // value here, and are marked with a zero segment length so that the interpolation loops skip them.
+    for (uint32_t trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        const Track& track = m_Tracks[trackIndex];
+        const float* times = m_Times.data() + track.firstKeyframe;
+        const uint32_t count = track.keyframeCount;
+
+        validTracks[trackIndex] = 1;
+        cursor.segmentLengths[trackIndex] = 0.f;
+
+        if (count == 0)
+        {
+            validTracks[trackIndex] = 0;
+            values[trackIndex] = 0.f;
+            continue;
+        }
+
+        if (time <= times[0])
+        {
+            cursor.keyframes[trackIndex] = 0;
+            values[trackIndex] = m_Values[track.firstKeyframe];
+            continue;
+        }
+
+        if (count == 1 || time >= times[count - 1])
+        {
+            if (extrapolateLastValues)
+                values[trackIndex] = m_Values[track.firstKeyframe + count - 1];
+            else
+            {
+                validTracks[trackIndex] = 0;
+                values[trackIndex] = 0.f;
+            }
+            continue;
+        }
+
+        uint32_t keyframe = FindKeyframe([times](uint32_t index) { return times[index]; }, count, time, cursor.keyframes[trackIndex]);
+        cursor.keyframes[trackIndex] = keyframe;
+
+        const float dt = times[keyframe + 1] - times[keyframe];
+        cursor.segmentTimes[trackIndex] = (time - times[keyframe]) / dt;
+        cursor.segmentLengths[trackIndex] = dt;
+    }
+
+    // Interpolate the tracks one mode at a time, so that the mode branch is predictable within each group.
+    for (uint32_t mode = 0; mode < ModeCount; mode++)
+    {
+        for (uint32_t sortedIndex = m_ModeOffsets[mode]; sortedIndex < m_ModeOffsets[mode + 1]; sortedIndex++)
+        {
+            const uint32_t trackIndex = m_TracksByMode[sortedIndex];
+            const float dt = cursor.segmentLengths[trackIndex];
+            if (dt == 0.f)
+                continue;
+
+            const Track& track = m_Tracks[trackIndex];
+            const uint32_t offset = cursor.keyframes[trackIndex];
+            const uint32_t b = track.firstKeyframe + offset;
+            const uint32_t c = b + 1;
+            const float u = cursor.segmentTimes[trackIndex];
+
+            switch (InterpolationMode(mode))
+            {
+            case InterpolationMode::Step:
+                values[trackIndex] = m_Values[b];
+                break;
+            case InterpolationMode::Linear:
+                values[trackIndex] = InterpolateLinear(m_Values[b], m_Values[c], u);
+                break;
+            case InterpolationMode::Slerp:
+                values[trackIndex] = InterpolateSlerp(m_Values[b], m_Values[c], u);
+                break;
+            case InterpolationMode::CatmullRomSpline: {
+                const uint32_t a = (offset > 0) ? b - 1 : b;
+                const uint32_t d = (offset < track.keyframeCount - 2) ? c + 1 : c;
+                values[trackIndex] = InterpolateCatmullRom(m_Values[a], m_Values[b], m_Values[c], m_Values[d], u);
+                break;
+            }
+            case InterpolationMode::HermiteSpline:
+                values[trackIndex] = InterpolateHermite(m_Values[b], m_OutTangents[b], m_Values[c], m_InTangents[c], u, dt);
+                break;
+            }
+        }
+    }
+}
+
+std::shared_ptr<Sampler> Sequence::GetTrack(const std::string& name) const
+{
+    auto it = m_TrackIndices.find(name);
+    if (it == m_TrackIndices.end())
+        return nullptr;
+
+    return m_Tracks[it->second];
+}
+
+std::optional<uint32_t> Sequence::GetTrackIndex(const std::string& name) const
+{
+    auto it = m_TrackIndices.find(name);
+    if (it == m_TrackIndices.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
 std::optional<dm::float4> Sequence::Evaluate(const std::string& name, float time, bool extrapolateLastValues)
 {
     std::shared_ptr<Sampler> track = GetTrack(name);
@@ -226,12 +512,40 @@ std::optional<dm::float4> Sequence::Evaluate(const std::string& name, float time
     return track->Evaluate(time, extrapolateLastValues);
 }
 
+std::optional<dm::float4> Sequence::Evaluate(uint32_t trackIndex, float time, bool extrapolateLastValues) const
+{
+    if (trackIndex >= m_Tracks.size() || !m_Tracks[trackIndex])
+        return std::optional<dm::float4>();
+
+    return m_Tracks[trackIndex]->Evaluate(time, extrapolateLastValues);
+}
+
 void Sequence::AddTrack(const std::string& name, const std::shared_ptr<Sampler>& track)
 {
-    m_Tracks[name] = track;
+    auto it = m_TrackIndices.find(name);
+    if (it != m_TrackIndices.end())
+    {
+        m_Tracks[it->second] = track;
+    }
+    else
+    {
+        m_TrackIndices[name] = uint32_t(m_Tracks.size());
+        m_Tracks.push_back(track);
+    }
+
     m_Duration = std::max(m_Duration, track->GetEndTime());
 }
 
+std::shared_ptr<CompiledClip> Sequence::Compile() const
+{
+    std::vector<const Sampler*> samplers;
+    samplers.reserve(m_Tracks.size());
+    for (const auto& track : m_Tracks)
+        samplers.push_back(track.get());
+
+    return std::make_shared<CompiledClip>(samplers);
+}
+
 void Sequence::Load(Json::Value& node)
 {
     for (auto& trackNode : node)
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../DonutCore/Math.h"
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <unordered_map>
@@ -57,6 +58,13 @@ namespace donut::engine::animation
         const Keyframe& a, const Keyframe& b,
         const Keyframe& c, const Keyframe& d, float t, float dt);
 
+    // Position of a sampler in its keyframe array, kept by the caller between evaluations.
+    // When time advances monotonically, the next keyframe pair is found in a few steps instead of a binary search.
+    struct SamplerCursor
+    {
+        uint32_t keyframe = 0;
+    };
+
     class Sampler
     {
     protected:
@@ -68,8 +76,10 @@ namespace donut::engine::animation
         virtual ~Sampler() = default;
 
         std::optional<dm::float4> Evaluate(float time, bool extrapolateLastValues = false) const;
+        std::optional<dm::float4> Evaluate(float time, SamplerCursor& cursor, bool extrapolateLastValues = false) const;
 
         [[nodiscard]] std::vector<Keyframe>& GetKeyframes() { return m_Keyframes; }
+        [[nodiscard]] const std::vector<Keyframe>& GetKeyframes() const { return m_Keyframes; }
         void AddKeyframe(const Keyframe keyframe);
 
         [[nodiscard]] InterpolationMode GetMode() const { return m_Mode; }
@@ -81,25 +91,79 @@ namespace donut::engine::animation
         void Load(Json::Value& node);
     };
 
+    // Playback state of one CompiledClip instance: the keyframe cursor of every track, and scratch space
+    // for the evaluation so that evaluating a clip does not allocate after the first call.
+    struct ClipCursor
+    {
+        std::vector<uint32_t> keyframes;
+        std::vector<float> segmentTimes;
+        std::vector<float> segmentLengths;
+    };
+
+    // A flattened, read-only copy of a set of samplers, addressed by track index.
+    // The keyframes of all tracks are stored in shared arrays, and Evaluate samples every track at once:
+    // a cursor pass locates the keyframes of each track, then one vectorized loop per interpolation mode
+    // computes the values. The clip does not follow later changes to the samplers it was compiled from.
+    class CompiledClip
+    {
+    private:
+        struct Track
+        {
+            uint32_t firstKeyframe = 0;
+            uint32_t keyframeCount = 0;
+        };
+
+        static constexpr uint32_t ModeCount = uint32_t(InterpolationMode::HermiteSpline) + 1;
+
+        std::vector<Track> m_Tracks;
+
+        // the keyframes of all tracks, split by component so that each pass only loads what it uses
+        std::vector<float> m_Times;
+        std::vector<dm::float4> m_Values;
+        std::vector<dm::float4> m_InTangents;
+        std::vector<dm::float4> m_OutTangents;
+        std::vector<uint32_t> m_TracksByMode;
+        uint32_t m_ModeOffsets[ModeCount + 1] = {};
+        float m_Duration = 0.f;
+
+    public:
+        // Creates one track per sampler, in order. Null samplers produce tracks without values.
+        explicit CompiledClip(const std::vector<const Sampler*>& samplers);
+
+        [[nodiscard]] uint32_t GetTrackCount() const { return uint32_t(m_Tracks.size()); }
+        [[nodiscard]] float GetDuration() const { return m_Duration; }
+
+        // Samples all tracks at the given time. Writes one value per track into 'values', and sets the
+        // matching entry of 'validTracks' to 0 for tracks that have no value at that time.
+        void Evaluate(float time, ClipCursor& cursor, bool extrapolateLastValues, dm::float4* values, uint8_t* validTracks) const;
+    };
+
     class Sequence
     {
     protected:
-        std::unordered_map<std::string, std::shared_ptr<Sampler>> m_Tracks;
+        std::vector<std::shared_ptr<Sampler>> m_Tracks;
+        std::unordered_map<std::string, uint32_t> m_TrackIndices;
         float m_Duration = 0.f;
 
     public:
         Sequence() = default;
         virtual ~Sequence() = default;
 
-        std::shared_ptr<Sampler> GetTrack(const std::string& name)
-        {
-            return m_Tracks[name];
-        }
+        std::shared_ptr<Sampler> GetTrack(const std::string& name) const;
+        [[nodiscard]] const std::shared_ptr<Sampler>& GetTrack(uint32_t index) const { return m_Tracks[index]; }
+        [[nodiscard]] uint32_t GetTrackCount() const { return uint32_t(m_Tracks.size()); }
+
+        // Returns the index of a track for use with Evaluate or a compiled clip, or std::nullopt if there is no such track.
+        [[nodiscard]] std::optional<uint32_t> GetTrackIndex(const std::string& name) const;
 
         std::optional<dm::float4> Evaluate(const std::string& name, float time, bool extrapolateLastValues = false);
+        std::optional<dm::float4> Evaluate(uint32_t trackIndex, float time, bool extrapolateLastValues = false) const;
 
         void AddTrack(const std::string& name, const std::shared_ptr<Sampler>& track);
 
+        // Compiles the tracks into a clip with the same track indices.
+        [[nodiscard]] std::shared_ptr<CompiledClip> Compile() const;
+
         [[nodiscard]] float GetDuration() const { return m_Duration; }
 
         void Load(Json::Value& node);
@@ -223,14 +223,20 @@ void Scene::LoadModels(
         return;
     }
 
+    std::vector<std::filesystem::path> fileNames;
+    fileNames.reserve(modelList.size());
+    for (const auto& model : modelList)
+        fileNames.push_back(scenePath / std::filesystem::path(model.asString()));
+
+    // Read the model files in the background while the first models are parsed.
+    m_fs->prefetch(fileNames);
+
     m_Models.resize(modelList.size());
     uint32_t index = 0;
-    for (const auto& model : modelList)
+    for (const auto& fileName : fileNames)
     {
         ++g_LoadingStats.ObjectsTotal;
 
-        std::filesystem::path fileName = scenePath / std::filesystem::path(model.asString());
-
         LoadModelAsync(index, fileName, executor);
 
         ++index;
@@ -22,6 +22,11 @@
 
 #include "pch.h"
 #include <sstream>
+#include <thread>
+
+#ifdef DONUT_WITH_TASKFLOW
+#include <taskflow/taskflow.hpp>
+#endif
 
 using namespace donut::engine;
 
@@ -392,6 +397,15 @@ int SceneGraphWalker::Up()
 }
 
 bool SceneGraphAnimationChannel::Apply(float time) const
+{
+    auto valueOption = m_Sampler->Evaluate(time, true);
+    if (!valueOption.has_value())
+        return false;
+
+    return ApplyValue(valueOption.value());
+}
+
+bool SceneGraphAnimationChannel::ApplyValue(const dm::float4& value) const
 {
     auto node = m_TargetNode.lock();
     auto material = m_TargetMaterial.lock();
@@ -399,12 +413,6 @@ bool SceneGraphAnimationChannel::Apply(float time) const
         (!material && !node && m_Attribute == AnimationAttribute::LeafProperty))
         return false;
 
-    auto valueOption = m_Sampler->Evaluate(time, true);
-    if (!valueOption.has_value())
-        return false;
-
-    auto value = valueOption.value();
-
     switch(m_Attribute)
     {
     case AnimationAttribute::Scaling:
@@ -477,6 +485,7 @@ std::shared_ptr<SceneGraphLeaf> SceneGraphAnimation::Clone()
             channel->GetSampler(), channel->GetTargetNode(), channel->GetAttribute());
         copy->AddChannel(channelCopy);
     }
+    copy->m_Clip = m_Clip;
     return std::static_pointer_cast<SceneGraphLeaf>(copy);
 }
 
@@ -489,15 +498,31 @@ void SceneGraphAnimation::AddChannel(const std::shared_ptr<SceneGraphAnimationCh
 {
     m_Channels.push_back(channel);
     m_Duration = std::max(m_Duration, channel->GetSampler()->GetEndTime());
+    m_Clip.reset();
 ;}
 
 bool SceneGraphAnimation::Apply(float time) const
 {
+    if (!m_Clip)
+    {
+        std::vector<const animation::Sampler*> samplers;
+        samplers.reserve(m_Channels.size());
+        for (const auto& channel : m_Channels)
+            samplers.push_back(channel->GetSampler().get());
+
+        m_Clip = std::make_shared<animation::CompiledClip>(samplers);
+    }
+
+    // sample all channels in one batch, then write the values to their targets
+    m_Values.resize(m_Channels.size());
+    m_ValidChannels.resize(m_Channels.size());
+    m_Clip->Evaluate(time, m_Cursor, true, m_Values.data(), m_ValidChannels.data());
+
     bool success = false;
 
-    for (const auto& channel : m_Channels)
+    for (size_t channelIndex = 0; channelIndex < m_Channels.size(); channelIndex++)
     {
-        success = channel->Apply(time) && success;
+        success = m_ValidChannels[channelIndex] && m_Channels[channelIndex]->ApplyValue(m_Values[channelIndex]) && success;
     }
 
     return success;
@@ -518,6 +543,8 @@ void SceneGraph::RegisterLeaf(const std::shared_ptr<SceneGraphLeaf>& leaf)
 {
     if (!leaf)
         return;
+
+    ++m_StructureVersion;
     
     auto meshInstance = std::dynamic_pointer_cast<MeshInstance>(leaf);
     if (meshInstance)
@@ -586,6 +613,8 @@ void SceneGraph::UnregisterLeaf(const std::shared_ptr<SceneGraphLeaf>& leaf)
     if (!leaf)
         return;
 
+    ++m_StructureVersion;
+
     auto meshInstance = std::dynamic_pointer_cast<MeshInstance>(leaf);
     if (meshInstance)
     {
@@ -948,7 +977,60 @@ std::shared_ptr<SceneGraphNode> SceneGraph::FindNode(const std::filesystem::path
     return current->shared_from_this();
 }
 
-void SceneGraph::Refresh(uint32_t frameIndex)
+// Updates the transforms, bounding box and content flags of one node whose parent has already been refreshed.
+// Does not touch the node's dirty flags.
+void SceneGraph::RefreshNode(SceneGraphNode* current, bool supergraphTransformUpdated, bool supergraphContentUpdate)
+{
+    SceneGraphNode* parent = current->m_Parent;
+
+    // save the current local/global transforms as previous
+    current->m_PrevLocalTransform = current->m_LocalTransform;
+    current->m_PrevGlobalTransform = current->m_GlobalTransform;
+    current->m_PrevGlobalTransformFloat = current->m_GlobalTransformFloat;
+
+    if ((current->m_Dirty & SceneGraphNode::DirtyFlags::LocalTransform) != 0)
+    {
+        current->UpdateLocalTransform();
+    }
+
+    // update the global transform of the current node
+    if (parent)
+    {
+        current->m_GlobalTransform = current->m_HasLocalTransform
+            ? current->m_LocalTransform * parent->m_GlobalTransform
+            : parent->m_GlobalTransform;
+    }
+    else
+    {
+        current->m_GlobalTransform = current->m_LocalTransform;
+    }
+    current->m_GlobalTransformFloat = dm::affine3(current->m_GlobalTransform);
+
+    // initialize the global bbox of the current node, start with the leaf (or an empty box if there is no leaf)
+    if ((current->m_Dirty & (SceneGraphNode::DirtyFlags::SubgraphStructure | SceneGraphNode::DirtyFlags::SubgraphTransforms)) != 0 || supergraphTransformUpdated)
+    {
+        current->m_GlobalBoundingBox = dm::box3::empty();
+        if (current->m_Leaf)
+        {
+            dm::box3 localBoundingBox = current->m_Leaf->GetLocalBoundingBox();
+            if (!localBoundingBox.isempty())
+                current->m_GlobalBoundingBox = localBoundingBox * current->m_GlobalTransformFloat;
+        }
+    }
+
+    // initialize the content flags of the current node
+    if (supergraphContentUpdate || (current->m_Dirty & (SceneGraphNode::DirtyFlags::SubgraphStructure | SceneGraphNode::DirtyFlags::SubgraphContentUpdate)) != 0)
+    {
+        if (current->m_Leaf)
+            current->m_LeafContent = current->m_Leaf->GetContentFlags();
+        else
+            current->m_LeafContent = SceneContentFlags::None;
+
+        current->m_SubgraphContent = current->m_LeafContent;
+    }
+}
+
+void SceneGraph::RefreshWalker(uint32_t frameIndex)
 {
     struct StackItem
     {
@@ -956,8 +1038,6 @@ void SceneGraph::Refresh(uint32_t frameIndex)
         bool supergraphContentUpdate = false;
     };
 
-    bool structureDirty = HasPendingStructureChanges();
-
     StackItem context;
     std::vector<StackItem> stack;
 
@@ -967,54 +1047,10 @@ void SceneGraph::Refresh(uint32_t frameIndex)
         auto current = walker.Get();
         auto parent = current->m_Parent;
 
-        // save the current local/global transforms as previous
-        current->m_PrevLocalTransform = current->m_LocalTransform;
-        current->m_PrevGlobalTransform = current->m_GlobalTransform;
-        current->m_PrevGlobalTransformFloat = current->m_GlobalTransformFloat;
-
         bool currentTransformUpdated = (current->m_Dirty & SceneGraphNode::DirtyFlags::LocalTransform) != 0;
         bool currentContentUpdated = (current->m_Dirty & SceneGraphNode::DirtyFlags::SubgraphContentUpdate) != 0;
 
-        if (currentTransformUpdated)
-        {
-            current->UpdateLocalTransform();
-        }
-
-        // update the global transform of the current node
-        if (parent)
-        {
-            current->m_GlobalTransform = current->m_HasLocalTransform
-                ? current->m_LocalTransform * parent->m_GlobalTransform
-                : parent->m_GlobalTransform;
-        }
-        else
-        {
-            current->m_GlobalTransform = current->m_LocalTransform;
-        }
-        current->m_GlobalTransformFloat = dm::affine3(current->m_GlobalTransform);
-
-        // initialize the global bbox of the current node, start with the leaf (or an empty box if there is no leaf)
-        if ((current->m_Dirty & (SceneGraphNode::DirtyFlags::SubgraphStructure | SceneGraphNode::DirtyFlags::SubgraphTransforms)) != 0 || context.supergraphTransformUpdated)
-        {
-            current->m_GlobalBoundingBox = dm::box3::empty();
-            if (current->m_Leaf)
-            {
-                dm::box3 localBoundingBox = current->m_Leaf->GetLocalBoundingBox();
-                if (!localBoundingBox.isempty())
-                    current->m_GlobalBoundingBox = localBoundingBox * current->m_GlobalTransformFloat;
-            }
-        }
-
-        // initialize the content flags of the current node
-        if (context.supergraphContentUpdate || (current->m_Dirty & (SceneGraphNode::DirtyFlags::SubgraphStructure | SceneGraphNode::DirtyFlags::SubgraphContentUpdate)) != 0)
-        {
-            if (current->m_Leaf)
-                current->m_LeafContent = current->m_Leaf->GetContentFlags();
-            else
-                current->m_LeafContent = SceneContentFlags::None;
-
-            current->m_SubgraphContent = current->m_LeafContent;
-        }
+        RefreshNode(current, context.supergraphTransformUpdated, context.supergraphContentUpdate);
 
         // store the update frame number for skinned groups
         if (auto meshReference = dynamic_cast<SkinnedMeshReference*>(current->m_Leaf.get()))
@@ -1085,6 +1121,297 @@ void SceneGraph::Refresh(uint32_t frameIndex)
             }
         }
     }
+}
+
+namespace
+{
+    // Per-node results of the flattened refresh, read by the node's children.
+    enum FlatState : uint8_t
+    {
+        FlatState_Visited = 0x01,
+        FlatState_VisitChildren = 0x02,
+        FlatState_TransformUpdated = 0x04,  // the node or one of its ancestors has a new local transform
+        FlatState_ContentUpdated = 0x08     // the node or one of its ancestors has invalidated content
+    };
+
+    // Smallest number of nodes in a range, and smallest graph that is refreshed in parallel.
+    constexpr uint32_t c_MinFlatRangeSize = 256;
+    constexpr size_t c_MinNodesForParallelRefresh = 16384;
+}
+
+void SceneGraph::SetFlattenedRefresh(bool enable, tf::Executor* executor)
+{
+    m_FlattenedRefresh = enable;
+    m_RefreshExecutor = executor;
+
+    // rebuilt on the next refresh
+    m_Flat = FlatHierarchy();
+}
+
+void SceneGraph::BuildFlatHierarchy()
+{
+    m_Flat = FlatHierarchy();
+
+    // depth-first order, children in the same order as in the graph
+    std::vector<std::pair<SceneGraphNode*, int32_t>> stack;
+    if (m_Root)
+        stack.emplace_back(m_Root.get(), -1);
+
+    while (!stack.empty())
+    {
+        auto [node, parentIndex] = stack.back();
+        stack.pop_back();
+
+        int32_t index = int32_t(m_Flat.nodes.size());
+        m_Flat.nodes.push_back(node);
+        m_Flat.parents.push_back(parentIndex);
+        m_Flat.skinnedReferences.push_back(dynamic_cast<SkinnedMeshReference*>(node->m_Leaf.get()));
+
+        for (auto child = node->m_Children.rbegin(); child != node->m_Children.rend(); ++child)
+            stack.emplace_back(child->get(), index);
+    }
+
+    uint32_t nodeCount = uint32_t(m_Flat.nodes.size());
+    m_Flat.states.resize(nodeCount, 0);
+    m_Flat.subgraphEnds.resize(nodeCount);
+    for (uint32_t index = 0; index < nodeCount; index++)
+        m_Flat.subgraphEnds[index] = index + 1;
+
+    // children come after their parents, so one reverse pass finds the end of every subgraph
+    for (uint32_t index = nodeCount; index-- > 1; )
+    {
+        uint32_t& parentEnd = m_Flat.subgraphEnds[m_Flat.parents[index]];
+        parentEnd = std::max(parentEnd, m_Flat.subgraphEnds[index]);
+    }
+
+    size_t workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+#ifdef DONUT_WITH_TASKFLOW
+    if (m_RefreshExecutor)
+        workerCount = std::max<size_t>(m_RefreshExecutor->num_workers(), 1);
+#endif
+
+    // Cut the graph into ranges of whole subgraphs, a few per worker. The roots of the subgraphs that are
+    // too large for one range form the spine, which is refreshed serially before the ranges.
+    uint32_t maxRangeSize = std::max(c_MinFlatRangeSize, uint32_t(nodeCount / (workerCount * 8)));
+    for (uint32_t index = 0; index < nodeCount; )
+    {
+        uint32_t subgraphEnd = m_Flat.subgraphEnds[index];
+        if (subgraphEnd - index > maxRangeSize)
+        {
+            m_Flat.steps.push_back({ index, false });
+            m_Flat.spine.push_back(index);
+            ++index;
+            continue;
+        }
+
+        // siblings that follow each other share a range
+        if (!m_Flat.steps.empty() && m_Flat.steps.back().isRange && subgraphEnd - m_Flat.ranges.back().begin <= maxRangeSize)
+        {
+            m_Flat.ranges.back().end = subgraphEnd;
+        }
+        else
+        {
+            m_Flat.steps.push_back({ uint32_t(m_Flat.ranges.size()), true });
+            FlatRange& range = m_Flat.ranges.emplace_back();
+            range.begin = index;
+            range.end = subgraphEnd;
+        }
+
+        FlatRange& range = m_Flat.ranges.back();
+        int32_t parentIndex = m_Flat.parents[index];
+        if (parentIndex >= 0 && (range.rootParents.empty() || range.rootParents.back() != uint32_t(parentIndex)))
+            range.rootParents.push_back(uint32_t(parentIndex));
+
+        index = subgraphEnd;
+    }
+}
+
+// Refreshes one node of the flattened hierarchy if its parent has been refreshed with FlatState_VisitChildren.
+// Returns false if the node and its subgraph are skipped.
+bool SceneGraph::RefreshFlatNode(uint32_t index, std::vector<uint32_t>& skinnedUpdates)
+{
+    int32_t parentIndex = m_Flat.parents[index];
+    uint8_t parentState = (parentIndex >= 0) ? m_Flat.states[parentIndex] : uint8_t(FlatState_VisitChildren);
+    if ((parentState & FlatState_VisitChildren) == 0)
+    {
+        m_Flat.states[index] = 0;
+        return false;
+    }
+
+    SceneGraphNode* current = m_Flat.nodes[index];
+    bool supergraphTransformUpdated = (parentState & FlatState_TransformUpdated) != 0;
+    bool supergraphContentUpdate = (parentState & FlatState_ContentUpdated) != 0;
+    bool currentTransformUpdated = (current->m_Dirty & SceneGraphNode::DirtyFlags::LocalTransform) != 0;
+    bool currentContentUpdated = (current->m_Dirty & SceneGraphNode::DirtyFlags::SubgraphContentUpdate) != 0;
+
+    RefreshNode(current, supergraphTransformUpdated, supergraphContentUpdate);
+
+    // the skinned instances are updated after the parallel part, several joints may point at the same instance
+    if (currentTransformUpdated && m_Flat.skinnedReferences[index])
+        skinnedUpdates.push_back(index);
+
+    uint8_t state = FlatState_Visited;
+    if ((current->m_Dirty & SceneGraphNode::DirtyFlags::SubgraphMask) != 0 || supergraphTransformUpdated || supergraphContentUpdate)
+        state |= FlatState_VisitChildren;
+    if (currentTransformUpdated || supergraphTransformUpdated)
+        state |= FlatState_TransformUpdated;
+    if (currentContentUpdated || supergraphContentUpdate)
+        state |= FlatState_ContentUpdated;
+    m_Flat.states[index] = state;
+
+    // save the dirty flag to update the same nodes' previous transforms on the next frame
+    current->m_Dirty = (currentTransformUpdated || supergraphTransformUpdated)
+        ? SceneGraphNode::DirtyFlags::PrevTransform
+        : SceneGraphNode::DirtyFlags::None;
+
+    return true;
+}
+
+// Folds the bounding box, dirty flags and content flags of a refreshed node into its parent.
+void SceneGraph::PropagateFlatNode(uint32_t index)
+{
+    SceneGraphNode* current = m_Flat.nodes[index];
+    SceneGraphNode* parent = m_Flat.nodes[m_Flat.parents[index]];
+
+    parent->m_GlobalBoundingBox |= current->m_GlobalBoundingBox;
+    if ((current->m_Dirty & SceneGraphNode::DirtyFlags::PrevTransform) != 0)
+        parent->m_Dirty |= SceneGraphNode::DirtyFlags::SubgraphPrevTransforms;
+    parent->m_Dirty |= current->m_Dirty & SceneGraphNode::DirtyFlags::SubgraphMask;
+    parent->m_SubgraphContent |= current->m_SubgraphContent;
+}
+
+// Refreshes the subgraphs of a range top-down, skipping the clean ones. Every refreshed node is folded into
+// its parent as soon as its subgraph is finished, while the parent is still in the cache.
+// The roots of the range are folded into their spine parents later.
+void SceneGraph::RefreshFlatRange(FlatRange& range)
+{
+    range.skinnedUpdates.clear();
+
+    range.refreshed = range.rootParents.empty(); // the range that starts at the root node
+    for (uint32_t parentIndex : range.rootParents)
+        range.refreshed |= (m_Flat.states[parentIndex] & FlatState_VisitChildren) != 0;
+
+    if (!range.refreshed)
+        return;
+
+    auto finishOpenNodes = [this, &range](uint32_t next)
+    {
+        while (!range.openNodes.empty() && m_Flat.subgraphEnds[range.openNodes.back()] <= next)
+        {
+            uint32_t finished = range.openNodes.back();
+            range.openNodes.pop_back();
+            if (!range.openNodes.empty())
+                PropagateFlatNode(finished);
+        }
+    };
+
+    for (uint32_t index = range.begin; index < range.end; )
+    {
+        finishOpenNodes(index);
+
+        if (!RefreshFlatNode(index, range.skinnedUpdates))
+        {
+            index = m_Flat.subgraphEnds[index];
+            continue;
+        }
+
+        range.openNodes.push_back(index);
+        index = (m_Flat.states[index] & FlatState_VisitChildren) != 0 ? index + 1 : m_Flat.subgraphEnds[index];
+    }
+
+    finishOpenNodes(range.end);
+}
+
+void SceneGraph::RefreshFlattened(uint32_t frameIndex, bool structureDirty)
+{
+    if (structureDirty || m_Flat.nodes.empty() || m_Flat.nodes[0] != m_Root.get())
+        BuildFlatHierarchy();
+
+    if (m_Flat.nodes.empty())
+        return;
+
+    m_Flat.spineSkinnedUpdates.clear();
+    for (uint32_t index : m_Flat.spine)
+        RefreshFlatNode(index, m_Flat.spineSkinnedUpdates);
+
+    // when the root has no dirty subgraphs, the ranges only check their roots
+    bool refreshInParallel = !m_Flat.spine.empty()
+        && (m_Flat.states[0] & FlatState_VisitChildren) != 0
+        && m_Flat.nodes.size() >= c_MinNodesForParallelRefresh;
+
+#ifdef DONUT_WITH_TASKFLOW
+    if (refreshInParallel && m_RefreshExecutor)
+    {
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t(0), m_Flat.ranges.size(), size_t(1), [this](size_t index)
+        {
+            RefreshFlatRange(m_Flat.ranges[index]);
+        });
+
+        if (m_RefreshExecutor->this_worker_id() >= 0)
+            m_RefreshExecutor->corun(taskflow);
+        else
+            m_RefreshExecutor->run(taskflow).wait();
+    }
+    else
+#else
+    (void)refreshInParallel;
+#endif
+    {
+        for (FlatRange& range : m_Flat.ranges)
+            RefreshFlatRange(range);
+    }
+
+    // finish bottom-up: fold the range roots and the spine nodes into their parents
+    for (auto step = m_Flat.steps.rbegin(); step != m_Flat.steps.rend(); ++step)
+    {
+        if (step->isRange)
+        {
+            const FlatRange& range = m_Flat.ranges[step->index];
+            if (!range.refreshed)
+                continue;
+
+            for (uint32_t root = range.begin; root < range.end; root = m_Flat.subgraphEnds[root])
+            {
+                if ((m_Flat.states[root] & FlatState_Visited) != 0 && m_Flat.parents[root] >= 0)
+                    PropagateFlatNode(root);
+            }
+        }
+        else if ((m_Flat.states[step->index] & FlatState_Visited) != 0 && m_Flat.parents[step->index] >= 0)
+        {
+            PropagateFlatNode(step->index);
+        }
+    }
+
+    // store the update frame number for skinned groups
+    auto updateSkinnedInstances = [this, frameIndex](const std::vector<uint32_t>& skinnedUpdates)
+    {
+        for (uint32_t index : skinnedUpdates)
+        {
+            auto instance = m_Flat.skinnedReferences[index]->m_Instance.lock();
+            if (instance)
+                instance->m_LastUpdateFrameIndex = frameIndex;
+        }
+    };
+
+    updateSkinnedInstances(m_Flat.spineSkinnedUpdates);
+    for (const FlatRange& range : m_Flat.ranges)
+        updateSkinnedInstances(range.skinnedUpdates);
+}
+
+void SceneGraph::Refresh(uint32_t frameIndex)
+{
+    bool structureDirty = HasPendingStructureChanges();
+    bool boundsDirty = m_Root && (m_Root->m_Dirty & (SceneGraphNode::DirtyFlags::SubgraphStructure
+        | SceneGraphNode::DirtyFlags::SubgraphTransforms | SceneGraphNode::DirtyFlags::SubgraphContentUpdate)) != 0;
+
+    if (boundsDirty)
+        ++m_BoundsVersion;
+
+    if (m_FlattenedRefresh)
+        RefreshFlattened(frameIndex, structureDirty);
+    else
+        RefreshWalker(frameIndex);
 
     if (structureDirty)
     {
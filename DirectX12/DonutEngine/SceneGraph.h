@@ -31,6 +31,12 @@
 #include <functional>
 #include <filesystem>
 #include <stack>
+#include <vector>
+
+namespace tf
+{
+    class Executor;
+}
 
 namespace donut::engine
 {
@@ -433,6 +439,7 @@ namespace donut::engine
         void SetTargetNode(const std::shared_ptr<SceneGraphNode>& node) { m_TargetNode = node; }
         void SetLeafProperyName(const std::string& name) { m_LeafPropertyName = name; }
         bool Apply(float time) const;  // NOLINT(modernize-use-nodiscard)
+        bool ApplyValue(const dm::float4& value) const;  // NOLINT(modernize-use-nodiscard)
     };
 
     class SceneGraphAnimation : public SceneGraphLeaf
@@ -441,6 +448,13 @@ namespace donut::engine
         std::vector<std::shared_ptr<SceneGraphAnimationChannel>> m_Channels;
         float m_Duration = 0.f;
 
+        // The channel samplers compiled into one clip on the first Apply, shared with clones of this animation.
+        // Each animation keeps its own cursor, so playing it forward in time does not search the keyframes.
+        mutable std::shared_ptr<animation::CompiledClip> m_Clip;
+        mutable animation::ClipCursor m_Cursor;
+        mutable std::vector<dm::float4> m_Values;
+        mutable std::vector<uint8_t> m_ValidChannels;
+
     public:
         SceneGraphAnimation() = default;
 
@@ -451,6 +465,9 @@ namespace donut::engine
         [[nodiscard]] bool IsVald() const;
         bool Apply(float time) const;  // NOLINT(modernize-use-nodiscard)
         void AddChannel(const std::shared_ptr<SceneGraphAnimationChannel>& channel);
+
+        // Drops the compiled clip, so that the next Apply picks up changes made to the keyframes of the channel samplers.
+        void InvalidateClip() { m_Clip.reset(); }
     };
 
     // A container that tracks unique resources of the same type used by some entity, for example unique meshes used in a scene graph.
@@ -523,6 +540,40 @@ namespace donut::engine
     class SceneGraph : public std::enable_shared_from_this<SceneGraph>
     {
     private:
+        // A contiguous run of whole subgraphs in the flattened hierarchy, refreshed by one task.
+        // The parents of the subgraph roots are spine nodes, which are refreshed serially.
+        struct FlatRange
+        {
+            uint32_t begin = 0;
+            uint32_t end = 0;
+            std::vector<uint32_t> rootParents;          // distinct spine parents of the subgraph roots
+            bool refreshed = false;                     // false if all root parents were skipped
+            std::vector<uint32_t> openNodes;            // refreshed nodes whose subgraphs are not finished yet
+            std::vector<uint32_t> skinnedUpdates;
+        };
+
+        // One step of the serial part of the flattened refresh: either a spine node or a range.
+        struct FlatStep
+        {
+            uint32_t index;
+            bool isRange;
+        };
+
+        // Depth-first copy of the graph used by the flattened refresh path, rebuilt when the structure changes.
+        // The node arrays are indexed by the node's position in depth-first order.
+        struct FlatHierarchy
+        {
+            std::vector<SceneGraphNode*> nodes;
+            std::vector<int32_t> parents;               // -1 for the root
+            std::vector<uint32_t> subgraphEnds;         // one past the last node of the node's subgraph
+            std::vector<SkinnedMeshReference*> skinnedReferences;
+            std::vector<uint8_t> states;                // FlatState bits written by the current refresh
+            std::vector<uint32_t> spine;                // nodes whose subgraphs are too large for one range
+            std::vector<FlatRange> ranges;
+            std::vector<FlatStep> steps;                // spine nodes and ranges, in depth-first order
+            std::vector<uint32_t> spineSkinnedUpdates;
+        };
+
         friend class SceneGraphNode;
         std::shared_ptr<SceneGraphNode> m_Root;
         ResourceTracker<Material> m_Materials;
@@ -534,6 +585,19 @@ namespace donut::engine
         std::vector<std::shared_ptr<SceneGraphAnimation>> m_Animations;
         std::vector<std::shared_ptr<SceneCamera>> m_Cameras;
         std::vector<std::shared_ptr<Light>> m_Lights;
+        FlatHierarchy m_Flat;
+        uint64_t m_StructureVersion = 0;
+        uint64_t m_BoundsVersion = 0;
+        bool m_FlattenedRefresh = false;
+        tf::Executor* m_RefreshExecutor = nullptr;
+
+        static void RefreshNode(SceneGraphNode* current, bool supergraphTransformUpdated, bool supergraphContentUpdate);
+        void RefreshWalker(uint32_t frameIndex);
+        void RefreshFlattened(uint32_t frameIndex, bool structureDirty);
+        void BuildFlatHierarchy();
+        bool RefreshFlatNode(uint32_t index, std::vector<uint32_t>& skinnedUpdates);
+        void RefreshFlatRange(FlatRange& range);
+        void PropagateFlatNode(uint32_t index);
 
     protected:
         virtual void RegisterLeaf(const std::shared_ptr<SceneGraphLeaf>& leaf);
@@ -561,6 +625,11 @@ namespace donut::engine
         [[nodiscard]] bool HasPendingStructureChanges() const { return m_Root && (m_Root->m_Dirty & SceneGraphNode::DirtyFlags::SubgraphStructure) != 0; }
         [[nodiscard]] bool HasPendingTransformChanges() const { return m_Root && (m_Root->m_Dirty & (SceneGraphNode::DirtyFlags::SubgraphTransforms | SceneGraphNode::DirtyFlags::SubgraphPrevTransforms)) != 0; }
 
+        // Incremented when a leaf is added to or removed from the graph.
+        [[nodiscard]] uint64_t GetStructureVersion() const { return m_StructureVersion; }
+        // Incremented by Refresh when node transforms, bounding boxes or content flags may have changed.
+        [[nodiscard]] uint64_t GetBoundsVersion() const { return m_BoundsVersion; }
+
         // Replaces the current root node of the graph with the new one.
         std::shared_ptr<SceneGraphNode> SetRootNode(const std::shared_ptr<SceneGraphNode>& root);
 
@@ -582,6 +651,14 @@ namespace donut::engine
         // If multiple nodes within one parent have the same name matching that component of the path, only the first node will be considered.
         [[nodiscard]] std::shared_ptr<SceneGraphNode> FindNode(const std::filesystem::path& path, SceneGraphNode* context = nullptr) const;
 
+        // Selects how Refresh traverses the graph. By default it walks the node pointers.
+        // The flattened path keeps a depth-first copy of the hierarchy as arrays of nodes and parent indices,
+        // rebuilt only when the structure changes. It skips clean subgraphs, computes bounding boxes in a
+        // bottom-up pass, and refreshes independent subgraphs of large graphs in parallel when an executor is
+        // provided. Both paths produce the same transforms, bounding boxes and dirty flags.
+        void SetFlattenedRefresh(bool enable, tf::Executor* executor = nullptr);
+        [[nodiscard]] bool IsFlattenedRefreshEnabled() const { return m_FlattenedRefresh; }
+
         void Refresh(uint32_t frameIndex);
     };
 
@@ -17,6 +17,7 @@
 #include "../DonutRender/GeometryPasses.h"
 #include "../DonutRender/JointsRenderPass.h"
 #include "../DonutRender/LightProbeProcessingPass.h"
+#include "../DonutRender/MeshInstanceBvh.h"
 #include "../DonutRender/MipMapGenPass.h"
 #include "../DonutRender/PixelReadbackPass.h"
 #include "../DonutRender/PlanarShadowMap.h"
@@ -24,6 +24,8 @@
 #include <donut/render/GeometryPasses.h>
 #include <donut/engine/SceneGraph.h>
 #include <donut/engine/View.h>
+#include <algorithm>
+#include <tuple>
 
 using namespace donut::math;
 using namespace donut::engine;
@@ -141,12 +143,155 @@ void InstancedOpaqueDrawStrategy::FillChunk()
     m_ReadPtr = 0;
 }
 
+// Returns the strategy's BVH, brought up to date with the graph, if the strategy can cull with it:
+// the root node must be the root of a graph, and the graph must have no unrefreshed structure changes.
+static MeshInstanceBvh* PrepareInstanceBvh(std::shared_ptr<MeshInstanceBvh>& bvh, const std::shared_ptr<SceneGraphNode>& rootNode)
+{
+    if (!rootNode)
+        return nullptr;
+
+    auto graph = rootNode->GetGraph();
+    if (!graph || graph->GetRootNode() != rootNode)
+        return nullptr;
+
+    if (!bvh)
+        bvh = std::make_shared<MeshInstanceBvh>();
+
+    if (!bvh->Update(*graph))
+        return nullptr;
+
+    return bvh.get();
+}
+
+void InstancedOpaqueDrawStrategy::UpdateSortedGeometries()
+{
+    if (m_SortedBuildCount == m_Bvh->GetBuildCount())
+        return;
+
+    m_SortedBuildCount = m_Bvh->GetBuildCount();
+
+    const auto& instances = m_Bvh->GetInstances();
+    uint32_t instanceCount = uint32_t(instances.size());
+
+    m_SortedGeometries.clear();
+    m_InstanceGeometryOffsets.resize(instanceCount + 1);
+    for (uint32_t instance = 0; instance < instanceCount; instance++)
+    {
+        const MeshInstance* meshInstance = instances[instance];
+        const MeshInfo* mesh = meshInstance->GetMesh().get();
+        m_InstanceGeometryOffsets[instance] = uint32_t(m_SortedGeometries.size());
+        for (uint32_t geometry = 0; geometry < uint32_t(mesh->geometries.size()); geometry++)
+            m_SortedGeometries.push_back({ mesh->geometries[geometry]->material.get(), mesh->buffers.get(), mesh, meshInstance, instance, geometry });
+    }
+    m_InstanceGeometryOffsets[instanceCount] = uint32_t(m_SortedGeometries.size());
+
+    // the same order as CompareDrawItemsOpaque, over the whole scene instead of one chunk
+    std::sort(m_SortedGeometries.begin(), m_SortedGeometries.end(), [](const SortedGeometry& a, const SortedGeometry& b)
+    {
+        return std::tie(a.material, a.buffers, a.mesh, a.meshInstance, a.geometry)
+            < std::tie(b.material, b.buffers, b.mesh, b.meshInstance, b.geometry);
+    });
+
+    m_InstanceGeometryRanks.resize(m_SortedGeometries.size());
+    for (uint32_t rank = 0; rank < uint32_t(m_SortedGeometries.size()); rank++)
+    {
+        const SortedGeometry& sorted = m_SortedGeometries[rank];
+        m_InstanceGeometryRanks[m_InstanceGeometryOffsets[sorted.instance] + sorted.geometry] = rank;
+    }
+}
+
+// Culls the instances with the BVH and puts all visible geometries into the chunk, in the cached draw order.
+// Returns false if the BVH cannot be used.
+bool InstancedOpaqueDrawStrategy::FillFromBvh(const std::shared_ptr<SceneGraphNode>& rootNode)
+{
+    if (!UseInstanceBvh || !PrepareInstanceBvh(m_Bvh, rootNode))
+        return false;
+
+    UpdateSortedGeometries();
+
+    const auto& instances = m_Bvh->GetInstances();
+    const auto& instanceNodes = m_Bvh->GetInstanceNodes();
+
+    m_VisibleInstances.clear();
+    m_Bvh->Cull(m_ViewFrustum, SceneContentFlags::OpaqueMeshes | SceneContentFlags::AlphaTestedMeshes, m_VisibleInstances);
+
+    m_VisibleRanks.clear();
+    for (uint32_t instance : m_VisibleInstances)
+    {
+        const engine::MeshInfo* mesh = instances[instance]->GetMesh().get();
+        uint32_t firstRank = m_InstanceGeometryOffsets[instance];
+        size_t geometryCount = std::min<size_t>(mesh->geometries.size(), m_InstanceGeometryOffsets[instance + 1] - firstRank);
+
+        for (size_t geometryIndex = 0; geometryIndex < geometryCount; geometryIndex++)
+        {
+            const auto& geometry = mesh->geometries[geometryIndex];
+            auto domain = geometry->material->domain;
+            if (domain != MaterialDomain::Opaque && domain != MaterialDomain::AlphaTested)
+                continue;
+
+            if (mesh->geometries.size() > 1 && !mesh->skinPrototype)
+            {
+                dm::box3 geometryGlobalBoundingBox = geometry->objectSpaceBounds * instanceNodes[instance]->GetLocalToWorldTransformFloat();
+                if (!m_ViewFrustum.intersectsWith(geometryGlobalBoundingBox))
+                    continue;
+            }
+
+            m_VisibleRanks.push_back(m_InstanceGeometryRanks[firstRank + geometryIndex]);
+        }
+    }
+
+    // sorting the ranks puts the items in draw order without comparing them
+    std::sort(m_VisibleRanks.begin(), m_VisibleRanks.end());
+
+    size_t itemCount = m_VisibleRanks.size();
+    m_InstanceChunk.resize(itemCount);
+    m_InstancePtrChunk.resize(itemCount);
+
+    for (size_t i = 0; i < itemCount; i++)
+    {
+        const SortedGeometry& sorted = m_SortedGeometries[m_VisibleRanks[i]];
+
+        DrawItem& item = m_InstanceChunk[i];
+        item.instance = sorted.meshInstance;
+        item.mesh = sorted.mesh;
+        item.geometry = sorted.mesh->geometries[sorted.geometry].get();
+        item.material = item.geometry->material.get();
+        item.buffers = item.mesh->buffers.get();
+        item.cullMode = (item.material->doubleSided) ? nvrhi::RasterCullMode::None : nvrhi::RasterCullMode::Back;
+        item.distanceToCamera = 0; // don't care
+
+        m_InstancePtrChunk[i] = &item;
+    }
+
+    return true;
+}
+
 void donut::render::InstancedOpaqueDrawStrategy::PrepareForView(const std::shared_ptr<engine::SceneGraphNode>& rootNode, const engine::IView& view)
 {
-    m_Walker = SceneGraphWalker(rootNode.get());
     m_ViewFrustum = view.GetViewFrustum();
     m_InstanceChunk.clear();
+    m_InstancePtrChunk.clear();
     m_ReadPtr = 0;
+
+    // with the BVH, the whole view fits in one chunk and there is nothing left to walk
+    if (FillFromBvh(rootNode))
+        m_Walker = SceneGraphWalker(nullptr);
+    else
+        m_Walker = SceneGraphWalker(rootNode.get());
+}
+
+void InstancedOpaqueDrawStrategy::SetInstanceBvh(std::shared_ptr<MeshInstanceBvh> bvh)
+{
+    if (bvh == m_Bvh)
+        return;
+
+    m_Bvh = std::move(bvh);
+
+    // the build counts of different hierarchies are unrelated, so the cached draw order must be rebuilt
+    m_SortedBuildCount = 0;
+    m_SortedGeometries.clear();
+    m_InstanceGeometryOffsets.clear();
+    m_InstanceGeometryRanks.clear();
 }
 
 const DrawItem* InstancedOpaqueDrawStrategy::GetNextItem()
@@ -169,6 +314,118 @@ static int CompareDrawItemsTransparent(const DrawItem* a, const DrawItem* b)
     return a->distanceToCamera > b->distanceToCamera;
 }
 
+void TransparentDrawStrategy::AddInstanceItems(const MeshInstance* meshInstance, const SceneGraphNode* node,
+    const frustum& viewFrustum, const float3& viewOrigin)
+{
+    const engine::MeshInfo* mesh = meshInstance->GetMesh().get();
+    for (const auto& geometry : mesh->geometries)
+    {
+        const auto& material = geometry->material;
+        if (material->domain == MaterialDomain::Opaque || material->domain == MaterialDomain::AlphaTested)
+            continue;
+
+        dm::box3 geometryGlobalBoundingBox;
+        if (mesh->geometries.size() > 1 && mesh->skinPrototype.use_count() != 0)
+        {
+            geometryGlobalBoundingBox = geometry->objectSpaceBounds * node->GetLocalToWorldTransformFloat();
+            if (!viewFrustum.intersectsWith(geometryGlobalBoundingBox))
+                continue;
+        }
+        else
+        {
+            geometryGlobalBoundingBox = node->GetGlobalBoundingBox();
+        }
+
+        DrawItem item{};
+        item.instance = meshInstance;
+        item.mesh = mesh;
+        item.geometry = geometry.get();
+        item.material = geometry->material.get();
+        item.buffers = mesh->buffers.get();
+        item.distanceToCamera = length(geometryGlobalBoundingBox.center() - viewOrigin);
+        if (material->doubleSided)
+        {
+            if (DrawDoubleSidedMaterialsSeparately)
+            {
+                item.cullMode = nvrhi::RasterCullMode::Front;
+                m_InstancesToDraw.push_back(item);
+                item.cullMode = nvrhi::RasterCullMode::Back;
+                m_InstancesToDraw.push_back(item);
+            }
+            else
+            {
+                item.cullMode = nvrhi::RasterCullMode::None;
+                m_InstancesToDraw.push_back(item);
+            }
+        }
+        else
+        {
+            item.cullMode = nvrhi::RasterCullMode::Back;
+            m_InstancesToDraw.push_back(item);
+        }
+    }
+}
+
+void TransparentDrawStrategy::SortItems()
+{
+    size_t itemCount = m_InstancesToDraw.size();
+    m_InstancePtrsToDraw.resize(itemCount);
+
+    bool sameItems = m_PreviousKeys.size() == itemCount;
+    for (size_t i = 0; sameItems && i < itemCount; i++)
+    {
+        const DrawItem& item = m_InstancesToDraw[i];
+        sameItems = m_PreviousKeys[i] == DrawItemKey{ item.instance, item.geometry, item.cullMode };
+    }
+
+    for (size_t i = 0; i < itemCount; i++)
+    {
+        m_InstancePtrsToDraw[i] = &m_InstancesToDraw[sameItems ? m_PreviousOrder[i] : i];
+    }
+
+    bool sorted = false;
+    if (sameItems)
+    {
+        // The camera and the objects move little between frames, so the previous order is almost sorted,
+        // and insertion sort finishes in close to linear time. If it does not, sort from scratch.
+        size_t moveBudget = itemCount * 4;
+        sorted = true;
+
+        for (size_t i = 1; i < itemCount && sorted; i++)
+        {
+            const DrawItem* item = m_InstancePtrsToDraw[i];
+            size_t j = i;
+            while (j > 0 && CompareDrawItemsTransparent(item, m_InstancePtrsToDraw[j - 1]))
+            {
+                if (moveBudget == 0)
+                {
+                    sorted = false;
+                    break;
+                }
+
+                --moveBudget;
+                m_InstancePtrsToDraw[j] = m_InstancePtrsToDraw[j - 1];
+                --j;
+            }
+            m_InstancePtrsToDraw[j] = item;
+        }
+    }
+
+    if (!sorted && itemCount > 1)
+    {
+        std::sort(m_InstancePtrsToDraw.data(), m_InstancePtrsToDraw.data() + m_InstancePtrsToDraw.size(), CompareDrawItemsTransparent);
+    }
+
+    m_PreviousKeys.resize(itemCount);
+    m_PreviousOrder.resize(itemCount);
+    for (size_t i = 0; i < itemCount; i++)
+    {
+        const DrawItem& item = m_InstancesToDraw[i];
+        m_PreviousKeys[i] = DrawItemKey{ item.instance, item.geometry, item.cullMode };
+        m_PreviousOrder[i] = uint32_t(m_InstancePtrsToDraw[i] - m_InstancesToDraw.data());
+    }
+}
+
 void TransparentDrawStrategy::PrepareForView(const std::shared_ptr<engine::SceneGraphNode>& rootNode, const IView& view)
 {
     m_ReadPtr = 0;
@@ -179,91 +436,45 @@ void TransparentDrawStrategy::PrepareForView(const std::shared_ptr<engine::Scene
     float3 viewOrigin = view.GetViewOrigin();
     auto viewFrustum = view.GetViewFrustum();
 
-    SceneGraphWalker walker(rootNode.get());
-    while (walker)
+    MeshInstanceBvh* bvh = UseInstanceBvh ? PrepareInstanceBvh(m_Bvh, rootNode) : nullptr;
+    if (bvh)
     {
-        auto relevantContentFlags = SceneContentFlags::BlendedMeshes;
-        bool subgraphContentRelevant = (walker->GetSubgraphContentFlags() & relevantContentFlags) != 0;
-        bool nodeContentsRelevant = (walker->GetLeafContentFlags() & relevantContentFlags) != 0;
+        m_VisibleInstances.clear();
+        bvh->Cull(viewFrustum, SceneContentFlags::BlendedMeshes, m_VisibleInstances);
 
-        bool nodeVisible = false;
-        if (subgraphContentRelevant)
+        for (uint32_t instance : m_VisibleInstances)
+            AddInstanceItems(bvh->GetInstances()[instance], bvh->GetInstanceNodes()[instance], viewFrustum, viewOrigin);
+    }
+    else
+    {
+        SceneGraphWalker walker(rootNode.get());
+        while (walker)
         {
-            nodeVisible = viewFrustum.intersectsWith(walker->GetGlobalBoundingBox());
+            auto relevantContentFlags = SceneContentFlags::BlendedMeshes;
+            bool subgraphContentRelevant = (walker->GetSubgraphContentFlags() & relevantContentFlags) != 0;
+            bool nodeContentsRelevant = (walker->GetLeafContentFlags() & relevantContentFlags) != 0;
 
-            if (nodeVisible && nodeContentsRelevant)
+            bool nodeVisible = false;
+            if (subgraphContentRelevant)
             {
-                auto meshInstance = dynamic_cast<MeshInstance*>(walker->GetLeaf().get());
-                if (meshInstance)
-                {
-                    const engine::MeshInfo* mesh = meshInstance->GetMesh().get();
-                    for (const auto& geometry : mesh->geometries)
-                    {
-                        const auto& material = geometry->material;
-                        if (material->domain == MaterialDomain::Opaque || material->domain == MaterialDomain::AlphaTested)
-                            continue;
+                nodeVisible = viewFrustum.intersectsWith(walker->GetGlobalBoundingBox());
 
-                        dm::box3 geometryGlobalBoundingBox;
-                        if (mesh->geometries.size() > 1 && mesh->skinPrototype.use_count() != 0)
-                        {
-                            geometryGlobalBoundingBox = geometry->objectSpaceBounds * walker->GetLocalToWorldTransformFloat();
-                            if (!viewFrustum.intersectsWith(geometryGlobalBoundingBox))
-                                continue;
-                        }
-                        else
-                        {
-                            geometryGlobalBoundingBox = walker->GetGlobalBoundingBox();
-                        }
-
-                        DrawItem item{};
-                        item.instance = meshInstance;
-                        item.mesh = mesh;
-                        item.geometry = geometry.get();
-                        item.material = geometry->material.get();
-                        item.buffers = mesh->buffers.get();
-                        item.distanceToCamera = length(geometryGlobalBoundingBox.center() - viewOrigin);
-                        if (material->doubleSided)
-                        {
-                            if (DrawDoubleSidedMaterialsSeparately)
-                            {
-                                item.cullMode = nvrhi::RasterCullMode::Front;
-                                m_InstancesToDraw.push_back(item);
-                                item.cullMode = nvrhi::RasterCullMode::Back;
-                                m_InstancesToDraw.push_back(item);
-                            }
-                            else
-                            {
-                                item.cullMode = nvrhi::RasterCullMode::None;
-                                m_InstancesToDraw.push_back(item);
-                            }
-                        }
-                        else
-                        {
-                            item.cullMode = nvrhi::RasterCullMode::Back;
-                            m_InstancesToDraw.push_back(item);
-                        }
-                    }
+                if (nodeVisible && nodeContentsRelevant)
+                {
+                    auto meshInstance = dynamic_cast<MeshInstance*>(walker->GetLeaf().get());
+                    if (meshInstance)
+                        AddInstanceItems(meshInstance, walker.Get(), viewFrustum, viewOrigin);
                 }
             }
-        }
 
-        walker.Next(nodeVisible);
+            walker.Next(nodeVisible);
+        }
     }
 
     if (m_InstancesToDraw.empty())
         return;
 
-    m_InstancePtrsToDraw.resize(m_InstancesToDraw.size());
-
-    for (size_t i = 0; i < m_InstancesToDraw.size(); i++)
-    {
-        m_InstancePtrsToDraw[i] = &m_InstancesToDraw[i];
-    }
-
-    if (m_InstancePtrsToDraw.size() > 1)
-    {
-        std::sort(m_InstancePtrsToDraw.data(), m_InstancePtrsToDraw.data() + m_InstancePtrsToDraw.size(), CompareDrawItemsTransparent);
-    }
+    SortItems();
 }
 
 const DrawItem* TransparentDrawStrategy::GetNextItem()
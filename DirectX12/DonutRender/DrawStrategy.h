@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../DonutEngine/SceneGraph.h"
+#include "../DonutRender/MeshInstanceBvh.h"
 #include <memory>
 #include <vector>
 
@@ -63,9 +64,25 @@ namespace donut::render
         void SetData(const DrawItem* data, size_t count);
     };
     
+    // When prepared for the root node of a scene graph, the opaque and transparent strategies cull the mesh instances
+    // with a MeshInstanceBvh instead of walking the graph. Strategies that draw the same graph can share one hierarchy.
+    // Otherwise, or while the graph has structure changes that have not been refreshed, they walk the graph.
+
     class InstancedOpaqueDrawStrategy : public IDrawStrategy
     {
     private:
+        // A geometry of a BVH instance, in the cached draw order.
+        struct SortedGeometry
+        {
+            // the sort key, copied out of the instance to keep the sort cache friendly
+            const engine::Material* material;
+            const engine::BufferGroup* buffers;
+            const engine::MeshInfo* mesh;
+            const engine::MeshInstance* meshInstance;
+            uint32_t instance;
+            uint32_t geometry;
+        };
+
         dm::frustum m_ViewFrustum;
         engine::SceneGraphWalker m_Walker;
         std::vector<DrawItem> m_InstanceChunk;
@@ -73,9 +90,20 @@ namespace donut::render
         size_t m_ReadPtr = 0;
         size_t m_ChunkSize = 128;
 
+        std::shared_ptr<MeshInstanceBvh> m_Bvh;
+        uint64_t m_SortedBuildCount = 0;
+        std::vector<SortedGeometry> m_SortedGeometries;     // all geometries of the BVH instances, in draw order
+        std::vector<uint32_t> m_InstanceGeometryOffsets;    // range of each instance's ranks in m_InstanceGeometryRanks
+        std::vector<uint32_t> m_InstanceGeometryRanks;      // positions in m_SortedGeometries, by instance and geometry
+        std::vector<uint32_t> m_VisibleInstances;
+        std::vector<uint32_t> m_VisibleRanks;
+
         void FillChunk();
+        void UpdateSortedGeometries();
+        bool FillFromBvh(const std::shared_ptr<engine::SceneGraphNode>& rootNode);
 
     public:
+        bool UseInstanceBvh = true;
 
         void PrepareForView(
             const std::shared_ptr<engine::SceneGraphNode>& rootNode,
@@ -85,22 +113,51 @@ namespace donut::render
 
         [[nodiscard]] size_t GetChunkSize() const { return m_ChunkSize; }
         void SetChunkSize(size_t size) { m_ChunkSize = std::max<size_t>(size, 1u); }
+
+        [[nodiscard]] const std::shared_ptr<MeshInstanceBvh>& GetInstanceBvh() const { return m_Bvh; }
+        void SetInstanceBvh(std::shared_ptr<MeshInstanceBvh> bvh);
     };
 
     class TransparentDrawStrategy : public IDrawStrategy
     {
     private:
+        // Identifies a draw item between frames.
+        struct DrawItemKey
+        {
+            const engine::MeshInstance* instance;
+            const engine::MeshGeometry* geometry;
+            nvrhi::RasterCullMode cullMode;
+
+            bool operator==(const DrawItemKey& other) const { return instance == other.instance && geometry == other.geometry && cullMode == other.cullMode; }
+        };
+
         std::vector<DrawItem> m_InstancesToDraw;
         std::vector<const DrawItem*> m_InstancePtrsToDraw;
         size_t m_ReadPtr = 0;
 
+        std::shared_ptr<MeshInstanceBvh> m_Bvh;
+        std::vector<uint32_t> m_VisibleInstances;
+
+        // The items of the previous frame in the order they were collected, and their sorted order.
+        // When the same items are collected again, sorting starts from the previous order.
+        std::vector<DrawItemKey> m_PreviousKeys;
+        std::vector<uint32_t> m_PreviousOrder;
+
+        void AddInstanceItems(const engine::MeshInstance* meshInstance, const engine::SceneGraphNode* node,
+            const dm::frustum& viewFrustum, const dm::float3& viewOrigin);
+        void SortItems();
+
     public:
         bool DrawDoubleSidedMaterialsSeparately = true;
+        bool UseInstanceBvh = true;
         
         void PrepareForView(
             const std::shared_ptr<engine::SceneGraphNode>& rootNode,
             const engine::IView& view) override;
 
         const DrawItem* GetNextItem() override;
+
+        [[nodiscard]] const std::shared_ptr<MeshInstanceBvh>& GetInstanceBvh() const { return m_Bvh; }
+        void SetInstanceBvh(std::shared_ptr<MeshInstanceBvh> bvh) { m_Bvh = std::move(bvh); }
     };
 }
\ No newline at end of file
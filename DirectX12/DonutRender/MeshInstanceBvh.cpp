@@ -0,0 +1,395 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <donut/render/MeshInstanceBvh.h>
+#include <algorithm>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DONUT_BVH_SSE 1
+#else
+#define DONUT_BVH_SSE 0
+#endif
+
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+namespace
+{
+    constexpr uint32_t c_InvalidIndex = UINT32_MAX;
+
+    struct BuildItem
+    {
+        box3 bounds;
+        float3 center;
+        uint32_t contentFlags;
+        uint32_t instance;
+    };
+
+    struct BuildResult
+    {
+        uint32_t node;
+        box3 bounds;
+        uint32_t contentFlags;
+    };
+
+    // Writes the bounds and content flags of one child of a node. Returns true if they have changed.
+    bool SetChildBounds(MeshInstanceBvh::Node& node, uint32_t child, const box3& bounds, uint32_t contentFlags)
+    {
+        bool changed = node.minX[child] != bounds.m_mins.x || node.minY[child] != bounds.m_mins.y || node.minZ[child] != bounds.m_mins.z
+            || node.maxX[child] != bounds.m_maxs.x || node.maxY[child] != bounds.m_maxs.y || node.maxZ[child] != bounds.m_maxs.z
+            || node.contentFlags[child] != contentFlags;
+
+        node.minX[child] = bounds.m_mins.x;
+        node.minY[child] = bounds.m_mins.y;
+        node.minZ[child] = bounds.m_mins.z;
+        node.maxX[child] = bounds.m_maxs.x;
+        node.maxY[child] = bounds.m_maxs.y;
+        node.maxZ[child] = bounds.m_maxs.z;
+        node.contentFlags[child] = contentFlags;
+
+        return changed;
+    }
+
+    box3 GetChildBounds(const MeshInstanceBvh::Node& node, uint32_t child)
+    {
+        return box3(
+            float3(node.minX[child], node.minY[child], node.minZ[child]),
+            float3(node.maxX[child], node.maxY[child], node.maxZ[child]));
+    }
+
+    // Spreads the low 21 bits of a value so that there are two zero bits after each of them.
+    uint64_t SpreadBits(uint64_t x)
+    {
+        x &= 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffffull;
+        x = (x | x << 16) & 0x1f0000ff0000ffull;
+        x = (x | x << 8) & 0x100f00f00f00f00full;
+        x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+        x = (x | x << 2) & 0x1249249249249249ull;
+        return x;
+    }
+
+    // Sorts the items along a Morton curve through their centers, so that any contiguous range of items
+    // is spatially coherent and the tree can be built by splitting ranges by count.
+    void SortItems(std::vector<BuildItem>& items)
+    {
+        box3 centers = box3::empty();
+        for (const BuildItem& item : items)
+            centers |= item.center;
+
+        float3 extent = centers.diagonal();
+        float3 scale = float3(
+            extent.x > 0.f ? 2097151.f / extent.x : 0.f,
+            extent.y > 0.f ? 2097151.f / extent.y : 0.f,
+            extent.z > 0.f ? 2097151.f / extent.z : 0.f);
+
+        // sort (code, index) pairs instead of the items themselves
+        std::vector<std::pair<uint64_t, uint32_t>> keys(items.size());
+        for (size_t index = 0; index < items.size(); index++)
+        {
+            float3 cell = (items[index].center - centers.m_mins) * scale;
+            uint64_t code = SpreadBits(uint64_t(cell.x)) | SpreadBits(uint64_t(cell.y)) << 1 | SpreadBits(uint64_t(cell.z)) << 2;
+            keys[index] = { code, uint32_t(index) };
+        }
+
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<BuildItem> sortedItems;
+        sortedItems.reserve(items.size());
+        for (const auto& key : keys)
+            sortedItems.push_back(items[key.second]);
+
+        items.swap(sortedItems);
+    }
+
+    class BvhBuilder
+    {
+    private:
+        std::vector<MeshInstanceBvh::Node>& m_Nodes;
+        std::vector<uint32_t>& m_InstanceSlots;
+
+    public:
+        BvhBuilder(std::vector<MeshInstanceBvh::Node>& nodes, std::vector<uint32_t>& instanceSlots)
+            : m_Nodes(nodes)
+            , m_InstanceSlots(instanceSlots)
+        {
+        }
+
+        // Builds the node for a range of items: up to 4 items become its leaves directly, larger ranges
+        // are split in 4 by count. Nodes are created before their children.
+        BuildResult BuildNode(BuildItem* begin, BuildItem* end, uint32_t parentSlot)
+        {
+            uint32_t nodeIndex = uint32_t(m_Nodes.size());
+            MeshInstanceBvh::Node& newNode = m_Nodes.emplace_back();
+            for (uint32_t child = 0; child < MeshInstanceBvh::Width; child++)
+            {
+                SetChildBounds(newNode, child, box3::empty(), 0);
+                newNode.children[child] = c_InvalidIndex;
+            }
+            newNode.leafMask = 0;
+            newNode.parentSlot = parentSlot;
+
+            BuildItem* groups[MeshInstanceBvh::Width + 1];
+            uint32_t groupCount = 0;
+            size_t itemCount = end - begin;
+            if (itemCount <= MeshInstanceBvh::Width)
+            {
+                for (BuildItem* item = begin; item != end; ++item)
+                    groups[groupCount++] = item;
+            }
+            else
+            {
+                // the items are in Morton order, so equal quarters are compact groups
+                for (uint32_t child = 0; child < MeshInstanceBvh::Width; child++)
+                    groups[groupCount++] = begin + itemCount * child / MeshInstanceBvh::Width;
+            }
+            groups[groupCount] = end;
+
+            BuildResult result = { nodeIndex, box3::empty(), 0 };
+            for (uint32_t child = 0; child < groupCount; child++)
+            {
+                BuildItem* groupBegin = groups[child];
+                BuildItem* groupEnd = groups[child + 1];
+                uint32_t slot = nodeIndex * MeshInstanceBvh::Width + child;
+
+                BuildResult childResult;
+                if (groupEnd - groupBegin == 1)
+                {
+                    childResult = { groupBegin->instance, groupBegin->bounds, groupBegin->contentFlags };
+                    m_InstanceSlots[groupBegin->instance] = slot;
+                    m_Nodes[nodeIndex].leafMask |= 1u << child;
+                }
+                else
+                {
+                    childResult = BuildNode(groupBegin, groupEnd, slot);
+                }
+
+                // the recursion may have reallocated the nodes
+                MeshInstanceBvh::Node& node = m_Nodes[nodeIndex];
+                node.children[child] = childResult.node;
+                SetChildBounds(node, child, childResult.bounds, childResult.contentFlags);
+
+                result.bounds |= childResult.bounds;
+                result.contentFlags |= childResult.contentFlags;
+            }
+
+            return result;
+        }
+    };
+
+    // Tests all children of a node against the frustum, with the same arithmetic as frustum::intersectsWith(box3).
+    // Returns a mask where bit N is set if child N may intersect the frustum.
+    uint32_t IntersectChildren(const MeshInstanceBvh::Node& node, const frustum& viewFrustum)
+    {
+        static_assert(MeshInstanceBvh::Width == 4);
+
+#if DONUT_BVH_SSE
+        __m128 minX = _mm_loadu_ps(node.minX);
+        __m128 minY = _mm_loadu_ps(node.minY);
+        __m128 minZ = _mm_loadu_ps(node.minZ);
+        __m128 maxX = _mm_loadu_ps(node.maxX);
+        __m128 maxY = _mm_loadu_ps(node.maxY);
+        __m128 maxZ = _mm_loadu_ps(node.maxZ);
+        __m128 zero = _mm_setzero_ps();
+        __m128 outside = zero;
+
+        for (int i = 0; i < frustum::PLANES_COUNT; ++i)
+        {
+            const plane& p = viewFrustum.planes[i];
+            __m128 x = p.normal.x > 0 ? minX : maxX;
+            __m128 y = p.normal.y > 0 ? minY : maxY;
+            __m128 z = p.normal.z > 0 ? minZ : maxZ;
+
+            __m128 distance = _mm_mul_ps(_mm_set1_ps(p.normal.x), x);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p.normal.y), y));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p.normal.z), z));
+            distance = _mm_sub_ps(distance, _mm_set1_ps(p.distance));
+
+            outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, zero));
+        }
+
+        return ~uint32_t(_mm_movemask_ps(outside)) & 0xf;
+#else
+        uint32_t mask = 0;
+        for (uint32_t child = 0; child < MeshInstanceBvh::Width; child++)
+        {
+            if (viewFrustum.intersectsWith(GetChildBounds(node, child)))
+                mask |= 1u << child;
+        }
+        return mask;
+#endif
+    }
+}
+
+void MeshInstanceBvh::Build(const SceneGraph& graph)
+{
+    m_Nodes.clear();
+    m_Instances.clear();
+    m_InstanceNodes.clear();
+
+    std::vector<BuildItem> items;
+    items.reserve(graph.GetMeshInstances().size());
+
+    for (const auto& instance : graph.GetMeshInstances())
+    {
+        SceneGraphNode* node = instance->GetNode();
+        if (!node || !instance->GetMesh())
+            continue;
+
+        BuildItem& item = items.emplace_back();
+        item.bounds = node->GetGlobalBoundingBox();
+        item.center = item.bounds.isempty() ? float3(0.f) : item.bounds.center();
+        item.contentFlags = uint32_t(node->GetLeafContentFlags());
+        item.instance = uint32_t(m_Instances.size());
+
+        m_Instances.push_back(instance.get());
+        m_InstanceNodes.push_back(node);
+    }
+
+    m_InstanceSlots.assign(m_Instances.size(), c_InvalidIndex);
+
+    if (!items.empty())
+    {
+        SortItems(items);
+
+        m_Nodes.reserve(items.size() / 2);
+        BvhBuilder builder(m_Nodes, m_InstanceSlots);
+        builder.BuildNode(items.data(), items.data() + items.size(), c_InvalidIndex);
+    }
+
+    m_DirtyNodes.assign(m_Nodes.size(), 0);
+    ++m_BuildCount;
+}
+
+void MeshInstanceBvh::Refit()
+{
+    // copy the new instance bounds, flag the nodes above the changed instances
+    for (uint32_t instance = 0; instance < uint32_t(m_Instances.size()); instance++)
+    {
+        const SceneGraphNode* instanceNode = m_InstanceNodes[instance];
+        uint32_t slot = m_InstanceSlots[instance];
+
+        if (!SetChildBounds(m_Nodes[slot / Width], slot % Width, instanceNode->GetGlobalBoundingBox(), uint32_t(instanceNode->GetLeafContentFlags())))
+            continue;
+
+        for (uint32_t nodeIndex = slot / Width; nodeIndex != c_InvalidIndex && !m_DirtyNodes[nodeIndex]; )
+        {
+            m_DirtyNodes[nodeIndex] = 1;
+            uint32_t parentSlot = m_Nodes[nodeIndex].parentSlot;
+            nodeIndex = (parentSlot != c_InvalidIndex) ? parentSlot / Width : c_InvalidIndex;
+        }
+    }
+
+    // children are created after their parents, so a reverse pass updates every child before its parent
+    for (uint32_t nodeIndex = uint32_t(m_Nodes.size()); nodeIndex-- > 0; )
+    {
+        if (!m_DirtyNodes[nodeIndex])
+            continue;
+
+        m_DirtyNodes[nodeIndex] = 0;
+
+        const Node& node = m_Nodes[nodeIndex];
+        if (node.parentSlot == c_InvalidIndex)
+            continue;
+
+        box3 bounds = box3::empty();
+        uint32_t contentFlags = 0;
+        for (uint32_t child = 0; child < Width; child++)
+        {
+            if (node.children[child] == c_InvalidIndex)
+                continue;
+
+            bounds |= GetChildBounds(node, child);
+            contentFlags |= node.contentFlags[child];
+        }
+
+        SetChildBounds(m_Nodes[node.parentSlot / Width], node.parentSlot % Width, bounds, contentFlags);
+    }
+}
+
+bool MeshInstanceBvh::Update(const SceneGraph& graph)
+{
+    // the node bounds are only valid after the graph has been refreshed
+    if (graph.HasPendingStructureChanges())
+        return false;
+
+    auto currentGraph = m_Graph.lock();
+    if (currentGraph.get() != &graph || graph.GetStructureVersion() != m_StructureVersion)
+    {
+        Build(graph);
+        m_Graph = graph.weak_from_this();
+        m_StructureVersion = graph.GetStructureVersion();
+        m_BoundsVersion = graph.GetBoundsVersion();
+    }
+    else if (graph.GetBoundsVersion() != m_BoundsVersion)
+    {
+        Refit();
+        m_BoundsVersion = graph.GetBoundsVersion();
+    }
+
+    return true;
+}
+
+void MeshInstanceBvh::Cull(const frustum& viewFrustum, SceneContentFlags contentFlags, std::vector<uint32_t>& visibleInstances) const
+{
+    if (m_Nodes.empty())
+        return;
+
+    // splitting by count keeps the depth under log4(instances) + 1, and each level adds at most 3 entries
+    uint32_t stack[64];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = m_Nodes[stack[--stackSize]];
+
+        uint32_t relevantMask = 0;
+        for (uint32_t child = 0; child < Width; child++)
+        {
+            if ((node.contentFlags[child] & uint32_t(contentFlags)) != 0)
+                relevantMask |= 1u << child;
+        }
+
+        if (!relevantMask)
+            continue;
+
+        uint32_t visibleMask = IntersectChildren(node, viewFrustum) & relevantMask;
+
+        // push the nodes in reverse to visit the children in order
+        for (uint32_t child = Width; child-- > 0; )
+        {
+            if ((visibleMask & (1u << child)) != 0 && (node.leafMask & (1u << child)) == 0)
+                stack[stackSize++] = node.children[child];
+        }
+
+        for (uint32_t child = 0; child < Width; child++)
+        {
+            if ((visibleMask & node.leafMask & (1u << child)) != 0)
+                visibleInstances.push_back(node.children[child]);
+        }
+    }
+}
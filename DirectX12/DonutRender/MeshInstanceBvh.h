@@ -0,0 +1,94 @@
+/*
+* Copyright (c) 2014-2021, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../DonutEngine/SceneGraph.h"
+#include "../DonutCore/Math.h"
+#include <memory>
+#include <vector>
+
+namespace donut::render
+{
+    /*
+    A bounding volume hierarchy over the mesh instances of a scene graph, used for frustum culling.
+
+    Every node has up to 4 children, and their bounding boxes are stored as arrays of coordinates,
+    so that all children of a node are tested against the frustum at once with SIMD instructions.
+    A child is either another node or a single mesh instance. Each child also stores the union of
+    the content flags of its instances, so that subtrees without relevant content are skipped.
+
+    The instance bounds are the global bounding boxes of the instances' nodes, which are the boxes
+    that SceneGraphWalker based culling tests. The tree is rebuilt when leaves are added to or removed
+    from the graph, and refitted bottom-up when SceneGraph::Refresh reports changed bounds.
+    */
+    class MeshInstanceBvh
+    {
+    public:
+        static constexpr uint32_t Width = 4;
+
+        struct Node
+        {
+            float minX[Width];
+            float minY[Width];
+            float minZ[Width];
+            float maxX[Width];
+            float maxY[Width];
+            float maxZ[Width];
+            uint32_t contentFlags[Width];   // SceneContentFlags of the child's instances, 0 for unused children
+            uint32_t children[Width];       // node index, or instance index if the child is a leaf
+            uint32_t leafMask;              // bit N is set if child N is an instance
+            uint32_t parentSlot;            // parent node index * Width + child index, UINT32_MAX for the root node
+        };
+
+    private:
+        std::weak_ptr<const engine::SceneGraph> m_Graph;
+        std::vector<Node> m_Nodes;
+        std::vector<engine::MeshInstance*> m_Instances;
+        std::vector<engine::SceneGraphNode*> m_InstanceNodes;
+        std::vector<uint32_t> m_InstanceSlots;      // node index * Width + child index of every instance
+        std::vector<uint8_t> m_DirtyNodes;
+        uint64_t m_StructureVersion = 0;
+        uint64_t m_BoundsVersion = 0;
+        uint64_t m_BuildCount = 0;
+
+        void Build(const engine::SceneGraph& graph);
+        void Refit();
+
+    public:
+        // Brings the tree up to date with the graph: rebuilds it if the set of leaves has changed, or refits it
+        // if the bounds have changed. Returns false if the graph has structure changes that have not been
+        // refreshed yet, in which case the tree must not be used until the next Update.
+        bool Update(const engine::SceneGraph& graph);
+
+        // Appends the indices of the instances that have any of the content flags and intersect the frustum.
+        void Cull(const dm::frustum& frustum, engine::SceneContentFlags contentFlags, std::vector<uint32_t>& visibleInstances) const;
+
+        [[nodiscard]] const std::vector<engine::MeshInstance*>& GetInstances() const { return m_Instances; }
+        [[nodiscard]] const std::vector<engine::SceneGraphNode*>& GetInstanceNodes() const { return m_InstanceNodes; }
+        [[nodiscard]] const std::vector<Node>& GetNodes() const { return m_Nodes; }
+
+        // Incremented on every rebuild, when the instance indices change.
+        [[nodiscard]] uint64_t GetBuildCount() const { return m_BuildCount; }
+    };
+}
@@ -0,0 +1,201 @@
+// 청크 SoA 아키타입 저장소와 이전 해시 맵 기반 저장소의 순회 비용 비교.
+// 이전 경로는 GetComponent<T>(entity) 한 번마다 타입 ID, 엔티티 위치, 컴포넌트 배열, 엔티티 행 순서로
+// 네 번의 해시 조회를 거쳤으므로 같은 구조를 여기서 재현해 기준으로 삼습니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/ECSQuery.h"
+#include <cmath>
+#include <typeindex>
+#include <unordered_map>
+
+namespace
+{
+	using namespace ECSBenchmark;
+
+	struct BenchTransform {
+		static const char* GetName() { return "BenchTransform"; }
+		float Position[3] = { 0.0f, 0.0f, 0.0f };
+		float Rotation[3] = { 0.0f, 0.0f, 0.0f };
+		float Scale[3] = { 1.0f, 1.0f, 1.0f };
+	};
+	struct BenchRigidBody {
+		static const char* GetName() { return "BenchRigidBody"; }
+		float Velocity[3] = { 0.0f, 0.0f, 0.0f };
+		float Mass = 1.0f;
+	};
+	void to_json(json& j, const BenchTransform& t) { j = json{ { "Position", { t.Position[0], t.Position[1], t.Position[2] } } }; }
+	void to_json(json& j, const BenchRigidBody& r) { j = json{ { "Mass", r.Mass } }; }
+
+	void Integrate(BenchTransform& transform, const BenchRigidBody& rigidBody, float dt)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+			transform.Position[axis] += rigidBody.Velocity[axis] * dt;
+	}
+
+	// 해시 맵 기반이던 이전 ECS::Archetype/ArchetypeManager의 저장 구조.
+	class LegacyWorld {
+	private:
+		struct IColumn {
+			virtual ~IColumn() = default;
+		};
+		template<typename T>
+		struct Column : IColumn {
+			std::vector<T> Data;
+		};
+		struct LegacyArchetype {
+			std::unordered_map<ECS::ComponentType, std::unique_ptr<IColumn>> Columns;
+			std::unordered_map<ECS::Entity, ECS::ComponentHandle> EntityToIndex;
+		};
+
+		std::unordered_map<std::type_index, ECS::ComponentType> mComponentTypes;
+		std::unordered_map<ECS::Entity, LegacyArchetype*> mEntityLocations;
+		LegacyArchetype mArchetype;
+
+	public:
+		LegacyWorld()
+		{
+			mComponentTypes[typeid(BenchTransform)] = 0;
+			mComponentTypes[typeid(BenchRigidBody)] = 1;
+			mArchetype.Columns[0] = std::make_unique<Column<BenchTransform>>();
+			mArchetype.Columns[1] = std::make_unique<Column<BenchRigidBody>>();
+		}
+
+		void Add(ECS::Entity entity, const BenchTransform& transform, const BenchRigidBody& rigidBody)
+		{
+			ECS::ComponentHandle index = mArchetype.EntityToIndex.size();
+			mArchetype.EntityToIndex[entity] = index;
+			static_cast<Column<BenchTransform>*>(mArchetype.Columns.at(0).get())->Data.push_back(transform);
+			static_cast<Column<BenchRigidBody>*>(mArchetype.Columns.at(1).get())->Data.push_back(rigidBody);
+			mEntityLocations[entity] = &mArchetype;
+		}
+
+		template<typename T>
+		T& GetComponent(ECS::Entity entity)
+		{
+			ECS::ComponentType type = mComponentTypes.at(typeid(T));
+			LegacyArchetype* archetype = mEntityLocations.at(entity);
+			auto* column = static_cast<Column<T>*>(archetype->Columns.at(type).get());
+			return column->Data[archetype->EntityToIndex[entity]];
+		}
+	};
+
+	BenchRigidBody MakeRigidBody(size_t i)
+	{
+		BenchRigidBody rigidBody;
+		rigidBody.Velocity[0] = static_cast<float>(i % 7);
+		rigidBody.Velocity[1] = static_cast<float>(i % 5);
+		rigidBody.Velocity[2] = static_cast<float>(i % 3);
+		return rigidBody;
+	}
+
+	double SumPositions(size_t count, const std::function<const BenchTransform& (ECS::Entity)>& get)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const BenchTransform& transform = get(ECS::MakeEntity(static_cast<std::uint32_t>(i), 0));
+			sum += transform.Position[0] + transform.Position[1] + transform.Position[2];
+		}
+		return sum;
+	}
+
+	void RunIteration(size_t entityCount)
+	{
+		constexpr float dt = 1.0f / 60.0f;
+		constexpr int repeat = 10;
+
+		LegacyWorld legacy;
+		ECS::ArchetypeManager manager;
+		manager.RegisterComponent<BenchTransform>();
+		manager.RegisterComponent<BenchRigidBody>();
+
+		std::vector<ECS::Entity> entities(entityCount);
+		for (size_t i = 0; i < entityCount; ++i)
+		{
+			ECS::Entity entity = ECS::MakeEntity(static_cast<std::uint32_t>(i), 0);
+			entities[i] = entity;
+			legacy.Add(entity, BenchTransform{}, MakeRigidBody(i));
+
+			ECS::Signature signature;
+			manager.AddComponent(entity, BenchTransform{}, signature);
+			signature.set(manager.GetComponentType<BenchTransform>());
+			manager.AddComponent(entity, MakeRigidBody(i), signature);
+		}
+
+		std::printf(" %zu entities\n", entityCount);
+		double legacyMs = MeasureBest(repeat, [&]() {
+			for (ECS::Entity entity : entities)
+				Integrate(legacy.GetComponent<BenchTransform>(entity), legacy.GetComponent<BenchRigidBody>(entity), dt);
+		});
+		Report("legacy hash lookup per entity", entityCount, legacyMs);
+
+		double lookupMs = MeasureBest(repeat, [&]() {
+			for (ECS::Entity entity : entities)
+				Integrate(manager.GetComponent<BenchTransform>(entity), manager.GetComponent<BenchRigidBody>(entity), dt);
+		});
+		Report("chunked GetComponent per entity", entityCount, lookupMs);
+
+		double queryMs = MeasureBest(repeat, [&]() {
+			ECS::EntityQuery<BenchTransform, const BenchRigidBody>(&manager).ForEach(
+				[dt](BenchTransform& transform, const BenchRigidBody& rigidBody) { Integrate(transform, rigidBody, dt); });
+		});
+		Report("chunked Query ForEach", entityCount, queryMs);
+
+		// 청크 저장소는 GetComponent와 Query 두 경로로 측정했으므로 legacy의 두 배만큼 적분되었습니다.
+		double legacySum = SumPositions(entityCount, [&](ECS::Entity e) -> const BenchTransform& { return legacy.GetComponent<BenchTransform>(e); });
+		double chunkSum = SumPositions(entityCount, [&](ECS::Entity e) -> const BenchTransform& { return manager.GetComponent<BenchTransform>(e); });
+		Check(std::abs(2.0 * legacySum - chunkSum) <= 1e-5 * std::abs(chunkSum), "chunked iteration matches legacy storage");
+	}
+
+	// 엔티티 수가 청크 경계에 걸친 상태에서 추가/삭제를 반복합니다.
+	// 마지막 청크가 비는 순간 해제하면 반복마다 16KB 청크를 새로 할당하게 되므로 예비 청크 효과를 측정합니다.
+	void RunChunkBoundaryChurn()
+	{
+		ECS::ArchetypeManager manager;
+		manager.RegisterComponent<BenchTransform>();
+		manager.RegisterComponent<BenchRigidBody>();
+
+		auto spawn = [&manager](std::uint32_t index) {
+			ECS::Entity entity = ECS::MakeEntity(index, 0);
+			ECS::Signature signature;
+			manager.AddComponent(entity, BenchTransform{}, signature);
+			signature.set(manager.GetComponentType<BenchTransform>());
+			manager.AddComponent(entity, BenchRigidBody{}, signature);
+		};
+
+		// 두 컴포넌트를 모두 가진 아키타입의 첫 청크를 정확히 채웁니다.
+		spawn(0);
+		const ECS::Archetype* archetype = nullptr;
+		for (ECS::Archetype* candidate : manager.GetArchetypes())
+		{
+			if (candidate->GetEntityCount() == 1)
+				archetype = candidate;
+		}
+		const std::uint32_t capacity = static_cast<std::uint32_t>(archetype->GetChunkCapacity());
+		for (std::uint32_t i = 1; i < capacity; ++i)
+			spawn(i);
+
+		constexpr size_t churnCount = 100000;
+		double churnMs = MeasureBest(5, [&]() {
+			for (size_t i = 0; i < churnCount; ++i)
+			{
+				spawn(capacity);
+				manager.EntityDestroyed(ECS::MakeEntity(capacity, 0));
+			}
+		});
+		std::printf(" chunk boundary churn (capacity %u)\n", capacity);
+		Report("spawn + destroy across chunk boundary", churnCount, churnMs);
+		Check(archetype->GetEntityCount() == capacity && archetype->GetChunkCount() == 1, "churn leaves one full chunk");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunArchetypeBenchmark()
+	{
+		std::printf("[Archetype] legacy hash maps vs chunked SoA\n");
+		for (size_t entityCount : { size_t(10000), size_t(100000) })
+			RunIteration(entityCount);
+		RunChunkBoundaryChurn();
+	}
+}
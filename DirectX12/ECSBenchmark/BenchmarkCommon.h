@@ -0,0 +1,49 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace ECSBenchmark
+{
+	// func를 repeat번 실행해 가장 빠른 실행 시간(ms)을 반환합니다.
+	// 첫 실행은 캐시와 할당자 예열용으로 측정에서 제외합니다.
+	template<typename Func>
+	double MeasureBest(int repeat, Func&& func)
+	{
+		func();
+		double best = 1e30;
+		for (int i = 0; i < repeat; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			func();
+			auto end = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+
+	inline void Report(const char* name, size_t itemCount, double ms)
+	{
+		std::printf("  %-44s %9zu items %10.3f ms %9.2f ns/item\n", name, itemCount, ms, ms * 1e6 / static_cast<double>(itemCount));
+	}
+
+	// 측정 결과가 기준 경로와 다르면 실패로 기록합니다. main은 실패가 하나라도 있으면 1을 반환합니다.
+	inline int gFailureCount = 0;
+	inline void Check(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			std::printf("  FAILED: %s\n", what);
+			++gFailureCount;
+		}
+	}
+
+	void RunArchetypeBenchmark();
+	void RunDescriptorAllocatorBenchmark();
+	void RunEntityBenchmark();
+	void RunInstanceCullBenchmark();
+	void RunRepositoryBenchmark();
+	void RunSnapshotBenchmark();
+	void RunTransformBenchmark();
+	void RunViewFrustumBenchmark();
+}
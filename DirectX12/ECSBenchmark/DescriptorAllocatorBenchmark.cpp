@@ -0,0 +1,250 @@
+// DX12_HeapRepository가 쓰는 DescriptorIndexAllocator의 동작 검증과 처리량 측정.
+// 이전 힙 저장소는 인덱스를 증가시키기만 하고 돌려받지 않았으므로 비교할 기준 경로는 없습니다.
+// 프리 리스트 재사용, 펜스에 따른 프레임 링 회수, 힙 확장을 고정 시나리오로 확인하고,
+// GPU가 1~2 프레임 늦게 따라오는 무작위 시뮬레이션에서 슬롯이 겹치지 않는지 확인합니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/DescriptorIndexAllocator.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+
+namespace
+{
+	using namespace ECSBenchmark;
+
+	constexpr std::uint32_t Invalid = DescriptorIndexAllocator::Invalid;
+
+	// 해제한 슬롯은 그 프레임의 펜스가 완료될 때까지 다시 나오지 않아야 합니다.
+	void RunFreeListReuse()
+	{
+		DescriptorIndexAllocator allocator(4, 8);
+		std::uint32_t slots[4];
+		for (std::uint32_t& slot : slots)
+			slot = allocator.AllocatePersistent();
+		Check(slots[0] == 0 && slots[1] == 1 && slots[2] == 2 && slots[3] == 3, "persistent slots are handed out in order");
+		Check(allocator.AllocatePersistent() == Invalid, "full persistent region returns Invalid");
+
+		allocator.FreePersistent(slots[1]);
+		Check(allocator.GetPersistentCount() == 3, "free lowers the live count");
+		Check(allocator.AllocatePersistent() == Invalid, "freed slot is not reused within its frame");
+
+		allocator.EndFrame(1);
+		allocator.ReleaseCompleted(0);
+		Check(allocator.AllocatePersistent() == Invalid, "freed slot is not reused before its fence completes");
+
+		allocator.ReleaseCompleted(1);
+		Check(allocator.AllocatePersistent() == slots[1], "freed slot is reused once its fence completes");
+		Check(allocator.GetPersistentHighWater() == 4, "reuse does not advance the high-water mark");
+	}
+
+	// 프레임마다 링에서 자른 구간은 그 프레임의 펜스가 완료되면 한꺼번에 돌아와야 합니다.
+	void RunFrameRing()
+	{
+		const std::uint32_t base = 16;
+		DescriptorIndexAllocator allocator(base, 8);
+
+		Check(allocator.AllocateTransient(5) == base + 0, "first range starts the ring");
+		allocator.EndFrame(1);
+		Check(allocator.AllocateTransient(2) == base + 5, "next frame continues after the previous range");
+		allocator.EndFrame(2);
+		Check(allocator.AllocateTransient(3) == Invalid, "ring is full while earlier frames are in flight");
+
+		allocator.ReleaseCompleted(1);
+		Check(allocator.GetTransientUsed() == 2, "completed frame returns its whole range");
+
+		// 끝에 남은 1칸으로는 3칸을 줄 수 없으므로 처음으로 감고, 버린 칸도 이번 프레임이 쓴 것으로 셉니다.
+		Check(allocator.AllocateTransient(3) == base + 0, "range that does not fit at the end wraps to the start");
+		Check(allocator.AllocateTransient(2) == base + 3, "wrapped range is followed contiguously");
+		Check(allocator.GetTransientUsed() == 8 && allocator.AllocateTransient(1) == Invalid, "wrapped frame counts the skipped tail");
+		allocator.EndFrame(3);
+
+		allocator.ReleaseCompleted(2);
+		Check(allocator.GetTransientUsed() == 6, "frames are released in fence order");
+		allocator.ReleaseCompleted(3);
+		Check(allocator.GetTransientUsed() == 0 && allocator.AllocateTransient(8) == base + 0, "empty ring restarts from the beginning");
+		Check(allocator.AllocateTransient(9) == Invalid && allocator.AllocateTransient(0) == Invalid, "oversized and empty requests are rejected");
+	}
+
+	// 힙을 키운 뒤에도 살아 있는 영구 인덱스는 그대로이고, 임시 인덱스는 새 영구 영역 뒤에서 시작해야 합니다.
+	void RunGrow()
+	{
+		DescriptorIndexAllocator allocator(4, 4);
+		for (int i = 0; i < 4; ++i)
+			allocator.AllocatePersistent();
+		allocator.AllocateTransient(3);
+		Check(allocator.AllocatePersistent() == Invalid, "allocator reports exhaustion before growing");
+
+		allocator.Grow(8, 8);
+		Check(allocator.GetPersistentCapacity() == 8 && allocator.GetCapacity() == 16, "grow updates the capacities");
+		Check(allocator.GetPersistentCount() == 4 && allocator.GetPersistentHighWater() == 4, "grow keeps the live persistent slots");
+		Check(allocator.AllocatePersistent() == 4, "grown persistent region continues after the old slots");
+		Check(allocator.GetTransientUsed() == 0 && allocator.AllocateTransient(8) == 8, "ring restarts after the new persistent region");
+
+		allocator.Grow(2, 8);
+		Check(allocator.GetPersistentCapacity() == 8, "grow never shrinks the persistent region");
+	}
+
+	// GPU가 1~2 프레임 늦게 완료하는 상황에서 무작위로 할당/해제/임시 할당을 섞어 수행합니다.
+	// 공간이 모자라면 DX12_HeapRepository처럼 두 배로 키웁니다.
+	void RunRandomized()
+	{
+		std::mt19937 random(3);
+		DescriptorIndexAllocator allocator(64, 64);
+
+		struct TransientRange
+		{
+			std::uint32_t First;
+			std::uint32_t Count;
+			std::uint64_t FenceValue;
+		};
+		std::set<std::uint32_t> live;
+		std::map<std::uint32_t, std::uint64_t> blocked;	// 해제한 슬롯 -> 해제한 프레임의 펜스 값
+		std::vector<std::uint32_t> frameFrees;
+		std::vector<TransientRange> inFlight;
+		std::vector<TransientRange> frameRanges;
+
+		bool duplicateLive = false, reusedEarly = false, overlapping = false, outOfRange = false, countMismatch = false;
+		std::uint64_t fence = 0, completed = 0;
+		size_t operations = 0;
+		int grows = 0;
+
+		auto overlaps = [](std::uint32_t first, std::uint32_t count, const std::vector<TransientRange>& ranges) {
+			for (const TransientRange& range : ranges)
+			{
+				if (first < range.First + range.Count && range.First < first + count)
+					return true;
+			}
+			return false;
+		};
+
+		// 시뮬레이션은 상태를 이어 가므로 한 번만 실행해 측정합니다.
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < 20000; ++frame)
+		{
+			if (fence >= 2 && random() % 3)
+				completed = std::max<std::uint64_t>(completed, fence - 1 - random() % 2);
+			allocator.ReleaseCompleted(completed);
+			std::erase_if(inFlight, [&](const TransientRange& range) { return range.FenceValue <= completed; });
+			std::erase_if(blocked, [&](const auto& entry) { return entry.second <= completed; });
+
+			const int operationCount = random() % 20;
+			for (int o = 0; o < operationCount; ++o, ++operations)
+			{
+				const int kind = random() % 3;
+				if (kind == 0)
+				{
+					std::uint32_t index = allocator.AllocatePersistent();
+					if (index == Invalid)
+					{
+						allocator.Grow(allocator.GetPersistentCapacity() * 2, allocator.GetTransientCapacity());
+						inFlight.clear();
+						frameRanges.clear();
+						++grows;
+						index = allocator.AllocatePersistent();
+					}
+					outOfRange |= index >= allocator.GetPersistentCapacity();
+					duplicateLive |= live.count(index) != 0;
+					reusedEarly |= blocked.count(index) != 0 || std::find(frameFrees.begin(), frameFrees.end(), index) != frameFrees.end();
+					live.insert(index);
+				}
+				else if (kind == 1 && !live.empty())
+				{
+					auto it = live.begin();
+					std::advance(it, random() % live.size());
+					frameFrees.push_back(*it);
+					allocator.FreePersistent(*it);
+					live.erase(it);
+				}
+				else
+				{
+					const std::uint32_t count = 1 + random() % 12;
+					std::uint32_t first = allocator.AllocateTransient(count);
+					if (first == Invalid)
+					{
+						allocator.Grow(allocator.GetPersistentCapacity(), allocator.GetTransientCapacity() * 2);
+						inFlight.clear();
+						frameRanges.clear();
+						++grows;
+						first = allocator.AllocateTransient(count);
+					}
+					outOfRange |= first == Invalid || first < allocator.GetPersistentCapacity() || first + count > allocator.GetCapacity();
+					overlapping |= overlaps(first, count, inFlight) || overlaps(first, count, frameRanges);
+					frameRanges.push_back({ first, count, 0 });
+				}
+			}
+
+			allocator.EndFrame(++fence);
+			for (TransientRange& range : frameRanges)
+			{
+				range.FenceValue = fence;
+				inFlight.push_back(range);
+			}
+			frameRanges.clear();
+			for (std::uint32_t index : frameFrees)
+				blocked[index] = fence;
+			frameFrees.clear();
+			countMismatch |= allocator.GetPersistentCount() != live.size();
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::printf(" 20000 frames, GPU 1-2 frames behind: %d grows, capacity %u + %u\n", grows, allocator.GetPersistentCapacity(), allocator.GetTransientCapacity());
+		Report("randomized simulation (with checks)", operations, ms);
+		Check(!duplicateLive, "no live persistent slot is handed out twice");
+		Check(!reusedEarly, "freed slots are not reused before their fence completes");
+		Check(!overlapping, "transient ranges never overlap ranges in flight");
+		Check(!outOfRange, "indices stay inside their region");
+		Check(!countMismatch, "live count matches the simulation");
+	}
+
+	// 프레임마다 영구 슬롯 churnCount개를 해제/할당하고 임시 구간을 잘라 쓰는 비용.
+	void RunThroughput()
+	{
+		constexpr std::uint32_t liveCount = 4096;
+		constexpr int frameCount = 1000;
+		constexpr int churnCount = 256;
+
+		DescriptorIndexAllocator allocator(liveCount * 2, 4096);
+		std::vector<std::uint32_t> live(liveCount);
+		for (std::uint32_t& index : live)
+			index = allocator.AllocatePersistent();
+
+		std::uint64_t fence = 0;
+		size_t next = 0;
+		bool failed = false;
+		double ms = MeasureBest(5, [&]() {
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				if (fence >= 2)
+					allocator.ReleaseCompleted(fence - 2);
+				for (int i = 0; i < churnCount; ++i, ++next)
+				{
+					std::uint32_t& index = live[next % liveCount];
+					allocator.FreePersistent(index);
+					index = allocator.AllocatePersistent();
+					failed |= index == Invalid;
+				}
+				for (int i = 0; i < 64; ++i)
+					failed |= allocator.AllocateTransient(4) == Invalid;
+				allocator.EndFrame(++fence);
+			}
+		});
+		Report("persistent churn + transient ranges", size_t(frameCount) * (churnCount * 2 + 64), ms);
+		Check(!failed, "steady-state churn never runs out of slots");
+		Check(allocator.GetPersistentHighWater() <= liveCount + 3 * churnCount, "freed slots are recycled instead of growing the high-water mark");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunDescriptorAllocatorBenchmark()
+	{
+		std::printf("[DescriptorAllocator] free list, frame ring and growth\n");
+		RunFreeListReuse();
+		RunFrameRing();
+		RunGrow();
+		RunRandomized();
+		RunThroughput();
+	}
+}
@@ -0,0 +1,125 @@
+// 세대 번호 엔티티 핸들과 페이지 슬롯 테이블의 생성/파괴 비용 측정.
+// 기준은 이전의 고정 크기 EntityManager로, MAX_ENTITIES(5000)개의 ID를 std::queue에 미리 채우고
+// 시그니처를 고정 크기 std::array에 저장했습니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/ECSEntity.h"
+#include <queue>
+
+namespace
+{
+	using namespace ECSBenchmark;
+
+	class LegacyEntityManager
+	{
+	public:
+		static constexpr std::uint32_t MAX_ENTITIES = 5000;
+
+		LegacyEntityManager()
+		{
+			for (std::uint32_t entity = 0; entity < MAX_ENTITIES; ++entity)
+				mAvailableEntities.push(entity);
+		}
+
+		std::uint32_t CreateEntity()
+		{
+			std::uint32_t id = mAvailableEntities.front();
+			mAvailableEntities.pop();
+			++mLivingEntityCount;
+			return id;
+		}
+
+		void DestroyEntity(std::uint32_t entity)
+		{
+			mSignatures[entity].reset();
+			mAvailableEntities.push(entity);
+			--mLivingEntityCount;
+		}
+
+		std::uint32_t GetLivingEntityCount() const { return mLivingEntityCount; }
+
+	private:
+		std::queue<std::uint32_t> mAvailableEntities{};
+		std::array<ECS::Signature, MAX_ENTITIES> mSignatures{};
+		std::uint32_t mLivingEntityCount{};
+	};
+
+	// 살아 있는 엔티티 liveCount개를 유지하면서 가장 오래된 엔티티를 파괴하고 새로 만드는 것을 churnCount번 반복합니다.
+	// 초기 liveCount개 생성은 측정에서 제외합니다.
+	template<typename Manager, typename Handle>
+	double MeasureChurn(size_t liveCount, size_t churnCount, std::uint32_t& livingAfter)
+	{
+		auto manager = std::make_unique<Manager>();
+		std::vector<Handle> live(liveCount);
+		for (size_t i = 0; i < liveCount; ++i)
+			live[i] = manager->CreateEntity();
+
+		size_t next = 0;
+		double ms = MeasureBest(5, [&]() {
+			for (size_t i = 0; i < churnCount; ++i, ++next)
+			{
+				Handle& oldest = live[next % liveCount];
+				manager->DestroyEntity(oldest);
+				oldest = manager->CreateEntity();
+			}
+		});
+		livingAfter = manager->GetLivingEntityCount();
+		return ms;
+	}
+
+	void RunStartup()
+	{
+		constexpr size_t managerCount = 1000;
+		double legacyMs = MeasureBest(5, [&]() {
+			for (size_t i = 0; i < managerCount; ++i)
+				std::make_unique<LegacyEntityManager>();
+		});
+		Report("legacy construct (5000 queued IDs)", managerCount, legacyMs);
+
+		double pagedMs = MeasureBest(5, [&]() {
+			for (size_t i = 0; i < managerCount; ++i)
+				std::make_unique<ECS::EntityManager>();
+		});
+		Report("paged construct", managerCount, pagedMs);
+	}
+
+	void RunChurn()
+	{
+		constexpr size_t churnCount = 100000;
+		std::uint32_t legacyLiving = 0;
+		std::uint32_t pagedLiving = 0;
+
+		// 기존 관리자는 5000개 상한이 있으므로 그 안에서 비교합니다.
+		double legacyMs = MeasureChurn<LegacyEntityManager, std::uint32_t>(4000, churnCount, legacyLiving);
+		Report("legacy churn, 4000 live", churnCount, legacyMs);
+		double pagedMs = MeasureChurn<ECS::EntityManager, ECS::Entity>(4000, churnCount, pagedLiving);
+		Report("paged churn, 4000 live", churnCount, pagedMs);
+		Check(legacyLiving == 4000 && pagedLiving == 4000, "churn keeps the live count");
+
+		double largeMs = MeasureChurn<ECS::EntityManager, ECS::Entity>(1000000, churnCount, pagedLiving);
+		Report("paged churn, 1M live", churnCount, largeMs);
+		Check(pagedLiving == 1000000, "paged manager grows past the old cap");
+	}
+
+	// 재활용된 슬롯에서 이전 핸들이 새 엔티티로 오인되지 않는지 확인합니다.
+	void RunStaleHandleCheck()
+	{
+		ECS::EntityManager manager;
+		ECS::Entity first = manager.CreateEntity();
+		manager.DestroyEntity(first);
+		ECS::Entity second = manager.CreateEntity();
+		Check(ECS::GetEntityIndex(first) == ECS::GetEntityIndex(second), "destroyed slot is reused");
+		Check(!manager.IsAlive(first) && manager.IsAlive(second), "stale handle does not alias the recycled entity");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunEntityBenchmark()
+	{
+		std::printf("[Entity] queued IDs vs generational paged slots\n");
+		RunStartup();
+		RunChurn();
+		RunStaleHandleCheck();
+	}
+}
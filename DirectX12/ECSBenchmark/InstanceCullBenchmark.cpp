@@ -0,0 +1,165 @@
+// InstanceCullCompactKernel과 이전 SyncData의 단일 스레드 컬링 루프 비교.
+// 이전 루프는 Render Item마다 인스턴스를 순서대로 BoundingFrustum::Contains로 검사하고,
+// 보이는 InstanceData를 업로드 버퍼에 하나씩 기록했습니다. 두 경로 모두 CPU 버퍼에 기록해 결과를 바이트 단위로 비교합니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/DX12_InstanceCullCompact.h"
+#include <cstring>
+#include <random>
+
+namespace
+{
+	using namespace ECSBenchmark;
+	using namespace DirectX;
+
+	struct CullWorld
+	{
+		std::vector<std::vector<InstanceComponent>> Items;	// Render Item별 인스턴스
+		std::vector<bool> CullingEnabled;
+		size_t InstanceCount = 0;
+	};
+
+	// 크기가 제각각인 Render Item을 만듭니다. 일곱 번째마다 인스턴스가 몇 개뿐인 항목을 넣어 작은 구간도 섞고,
+	// 세 번째마다 컬링을 끄며, 인스턴스 10%는 UseCulling 옵션을 끕니다.
+	void Populate(CullWorld& world, size_t itemCount)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f), radius(0.1f, 5.0f);
+
+		world.Items.resize(itemCount);
+		world.CullingEnabled.resize(itemCount);
+		for (size_t r = 0; r < itemCount; ++r)
+		{
+			std::vector<InstanceComponent>& instances = world.Items[r];
+			instances.resize(r % 7 == 0 ? 3 : 1000 + (r * 977) % 3000);
+			for (InstanceComponent& instance : instances)
+			{
+				float* data = reinterpret_cast<float*>(&instance.InstanceData);
+				for (size_t k = 0; k < sizeof(InstanceData) / sizeof(float); ++k)
+					data[k] = position(random);
+				instance.BoundingSphere = BoundingSphere(XMFLOAT3(position(random), position(random) * 0.2f, position(random)), radius(random));
+				if (random() % 10 == 0)
+					instance.Option = eCFGInstanceComponent::None;
+			}
+			world.CullingEnabled[r] = r % 3 != 0;
+			world.InstanceCount += instances.size();
+		}
+	}
+
+	BoundingFrustum MakeCameraFrustum()
+	{
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(10.0f, 20.0f, -30.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		BoundingFrustum frustum;
+		BoundingFrustum::CreateFromMatrix(frustum, XMMatrixPerspectiveFovLH(0.8f, 1.7f, 1.0f, 150.0f));
+		frustum.Transform(frustum, XMMatrixInverse(nullptr, view));
+		return frustum;
+	}
+
+	// 인스턴스마다 BoundingFrustum::Contains로 검사하고 바로 기록하던 이전 SyncData의 컬링 루프.
+	void CullSerial(const CullWorld& world, const BoundingFrustum& frustum, BYTE* destination, UINT elementByteSize, std::vector<uint32_t>& visibleCounts)
+	{
+		uint32_t start = 0;
+		for (size_t r = 0; r < world.Items.size(); ++r)
+		{
+			uint32_t visible = 0;
+			for (const InstanceComponent& instance : world.Items[r])
+			{
+				if (!world.CullingEnabled[r]
+					|| !(instance.Option & eCFGInstanceComponent::UseCulling)
+					|| frustum.Contains(instance.BoundingSphere) != DISJOINT)
+				{
+					memcpy(destination + static_cast<size_t>(start + visible) * elementByteSize, &instance.InstanceData, sizeof(InstanceData));
+					++visible;
+				}
+			}
+			visibleCounts[r] = visible;
+			start += static_cast<uint32_t>(world.Items[r].size());
+		}
+	}
+
+	void MakeRanges(const CullWorld& world, std::vector<InstanceCullRange>& ranges)
+	{
+		ranges.clear();
+		uint32_t start = 0;
+		for (size_t r = 0; r < world.Items.size(); ++r)
+		{
+			InstanceCullRange range;
+			range.Instances = world.Items[r].data();
+			range.Count = static_cast<uint32_t>(world.Items[r].size());
+			range.Destination = start;
+			range.CullingEnabled = world.CullingEnabled[r];
+			ranges.push_back(range);
+			start += range.Count;
+		}
+	}
+
+	void RunSingleView(size_t itemCount)
+	{
+		CullWorld world;
+		Populate(world, itemCount);
+		const BoundingFrustum frustum = MakeCameraFrustum();
+		ViewFrustumSet views;
+		views.Add(frustum);
+
+		const UINT elementByteSize = sizeof(InstanceData);
+		std::vector<BYTE> serial(world.InstanceCount * elementByteSize);
+		std::vector<BYTE> kernel(world.InstanceCount * elementByteSize);
+		std::vector<uint32_t> serialCounts(itemCount);
+
+		std::printf(" %zu instances in %zu render items, %zu worker threads\n", world.InstanceCount, itemCount, ECS::JobSystem::GetInstance().GetWorkerCount());
+		double serialMs = MeasureBest(10, [&]() { CullSerial(world, frustum, serial.data(), elementByteSize, serialCounts); });
+		Report("serial Contains + memcpy", world.InstanceCount, serialMs);
+
+		InstanceCullCompactKernel cullKernel;
+		std::vector<InstanceCullRange> ranges;
+		double kernelMs = MeasureBest(10, [&]() {
+			MakeRanges(world, ranges);
+			cullKernel.Run(ranges.data(), ranges.size(), views, 1u, kernel.data(), elementByteSize);
+		});
+		Report("InstanceCullCompactKernel", world.InstanceCount, kernelMs);
+
+		size_t visible = 0;
+		bool sameCounts = true;
+		for (size_t r = 0; r < itemCount; ++r)
+		{
+			visible += serialCounts[r];
+			sameCounts = sameCounts && ranges[r].VisibleCount == serialCounts[r];
+		}
+		std::printf("  %zu visible\n", visible);
+		Check(sameCounts, "kernel visible counts match the serial loop");
+		Check(memcmp(serial.data(), kernel.data(), serial.size()) == 0, "kernel writes the same instance buffer as the serial loop");
+	}
+
+	// 원소 간격이 InstanceData보다 큰 업로드 버퍼(상수 버퍼 정렬 등)에도 같은 순서로 기록하는지 확인합니다.
+	void RunStrideCheck()
+	{
+		CullWorld world;
+		Populate(world, 8);
+		const BoundingFrustum frustum = MakeCameraFrustum();
+		ViewFrustumSet views;
+		views.Add(frustum);
+
+		const UINT elementByteSize = (sizeof(InstanceData) + 255) & ~255u;
+		std::vector<BYTE> serial(world.InstanceCount * elementByteSize);
+		std::vector<BYTE> kernel(world.InstanceCount * elementByteSize);
+		std::vector<uint32_t> serialCounts(world.Items.size());
+		CullSerial(world, frustum, serial.data(), elementByteSize, serialCounts);
+
+		InstanceCullCompactKernel cullKernel;
+		std::vector<InstanceCullRange> ranges;
+		MakeRanges(world, ranges);
+		cullKernel.Run(ranges.data(), ranges.size(), views, 1u, kernel.data(), elementByteSize);
+		Check(memcmp(serial.data(), kernel.data(), serial.size()) == 0, "kernel honours the element stride");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunInstanceCullBenchmark()
+	{
+		std::printf("[InstanceCull] serial frustum loop vs parallel cull + compact kernel\n");
+		RunSingleView(40);
+		RunSingleView(400);
+		RunStrideCheck();
+	}
+}
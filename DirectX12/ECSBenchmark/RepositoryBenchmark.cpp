@@ -0,0 +1,129 @@
+// IRepository의 비동기 로드 검증과 처리량 측정.
+// 로더가 실패하거나 예외를 던져도 핸들이 Failed로 끝나 LoadFuture::Wait와 같은 이름의 동기 Load가 멈추지 않는지 확인하고,
+// 작은 리소스를 LoadAsync로 한꺼번에 요청해 모두 Ready가 될 때까지의 시간과 락 없는 Get 비용을 측정합니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/ECSRepository.h"
+#include <future>
+#include <stdexcept>
+
+namespace
+{
+	using namespace ECSBenchmark;
+
+	struct TestResource
+	{
+		size_t Value = 0;
+	};
+
+	// "throw"로 시작하는 이름은 예외를, "fail"로 시작하는 이름은 false를 돌려줍니다.
+	// 두 로드가 겹치도록 실패하는 로드는 잠시 기다립니다.
+	class TestRepository : public ECS::IRepository<TestResource>
+	{
+	public:
+		~TestRepository() { Shutdown(); }
+
+		std::atomic<int> LoadCount{ 0 };
+
+	protected:
+		bool LoadResourceInternal(const std::string& name, TestResource* ptr) override
+		{
+			++LoadCount;
+			if (name.rfind("throw", 0) == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				throw std::runtime_error("loader failed");
+			}
+			if (name.rfind("fail", 0) == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				return false;
+			}
+			ptr->Value = name.size();
+			return true;
+		}
+	};
+
+	// 다른 스레드에서 Load(name)을 실행하고, 제한 시간 안에 끝나지 않으면 멈춘 것으로 봅니다.
+	// 멈춘 스레드는 정리할 수 없으므로 그때는 바로 종료합니다.
+	ECS::RepoHandle LoadWithTimeout(TestRepository& repository, const std::string& name)
+	{
+		auto result = std::async(std::launch::async, [&repository, name]() { return repository.Load(name); });
+		if (result.wait_for(std::chrono::seconds(5)) != std::future_status::ready)
+		{
+			Check(false, "Load of a failing resource returns instead of waiting forever");
+			std::printf("Some checks FAILED.\n");
+			std::fflush(stdout);
+			std::quick_exit(1);
+		}
+		return result.get();
+	}
+
+	void RunFailedLoads(const char* prefix)
+	{
+		TestRepository repository;
+		const std::string name = std::string(prefix) + ".mesh";
+
+		// 워커에서 로드 중인 이름을 동기 Load가 기다리는 경우
+		TestRepository::LoadFuture future = repository.LoadAsync(name);
+		const ECS::RepoHandle concurrent = LoadWithTimeout(repository, name);
+		Check(future.Wait() == ECS::eLoadState::Failed, "LoadFuture::Wait reports Failed");
+		Check(future.Get() == nullptr && repository.Get(future.GetHandle()) == nullptr, "failed handle has no resource");
+		Check(concurrent == 0, "concurrent Load of the same name returns an invalid handle");
+
+		// 실패한 이름은 매핑에서 지워지므로 다시 로드하면 로더를 다시 부릅니다.
+		const int loadCount = repository.LoadCount.load();
+		Check(LoadWithTimeout(repository, name) == 0 && repository.LoadCount.load() == loadCount + 1, "failed name is loaded again on the next Load");
+
+		repository.Release(future.GetHandle());
+		Check(repository.GetState(future.GetHandle()) == ECS::eLoadState::Empty, "released failed handle becomes Empty");
+
+		TestRepository::LoadFuture good = repository.LoadAsync("good.mesh");
+		Check(good.Get() && good.Get()->Value == 9, "other loads still succeed");
+		repository.Release(good.GetHandle());
+	}
+
+	void RunThroughput()
+	{
+		constexpr size_t resourceCount = 4096;
+		std::vector<std::string> names(resourceCount);
+		for (size_t i = 0; i < resourceCount; ++i)
+			names[i] = "resource" + std::to_string(i);
+
+		TestRepository repository;
+		std::vector<TestRepository::LoadFuture> futures(resourceCount);
+		bool allReady = true;
+		double loadMs = MeasureBest(3, [&]() {
+			repository.Shutdown();
+			for (size_t i = 0; i < resourceCount; ++i)
+				futures[i] = repository.LoadAsync(names[i]);
+			for (const auto& future : futures)
+				allReady &= future.Wait() == ECS::eLoadState::Ready;
+		});
+		Report("LoadAsync + Wait", resourceCount, loadMs);
+
+		size_t sum = 0;
+		double getMs = MeasureBest(5, [&]() {
+			for (int pass = 0; pass < 100; ++pass)
+			{
+				for (const auto& future : futures)
+					sum += repository.Get(future.GetHandle())->Value;
+			}
+		});
+		Report("Get (lock-free)", resourceCount * 100, getMs);
+
+		Check(allReady, "every async load becomes Ready");
+		Check(sum > 0, "loaded resources are readable");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunRepositoryBenchmark()
+	{
+		std::printf("[Repository] async load failures and throughput\n");
+		RunFailedLoads("fail");
+		RunFailedLoads("throw");
+		RunThroughput();
+	}
+}
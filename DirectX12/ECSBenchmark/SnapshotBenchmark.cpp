@@ -0,0 +1,155 @@
+// 바이너리 월드 스냅샷 왕복(저장 -> 로드)과 이전 JSON 저장 경로의 비교.
+// 이전 SaveWorldToFile은 엔티티마다 모든 컴포넌트를 nlohmann::json 객체로 만든 뒤 dump(4)로 기록했습니다.
+// 손상된 파일이 기존 월드를 지우지 않고 거부되는지도 함께 확인합니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/ECSQuery.h"
+#include "../ECSCore/ECSSnapshot.h"
+#include <cstddef>
+#include <filesystem>
+
+namespace
+{
+	using namespace ECSBenchmark;
+
+	struct SnapshotPosition {
+		static const char* GetName() { return "SnapshotPosition"; }
+		float X = 0.0f, Y = 0.0f, Z = 0.0f;
+	};
+	struct SnapshotVelocity {
+		static const char* GetName() { return "SnapshotVelocity"; }
+		float X = 0.0f, Y = 0.0f, Z = 0.0f;
+		float Damping = 0.0f;
+	};
+	void to_json(json& j, const SnapshotPosition& p) { j = json{ { "Position", { p.X, p.Y, p.Z } } }; }
+	void to_json(json& j, const SnapshotVelocity& v) { j = json{ { "Velocity", { v.X, v.Y, v.Z } }, { "Damping", v.Damping } }; }
+
+	void RegisterComponents(ECS::ArchetypeManager& manager)
+	{
+		manager.RegisterComponent<SnapshotPosition>();
+		manager.RegisterComponent<SnapshotVelocity>();
+	}
+
+	// 절반은 위치만, 절반은 위치와 속도를 가진 엔티티 entityCount개를 만듭니다.
+	void PopulateWorld(ECS::EntityManager& entityManager, ECS::ArchetypeManager& manager, size_t entityCount)
+	{
+		for (size_t i = 0; i < entityCount; ++i)
+		{
+			ECS::Entity entity = entityManager.CreateEntity();
+			ECS::Signature signature;
+			manager.AddComponent(entity, SnapshotPosition{ static_cast<float>(i), 1.0f, 2.0f }, signature);
+			signature.set(manager.GetComponentType<SnapshotPosition>());
+			if (i % 2)
+			{
+				manager.AddComponent(entity, SnapshotVelocity{ 0.0f, static_cast<float>(i), 0.0f, 0.5f }, signature);
+				signature.set(manager.GetComponentType<SnapshotVelocity>());
+			}
+			entityManager.SetSignature(entity, signature);
+		}
+	}
+
+	double SumPositions(ECS::ArchetypeManager& manager)
+	{
+		double sum = 0.0;
+		ECS::EntityQuery<const SnapshotPosition>(&manager).ForEach([&sum](const SnapshotPosition& p) { sum += p.X; });
+		return sum;
+	}
+
+	void SaveJson(ECS::ArchetypeManager& manager, const std::string& filePath)
+	{
+		json entities = json::array();
+		for (ECS::Archetype* archetype : manager.GetArchetypes())
+		{
+			for (ECS::ComponentHandle handle = 0; handle < archetype->GetEntityCount(); ++handle)
+			{
+				json entity;
+				for (ECS::ComponentType type = 0; type < manager.GetComponentTypeCount(); ++type)
+				{
+					if (archetype->HasComponent(type))
+						archetype->AddComponentToJson(type, handle, entity);
+				}
+				entities.push_back(std::move(entity));
+			}
+		}
+		std::ofstream file(filePath);
+		file << json{ { "entities", entities } }.dump(4);
+	}
+
+	void RunRoundTrip(size_t entityCount, const std::string& directory)
+	{
+		const std::string snapshotPath = directory + "/bench.ecsw";
+		const std::string jsonPath = directory + "/bench.json";
+
+		ECS::EntityManager entityManager;
+		ECS::ArchetypeManager manager;
+		RegisterComponents(manager);
+		PopulateWorld(entityManager, manager, entityCount);
+		const double expectedSum = SumPositions(manager);
+		TimeComponent time{};
+
+		std::printf(" %zu entities\n", entityCount);
+		double jsonMs = MeasureBest(3, [&]() { SaveJson(manager, jsonPath); });
+		Report("JSON dump(4) save", entityCount, jsonMs);
+
+		bool saved = true;
+		double saveMs = MeasureBest(5, [&]() { saved &= ECS::WorldSnapshot::Save(snapshotPath, manager, time); });
+		Report("binary snapshot save", entityCount, saveMs);
+
+		ECS::EntityManager loadedEntities;
+		ECS::ArchetypeManager loaded;
+		RegisterComponents(loaded);
+		bool restored = true;
+		double loadMs = MeasureBest(5, [&]() { restored &= ECS::WorldSnapshot::Load(snapshotPath, loadedEntities, loaded, time); });
+		Report("binary snapshot load", entityCount, loadMs);
+
+		Check(saved && restored, "snapshot save and load succeed");
+		Check(loadedEntities.GetLivingEntityCount() == entityCount, "snapshot restores every entity");
+		Check(SumPositions(loaded) == expectedSum, "snapshot restores component data");
+	}
+
+	// 손상된 스냅샷은 월드를 지우기 전에 거부되어야 합니다.
+	void RunCorruptionCheck(const std::string& directory)
+	{
+		const std::string snapshotPath = directory + "/valid.ecsw";
+		const std::string corruptPath = directory + "/corrupt.ecsw";
+
+		ECS::EntityManager entityManager;
+		ECS::ArchetypeManager manager;
+		RegisterComponents(manager);
+		PopulateWorld(entityManager, manager, 1000);
+		TimeComponent time{};
+		ECS::WorldSnapshot::Save(snapshotPath, manager, time);
+
+		std::ifstream input(snapshotPath, std::ios::binary);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		input.close();
+
+		auto loadCorrupted = [&](const std::vector<char>& corrupted) {
+			std::ofstream(corruptPath, std::ios::binary).write(corrupted.data(), static_cast<std::streamsize>(corrupted.size()));
+			return ECS::WorldSnapshot::Load(corruptPath, entityManager, manager, time);
+		};
+
+		// 첫 아키타입 블록의 EntityCount를 곱셈이 넘칠 만큼 크게 바꿉니다.
+		size_t blockOffset = sizeof(ECS::WorldSnapshot::SnapshotHeader) + 2 * sizeof(ECS::WorldSnapshot::SnapshotComponentType);
+		blockOffset = (blockOffset + ECS::WorldSnapshot::SNAPSHOT_ALIGNMENT - 1) & ~(ECS::WorldSnapshot::SNAPSHOT_ALIGNMENT - 1);
+		std::vector<char> hugeCount = bytes;
+		std::uint64_t count = (std::numeric_limits<std::uint64_t>::max() / sizeof(SnapshotPosition)) + 2;
+		std::memcpy(hugeCount.data() + blockOffset + offsetof(ECS::WorldSnapshot::SnapshotArchetype, EntityCount), &count, sizeof(count));
+		Check(!loadCorrupted(hugeCount), "overflowing entity count is rejected");
+
+		std::vector<char> truncated(bytes.begin(), bytes.end() - 64);
+		Check(!loadCorrupted(truncated), "truncated snapshot is rejected");
+		Check(entityManager.GetLivingEntityCount() == 1000, "rejected snapshot leaves the world intact");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunSnapshotBenchmark()
+	{
+		std::printf("[Snapshot] JSON save vs binary snapshot round trip\n");
+		const std::string directory = std::filesystem::temp_directory_path().string();
+		RunRoundTrip(100000, directory);
+		RunCorruptionCheck(directory);
+	}
+}
@@ -0,0 +1,144 @@
+// WorldMatrixUpdateSystem의 SIMD 배치 커널과 이전 엔티티별 스칼라 경로의 비교.
+// 이전 경로는 엔티티마다 회전 행렬 세 개를 곱하고 XMMatrixInverse로 일반 4x4 역행렬을 구했습니다.
+// 두 경로를 같은 입력으로 실행해 World/WorldInvTranspose/TexTransform/RotationQuat의 오차도 확인합니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/WorldMatrixUpdateSystem.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+	using namespace ECSBenchmark;
+
+	// 아키타입 청크 하나에 들어가는 행 수와 비슷한 크기로 잘라 커널을 호출합니다.
+	constexpr size_t SLICE_ROWS = 64;
+
+	// SIMD 배치 커널 이전 WorldMatrixUpdateSystem::Update의 엔티티별 계산.
+	void UpdateScalar(TransformComponent& transform, const CFGInstanceComponent& cfg, const TextureScaleComponent& textureScale, InstanceData& instance)
+	{
+		using namespace DirectX;
+
+		float rx = XMConvertToRadians(transform.Rotation.x);
+		float ry = XMConvertToRadians(transform.Rotation.y);
+		float rz = XMConvertToRadians(transform.Rotation.z);
+		transform.RotationQuat = XMQuaternionRotationRollPitchYaw(rx, ry, rz);
+
+		XMMATRIX rotation = XMMatrixRotationX(rx) * XMMatrixRotationY(ry) * XMMatrixRotationZ(rz);
+		if (cfg.Option & eCFGInstanceComponent::UseQuat)
+			rotation = XMMatrixRotationQuaternion(XMLoadFloat4(&transform.RotationQuat));
+
+		XMMATRIX world = XMMatrixScaling(transform.Scale.x, transform.Scale.y, transform.Scale.z) * rotation
+			* XMMatrixTranslation(transform.Position.x, transform.Position.y, transform.Position.z);
+		XMMATRIX texTransform = XMMatrixScaling(textureScale.TextureScale.x, textureScale.TextureScale.y, textureScale.TextureScale.z);
+		XMVECTOR determinant = XMMatrixDeterminant(world);
+		instance.World = XMMatrixTranspose(world);
+		instance.TexTransform = XMMatrixTranspose(texTransform);
+		instance.WorldInvTranspose = XMMatrixInverse(&determinant, world);
+	}
+
+	struct TransformWorld
+	{
+		std::vector<TransformComponent> Transforms;
+		std::vector<CFGInstanceComponent> Cfgs;
+		std::vector<TextureScaleComponent> TextureScales;
+		std::vector<InstanceData> Instances;
+	};
+
+	// 1/3은 UseQuat 경로, 나머지는 오일러 경로를 타도록 임의의 트랜스폼을 만듭니다.
+	void Populate(TransformWorld& world, size_t count)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> degrees(-360.0f, 360.0f), scale(0.2f, 5.0f), position(-100.0f, 100.0f);
+
+		world.Transforms.resize(count);
+		world.Cfgs.resize(count);
+		world.TextureScales.resize(count);
+		world.Instances.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			TransformComponent& transform = world.Transforms[i];
+			transform.Position = float3(position(random), position(random), position(random));
+			transform.Scale = float3(scale(random), scale(random), scale(random));
+			transform.Rotation = float3(degrees(random), degrees(random), degrees(random));
+			if (i % 3 == 0)
+				world.Cfgs[i].Option = eCFGInstanceComponent::UseQuat;
+			world.TextureScales[i].TextureScale = float3(1.0f, 2.0f, 3.0f);
+		}
+	}
+
+	struct MaxError
+	{
+		double World = 0.0;
+		double InverseRelative = 0.0;
+		double TexTransform = 0.0;
+		double Quaternion = 0.0;
+	};
+
+	MaxError Compare(const TransformWorld& expected, const TransformWorld& actual)
+	{
+		MaxError error;
+		for (size_t i = 0; i < expected.Instances.size(); ++i)
+		{
+			const InstanceData& a = expected.Instances[i];
+			const InstanceData& b = actual.Instances[i];
+			for (int r = 0; r < 4; ++r)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					error.World = std::max(error.World, static_cast<double>(std::fabs(a.World.m[r][c] - b.World.m[r][c])));
+					error.TexTransform = std::max(error.TexTransform, static_cast<double>(std::fabs(a.TexTransform.m[r][c] - b.TexTransform.m[r][c])));
+					double inverse = std::fabs(a.WorldInvTranspose.m[r][c] - b.WorldInvTranspose.m[r][c]) / (1.0 + std::fabs(a.WorldInvTranspose.m[r][c]));
+					error.InverseRelative = std::max(error.InverseRelative, inverse);
+				}
+			}
+			const float4& qa = expected.Transforms[i].RotationQuat;
+			const float4& qb = actual.Transforms[i].RotationQuat;
+			error.Quaternion = std::max({ error.Quaternion,
+				static_cast<double>(std::fabs(qa.x - qb.x)), static_cast<double>(std::fabs(qa.y - qb.y)),
+				static_cast<double>(std::fabs(qa.z - qb.z)), static_cast<double>(std::fabs(qa.w - qb.w)) });
+		}
+		return error;
+	}
+
+	void RunInstanceCount(size_t count)
+	{
+		TransformWorld scalar;
+		Populate(scalar, count);
+		TransformWorld batch = scalar;
+		const int repeat = count >= 1000000 ? 3 : 10;
+
+		std::printf(" %zu instances\n", count);
+		double scalarMs = MeasureBest(repeat, [&]() {
+			for (size_t i = 0; i < count; ++i)
+				UpdateScalar(scalar.Transforms[i], scalar.Cfgs[i], scalar.TextureScales[i], scalar.Instances[i]);
+		});
+		Report("scalar per entity", count, scalarMs);
+
+		double batchMs = MeasureBest(repeat, [&]() {
+			for (size_t first = 0; first < count; first += SLICE_ROWS)
+			{
+				size_t rows = std::min(SLICE_ROWS, count - first);
+				WorldMatrixUpdateSystem::UpdateChunk(rows, &batch.Transforms[first], &batch.Cfgs[first],
+					&batch.TextureScales[first], &batch.Instances[first]);
+			}
+		});
+		Report("SIMD batch (4 lanes)", count, batchMs);
+
+		MaxError error = Compare(scalar, batch);
+		std::printf("  max error: world %.2e, inverse (relative) %.2e, quaternion %.2e\n", error.World, error.InverseRelative, error.Quaternion);
+		// 기준 경로의 XMMatrixInverse도 float 소거법이라 스케일이 작은 행렬에서는 1e-4 정도 차이가 납니다.
+		Check(error.World <= 1e-4 && error.InverseRelative <= 1e-3 && error.Quaternion <= 1e-5, "SIMD batch matches the scalar matrices");
+		Check(error.TexTransform == 0.0, "SIMD batch writes the same texture transform");
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunTransformBenchmark()
+	{
+		std::printf("[Transform] scalar world matrix update vs SIMD batch kernel\n");
+		for (size_t count : { size_t(1000), size_t(10000), size_t(100000), size_t(1000000) })
+			RunInstanceCount(count);
+	}
+}
@@ -0,0 +1,158 @@
+// ViewFrustumSet::Test와 뷰마다 BoundingFrustum::Contains를 부르는 경로의 비교.
+// 카메라 원근 절두체 하나와 그림자 캐스케이드 같은 직교 절두체 네 개로 임의의 바운딩 스피어를 검사해
+// 뷰 마스크가 Contains(sphere) != DISJOINT와 같은지 확인합니다.
+
+#include "BenchmarkCommon.h"
+#include "../ECSCore/DX12_InstanceCullCompact.h"
+#include <bit>
+#include <random>
+
+namespace
+{
+	using namespace ECSBenchmark;
+	using namespace DirectX;
+
+	std::vector<BoundingFrustum> MakeViews()
+	{
+		std::vector<BoundingFrustum> frustums(5);
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(10.0f, 20.0f, -30.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		BoundingFrustum::CreateFromMatrix(frustums[0], XMMatrixPerspectiveFovLH(0.8f, 1.7f, 1.0f, 150.0f));
+		frustums[0].Transform(frustums[0], XMMatrixInverse(nullptr, view));
+
+		for (int c = 0; c < 4; ++c)
+		{
+			XMMATRIX lightView = XMMatrixLookAtLH(XMVectorSet(50.0f, 100.0f, 50.0f, 1.0f),
+				XMVectorSet(c * 20.0f, 0.0f, c * 10.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			const float size = 30.0f * (c + 1);
+			BoundingFrustum::CreateFromMatrix(frustums[1 + c], XMMatrixOrthographicLH(size, size, 1.0f, 400.0f));
+			frustums[1 + c].Transform(frustums[1 + c], XMMatrixInverse(nullptr, lightView));
+		}
+		return frustums;
+	}
+
+	std::vector<InstanceComponent> MakeInstances(size_t count)
+	{
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f), radius(0.1f, 5.0f);
+
+		std::vector<InstanceComponent> instances(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			instances[i].BoundingSphere = BoundingSphere(XMFLOAT3(position(random), position(random) * 0.2f, position(random)), radius(random));
+			instances[i].InstanceData.MaterialIndex = static_cast<uint32_t>(i);
+		}
+		return instances;
+	}
+
+	uint32_t ContainsMask(const std::vector<BoundingFrustum>& frustums, const BoundingSphere& sphere)
+	{
+		uint32_t mask = 0;
+		for (size_t v = 0; v < frustums.size(); ++v)
+		{
+			if (frustums[v].Contains(sphere) != DISJOINT)
+				mask |= 1u << v;
+		}
+		return mask;
+	}
+
+	void RunMaskComparison(const std::vector<BoundingFrustum>& frustums, const std::vector<InstanceComponent>& instances)
+	{
+		ViewFrustumSet views;
+		for (const BoundingFrustum& frustum : frustums)
+			views.Add(frustum);
+
+		std::vector<uint32_t> expected(instances.size());
+		std::vector<uint32_t> actual(instances.size());
+
+		std::printf(" %zu spheres, %zu views\n", instances.size(), frustums.size());
+		double containsMs = MeasureBest(5, [&]() {
+			for (size_t i = 0; i < instances.size(); ++i)
+				expected[i] = ContainsMask(frustums, instances[i].BoundingSphere);
+		});
+		Report("BoundingFrustum::Contains per view", instances.size(), containsMs);
+
+		double testMs = MeasureBest(5, [&]() {
+			for (size_t i = 0; i < instances.size(); ++i)
+				actual[i] = views.Test(instances[i].BoundingSphere);
+		});
+		Report("ViewFrustumSet::Test", instances.size(), testMs);
+
+		size_t visibleBits = 0;
+		for (uint32_t mask : expected)
+			visibleBits += std::popcount(mask);
+		std::printf("  %zu visible (sphere, view) pairs\n", visibleBits);
+		Check(visibleBits > 0 && expected == actual, "view masks match BoundingFrustum::Contains");
+	}
+
+	// 그룹 여덟 개를 모두 채우면 뷰 v의 비트가 절두체 v % 5의 결과와 같아야 하고, 33번째 뷰는 거부되어야 합니다.
+	void RunFullSet(const std::vector<BoundingFrustum>& frustums, const std::vector<InstanceComponent>& instances)
+	{
+		ViewFrustumSet views;
+		for (uint32_t v = 0; v < ViewFrustumSet::MaxViews; ++v)
+			views.Add(frustums[v % frustums.size()]);
+		Check(views.GetAllViewsMask() == UINT32_MAX, "32 views fill the mask");
+		Check(views.Add(frustums[0]) == ViewFrustumSet::InvalidView && views.GetViewCount() == ViewFrustumSet::MaxViews,
+			"33rd view is rejected");
+
+		bool same = true;
+		for (size_t i = 0; i < 2000; ++i)
+		{
+			const uint32_t expected = ContainsMask(frustums, instances[i].BoundingSphere);
+			const uint32_t mask = views.Test(instances[i].BoundingSphere);
+			for (uint32_t v = 0; v < ViewFrustumSet::MaxViews; ++v)
+				same = same && ((mask >> v) & 1u) == ((expected >> (v % frustums.size())) & 1u);
+		}
+		Check(same, "every group of a full set matches Contains");
+	}
+
+	// compactMask로 고른 뷰 중 하나라도 볼 수 있는 인스턴스만 순서대로 기록되고, 인스턴스별 마스크는 모든 뷰의 결과여야 합니다.
+	void RunCompactMask(const std::vector<BoundingFrustum>& frustums, const std::vector<InstanceComponent>& instances)
+	{
+		ViewFrustumSet views;
+		for (const BoundingFrustum& frustum : frustums)
+			views.Add(frustum);
+
+		for (uint32_t compactMask : { 1u, 0x1Eu, views.GetAllViewsMask() })
+		{
+			std::vector<uint32_t> expected;
+			for (const InstanceComponent& instance : instances)
+			{
+				if (ContainsMask(frustums, instance.BoundingSphere) & compactMask)
+					expected.push_back(instance.InstanceData.MaterialIndex);
+			}
+
+			std::vector<InstanceData> buffer(instances.size());
+			std::vector<uint32_t> masks(instances.size());
+			InstanceCullRange range;
+			range.Instances = instances.data();
+			range.Count = static_cast<uint32_t>(instances.size());
+			range.CullingEnabled = true;
+			range.VisibilityMasks = masks.data();
+			InstanceCullCompactKernel cullKernel;
+			cullKernel.Run(&range, 1, views, compactMask, reinterpret_cast<BYTE*>(buffer.data()), sizeof(InstanceData));
+
+			bool same = range.VisibleCount == expected.size();
+			for (size_t i = 0; same && i < expected.size(); ++i)
+				same = buffer[i].MaterialIndex == expected[i];
+			Check(same, "kernel compacts the instances seen by any view in the mask");
+
+			bool sameMasks = true;
+			for (size_t i = 0; sameMasks && i < instances.size(); ++i)
+				sameMasks = masks[i] == ContainsMask(frustums, instances[i].BoundingSphere);
+			Check(sameMasks, "kernel records the mask of every view");
+		}
+	}
+}
+
+namespace ECSBenchmark
+{
+	void RunViewFrustumBenchmark()
+	{
+		std::printf("[ViewFrustum] per-view Contains vs multi-view SIMD mask\n");
+		const std::vector<BoundingFrustum> frustums = MakeViews();
+		const std::vector<InstanceComponent> instances = MakeInstances(100000);
+		RunMaskComparison(frustums, instances);
+		RunFullSet(frustums, instances);
+		RunCompactMask(frustums, instances);
+	}
+}
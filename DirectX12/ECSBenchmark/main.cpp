@@ -0,0 +1,19 @@
+// ECSBenchmark: ECSCore 자료구조와 커널의 마이크로 벤치마크.
+// Release|x64로 빌드해 실행하며, 각 벤치마크는 최적화 경로의 결과를 기준 경로와 비교해 검증합니다.
+
+#include "BenchmarkCommon.h"
+
+int main()
+{
+	ECSBenchmark::RunArchetypeBenchmark();
+	ECSBenchmark::RunDescriptorAllocatorBenchmark();
+	ECSBenchmark::RunEntityBenchmark();
+	ECSBenchmark::RunInstanceCullBenchmark();
+	ECSBenchmark::RunRepositoryBenchmark();
+	ECSBenchmark::RunSnapshotBenchmark();
+	ECSBenchmark::RunTransformBenchmark();
+	ECSBenchmark::RunViewFrustumBenchmark();
+
+	std::printf("%s\n", ECSBenchmark::gFailureCount == 0 ? "All checks passed." : "Some checks FAILED.");
+	return ECSBenchmark::gFailureCount == 0 ? 0 : 1;
+}
@@ -4,16 +4,14 @@
 
 class BoundingVolumeUpdateSystem : public ECS::ISystem {
 public:
-	void Update() override {
-		auto& coordinator = ECS::Coordinator::GetInstance();
-		for (ECS::Entity entity : mEntities) {
-			auto& transform = coordinator.GetComponent<TransformComponent>(entity);
-			if (!transform.Dirty)
-				continue;
-
-			auto& boundingVolumn = coordinator.GetComponent<BoundingVolumnComponent>(entity);
-			auto& mesh = coordinator.GetComponent<DX12_MeshComponent>(entity);
+	void DeclareAccess(ECS::SystemAccess& access) override {
+		access.Read<TransformComponent>().Read<DX12_MeshComponent>().Write<BoundingVolumnComponent>();
+	}
 
+	// 지난 Update 이후 트랜스폼이나 메시가 바뀐 청크만 다시 계산합니다.
+	void Update() override {
+		Query<const TransformComponent, const DX12_MeshComponent, BoundingVolumnComponent>().Changed<TransformComponent, DX12_MeshComponent>().ParallelForEach(
+			[](const TransformComponent& transform, const DX12_MeshComponent& mesh, BoundingVolumnComponent& boundingVolumn) {
 			boundingVolumn.BoundingBox = mesh.BoundingBox;
 			boundingVolumn.BoundingBox.Center.x *= transform.Scale.x;
 			boundingVolumn.BoundingBox.Center.y *= transform.Scale.y;
@@ -33,7 +31,7 @@ public:
 			boundingVolumn.BoundingSphere.Center.y += transform.Position.y;
 			boundingVolumn.BoundingSphere.Center.z += transform.Position.z;
 			boundingVolumn.BoundingSphere.Radius *= transform.Scale.Length();
-		}
+		});
 	}
 
 private:
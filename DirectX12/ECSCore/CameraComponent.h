@@ -129,6 +129,10 @@ public:
 		CameraData.Proj = DirectX::XMMatrixPerspectiveFovLH(CurrentFOV, Aspect, NearZ, FarZ);
 
 		CameraData.ViewProj = DirectX::XMMatrixMultiply(CameraData.View, CameraData.Proj);
+
+		// Step 5. 월드 공간 절두체 (DX12_SceneSystem의 뷰 컬링에서 사용)
+		DirectX::BoundingFrustum::CreateFromMatrix(Frustum, CameraData.Proj);
+		Frustum.Transform(Frustum, DirectX::XMMatrixInverse(nullptr, CameraData.View));
 	}
 
 	float4 GetPosition4f()const { return float4(r_Position.x, r_Position.y, r_Position.z, 0.0f); }
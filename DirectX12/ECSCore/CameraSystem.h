@@ -25,8 +25,8 @@ public:
 		if (input.IsKeyDown('w')) moveDir.z += 1.0f;
 		if (input.IsKeyDown('S')) moveDir.z -= 1.0f;
 		if (input.IsKeyDown('s')) moveDir.z -= 1.0f;
-		moveDir *= ECS::Coordinator::GetInstance().GetSingletonComponent<TimeComponent>().deltaTime;
-		LOG_VERBOSE("delta: {} || called with moveDir: {}, {}, {}", ECS::Coordinator::GetInstance().GetSingletonComponent<TimeComponent>().deltaTime, moveDir.x, moveDir.y, moveDir.z);
+		moveDir *= ECS::Coordinator::GetInstance().GetSingletonComponent<const TimeComponent>().deltaTime;
+		LOG_VERBOSE("delta: {} || called with moveDir: {}, {}, {}", ECS::Coordinator::GetInstance().GetSingletonComponent<const TimeComponent>().deltaTime, moveDir.x, moveDir.y, moveDir.z);
 		
 
 		auto currCameraBuffer = DX12_FrameResourceSystem::GetInstance().GetCurrentFrameResource().CameraDataBuffer.get();
@@ -49,6 +49,9 @@ public:
 
 		return mAllCameras.size() - 1;
 	}
+	size_t GetCameraCount() const {
+		return mAllCameras.size();
+	}
 	CameraComponent* GetCamera(size_t handle) {
 		if (handle < mAllCameras.size()) {
 			return mAllCameras[handle].get();
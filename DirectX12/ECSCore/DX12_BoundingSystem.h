@@ -6,14 +6,14 @@
 
 class DX12_BoundingSystem : public ECS::ISystem {
 public:
-	void Update() override {
-		auto& coordinator = ECS::Coordinator::GetInstance();
-		for (ECS::Entity entity : mEntities) {
-			auto& transform = coordinator.GetComponent<TransformComponent>(entity);
-			if (!transform.Dirty) continue;
-			auto& bounding = coordinator.GetComponent<DX12_BoundingComponent>(entity);
-			auto& mesh = coordinator.GetComponent<DX12_MeshComponent>(entity);
+	void DeclareAccess(ECS::SystemAccess& access) override {
+		access.Read<TransformComponent>().Read<DX12_MeshComponent>().Write<DX12_BoundingComponent>();
+	}
 
+	// 지난 Update 이후 트랜스폼이나 메시가 바뀐 청크만 다시 계산합니다.
+	void Update() override {
+		Query<const TransformComponent, const DX12_MeshComponent, DX12_BoundingComponent>().Changed<TransformComponent, DX12_MeshComponent>().ForEach(
+			[](const TransformComponent& transform, const DX12_MeshComponent& mesh, DX12_BoundingComponent& bounding) {
 			DirectX::XMMATRIX S = DirectX::XMMatrixScaling(transform.Scale.x, transform.Scale.y, transform.Scale.z);
 			DirectX::XMMATRIX R = DirectX::XMMatrixRotationRollPitchYaw(
 				DirectX::XMConvertToRadians(transform.Rotation.x),
@@ -26,7 +26,7 @@ public:
 			mesh.BoundingBox.Transform(bounding.Box, world);
 			mesh.BoundingSphere.Transform(bounding.Sphere, world);
 			LOG_VERBOSE("box {}, {}, {}", bounding.Box.Center.x, bounding.Box.Center.y, bounding.Box.Center.z);
-		}
+		});
 	}
 
 private:
@@ -53,6 +53,9 @@ public:
 	inline std::uint64_t GetFenceValue() const {
 		return mFenceValue;
 	}
+	inline std::uint64_t GetCompletedFenceValue() const {
+		return mFence->GetCompletedValue();
+	}
 
 	inline void FlushCommandQueue() {
 		SetSignalFence();
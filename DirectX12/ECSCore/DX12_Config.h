@@ -162,6 +162,17 @@ public:
 		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
 	}
 
+	// 여러 원소를 한 번에 기록하는 경로(InstanceCullCompactKernel 등)에서 사용하는 매핑 메모리와 원소 간격
+	BYTE* MappedData()const
+	{
+		return mMappedData;
+	}
+
+	UINT ElementByteSize()const
+	{
+		return mElementByteSize;
+	}
+
 private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
 	BYTE* mMappedData = nullptr;
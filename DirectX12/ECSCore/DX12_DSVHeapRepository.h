@@ -67,15 +67,4 @@ protected:
 
 		return true;
 	}
-	virtual bool UnloadResource(ECS::RepoHandle handle)
-	{
-		if (IRepository<DX12_HeapComponent>::UnloadResource(handle))
-		{
-			// TODO: GPU 리소스 해제 (예: DestroyBuffer(mesh->vertexBuffer))
-
-			return true;
-		}
-
-		return false;
-	}
 };
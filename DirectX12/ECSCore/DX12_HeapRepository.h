@@ -3,7 +3,15 @@
 #include "DX12_Component.h"
 #include "TextureSystem.h"
 #include "ECSRepository.h"
+#include "DescriptorIndexAllocator.h"
 
+// 디스크립터 힙 저장소.
+// 영구 슬롯(텍스처 SRV, 스왑체인 RTV 등)은 프리 리스트로 재사용하고, 프레임 단위 임시 슬롯은 링에서 잘라 쓰며
+// 펜스 값으로 회수합니다 (DescriptorIndexAllocator). 공간이 모자라면 힙을 두 배로 키우고 영구 슬롯을 새 힙으로 복사합니다.
+// 옛 힙은 GPU가 다 쓸 때까지(그 프레임의 펜스가 완료될 때까지) 보관합니다.
+// D3D12는 셰이더 가시 힙에서 디스크립터를 복사해 올 수 없으므로, 셰이더 가시 힙은 CPU 전용 미러 힙을 함께 둡니다.
+// 이때 영구 슬롯의 CPU 핸들은 미러를 가리키고, 기록한 뒤 Commit()으로 셰이더 가시 힙에 반영합니다.
+// 모든 public 함수는 스레드 안전합니다.
 class DX12_HeapRepository
 {
 public:
@@ -12,72 +20,214 @@ public:
 		, std::uint32_t size = 64
 		, const D3D12_DESCRIPTOR_HEAP_TYPE& descType = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
 		, const D3D12_DESCRIPTOR_HEAP_FLAGS& flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE
+		, std::uint32_t transientSize = 0
 	)
 		: mDevice(device)
 		, mType(descType)
-		, mNumDescriptors(size + (DEFAULT_SIZE - size) % DEFAULT_SIZE)
+		, mFlags(flags)
 		, mDescriptorSize(device->GetDescriptorHandleIncrementSize(mType))
-		, mSize(0)
+		, mAllocator(size + (DEFAULT_SIZE - size) % DEFAULT_SIZE, transientSize + (DEFAULT_SIZE - transientSize) % DEFAULT_SIZE)
 	{
 		LOG_INFO("DX12 Heap Type: {}", static_cast<int>(mType));
 		LOG_INFO("Descriptor Size: {}", mDescriptorSize);
-		CreateHeap(mNumDescriptors, flags);
+		CreateHeaps(mAllocator.GetCapacity(), mHeap, mMirrorHeap);
 	}
 
 	~DX12_HeapRepository() = default;
 	DX12_HeapRepository(const DX12_HeapRepository&) = delete;
 	DX12_HeapRepository& operator=(const DX12_HeapRepository&) = delete;
 
-	size_t GetSize() const { return mSize; }
+	size_t GetSize() const
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return mAllocator.GetPersistentCount();
+	}
+
 	size_t LoadTexture(Texture* texture) {
-		texture->Handle = mSize;
+		std::lock_guard<std::mutex> lock(mtx);
+		texture->Handle = AllocatePersistentLocked();
 		BuildTexture2DSrv(texture);
-		return mSize++;
+		CommitLocked(static_cast<std::uint32_t>(texture->Handle));
+		return texture->Handle;
+	}
+
+	// 영구 슬롯을 할당해 기록할 CPU 핸들을 돌려줍니다. 셰이더 가시 힙이라면 기록 후 Commit()을 호출해야 합니다.
+	inline D3D12_CPU_DESCRIPTOR_HANDLE AllocateHandle()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return GetCPUHandleLocked(AllocatePersistentLocked());
+	}
+
+	inline std::uint32_t AllocateIndex()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return AllocatePersistentLocked();
+	}
+
+	// 영구 슬롯을 해제합니다. 현재 프레임의 펜스가 완료된 뒤에 재사용됩니다.
+	void Free(std::uint32_t index)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		mAllocator.FreePersistent(index);
+	}
+
+	// 미러에 기록한 영구 슬롯을 셰이더 가시 힙으로 복사합니다. 미러가 없는 힙에서는 아무것도 하지 않습니다.
+	void Commit(std::uint32_t index)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		CommitLocked(index);
+	}
+
+	// 이번 프레임에만 쓰는 count개의 연속 슬롯. GetCPUHandle로 셰이더 가시 힙에 직접 기록합니다.
+	std::uint32_t AllocateTransient(std::uint32_t count)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		std::uint32_t index = mAllocator.AllocateTransient(count);
+		if (index == DescriptorIndexAllocator::Invalid)
+		{
+			std::uint32_t transientCapacity = std::max(mAllocator.GetTransientCapacity() * 2, DEFAULT_SIZE);
+			while (transientCapacity < count)
+				transientCapacity *= 2;
+			GrowLocked(mAllocator.GetPersistentCapacity(), transientCapacity);
+			index = mAllocator.AllocateTransient(count);
+		}
+		return index;
+	}
+
+	// 프레임 시작 시 GPU가 끝낸 펜스 값으로 임시 구간, 해제된 슬롯, 옛 힙을 회수합니다.
+	void BeginFrame(std::uint64_t completedFenceValue)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		mAllocator.ReleaseCompleted(completedFenceValue);
+		while (!mRetiredHeaps.empty() && mRetiredHeaps.front().FenceValue <= completedFenceValue)
+			mRetiredHeaps.pop_front();
+	}
+
+	// 프레임을 제출하며 Signal한 펜스 값을 이번 프레임의 임시 구간, 해제 슬롯, 교체된 힙에 붙입니다.
+	void EndFrame(std::uint64_t fenceValue)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		mAllocator.EndFrame(fenceValue);
+		for (auto& retired : mFrameRetiredHeaps)
+			mRetiredHeaps.push_back({ fenceValue, std::move(retired) });
+		mFrameRetiredHeaps.clear();
 	}
 
+	// 힙이 커지면 바뀌므로, 커맨드 리스트에 설정할 때마다 새로 가져옵니다.
 	inline ID3D12DescriptorHeap* GetHeap() const
 	{
+		std::lock_guard<std::mutex> lock(mtx);
 		return mHeap.Get();
 	}
 	size_t GetIndex(D3D12_CPU_DESCRIPTOR_HANDLE handle)
 	{
-		return (handle.ptr - mHeap->GetCPUDescriptorHandleForHeapStart().ptr) / mDescriptorSize;
-	}
-	inline D3D12_CPU_DESCRIPTOR_HANDLE AllocateHandle()
-	{
-		return static_cast<D3D12_CPU_DESCRIPTOR_HANDLE>(mHeap->GetCPUDescriptorHandleForHeapStart().ptr + mSize++ * mDescriptorSize);
+		std::lock_guard<std::mutex> lock(mtx);
+		ID3D12DescriptorHeap* heap = mMirrorHeap ? mMirrorHeap.Get() : mHeap.Get();
+		SIZE_T start = heap->GetCPUDescriptorHandleForHeapStart().ptr;
+		if (handle.ptr < start || handle.ptr >= start + SIZE_T(mAllocator.GetPersistentCapacity()) * mDescriptorSize)
+			start = mHeap->GetCPUDescriptorHandleForHeapStart().ptr;
+		return (handle.ptr - start) / mDescriptorSize;
 	}
 	inline D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(std::uint32_t index)
 	{
-		return static_cast<D3D12_CPU_DESCRIPTOR_HANDLE>(mHeap->GetCPUDescriptorHandleForHeapStart().ptr + index * mDescriptorSize);
+		std::lock_guard<std::mutex> lock(mtx);
+		return GetCPUHandleLocked(index);
 	}
 	inline D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(std::uint32_t index)
 	{
-		return static_cast<D3D12_GPU_DESCRIPTOR_HANDLE>(mHeap->GetGPUDescriptorHandleForHeapStart().ptr + index * mDescriptorSize);
+		std::lock_guard<std::mutex> lock(mtx);
+		return static_cast<D3D12_GPU_DESCRIPTOR_HANDLE>(mHeap->GetGPUDescriptorHandleForHeapStart().ptr + SIZE_T(index) * mDescriptorSize);
 	}
 protected:
 	constexpr static std::uint32_t DEFAULT_SIZE = 64;
+
+	struct RetiredHeap
+	{
+		std::uint64_t FenceValue;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> Heaps;
+	};
+
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mMirrorHeap;	// 셰이더 가시 힙일 때만 존재
 	const D3D12_DESCRIPTOR_HEAP_TYPE mType;
+	const D3D12_DESCRIPTOR_HEAP_FLAGS mFlags;
 	const std::uint32_t mDescriptorSize;
-	const std::uint32_t mNumDescriptors;
 	ID3D12Device* mDevice;
 
 	mutable std::mutex mtx;
-	size_t mSize;
+	DescriptorIndexAllocator mAllocator;
+	std::vector<std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>>> mFrameRetiredHeaps;
+	std::deque<RetiredHeap> mRetiredHeaps;
 
 protected:
-	inline void CreateHeap(uint32_t num, D3D12_DESCRIPTOR_HEAP_FLAGS flags)
+	inline void CreateHeaps(uint32_t num, Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& heap, Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& mirrorHeap)
 	{
 		D3D12_DESCRIPTOR_HEAP_DESC heapDesc
 		{
 			/* D3D12_DESCRIPTOR_HEAP_TYPE Type	*/mType,
 			/* UINT NumDescriptors				*/num,
-			/* D3D12_DESCRIPTOR_HEAP_FLAGS Flags*/flags,
+			/* D3D12_DESCRIPTOR_HEAP_FLAGS Flags*/mFlags,
 			/* UINT NodeMask					*/0
 		};
-		ThrowIfFailed(mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mHeap.GetAddressOf())));
+		ThrowIfFailed(mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(heap.GetAddressOf())));
 		LOG_INFO("DX12 Render Tagert View Descriptor Heap Size: {}", num);
+
+		if (mFlags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+		{
+			heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+			ThrowIfFailed(mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mirrorHeap.GetAddressOf())));
+		}
+	}
+
+	std::uint32_t AllocatePersistentLocked()
+	{
+		std::uint32_t index = mAllocator.AllocatePersistent();
+		if (index == DescriptorIndexAllocator::Invalid)
+		{
+			GrowLocked(std::max(mAllocator.GetPersistentCapacity() * 2, DEFAULT_SIZE), mAllocator.GetTransientCapacity());
+			index = mAllocator.AllocatePersistent();
+		}
+		return index;
+	}
+
+	// 영구 슬롯의 CPU 핸들은 (있다면) 미러를, 임시 슬롯은 셰이더 가시 힙을 가리킵니다.
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandleLocked(std::uint32_t index) const
+	{
+		ID3D12DescriptorHeap* heap = mMirrorHeap && index < mAllocator.GetPersistentCapacity() ? mMirrorHeap.Get() : mHeap.Get();
+		return static_cast<D3D12_CPU_DESCRIPTOR_HANDLE>(heap->GetCPUDescriptorHandleForHeapStart().ptr + SIZE_T(index) * mDescriptorSize);
+	}
+
+	void CommitLocked(std::uint32_t index)
+	{
+		if (!mMirrorHeap)
+			return;
+		D3D12_CPU_DESCRIPTOR_HANDLE dst{ mHeap->GetCPUDescriptorHandleForHeapStart().ptr + SIZE_T(index) * mDescriptorSize };
+		mDevice->CopyDescriptorsSimple(1, dst, GetCPUHandleLocked(index), mType);
+	}
+
+	// 새 힙을 만들고 지금까지 쓴 영구 슬롯 [0, HighWater)를 복사합니다. 옛 힙은 이번 프레임의 펜스가 완료될 때까지 보관합니다.
+	void GrowLocked(std::uint32_t persistentCapacity, std::uint32_t transientCapacity)
+	{
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mirrorHeap;
+		CreateHeaps(persistentCapacity + transientCapacity, heap, mirrorHeap);
+
+		const std::uint32_t count = mAllocator.GetPersistentHighWater();
+		if (count > 0)
+		{
+			// 복사 원본은 항상 CPU 전용 힙(미러 또는 셰이더에 보이지 않는 힙)입니다.
+			ID3D12DescriptorHeap* source = mMirrorHeap ? mMirrorHeap.Get() : mHeap.Get();
+			ID3D12DescriptorHeap* destination = mirrorHeap ? mirrorHeap.Get() : heap.Get();
+			mDevice->CopyDescriptorsSimple(count, destination->GetCPUDescriptorHandleForHeapStart(), source->GetCPUDescriptorHandleForHeapStart(), mType);
+			if (mirrorHeap)
+				mDevice->CopyDescriptorsSimple(count, heap->GetCPUDescriptorHandleForHeapStart(), mirrorHeap->GetCPUDescriptorHandleForHeapStart(), mType);
+		}
+
+		LOG_INFO("DX12 Heap Type {} grown: {} -> {} descriptors", static_cast<int>(mType), mAllocator.GetCapacity(), persistentCapacity + transientCapacity);
+		mFrameRetiredHeaps.push_back({ mHeap, mMirrorHeap });
+		mHeap = heap;
+		mMirrorHeap = mirrorHeap;
+		mAllocator.Grow(persistentCapacity, transientCapacity);
 	}
 
 	void BuildTexture2DSrv(Texture* texture)
@@ -106,6 +256,6 @@ protected:
 			/* 	D3D12_RAYTRACING_ACCELERATION_STRUCTURE_SRV RaytracingAccelerationStructure	*/
 			/* }																			*/
 		};
-		mDevice->CreateShaderResourceView(texture->Resource.Get(), &srvDesc, GetCPUHandle(texture->Handle));
+		mDevice->CreateShaderResourceView(texture->Resource.Get(), &srvDesc, GetCPUHandleLocked(static_cast<std::uint32_t>(texture->Handle)));
 	}
 };
@@ -0,0 +1,115 @@
+#pragma once
+#include "InstanceComponent.h"
+#include "ECSJobSystem.h"
+#include "DX12_ViewFrustumSet.h"
+
+// 한 Render Item의 인스턴스 구간. Destination 위치부터 보이는 인스턴스가 순서대로 기록됩니다.
+struct InstanceCullRange
+{
+	const InstanceComponent* Instances = nullptr;
+	uint32_t Count = 0;
+	uint32_t Destination = 0;	// 대상 버퍼의 원소 인덱스 (StartInstanceLocation)
+	bool CullingEnabled = false;
+	uint32_t* VisibilityMasks = nullptr;	// 선택. Count개의 인스턴스별 뷰 마스크를 기록할 곳
+
+	uint32_t VisibleCount = 0;	// Run() 결과
+};
+
+// 인스턴스 컬링 + 압축 커널.
+// 1) 구간을 ChunkSize 단위 청크로 나누어 워커 스레드에서 인스턴스마다 모든 뷰를 한 번에 검사하고,
+//    compactMask의 뷰 중 하나라도 볼 수 있는 인스턴스 인덱스를 청크별 목록에 모읍니다.
+//    구간에 VisibilityMasks가 있으면 인스턴스별 뷰 마스크도 그대로 기록해, 다른 뷰의 패스가 읽을 수 있게 합니다.
+// 2) 구간별로 청크 목록 길이의 prefix sum을 구해 각 청크의 기록 위치를 정합니다.
+// 3) 청크마다 대상 버퍼의 연속 구간에 InstanceData를 순서대로 memcpy 합니다.
+// 결과 순서는 단일 스레드 루프와 같습니다. 대상은 UploadBuffer의 매핑 메모리나 CPU 버퍼 어느 쪽이든 될 수 있어
+// GPU 없이도 테스트·벤치마크할 수 있습니다. 청크 목록은 재사용되므로 매 프레임 할당하지 않습니다.
+// InstanceData 자체를 청크 목록에 모으면 한 번 더 복사하게 되어, 인덱스만 모으는 쪽이 더 빠릅니다.
+class InstanceCullCompactKernel
+{
+public:
+	static constexpr uint32_t ChunkSize = 256;
+
+	// 컬링하지 않는 인스턴스는 모든 뷰에서 보이는 것으로 처리합니다.
+	// elementByteSize는 대상 버퍼의 원소 간격입니다 (UploadBuffer::ElementByteSize).
+	void Run(InstanceCullRange* ranges, size_t rangeCount, const ViewFrustumSet& views, uint32_t compactMask,
+		BYTE* destination, UINT elementByteSize, ECS::JobSystem& jobSystem = ECS::JobSystem::GetInstance())
+	{
+		mChunkCount = 0;
+		for (size_t r = 0; r < rangeCount; ++r)
+		{
+			for (uint32_t first = 0; first < ranges[r].Count; first += ChunkSize)
+			{
+				if (mChunkCount == mChunks.size())
+					mChunks.emplace_back();
+				Chunk& chunk = mChunks[mChunkCount++];
+				chunk.Range = static_cast<uint32_t>(r);
+				chunk.First = first;
+				chunk.Last = std::min(first + ChunkSize, ranges[r].Count);
+			}
+		}
+
+		jobSystem.ParallelFor(0, mChunkCount, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; ++c)
+					Cull(mChunks[c], ranges[mChunks[c].Range], views, compactMask);
+			});
+
+		// 청크는 구간 순서대로 만들어지므로 구간별 VisibleCount 누적값이 곧 청크 오프셋의 prefix sum입니다.
+		for (size_t r = 0; r < rangeCount; ++r)
+			ranges[r].VisibleCount = 0;
+		for (size_t c = 0; c < mChunkCount; ++c)
+		{
+			Chunk& chunk = mChunks[c];
+			InstanceCullRange& range = ranges[chunk.Range];
+			chunk.Offset = range.Destination + range.VisibleCount;
+			range.VisibleCount += static_cast<uint32_t>(chunk.Visible.size());
+		}
+
+		jobSystem.ParallelFor(0, mChunkCount, 4, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; ++c)
+					Write(mChunks[c], ranges[mChunks[c].Range], destination, elementByteSize);
+			});
+	}
+
+private:
+	struct Chunk
+	{
+		uint32_t Range = 0;
+		uint32_t First = 0;
+		uint32_t Last = 0;
+		uint32_t Offset = 0;
+		std::vector<uint32_t> Visible;
+	};
+
+	static void Cull(Chunk& chunk, const InstanceCullRange& range, const ViewFrustumSet& views, uint32_t compactMask)
+	{
+		chunk.Visible.clear();
+		const uint32_t allViews = views.GetAllViewsMask();
+		for (uint32_t i = chunk.First; i < chunk.Last; ++i)
+		{
+			const InstanceComponent& instance = range.Instances[i];
+			const uint32_t mask = range.CullingEnabled && (instance.Option & eCFGInstanceComponent::UseCulling)
+				? views.Test(instance.BoundingSphere)
+				: allViews;
+
+			if (range.VisibilityMasks)
+				range.VisibilityMasks[i] = mask;
+			if (mask & compactMask)
+				chunk.Visible.push_back(i);
+		}
+	}
+
+	static void Write(const Chunk& chunk, const InstanceCullRange& range, BYTE* destination, UINT elementByteSize)
+	{
+		BYTE* dst = destination + static_cast<size_t>(chunk.Offset) * elementByteSize;
+		for (uint32_t index : chunk.Visible)
+		{
+			memcpy(dst, &range.Instances[index].InstanceData, sizeof(InstanceData));
+			dst += elementByteSize;
+		}
+	}
+
+	std::vector<Chunk> mChunks;
+	size_t mChunkCount = 0;
+};
@@ -13,12 +13,10 @@ public:
 	enum class eMeshType { STANDARD, SKINNED, SPRITE };
 
 	ECS::RepoHandle LoadMesh(const std::string& name, std::vector<MeshData>& meshes, eMeshType meshType = eMeshType::STANDARD, bool useIndex32 = false) {
+		// 공용 커맨드 리스트에 업로드를 기록하므로 메시 생성은 직렬화합니다. Get()은 락을 잡지 않으므로 막히지 않습니다.
 		std::lock_guard<std::mutex> lock(mtx);
-		auto it = mNameToHandle.find(name);
-		if (it != mNameToHandle.end()) {
-			mResourceStorage[it->second].refCount++;
-			return it->second;
-		}
+		if (ECS::RepoHandle existing = AcquireByNameLocked(name))
+			return existing;
 
 		auto geo = std::make_unique<DX12_MeshGeometry>();
 		{
@@ -136,25 +134,26 @@ public:
 			}
 		}
 
-		ECS::RepoHandle handle = mNextHandle++;
-		mResourceStorage[handle] = { std::move(geo), 1 };
+		ECS::RepoHandle handle = ReserveHandleLocked();
+		if (handle == 0)
+			return 0;
 		mNameToHandle[name] = handle;
+		Publish(handle, std::move(geo));
 		return handle;
 	}
 protected:
 	virtual bool UnloadResource(ECS::RepoHandle handle) override
 	{
-		std::lock_guard<std::mutex> lock(mtx);
-		auto it = mResourceStorage.find(handle);
-		if (it != mResourceStorage.end() && it->second.refCount == 1)
+		// IRepository::Release가 mtx를 잡고 마지막 참조를 해제할 때 호출합니다.
+		if (DX12_MeshGeometry* geo = Get(handle))
 		{
-			LOG_INFO("Mesh with handle {} released, refCount: {}", handle, it->second.refCount);
-			it->second.resource->VertexBufferCPU.Reset();
-			it->second.resource->IndexBufferCPU.Reset();
-			it->second.resource->VertexBufferGPU.Reset();
-			it->second.resource->IndexBufferGPU.Reset();
-			it->second.resource->VertexBufferUploader.Reset();
-			it->second.resource->IndexBufferUploader.Reset();
+			LOG_INFO("Mesh with handle {} released", handle);
+			geo->VertexBufferCPU.Reset();
+			geo->IndexBufferCPU.Reset();
+			geo->VertexBufferGPU.Reset();
+			geo->IndexBufferGPU.Reset();
+			geo->VertexBufferUploader.Reset();
+			geo->IndexBufferUploader.Reset();
 		}
 
 		return true;
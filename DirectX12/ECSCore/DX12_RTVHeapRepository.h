@@ -46,14 +46,12 @@ public:
 			LOG_ERROR("Failed to load resource without name");
 			return 0; // Return an invalid handle if loading fails
 		}
-		ECS::RepoHandle handle;
-		{
-			std::lock_guard<std::mutex> lock(mtx);
-			handle = mNextHandle++;
-			resource->handle = handle - 1; // Handle is 0-based index in the heap
-			mResourceStorage[handle] = { std::move(resource), 1 };
-		}
-
+		std::lock_guard<std::mutex> lock(mtx);
+		ECS::RepoHandle handle = ReserveHandleLocked();
+		if (handle == 0)
+			return 0;
+		resource->handle = handle - 1; // Handle is 0-based index in the heap
+		Publish(handle, std::move(resource));
 		return handle;
 	}
 
@@ -61,18 +59,17 @@ public:
 		ECS::RepoHandle handle;
 		{
 			std::lock_guard<std::mutex> lock(mtx);
-			auto it = mNameToHandle.find(texture->Name);
-			if (it != mNameToHandle.end()) {
-				mResourceStorage[it->second].refCount++;
-				return it->second;
-			}
+			if (ECS::RepoHandle existing = AcquireByNameLocked(texture->Name))
+				return existing;
 			auto resource = std::make_unique<DX12_HeapComponent>();
 
-			handle = mNextHandle++;
+			handle = ReserveHandleLocked();
+			if (handle == 0)
+				return 0;
 			texture->Handle = handle;
 			resource->handle = handle - 1; // Handle is 0-based index in the heap
-			mResourceStorage[handle] = { std::move(resource), 1 };
 			mNameToHandle[texture->Name] = handle;
+			Publish(handle, std::move(resource));
 		}
 
 		BuildTexture2DSrv(texture);
@@ -149,15 +146,4 @@ protected:
 
 		return true;
 	}
-	virtual bool UnloadResource(ECS::RepoHandle handle)
-	{
-		if (IRepository<DX12_HeapComponent>::UnloadResource(handle))
-		{
-			// TODO: GPU 리소스 해제 (예: DestroyBuffer(mesh->vertexBuffer))
-
-			return true;
-		}
-
-		return false;
-	}
 };
@@ -35,6 +35,11 @@ public:
 		DX12_SceneSystem::GetInstance().UpdateInstance(ImGuiSystem::GetInstance().GetSelectInstance(), InputSystem::GetInstance());
 		DX12_SceneSystem::GetInstance().Update(DX12_FrameResourceSystem::GetInstance().GetCurrentFrameResource().InstanceDataBuffer.get(), DX12_FrameResourceSystem::GetInstance().GetCurrentFrameResource().InstanceIDCB.get());
 		DX12_FrameResourceSystem::GetInstance().BeginFrame();
+
+		const std::uint64_t completedFenceValue = DX12_CommandSystem::GetInstance().GetCompletedFenceValue();
+		mSRVHeapRepository->BeginFrame(completedFenceValue);
+		mRTVHeapRepository->BeginFrame(completedFenceValue);
+		mDSVHeapRepository->BeginFrame(completedFenceValue);
 	}
 
 	virtual void Update() override {
@@ -47,6 +52,12 @@ public:
 		DX12_CommandSystem::GetInstance().ExecuteCommandList();
 		DX12_SwapChainSystem::GetInstance().Present(false);
 		DX12_FrameResourceSystem::GetInstance().EndFrame();
+
+		// EndFrame에서 Signal한 펜스 값이 완료되면 이번 프레임의 임시 디스크립터와 해제 슬롯을 회수합니다.
+		const std::uint64_t fenceValue = DX12_CommandSystem::GetInstance().GetFenceValue();
+		mSRVHeapRepository->EndFrame(fenceValue);
+		mRTVHeapRepository->EndFrame(fenceValue);
+		mDSVHeapRepository->EndFrame(fenceValue);
 	}
 private:
 	ID3D12Device* mDevice;
@@ -103,7 +114,7 @@ private:
 		D3D12_RESOURCE_BARRIER RenderBarrier = CD3DX12_RESOURCE_BARRIER::Transition(DX12_SwapChainSystem::GetInstance().GetBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
 		mCommandList->ResourceBarrier(1, &RenderBarrier);
 
-		const auto& time = ECS::Coordinator::GetInstance().GetSingletonComponent<TimeComponent>();
+		const auto& time = ECS::Coordinator::GetInstance().GetSingletonComponent<const TimeComponent>();
 		float r = std::fmod(time.totalTime * 0.1f, 1.0f); // Example: Use time to create a dynamic color
 		float g = std::fmod(time.totalTime * 0.2f, 1.0f); // Example: Use time to create a dynamic color
 		float b = std::fmod(time.totalTime * 0.05f, 1.0f); // Example: Use time to create a dynamic color
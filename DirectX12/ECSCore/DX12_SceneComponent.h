@@ -14,6 +14,7 @@ ENUM_OPERATORS_32(eCFGRenderItem)
 struct RenderItem
 {
 	std::vector<InstanceComponent> Instances;
+	std::vector<uint32_t> VisibilityMasks;	// 인스턴스별 뷰 마스크. 비트 번호는 DX12_SceneSystem의 뷰 번호
 	ECS::RepoHandle GeometryHandle;
 	ECS::RepoHandle MeshHandle;
 	uint32_t NumFramesDirty = APP_NUM_BACK_BUFFERS;
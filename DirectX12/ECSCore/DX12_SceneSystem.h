@@ -7,6 +7,7 @@
 #include "DX12_SceneComponent.h"
 #include "DX12_FrameResourceSystem.h"
 #include "CameraSystem.h"
+#include "DX12_InstanceCullCompact.h"
 
 class DX12_SceneSystem {
 	DEFAULT_SINGLETON(DX12_SceneSystem)
@@ -94,6 +95,35 @@ public:
 		return &mAllRenderItems[key.RenderItemIndex].Instances[key.InstanceIndex];
 	}
 
+	// 카메라 0 외에 컬링할 뷰(그림자 캐스케이드, 반사/큐브맵 뷰 등)를 추가합니다. ClearViews()를 부를 때까지 유지됩니다.
+	// 인스턴스 버퍼에는 카메라 0에서 보이는 인스턴스만 기록되고, 추가한 뷰의 결과는 GetVisibilityMask로 읽습니다.
+	// 카메라 0이 뷰 0을 쓰고 추가한 뷰는 1부터 순서대로 번호를 받습니다. 이미 ViewFrustumSet::MaxViews개라면 InvalidView를 돌려줍니다.
+	uint32_t AddView(const DirectX::BoundingFrustum& frustum)
+	{
+		if (mExtraViews.size() + 1 >= ViewFrustumSet::MaxViews)
+			return ViewFrustumSet::InvalidView;
+
+		mExtraViews.push_back(frustum);
+		return static_cast<uint32_t>(mExtraViews.size());
+	}
+
+	void ClearViews()
+	{
+		mExtraViews.clear();
+	}
+
+	// 마지막 Update에서 계산한 인스턴스의 뷰 마스크. 뷰 i에서 보이면 비트 i가 켜져 있습니다.
+	uint32_t GetVisibilityMask(const InstanceKey& key) const
+	{
+		if (key.RenderItemIndex >= mAllRenderItems.size())
+			return 0;
+		const auto& masks = mAllRenderItems[key.RenderItemIndex].VisibilityMasks;
+		if (key.InstanceIndex >= masks.size())
+			return 0;
+
+		return masks[key.InstanceIndex];
+	}
+
 	void UpdateInstance(const InstanceKey& key, InputSystem& input)
 	{
 		if (key.RenderItemIndex >= mAllRenderItems.size())
@@ -129,26 +159,45 @@ public:
 private:
     void SyncData(UploadBuffer<InstanceData>* instanceDataBuffer)
     {
-		uint32_t visibleInstanceCount = 0;
+		// 카메라 0과 추가 뷰를 한 번에 검사합니다. 인스턴스 버퍼에는 카메라 0에서 보이는 인스턴스만 기록합니다.
+		mViews.Clear();
+		mViews.Add(CameraSystem::GetInstance().GetCamera(0)->Frustum);
+		for (const auto& frustum : mExtraViews)
+			mViews.Add(frustum);
+
+		// 컬링하지 않는 Render Item의 마스크는 모든 뷰이므로, 뷰 구성이 바뀌었을 때만 다시 기록합니다.
+		const bool viewsChanged = mViews.GetAllViewsMask() != mSyncedViewsMask;
+		mSyncedViewsMask = mViews.GetAllViewsMask();
+
+		mCullRanges.clear();
+		mCullMeshes.clear();
 		for (auto& ri : mAllRenderItems)
 		{
-			if (!(ri.Option & eCFGRenderItem::FrustumCullingEnabled) && ri.NumFramesDirty == 0)	// 현재 for문 내부에서 Frame Dirty를 바탕으로 Render Item 별로 업데이트를 관리하는데, 어떤 방식이 CPU 성능에 적합할지는 고민해보고 개선할 여지가 있다.
+			const bool cullingEnabled = ri.Option & eCFGRenderItem::FrustumCullingEnabled;
+			if (!cullingEnabled && ri.NumFramesDirty == 0 && !viewsChanged)	// 현재 for문 내부에서 Frame Dirty를 바탕으로 Render Item 별로 업데이트를 관리하는데, 어떤 방식이 CPU 성능에 적합할지는 고민해보고 개선할 여지가 있다.
 				continue;
-			--ri.NumFramesDirty;
-			
+			if (ri.NumFramesDirty > 0)
+				--ri.NumFramesDirty;
+
 			auto* meshComponent = DX12_MeshSystem::GetInstance().GetMeshComponent(ri.GeometryHandle, ri.MeshHandle);
-			visibleInstanceCount = meshComponent->StartInstanceLocation;
-			for (const auto& instance : ri.Instances)
-			{
-				if (!(ri.Option & eCFGRenderItem::FrustumCullingEnabled)
-					|| !(instance.Option & eCFGInstanceComponent::UseCulling)
-					|| (CameraSystem::GetInstance().GetCamera(0)->Frustum.Contains(instance.BoundingSphere) != DirectX::DISJOINT))
-				{
-					instanceDataBuffer->CopyData(visibleInstanceCount++, instance.InstanceData);
-				}
-			}
-			meshComponent->InstanceCount = visibleInstanceCount - meshComponent->StartInstanceLocation;
+			ri.VisibilityMasks.resize(ri.Instances.size());
+
+			InstanceCullRange range;
+			range.Instances = ri.Instances.data();
+			range.Count = static_cast<uint32_t>(ri.Instances.size());
+			range.Destination = meshComponent->StartInstanceLocation;
+			range.CullingEnabled = cullingEnabled;
+			range.VisibilityMasks = ri.VisibilityMasks.data();
+			mCullRanges.push_back(range);
+			mCullMeshes.push_back(meshComponent);
 		}
+
+		// 컬링은 워커 스레드에서 청크 단위로, 기록은 청크별 memcpy로 수행합니다.
+		mCullKernel.Run(mCullRanges.data(), mCullRanges.size(), mViews, 1u,
+			instanceDataBuffer->MappedData(), instanceDataBuffer->ElementByteSize());
+
+		for (size_t i = 0; i < mCullRanges.size(); ++i)
+			mCullMeshes[i]->InstanceCount = mCullRanges[i].VisibleCount;
     }
 
 	void SyncInstanceIDData(UploadBuffer<InstanceIDData>* instanceIDBuffer)
@@ -178,4 +227,12 @@ private:
 private:
 	uint32_t mNumFramesDirty = APP_NUM_BACK_BUFFERS;
 	std::vector<RenderItem> mAllRenderItems;
+
+	ViewFrustumSet mViews;
+	std::vector<DirectX::BoundingFrustum> mExtraViews;
+	uint32_t mSyncedViewsMask = 0;
+
+	InstanceCullCompactKernel mCullKernel;
+	std::vector<InstanceCullRange> mCullRanges;
+	std::vector<DX12_MeshComponent*> mCullMeshes;
 };
\ No newline at end of file
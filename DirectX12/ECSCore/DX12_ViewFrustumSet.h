@@ -0,0 +1,104 @@
+#pragma once
+#include "DX12_Config.h"
+
+// 여러 뷰(카메라, 그림자 캐스케이드, 반사/큐브맵 뷰)의 월드 공간 절두체 묶음.
+// 평면을 뷰 4개 단위로 SoA 배치해 두고, 바운딩 스피어 하나를 모든 뷰에 대해 한 번에 검사해
+// 뷰 i가 볼 수 있으면 비트 i가 켜진 가시성 마스크를 돌려줍니다.
+// 평면은 BoundingFrustum::Contains와 같은 방식(GetPlanes)으로 만들므로, 거리 합산 순서 차이로 경계에 딱 걸친 경우를 빼면
+// Contains(sphere) != DISJOINT와 결과가 같습니다.
+class ViewFrustumSet
+{
+public:
+	static constexpr uint32_t MaxViews = 32;
+	static constexpr uint32_t InvalidView = UINT32_MAX;
+
+	void Clear()
+	{
+		mViewCount = 0;
+	}
+
+	// 뷰를 추가하고 마스크의 비트 번호를 돌려줍니다. 이미 MaxViews개라면 InvalidView를 돌려줍니다.
+	uint32_t Add(const DirectX::BoundingFrustum& frustum)
+	{
+		if (mViewCount == MaxViews)
+			return InvalidView;
+
+		const uint32_t view = mViewCount++;
+		ViewGroup& group = mGroups[view / 4];
+		const uint32_t lane = view % 4;
+		if (lane == 0)
+			group = ViewGroup();
+
+		DirectX::XMVECTOR planes[6];
+		frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+		for (int p = 0; p < 6; ++p)
+		{
+			DirectX::XMFLOAT4 plane;
+			DirectX::XMStoreFloat4(&plane, planes[p]);
+			(&group.Planes[p][0].x)[lane] = plane.x;
+			(&group.Planes[p][1].x)[lane] = plane.y;
+			(&group.Planes[p][2].x)[lane] = plane.z;
+			(&group.Planes[p][3].x)[lane] = plane.w;
+		}
+		return view;
+	}
+
+	uint32_t GetViewCount() const { return mViewCount; }
+	uint32_t GetAllViewsMask() const { return mViewCount == 32 ? UINT32_MAX : (1u << mViewCount) - 1; }
+
+	uint32_t Test(const DirectX::BoundingSphere& sphere) const
+	{
+		using namespace DirectX;
+		const XMVECTOR centerX = XMVectorReplicate(sphere.Center.x);
+		const XMVECTOR centerY = XMVectorReplicate(sphere.Center.y);
+		const XMVECTOR centerZ = XMVectorReplicate(sphere.Center.z);
+		const XMVECTOR radius = XMVectorReplicate(sphere.Radius);
+
+		uint32_t mask = 0;
+		const uint32_t groupCount = (mViewCount + 3) / 4;
+		for (uint32_t g = 0; g < groupCount; ++g)
+		{
+			const ViewGroup& group = mGroups[g];
+			XMVECTOR outside = XMVectorFalseInt();
+			for (int p = 0; p < 6; ++p)
+			{
+				XMVECTOR distance = XMVectorMultiplyAdd(XMLoadFloat4A(&group.Planes[p][0]), centerX, XMLoadFloat4A(&group.Planes[p][3]));
+				distance = XMVectorMultiplyAdd(XMLoadFloat4A(&group.Planes[p][1]), centerY, distance);
+				distance = XMVectorMultiplyAdd(XMLoadFloat4A(&group.Planes[p][2]), centerZ, distance);
+				outside = XMVectorOrInt(outside, XMVectorGreater(distance, radius));
+			}
+			mask |= (~LaneMask(outside) & 0xFu) << (g * 4);
+		}
+		return mask & GetAllViewsMask();
+	}
+
+private:
+	// 뷰 4개의 평면. Planes[p][c]는 평면 p의 성분 c(nx, ny, nz, d)를 뷰 4개에 대해 담습니다.
+	// 빈 자리는 항상 바깥으로 판정되는 평면(0, 0, 0, FLT_MAX)으로 채웁니다.
+	struct ViewGroup
+	{
+		DirectX::XMFLOAT4A Planes[6][4];
+
+		ViewGroup()
+		{
+			for (auto& plane : Planes)
+			{
+				plane[0] = plane[1] = plane[2] = DirectX::XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f);
+				plane[3] = DirectX::XMFLOAT4A(FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX);
+			}
+		}
+	};
+
+	static uint32_t LaneMask(DirectX::FXMVECTOR v)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		return static_cast<uint32_t>(_mm_movemask_ps(v));
+#else
+		return (DirectX::XMVectorGetIntX(v) ? 1u : 0u) | (DirectX::XMVectorGetIntY(v) ? 2u : 0u)
+			| (DirectX::XMVectorGetIntZ(v) ? 4u : 0u) | (DirectX::XMVectorGetIntW(v) ? 8u : 0u);
+#endif
+	}
+
+	ViewGroup mGroups[MaxViews / 4];
+	uint32_t mViewCount = 0;
+};
@@ -0,0 +1,170 @@
+#pragma once
+// D3D12에 의존하지 않는 디스크립터 인덱스 할당기. DX12_HeapRepository가 힙 위에서 사용하며, GPU 없이도 테스트할 수 있습니다.
+// 스레드 안전하지 않으므로 호출하는 쪽에서 잠금을 책임집니다.
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// 인덱스 공간은 [0, PersistentCapacity)의 영구 영역과 그 뒤 TransientCapacity 크기의 프레임 링으로 나뉩니다.
+//  - 영구 슬롯: 프리 리스트로 재사용합니다. 해제한 슬롯은 GPU가 아직 참조할 수 있으므로,
+//    해제한 프레임의 펜스 값이 완료된 뒤(ReleaseCompleted)에야 다시 할당됩니다.
+//  - 임시 슬롯: 프레임마다 링에서 연속 구간을 잘라 씁니다. EndFrame에서 그 프레임의 구간에 펜스 값을 붙이고,
+//    펜스가 완료되면 구간 전체를 한꺼번에 돌려받습니다.
+// 공간이 모자라면 Invalid를 돌려주고, 호출하는 쪽이 힙을 키운 뒤 Grow를 호출합니다.
+class DescriptorIndexAllocator
+{
+public:
+	static constexpr std::uint32_t Invalid = UINT32_MAX;
+
+	DescriptorIndexAllocator(std::uint32_t persistentCapacity, std::uint32_t transientCapacity)
+		: mPersistentCapacity(persistentCapacity)
+		, mTransientCapacity(transientCapacity)
+	{
+	}
+
+	std::uint32_t AllocatePersistent()
+	{
+		if (!mFreeList.empty())
+		{
+			std::uint32_t index = mFreeList.back();
+			mFreeList.pop_back();
+			++mPersistentCount;
+			return index;
+		}
+		if (mPersistentHighWater == mPersistentCapacity)
+			return Invalid;
+
+		++mPersistentCount;
+		return mPersistentHighWater++;
+	}
+
+	// 현재 프레임이 끝나고(EndFrame) 그 펜스가 완료된 뒤에 재사용됩니다.
+	void FreePersistent(std::uint32_t index)
+	{
+		mFramePendingFrees.push_back(index);
+		--mPersistentCount;
+	}
+
+	// count개의 연속된 임시 슬롯 중 첫 인덱스. 반환값은 PersistentCapacity 이상입니다.
+	std::uint32_t AllocateTransient(std::uint32_t count)
+	{
+		if (count == 0 || count > mTransientCapacity || mRingUsed == mTransientCapacity)
+			return Invalid;
+
+		// 비어 있는 링은 처음부터 다시 씁니다. 그 밖에 head == tail이면 역시 비어 있다는 뜻입니다(가득 찬 경우는 위에서 걸러짐).
+		if (mRingUsed == 0)
+			mRingHead = mRingTail = 0;
+
+		std::uint32_t offset = Invalid;
+		std::uint32_t consumed = 0;
+		if (mRingHead >= mRingTail)
+		{
+			if (mTransientCapacity - mRingHead >= count)
+			{
+				offset = mRingHead;
+				consumed = count;
+			}
+			else if (mRingTail >= count)
+			{
+				// 끝부분은 버리고 처음으로 감습니다. 버린 공간도 이 프레임이 쓴 것으로 셉니다.
+				offset = 0;
+				consumed = mTransientCapacity - mRingHead + count;
+			}
+		}
+		else if (mRingTail - mRingHead >= count)
+		{
+			offset = mRingHead;
+			consumed = count;
+		}
+
+		if (offset == Invalid)
+			return Invalid;
+
+		mRingHead = (offset + count) % mTransientCapacity;
+		mRingUsed += consumed;
+		mFrameRingUsed += consumed;
+		return mPersistentCapacity + offset;
+	}
+
+	// 현재 프레임의 임시 구간과 해제 대기 슬롯에 이 프레임이 제출한 펜스 값을 붙입니다.
+	void EndFrame(std::uint64_t fenceValue)
+	{
+		if (mFrameRingUsed > 0)
+			mRingFrames.push_back({ fenceValue, mFrameRingUsed });
+		mFrameRingUsed = 0;
+
+		if (!mFramePendingFrees.empty())
+		{
+			mPendingFrees.push_back({ fenceValue, std::move(mFramePendingFrees) });
+			mFramePendingFrees.clear();
+		}
+	}
+
+	// GPU가 completedFenceValue까지 끝냈을 때 그 이전 프레임의 임시 구간과 해제 슬롯을 돌려받습니다.
+	void ReleaseCompleted(std::uint64_t completedFenceValue)
+	{
+		while (!mRingFrames.empty() && mRingFrames.front().FenceValue <= completedFenceValue)
+		{
+			mRingTail = (mRingTail + mRingFrames.front().Count) % mTransientCapacity;
+			mRingUsed -= mRingFrames.front().Count;
+			mRingFrames.pop_front();
+		}
+
+		while (!mPendingFrees.empty() && mPendingFrees.front().FenceValue <= completedFenceValue)
+		{
+			auto& indices = mPendingFrees.front().Indices;
+			mFreeList.insert(mFreeList.end(), indices.begin(), indices.end());
+			mPendingFrees.pop_front();
+		}
+	}
+
+	// 힙을 키운 뒤 호출합니다. 영구 슬롯의 인덱스는 그대로 유지됩니다.
+	// 링은 새 힙에서 비어 있는 상태로 다시 시작합니다. 이미 나간 임시 구간은 옛 힙에 남아 있으므로
+	// 옛 힙은 현재 프레임의 펜스가 완료될 때까지 살아 있어야 합니다.
+	void Grow(std::uint32_t persistentCapacity, std::uint32_t transientCapacity)
+	{
+		mPersistentCapacity = persistentCapacity > mPersistentCapacity ? persistentCapacity : mPersistentCapacity;
+		mTransientCapacity = transientCapacity;
+		mRingHead = 0;
+		mRingTail = 0;
+		mRingUsed = 0;
+		mFrameRingUsed = 0;
+		mRingFrames.clear();
+	}
+
+	std::uint32_t GetPersistentCapacity() const { return mPersistentCapacity; }
+	std::uint32_t GetTransientCapacity() const { return mTransientCapacity; }
+	std::uint32_t GetCapacity() const { return mPersistentCapacity + mTransientCapacity; }
+	// 한 번이라도 할당된 영구 인덱스의 끝. 힙을 키울 때 [0, HighWater)만 옮기면 됩니다.
+	std::uint32_t GetPersistentHighWater() const { return mPersistentHighWater; }
+	std::uint32_t GetPersistentCount() const { return mPersistentCount; }
+	std::uint32_t GetTransientUsed() const { return mRingUsed; }
+
+private:
+	struct RingFrame
+	{
+		std::uint64_t FenceValue;
+		std::uint32_t Count;
+	};
+
+	struct PendingFrees
+	{
+		std::uint64_t FenceValue;
+		std::vector<std::uint32_t> Indices;
+	};
+
+	std::uint32_t mPersistentCapacity;
+	std::uint32_t mTransientCapacity;
+
+	std::uint32_t mPersistentHighWater = 0;
+	std::uint32_t mPersistentCount = 0;
+	std::vector<std::uint32_t> mFreeList;
+	std::vector<std::uint32_t> mFramePendingFrees;
+	std::deque<PendingFrees> mPendingFrees;
+
+	std::uint32_t mRingHead = 0;
+	std::uint32_t mRingTail = 0;
+	std::uint32_t mRingUsed = 0;
+	std::uint32_t mFrameRingUsed = 0;
+	std::deque<RingFrame> mRingFrames;
+};
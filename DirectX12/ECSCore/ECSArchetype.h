@@ -1,99 +1,305 @@
 #pragma once
 #include "ECSConfig.h"
-#include "ECSSharedComponents.h" 
+#include "ECSSharedComponents.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
 
 namespace ECS {
 
-    // IComponentArray는 이제 엔티티가 아닌 인덱스로 데이터를 이동/제거하는 역할을 합니다.
-    class IComponentArray {
+    // 청크 하나의 기본 크기. 한 아키타입의 엔티티들은 이 크기의 블록 단위로 저장됩니다.
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+    static constexpr size_t CHUNK_ALIGNMENT = 64;
+    static constexpr std::uint8_t INVALID_COLUMN = std::numeric_limits<std::uint8_t>::max();
+
+    // 컴포넌트 타입별 크기/정렬과 수명 관리 함수 테이블.
+    // 청크의 컬럼은 타입이 지워진 raw 메모리이므로 이동/파괴/직렬화를 함수 포인터로 수행합니다.
+    struct ComponentInfo {
+        const char* Name = nullptr;
+        size_t Size = 0;
+        size_t Alignment = 0;
+        bool TriviallyCopyable = false;
+        void (*MoveConstruct)(void* dest, void* src) = nullptr;
+        void (*Destroy)(void* ptr) = nullptr;
+        void (*ToJson)(const void* ptr, json& jsonObject) = nullptr;
+
+        template<typename T>
+        static ComponentInfo Create() {
+            ComponentInfo info;
+            info.Name = T::GetName();
+            info.Size = sizeof(T);
+            info.Alignment = alignof(T);
+            info.TriviallyCopyable = std::is_trivially_copyable_v<T>;
+            info.MoveConstruct = [](void* dest, void* src) { new (dest) T(std::move(*static_cast<T*>(src))); };
+            info.Destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+            info.ToJson = [](const void* ptr, json& jsonObject) { jsonObject[T::GetName()] = *static_cast<const T*>(ptr); };
+            return info;
+        }
+    };
+
+    // 컴포넌트 변경 추적용 전역 버전.
+    // 시스템 실행과 구조 변경마다 새 버전을 발급하며, 청크는 컬럼마다 마지막으로 쓰기 접근된 버전을 기록합니다.
+    class ChangeVersion {
     public:
-        virtual ~IComponentArray() = default;
-        virtual void MoveData(ComponentHandle handle, IComponentArray* destArray) = 0;
-        virtual void RemoveData(ComponentHandle handle) = 0;
-        virtual void AddComponentToJson(ComponentHandle handle, json& jsonObject) const = 0;
+        static std::uint64_t Next() { return sVersion.fetch_add(1, std::memory_order_relaxed) + 1; }
+    private:
+        inline static std::atomic<std::uint64_t> sVersion{ 0 };
     };
 
-    template<typename T>
-    class ComponentArray : public IComponentArray {
+    // 고정 크기 메모리 블록. [Entity 배열][컬럼 0][컬럼 1]... 순서의 SoA 레이아웃을 가집니다.
+    // 각 컬럼의 오프셋은 소유 아키타입이 계산하며 모든 청크가 동일한 레이아웃을 공유합니다.
+    class ArchetypeChunk {
     private:
-        std::vector<T> mComponentArray;
+        std::byte* mData = nullptr;
+        size_t mCount = 0;
+        // 컬럼별 마지막 변경 버전. 같은 청크의 서로 다른 행을 여러 잡이 동시에 기록할 수 있으므로 atomic으로 둡니다.
+        std::unique_ptr<std::atomic<std::uint64_t>[]> mColumnVersions;
     public:
-        ComponentArray() {mComponentArray.reserve(64);}
-        size_t Size() const { return mComponentArray.size(); }
-        size_t Capacity() const { return mComponentArray.capacity(); }
-        void AddData(const T& component) { mComponentArray.emplace_back(component); }
-        T& GetData(ComponentHandle handle) {
-            assert(handle < mComponentArray.size());
-            return mComponentArray[handle];
-        }
-        const T& GetData(ComponentHandle handle) const {
-            assert(handle < mComponentArray.size());
-            return mComponentArray[handle];
-        }
-        void MoveData(ComponentHandle handle, IComponentArray* destArray) override {
-            auto* dest = static_cast<ComponentArray<T>*>(destArray);
-            dest->AddData(mComponentArray[handle]);
-        }
-        void RemoveData(ComponentHandle handle) override {
-            assert(handle < mComponentArray.size());
-            mComponentArray[handle] = std::move(mComponentArray.back());
-            mComponentArray.pop_back();
-        }
-        void AddComponentToJson(ComponentHandle handle, json& jsonObject) const override {
-            assert(handle < mComponentArray.size());
-            const T& component = mComponentArray[handle];
-            jsonObject[T::GetName()] = component;
+        ArchetypeChunk(size_t byteSize, size_t columnCount)
+            : mData(static_cast<std::byte*>(::operator new(byteSize, std::align_val_t(CHUNK_ALIGNMENT))))
+            , mColumnVersions(std::make_unique<std::atomic<std::uint64_t>[]>(columnCount))
+        {
         }
+        ~ArchetypeChunk() { ::operator delete(mData, std::align_val_t(CHUNK_ALIGNMENT)); }
+        ArchetypeChunk(const ArchetypeChunk&) = delete;
+        ArchetypeChunk& operator=(const ArchetypeChunk&) = delete;
+
+        std::byte* GetData() const { return mData; }
+        size_t GetCount() const { return mCount; }
+        Entity* GetEntities() const { return reinterpret_cast<Entity*>(mData); }
+
+        friend class Archetype;
     };
+
     class ArchetypeManager;
     class Archetype {
     private:
         ArchetypeManager* const mManager;
         const Signature mSignature;
-        const ComponentHandle mSharedComponentId;
-        std::vector<Entity> mEntities;
-        std::unordered_map<ComponentType, std::unique_ptr<IComponentArray>> mComponentArrays;
-        std::unordered_map<Entity, ComponentHandle> mEntityToComponentMap;
+        const SharedComponentID mSharedComponentId;
+
+        // 컬럼 레이아웃 (타입 -> 컬럼 인덱스 -> 청크 내 오프셋)
+        std::array<std::uint8_t, MAX_COMPONENTS> mColumnOfType;
+        std::vector<ComponentType> mColumnTypes;
+        std::vector<const ComponentInfo*> mColumnInfos;
+        std::vector<size_t> mColumnOffsets;
+        size_t mChunkCapacity = 0;
+        size_t mChunkByteSize = CHUNK_SIZE;
+
+        // 앞쪽 청크는 항상 가득 차 있고 마지막 청크만 비어 있을 수 있습니다.
+        // 따라서 ComponentHandle(평탄화된 행 번호)로부터 청크/행을 나눗셈 한 번으로 구할 수 있습니다.
+        std::vector<std::unique_ptr<ArchetypeChunk>> mChunks;
+        // 마지막 청크가 비었을 때 해제하지 않고 보관하는 예비 청크.
+        // 청크 경계에서 추가/삭제가 반복될 때 16KB 할당과 해제가 매번 일어나지 않도록 합니다.
+        std::unique_ptr<ArchetypeChunk> mSpareChunk;
+        size_t mEntityCount = 0;
+
+        size_t ComputeLayout(size_t capacity) {
+            size_t offset = sizeof(Entity) * capacity;
+            for (size_t column = 0; column < mColumnInfos.size(); ++column) {
+                const ComponentInfo* info = mColumnInfos[column];
+                offset = (offset + info->Alignment - 1) & ~(info->Alignment - 1);
+                mColumnOffsets[column] = offset;
+                offset += info->Size * capacity;
+            }
+            return offset;
+        }
+
+        ArchetypeChunk& CreateChunk() {
+            if (mSpareChunk)
+                mChunks.emplace_back(std::move(mSpareChunk));
+            else
+                mChunks.emplace_back(std::make_unique<ArchetypeChunk>(mChunkByteSize, mColumnTypes.size()));
+            return *mChunks.back();
+        }
+
+        void MarkAllChanged(ArchetypeChunk& chunk, std::uint64_t version) {
+            for (size_t column = 0; column < mColumnTypes.size(); ++column)
+                chunk.mColumnVersions[column].store(version, std::memory_order_relaxed);
+        }
+
+        void* GetColumnData(size_t column, ComponentHandle handle) const {
+            const ArchetypeChunk& chunk = *mChunks[handle / mChunkCapacity];
+            size_t row = handle % mChunkCapacity;
+            return chunk.mData + mColumnOffsets[column] + mColumnInfos[column]->Size * row;
+        }
+
     public:
         Archetype(Signature signature, SharedComponentID sharedId, ArchetypeManager* manager);
+        ~Archetype() {
+            while (mEntityCount > 0)
+                RemoveEntity(mEntityCount - 1);
+        }
+        Archetype(const Archetype&) = delete;
+        Archetype& operator=(const Archetype&) = delete;
 
         const Signature& GetSignature() const { return mSignature; }
         SharedComponentID GetSharedComponentId() const { return mSharedComponentId; }
-        size_t GetEntityCount() const { return mEntities.size(); }
-		Entity GetEntity(ComponentHandle handle) const {
-			assert(handle < mEntities.size() && "Index out of bounds.");
-			return mEntities[handle];
-		}
+        size_t GetEntityCount() const { return mEntityCount; }
+        size_t GetChunkCount() const { return mChunks.size(); }
+        size_t GetChunkCapacity() const { return mChunkCapacity; }
+        ArchetypeChunk& GetChunk(size_t index) {
+            assert(index < mChunks.size() && "Chunk index out of bounds.");
+            return *mChunks[index];
+        }
+        Entity GetEntity(ComponentHandle handle) const {
+            assert(handle < mEntityCount && "Index out of bounds.");
+            return mChunks[handle / mChunkCapacity]->GetEntities()[handle % mChunkCapacity];
+        }
+        bool HasComponent(ComponentType type) const { return mColumnOfType[type] != INVALID_COLUMN; }
+
+        // 청크의 type 컬럼이 마지막으로 쓰기 접근된 버전. 이 아키타입에 없는 타입이면 0입니다.
+        std::uint64_t GetChangeVersion(ComponentType type, const ArchetypeChunk& chunk) const {
+            std::uint8_t column = mColumnOfType[type];
+            return column != INVALID_COLUMN ? chunk.mColumnVersions[column].load(std::memory_order_relaxed) : 0;
+        }
+        void MarkChanged(ComponentType type, ArchetypeChunk& chunk, std::uint64_t version) {
+            assert(HasComponent(type) && "Archetype should have this component array.");
+            chunk.mColumnVersions[mColumnOfType[type]].store(version, std::memory_order_relaxed);
+        }
+        ArchetypeChunk& GetChunkOf(ComponentHandle handle) {
+            assert(handle < mEntityCount && "Index out of bounds.");
+            return *mChunks[handle / mChunkCapacity];
+        }
+
+        // 새 행을 확보하고 엔티티를 기록합니다. 컴포넌트 데이터는 호출자가 직접 생성해야 합니다.
         ComponentHandle AddEntity(Entity entity) {
-            assert(mEntityToComponentMap.find(entity) == mEntityToComponentMap.end());
-            ComponentHandle newIndex = mEntities.size();
-            mEntityToComponentMap[entity] = newIndex;
-            mEntities.emplace_back(entity);
+            if (mEntityCount == mChunks.size() * mChunkCapacity)
+                CreateChunk();
+
+            ComponentHandle newIndex = mEntityCount++;
+            ArchetypeChunk& chunk = *mChunks[newIndex / mChunkCapacity];
+            chunk.GetEntities()[chunk.mCount++] = entity;
+            MarkAllChanged(chunk, ChangeVersion::Next());
             return newIndex;
         }
-        Entity RemoveEntity(Entity entity) {
-            assert(mEntityToComponentMap.find(entity) != mEntityToComponentMap.end());
-            for (auto const& [type, array] : mComponentArrays)
-                array->RemoveData(mEntityToComponentMap[entity]);
-            Entity& movedEntity = mEntities[mEntityToComponentMap[entity]];
-            movedEntity = mEntities.back();
-            mEntities.pop_back();
-            mEntityToComponentMap[movedEntity] = mEntityToComponentMap[entity];
-            mEntityToComponentMap.erase(entity);
 
-            return movedEntity == entity ? INVALID_ENTITY : movedEntity;
+        // count개의 연속된 새 행을 확보하고 첫 행의 핸들을 반환합니다. 컴포넌트 데이터는 호출자가 직접 생성해야 합니다.
+        ComponentHandle AddEntities(const Entity* entities, size_t count) {
+            ComponentHandle first = mEntityCount;
+            std::uint64_t version = ChangeVersion::Next();
+            for (size_t i = 0; i < count;) {
+                if (mEntityCount == mChunks.size() * mChunkCapacity)
+                    CreateChunk();
+
+                ArchetypeChunk& chunk = *mChunks.back();
+                MarkAllChanged(chunk, version);
+                size_t n = std::min(count - i, mChunkCapacity - chunk.mCount);
+                std::copy_n(entities + i, n, chunk.GetEntities() + chunk.mCount);
+                chunk.mCount += n;
+                mEntityCount += n;
+                i += n;
+            }
+            return first;
+        }
+
+        // handle 위치의 모든 컴포넌트를 파괴하고 마지막 행을 빈자리로 옮깁니다.
+        // 위치가 바뀐 엔티티를 반환하며, 이동이 없었다면 INVALID_ENTITY를 반환합니다.
+        Entity RemoveEntity(ComponentHandle handle) {
+            assert(handle < mEntityCount && "Index out of bounds.");
+            ComponentHandle last = mEntityCount - 1;
+
+            for (size_t column = 0; column < mColumnInfos.size(); ++column) {
+                const ComponentInfo* info = mColumnInfos[column];
+                void* removed = GetColumnData(column, handle);
+                info->Destroy(removed);
+                if (handle != last) {
+                    void* moved = GetColumnData(column, last);
+                    if (info->TriviallyCopyable) {
+                        std::memcpy(removed, moved, info->Size);
+                    }
+                    else {
+                        info->MoveConstruct(removed, moved);
+                        info->Destroy(moved);
+                    }
+                }
+            }
+
+            ArchetypeChunk& lastChunk = *mChunks[last / mChunkCapacity];
+            Entity movedEntity = INVALID_ENTITY;
+            if (handle != last) {
+                movedEntity = lastChunk.GetEntities()[last % mChunkCapacity];
+                ArchetypeChunk& chunk = *mChunks[handle / mChunkCapacity];
+                chunk.GetEntities()[handle % mChunkCapacity] = movedEntity;
+                MarkAllChanged(chunk, ChangeVersion::Next());
+            }
+            --lastChunk.mCount;
+            --mEntityCount;
+            if (lastChunk.mCount == 0) {
+                if (!mSpareChunk)
+                    mSpareChunk = std::move(mChunks.back());
+                mChunks.pop_back();
+            }
+
+            return movedEntity;
+        }
+
+        void* GetComponentPtr(ComponentType type, ComponentHandle handle) {
+            assert(HasComponent(type) && "Archetype should have this component array.");
+            assert(handle < mEntityCount && "Index out of bounds.");
+            return GetColumnData(mColumnOfType[type], handle);
         }
         template<typename T>
-        void AddComponentData(T component) { GetComponentArray<T>()->AddData(component); }
-        template<typename T>
-        T& GetComponentData(ComponentHandle handle) { return GetComponentArray<T>()->GetData(handle); }
-        template<typename T>
-        T& GetComponentData(Entity entity) { return GetComponentArray<T>()->GetData(mEntityToComponentMap[entity]); }
+        T& GetComponentData(ComponentHandle handle);
         template<typename T>
-        ComponentArray<T>* GetComponentArray();
-        IComponentArray* GetComponentArray(ComponentType type) {
-            assert(mComponentArrays.count(type));
-            return mComponentArrays[type].get();
+        T* GetColumn(ArchetypeChunk& chunk);
+        std::byte* GetColumnPtr(ComponentType type, ArchetypeChunk& chunk) {
+            assert(HasComponent(type) && "Archetype should have this component array.");
+            return chunk.mData + mColumnOffsets[mColumnOfType[type]];
+        }
+
+        // first 행부터 count개 행의 type 컴포넌트를 src의 연속 메모리에서 청크 단위로 복사해 생성합니다.
+        // trivially copyable 컴포넌트 전용입니다. (월드 스냅샷 로드용)
+        void CopyColumnFrom(ComponentType type, ComponentHandle first, const std::byte* src, size_t count) {
+            assert(HasComponent(type) && "Archetype should have this component array.");
+            size_t column = mColumnOfType[type];
+            const ComponentInfo* info = mColumnInfos[column];
+            assert(info->TriviallyCopyable && "Only trivially copyable components can be copied as raw memory.");
+            while (count > 0) {
+                size_t row = first % mChunkCapacity;
+                size_t n = std::min(count, mChunkCapacity - row);
+                std::memcpy(GetColumnData(column, first), src, info->Size * n);
+                src += info->Size * n;
+                first += n;
+                count -= n;
+            }
+        }
+
+        // source의 handle 행에서 이 아키타입과 공통된 컴포넌트를 destHandle 행으로 이동 생성합니다.
+        void MoveCommonComponentsFrom(Archetype& source, ComponentHandle handle, ComponentHandle destHandle) {
+            for (size_t column = 0; column < mColumnTypes.size(); ++column) {
+                ComponentType type = mColumnTypes[column];
+                if (!source.HasComponent(type))
+                    continue;
+                mColumnInfos[column]->MoveConstruct(GetColumnData(column, destHandle), source.GetComponentPtr(type, handle));
+            }
+        }
+
+        // 여러 행을 한 번에 옮기는 버전. sourceHandles[i] 행이 destFirst + i 행으로 이동합니다.
+        // 컬럼 단위로 순회하며 trivially copyable 컴포넌트는 함수 포인터 호출 없이 memcpy로 복사합니다.
+        void MoveCommonComponentsFrom(Archetype& source, const ComponentHandle* sourceHandles, ComponentHandle destFirst, size_t count) {
+            for (size_t column = 0; column < mColumnTypes.size(); ++column) {
+                ComponentType type = mColumnTypes[column];
+                if (!source.HasComponent(type))
+                    continue;
+                const ComponentInfo* info = mColumnInfos[column];
+                size_t sourceColumn = source.mColumnOfType[type];
+                for (size_t i = 0; i < count; ++i) {
+                    void* dest = GetColumnData(column, destFirst + i);
+                    void* src = source.GetColumnData(sourceColumn, sourceHandles[i]);
+                    if (info->TriviallyCopyable)
+                        std::memcpy(dest, src, info->Size);
+                    else
+                        info->MoveConstruct(dest, src);
+                }
+            }
+        }
+
+        void AddComponentToJson(ComponentType type, ComponentHandle handle, json& jsonObject) {
+            mColumnInfos[mColumnOfType[type]]->ToJson(GetComponentPtr(type, handle), jsonObject);
         }
     };
 
@@ -108,69 +314,80 @@ namespace ECS {
     private:
         std::unique_ptr<SharedComponentManager> mSharedComponentManager;
         std::unordered_map<Signature, std::unordered_map<SharedComponentID, std::unique_ptr<Archetype>>> mArchetypes;
-        std::unordered_map<Entity, EntityLocation> mEntityLocations;
-        std::unordered_map<std::type_index, ComponentType> mComponentTypes;
-        std::unordered_map<ComponentType, std::function<std::unique_ptr<IComponentArray>()>> mComponentFactories;
+        std::vector<Archetype*> mArchetypeList;
+        std::vector<EntityLocation> mEntityLocations;
+        std::array<ComponentInfo, MAX_COMPONENTS> mComponentInfos;
         ComponentType mNextComponentType = 0;
+
+        // 타입별 ID 캐시. GetComponentType<T>()가 type_index 해시 조회 없이 상수 시간에 동작합니다.
+        template<typename T>
+        inline static ComponentType sComponentType = std::numeric_limits<ComponentType>::max();
+
+        // 위치 테이블은 세대 번호를 제외한 엔티티 인덱스로 접근합니다.
+        EntityLocation& GetLocation(Entity entity) {
+            std::uint32_t index = GetEntityIndex(entity);
+            if (index >= mEntityLocations.size())
+                mEntityLocations.resize(static_cast<size_t>(index) + 1);
+            return mEntityLocations[index];
+        }
+
     public:
         ArchetypeManager() {
             mSharedComponentManager = std::make_unique<SharedComponentManager>();
             mSharedComponentManager->RegisterSharedComponent<SharedRenderProperties, SharedRenderPropertiesHasher>();
         }
-        std::unique_ptr<IComponentArray> CreateComponentArray(ComponentType type) {
-            assert(mComponentFactories.count(type) > 0 && "Component factory not registered for this type.");
-            return mComponentFactories.at(type)();
+        const ComponentInfo& GetComponentInfo(ComponentType type) const {
+            assert(type < mNextComponentType && "Component not registered before use.");
+            return mComponentInfos[type];
         }
+        ComponentType GetComponentTypeCount() const { return mNextComponentType; }
         template<typename T>
         void RegisterComponent() {
-            std::type_index type = std::type_index(typeid(T));
-            assert(mComponentTypes.find(type) == mComponentTypes.end());
-            mComponentTypes[type] = mNextComponentType;
-            mComponentFactories[mNextComponentType] = []() { return std::make_unique<ComponentArray<T>>(); };
+            assert(mNextComponentType < MAX_COMPONENTS && "Too many component types.");
+            sComponentType<T> = mNextComponentType;
+            mComponentInfos[mNextComponentType] = ComponentInfo::Create<T>();
             mNextComponentType++;
         }
         template<typename T>
-        ComponentType GetComponentType() {
-            std::type_index type = std::type_index(typeid(T));
-            assert(mComponentTypes.find(type) != mComponentTypes.end());
-            return mComponentTypes[type];
+        ComponentType GetComponentType() const {
+            ComponentType type = sComponentType<T>;
+            assert(type < mNextComponentType && "Component not registered before use.");
+            return type;
         }
         std::vector<Archetype*> GetAllArchetypes() {
-            std::vector<Archetype*> archetypes;
-            for (auto const& [signature, sharedMap] : mArchetypes) {
-                for (auto const& [sharedId, archetypePtr] : sharedMap) {
-                    archetypes.push_back(archetypePtr.get());
-                }
-            }
-            return archetypes;
+            return mArchetypeList;
+        }
+        const std::vector<Archetype*>& GetArchetypes() const {
+            return mArchetypeList;
         }
         template<typename T>
         void AddComponent(Entity entity, const T& component, const Signature& oldSignature) {
-            EntityLocation oldLocation = { nullptr, 0 };
-            if (mEntityLocations.count(entity)) {
-                oldLocation = mEntityLocations[entity];
-            }
+            EntityLocation& location = GetLocation(entity);
+            ComponentType type = GetComponentType<T>();
             Signature newSignature = oldSignature;
-            newSignature.set(GetComponentType<T>());
-            size_t sharedId = oldLocation.Archetype ? oldLocation.Archetype->GetSharedComponentId() : 0;
+            newSignature.set(type);
+            SharedComponentID sharedId = location.Archetype ? location.Archetype->GetSharedComponentId() : 0;
             Archetype* newArchetype = FindOrCreateArchetype(newSignature, sharedId);
-            Archetype* oldArchetype = oldLocation.Archetype;
-            if (oldArchetype && oldArchetype != newArchetype) {
+            Archetype* oldArchetype = location.Archetype;
+            if (oldArchetype == newArchetype) {
+                // 이미 가진 컴포넌트를 다시 추가하면 값을 덮어씁니다.
+                newArchetype->GetComponentData<T>(location.Handle) = component;
+                return;
+            }
+            if (oldArchetype) {
                 MoveEntityBetweenArchetypes(entity, oldArchetype, newArchetype);
             }
             else {
-                ComponentHandle newHandle = newArchetype->AddEntity(entity);
-                mEntityLocations[entity] = { newArchetype, newHandle };
+                location = { newArchetype, newArchetype->AddEntity(entity) };
             }
-            newArchetype->AddComponentData<T>(component);
+            new (newArchetype->GetComponentPtr(type, mEntityLocations[GetEntityIndex(entity)].Handle)) T(component);
         }
         template<typename T>
         void RemoveComponent(Entity entity)
         {
             // 1. 엔티티의 현재 위치(아키타입, 인덱스)를 찾는다.
-            assert(mEntityLocations.count(entity));
-            EntityLocation& oldLocation = mEntityLocations[entity];
-            Archetype* sourceArchetype = oldLocation.Archetype;
+            assert(GetEntityIndex(entity) < mEntityLocations.size() && mEntityLocations[GetEntityIndex(entity)].Archetype);
+            Archetype* sourceArchetype = mEntityLocations[GetEntityIndex(entity)].Archetype;
 
             // 2. 현재 시그니처에서 T 컴포넌트 비트를 끈 새로운 시그니처를 계산한다.
             Signature newSignature = sourceArchetype->GetSignature();
@@ -181,39 +398,88 @@ namespace ECS {
             Archetype* destinationArchetype = FindOrCreateArchetype(newSignature, sharedId);
 
             // 4. 엔티티를 기존 아키타입에서 새 아키타입으로 이동시킨다.
-            // 이 함수는 데이터 복사, 기존 위치에서 제거, 위치 정보 업데이트를 모두 처리합니다.
+            // 이 함수는 데이터 이동, 기존 위치에서 제거, 위치 정보 업데이트를 모두 처리합니다.
             MoveEntityBetweenArchetypes(entity, sourceArchetype, destinationArchetype);
         }
 
         void EntityDestroyed(Entity entity)
         {
-            // 1. 파괴할 엔티티가 어디에 있는지 찾는다.
-            assert(mEntityLocations.count(entity));
-            EntityLocation& location = mEntityLocations[entity];
-            Archetype* archetype = location.Archetype;
-            ComponentHandle indexOfRemoved = location.Handle;
+            // 1. 파괴할 엔티티가 어디에 있는지 찾는다. 컴포넌트가 없는 엔티티는 아키타입에 속하지 않는다.
+            if (GetEntityIndex(entity) >= mEntityLocations.size() || !mEntityLocations[GetEntityIndex(entity)].Archetype)
+                return;
+            EntityLocation location = mEntityLocations[GetEntityIndex(entity)];
 
             // 2. 해당 아키타입에서 엔티티를 제거한다.
             // 이 과정에서 마지막 요소에 있던 다른 엔티티가 빈자리로 이동(swap)된다.
-            Entity movedEntity = archetype->RemoveEntity(entity);
+            Entity movedEntity = location.Archetype->RemoveEntity(location.Handle);
 
-            // 3. mEntityLocations 맵에서 파괴된 엔티티 정보를 완전히 삭제한다.
-            mEntityLocations.erase(entity);
+            // 3. 파괴된 엔티티의 위치 정보를 초기화한다.
+            mEntityLocations[GetEntityIndex(entity)] = {};
 
             // 4. 만약 swap으로 인해 다른 엔티티의 위치가 변경되었다면,
             //    그 엔티티의 위치 정보(인덱스)를 업데이트해준다.
             if (movedEntity != INVALID_ENTITY) {
-                mEntityLocations[movedEntity].Handle = indexOfRemoved;
+                mEntityLocations[GetEntityIndex(movedEntity)].Handle = location.Handle;
+            }
+        }
+
+        // 모든 엔티티를 제거합니다. 아키타입은 남겨 두므로 QueryCache가 가진 포인터는 계속 유효합니다.
+        void RemoveAllEntities() {
+            for (Archetype* archetype : mArchetypeList) {
+                while (archetype->GetEntityCount() > 0)
+                    archetype->RemoveEntity(archetype->GetEntityCount() - 1);
             }
+            mEntityLocations.clear();
+        }
+
+        EntityLocation GetEntityLocation(Entity entity) const {
+            std::uint32_t index = GetEntityIndex(entity);
+            return index < mEntityLocations.size() ? mEntityLocations[index] : EntityLocation{};
+        }
+
+        // 같은 원본/목적지 아키타입을 가진 엔티티 묶음을 한 번에 이동합니다. (EntityCommandBuffer 재생용)
+        // source가 nullptr이면 아키타입에 속하지 않았던 엔티티로 보고 행만 확보합니다.
+        // 목적지에만 있는 컴포넌트는 호출자가 생성해야 하며, entities[i]는 반환된 핸들 + i 행에 놓입니다.
+        ComponentHandle MoveEntities(const Entity* entities, size_t count, Archetype* source, Archetype* destination) {
+            assert(source != destination);
+
+            ComponentHandle first = destination->AddEntities(entities, count);
+            if (source) {
+                std::vector<ComponentHandle> handles(count);
+                for (size_t i = 0; i < count; ++i)
+                    handles[i] = mEntityLocations[GetEntityIndex(entities[i])].Handle;
+                destination->MoveCommonComponentsFrom(*source, handles.data(), first, count);
+
+                // 뒤쪽 행부터 제거하면 swap으로 끌려오는 마지막 행은 항상 이번 묶음에 속하지 않은 엔티티입니다.
+                std::sort(handles.begin(), handles.end(), std::greater<>());
+                for (ComponentHandle handle : handles) {
+                    Entity movedEntity = source->RemoveEntity(handle);
+                    if (movedEntity != INVALID_ENTITY)
+                        mEntityLocations[GetEntityIndex(movedEntity)].Handle = handle;
+                }
+            }
+            for (size_t i = 0; i < count; ++i)
+                GetLocation(entities[i]) = { destination, first + i };
+            return first;
         }
 
         template<typename T>
         T& GetComponent(Entity entity) {
-            assert(mEntityLocations.find(entity) != mEntityLocations.end());
-            EntityLocation& location = mEntityLocations[entity];
+            assert(GetEntityIndex(entity) < mEntityLocations.size() && mEntityLocations[GetEntityIndex(entity)].Archetype);
+            const EntityLocation& location = mEntityLocations[GetEntityIndex(entity)];
+            assert(location.Archetype->GetEntity(location.Handle) == entity && "Stale entity handle.");
             return location.Archetype->GetComponentData<T>(location.Handle);
         }
 
+        // 쓰기용 참조를 건네기 전에 엔티티가 속한 청크의 T 컬럼을 변경된 것으로 기록합니다.
+        template<typename T>
+        T& GetComponentForWrite(Entity entity, std::uint64_t version) {
+            T& component = GetComponent<T>(entity);
+            const EntityLocation& location = mEntityLocations[GetEntityIndex(entity)];
+            location.Archetype->MarkChanged(GetComponentType<T>(), location.Archetype->GetChunkOf(location.Handle), version);
+            return component;
+        }
+
         template<typename T, typename Hasher = std::hash<T>>
         void SetSharedComponent(Entity entity, const T& props) {
             // 1. 범용 관리자로부터 새로운 공유 컴포넌트 ID를 얻습니다.
@@ -224,52 +490,67 @@ namespace ECS {
         }
 
         Archetype* FindOrCreateArchetype(const Signature& signature, size_t sharedId) {
-            if (mArchetypes[signature].find(sharedId) == mArchetypes[signature].end()) {
-                mArchetypes[signature][sharedId] = std::make_unique<Archetype>(signature, sharedId, this);
+            auto& sharedMap = mArchetypes[signature];
+            auto it = sharedMap.find(sharedId);
+            if (it == sharedMap.end()) {
+                it = sharedMap.emplace(sharedId, std::make_unique<Archetype>(signature, sharedId, this)).first;
+                mArchetypeList.push_back(it->second.get());
             }
-            return mArchetypes[signature][sharedId].get();
+            return it->second.get();
         }
 
     private:
         void MoveEntityBetweenArchetypes(Entity entity, Archetype* source, Archetype* destination) {
             assert(source != destination);
 
-            ComponentHandle oldIndex = mEntityLocations[entity].Handle;
+            ComponentHandle oldIndex = mEntityLocations[GetEntityIndex(entity)].Handle;
             ComponentHandle newIndex = destination->AddEntity(entity);
 
-            // 1. 모든 기존 컴포넌트 데이터를 새 아키타입으로 복사
-            const auto& sourceSignature = source->GetSignature();
-            for (ComponentType i = 0; i < MAX_COMPONENTS; ++i) {
-                if (sourceSignature.test(i)) {
-                    IComponentArray* sourceArray = source->GetComponentArray(i);
-                    IComponentArray* destArray = destination->GetComponentArray(i); // 필요 시 생성
-                    sourceArray->MoveData(oldIndex, destArray);
-                }
-            }
+            // 1. 공통 컴포넌트 데이터를 새 아키타입의 청크로 이동
+            destination->MoveCommonComponentsFrom(*source, oldIndex, newIndex);
 
-            Entity movedEntity = source->RemoveEntity(entity);
-            mEntityLocations[entity] = { destination, newIndex };
-            if (source->GetEntityCount() > 0 && movedEntity != entity) {
-                mEntityLocations[movedEntity].Handle = oldIndex;
+            // 2. 기존 행 제거 (이동된 빈 껍데기 파괴 + 마지막 행 swap)
+            Entity movedEntity = source->RemoveEntity(oldIndex);
+            mEntityLocations[GetEntityIndex(entity)] = { destination, newIndex };
+            if (movedEntity != INVALID_ENTITY) {
+                mEntityLocations[GetEntityIndex(movedEntity)].Handle = oldIndex;
             }
         }
     };
     inline Archetype::Archetype(Signature signature, SharedComponentID sharedId, ArchetypeManager* manager)
-        : mSignature(signature)
+        : mManager(manager)
+        , mSignature(signature)
         , mSharedComponentId(sharedId)
-        , mManager(manager)
     {
+        mColumnOfType.fill(INVALID_COLUMN);
+        size_t bytesPerEntity = sizeof(Entity);
         for (ComponentType i = 0; i < MAX_COMPONENTS; ++i) {
             if (mSignature.test(i)) {
-                mComponentArrays[i] = mManager->CreateComponentArray(i);
+                const ComponentInfo& info = mManager->GetComponentInfo(i);
+                mColumnOfType[i] = static_cast<std::uint8_t>(mColumnTypes.size());
+                mColumnTypes.push_back(i);
+                mColumnInfos.push_back(&info);
+                bytesPerEntity += info.Size;
             }
         }
+        mColumnOffsets.resize(mColumnTypes.size());
+
+        // 정렬 패딩을 고려해 16KB 청크에 들어가는 최대 엔티티 수를 찾습니다.
+        // 엔티티 하나가 청크보다 크면 한 행짜리 청크를 크기에 맞게 할당합니다.
+        mChunkCapacity = std::max<size_t>(1, CHUNK_SIZE / bytesPerEntity);
+        while (mChunkCapacity > 1 && ComputeLayout(mChunkCapacity) > CHUNK_SIZE)
+            --mChunkCapacity;
+        mChunkByteSize = std::max(CHUNK_SIZE, ComputeLayout(mChunkCapacity));
     }
     template<typename T>
-    inline ComponentArray<T>* Archetype::GetComponentArray() {
-        ComponentType type = mManager->GetComponentType<T>();
-        assert(mComponentArrays.count(type) > 0 && "Archetype should have this component array.");
-        return static_cast<ComponentArray<T>*>(mComponentArrays.at(type).get());
+    inline T& Archetype::GetComponentData(ComponentHandle handle) {
+        return *static_cast<T*>(GetComponentPtr(mManager->GetComponentType<T>(), handle));
+    }
+    template<typename T>
+    inline T* Archetype::GetColumn(ArchetypeChunk& chunk) {
+        std::uint8_t column = mColumnOfType[mManager->GetComponentType<T>()];
+        assert(column != INVALID_COLUMN && "Archetype should have this component array.");
+        return reinterpret_cast<T*>(chunk.mData + mColumnOffsets[column]);
     }
 }
 
@@ -313,4 +594,4 @@ namespace ECS {
     private:
         std::unordered_map<std::type_index, std::unique_ptr<ISingletonComponent>> mSingletonComponents;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,338 @@
+#pragma once
+#include "ECSEntity.h"
+#include "ECSArchetype.h"
+#include "ECSJobSystem.h"
+
+namespace ECS
+{
+	// 엔티티 생성/파괴와 컴포넌트 추가/제거를 즉시 적용하지 않고 기록해 두었다가 동기화 지점에서 한꺼번에 재생하는 버퍼.
+	// 시스템이 병렬로 실행되는 페이즈 도중에도 어느 스레드에서든 기록할 수 있습니다.
+	// 기록은 스레드(JobSystem 워커)별 스트림에 쌓이므로 같은 스레드에서 기록한 명령끼리만 순서가 보장됩니다.
+	//
+	// 재생 시 명령을 엔티티별로 합친 뒤 (원본 아키타입, 최종 시그니처)가 같은 엔티티들을 묶어
+	// ArchetypeManager::MoveEntities로 한 번에 이동하므로, 엔티티마다 아키타입을 여러 번 옮겨 다니지 않습니다.
+	//
+	// 사용 예:
+	//   auto& commands = coordinator.GetCommandBuffer();
+	//   ECS::Entity projectile = commands.CreateEntity();
+	//   commands.AddComponent(projectile, TransformComponent{ ... });
+	//   commands.AddComponent(projectile, RigidBodyComponent{ ... });
+	class EntityCommandBuffer
+	{
+	public:
+		EntityCommandBuffer()
+		{
+			mStreams.resize(JobSystem::GetInstance().GetWorkerCount() + 1);
+			for (auto& stream : mStreams)
+				stream = std::make_unique<Stream>();
+		}
+		~EntityCommandBuffer() { Clear(); }
+		EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+		EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+		// 재생 시점에 실제 엔티티로 바뀌는 임시 엔티티를 반환합니다. 같은 버퍼에 기록하는 명령의 대상으로만 사용할 수 있습니다.
+		Entity CreateEntity()
+		{
+			Entity entity = MakeEntity(mNextDeferredIndex.fetch_add(1, std::memory_order_relaxed), DEFERRED_ENTITY_GENERATION);
+			Record({ eCommand::CreateEntity, 0, entity, nullptr, nullptr });
+			return entity;
+		}
+
+		void DestroyEntity(Entity entity)
+		{
+			Record({ eCommand::DestroyEntity, 0, entity, nullptr, nullptr });
+		}
+
+		// 컴포넌트 타입 ID가 필요하므로 ECSCoordinator.h에서 정의합니다.
+		template<typename T> void AddComponent(Entity entity, T component);
+		template<typename T> void RemoveComponent(Entity entity);
+
+		static bool IsDeferred(Entity entity)
+		{
+			return entity != INVALID_ENTITY && GetEntityGeneration(entity) == DEFERRED_ENTITY_GENERATION;
+		}
+
+		bool IsEmpty() const { return mCommandCount.load(std::memory_order_acquire) == 0; }
+
+		// 기록된 명령을 적용하고 버퍼를 비웁니다. 다른 스레드가 기록 중이지 않은 동기화 지점에서만 호출해야 합니다.
+		void Playback(EntityManager& entityManager, ArchetypeManager& archetypeManager)
+		{
+			if (IsEmpty())
+				return;
+
+			// 1. 명령을 대상 엔티티별로 합칩니다. 같은 컴포넌트를 여러 번 추가하면 마지막 값이 남습니다.
+			std::vector<PendingEntity> pending;
+			std::vector<PendingValue> values;
+			std::unordered_map<Entity, std::uint32_t> pendingIndex;
+			for (auto& stream : mStreams)
+			{
+				for (const Command& command : stream->Commands)
+				{
+					auto [it, inserted] = pendingIndex.try_emplace(command.Target, static_cast<std::uint32_t>(pending.size()));
+					if (inserted)
+						pending.push_back({ command.Target });
+					PendingEntity& entry = pending[it->second];
+
+					switch (command.Type)
+					{
+					case eCommand::CreateEntity:
+						break;
+					case eCommand::DestroyEntity:
+						entry.Destroyed = true;
+						break;
+					case eCommand::AddComponent:
+						entry.Added.set(command.Component);
+						entry.Removed.reset(command.Component);
+						SetPendingValue(entry, values, command.Component, command.Data);
+						break;
+					case eCommand::RemoveComponent:
+						entry.Removed.set(command.Component);
+						entry.Added.reset(command.Component);
+						SetPendingValue(entry, values, command.Component, nullptr);
+						break;
+					}
+				}
+			}
+
+			// 2. 파괴와 제자리 덮어쓰기를 처리하고, 아키타입 이동이 필요한 엔티티만 남깁니다.
+			std::vector<PendingEntity*> moves;
+			for (PendingEntity& entry : pending)
+			{
+				if (IsDeferred(entry.Target))
+				{
+					if (entry.Destroyed)
+						continue;
+					entry.Target = entityManager.CreateEntity();
+				}
+				else if (!entityManager.IsAlive(entry.Target))
+				{
+					LOG_WARN("EntityCommandBuffer: command recorded for a stale entity handle: {}", entry.Target);
+					continue;
+				}
+				else if (entry.Destroyed)
+				{
+					entityManager.DestroyEntity(entry.Target);
+					archetypeManager.EntityDestroyed(entry.Target);
+					continue;
+				}
+
+				Signature oldSignature = entityManager.GetSignature(entry.Target);
+				Signature newSignature = (oldSignature & ~entry.Removed) | entry.Added;
+				entityManager.SetSignature(entry.Target, newSignature);
+
+				EntityLocation location = archetypeManager.GetEntityLocation(entry.Target);
+				entry.Source = location.Archetype;
+				entry.NewSignature = newSignature;
+				if (newSignature != oldSignature)
+				{
+					moves.push_back(&entry);
+				}
+				else if (location.Archetype)
+				{
+					// 이미 가진 컴포넌트만 다시 추가된 경우 아키타입 이동 없이 값을 덮어씁니다.
+					ConstructValues(archetypeManager, values, entry, location.Archetype, location.Handle, location.Archetype);
+				}
+			}
+
+			// 3. (원본 아키타입, 최종 시그니처)가 같은 엔티티끼리 묶어 한 번에 이동합니다.
+			std::sort(moves.begin(), moves.end(), [](const PendingEntity* lhs, const PendingEntity* rhs) {
+				if (lhs->Source != rhs->Source)
+					return std::less<Archetype*>()(lhs->Source, rhs->Source);
+				return lhs->NewSignature.to_ullong() < rhs->NewSignature.to_ullong();
+			});
+
+			std::vector<Entity> batch;
+			for (size_t begin = 0; begin < moves.size();)
+			{
+				Archetype* source = moves[begin]->Source;
+				const Signature& signature = moves[begin]->NewSignature;
+				size_t end = begin + 1;
+				while (end < moves.size() && moves[end]->Source == source && moves[end]->NewSignature == signature)
+					++end;
+
+				SharedComponentID sharedId = source ? source->GetSharedComponentId() : 0;
+				Archetype* destination = archetypeManager.FindOrCreateArchetype(signature, sharedId);
+
+				batch.clear();
+				for (size_t i = begin; i < end; ++i)
+					batch.push_back(moves[i]->Target);
+				ComponentHandle first = archetypeManager.MoveEntities(batch.data(), batch.size(), source, destination);
+
+				for (size_t i = begin; i < end; ++i)
+					ConstructValues(archetypeManager, values, *moves[i], destination, first + (i - begin), source);
+
+				begin = end;
+			}
+
+			Clear();
+		}
+
+		// 기록된 명령을 적용하지 않고 버립니다.
+		void Clear()
+		{
+			for (auto& stream : mStreams)
+				stream->Reset();
+			mNextDeferredIndex.store(0, std::memory_order_relaxed);
+			mCommandCount.store(0, std::memory_order_release);
+		}
+
+	private:
+		enum class eCommand : std::uint8_t
+		{
+			CreateEntity,
+			DestroyEntity,
+			AddComponent,
+			RemoveComponent,
+		};
+
+		struct Command
+		{
+			eCommand Type;
+			ComponentType Component;
+			Entity Target;
+			void* Data;
+			void (*DestroyData)(void* ptr);
+		};
+
+		// 한 스레드가 기록하는 명령 목록과 컴포넌트 값을 담는 블록 할당기.
+		// 블록은 재생 후에도 유지되어 다음 프레임에 재사용되며, 주소가 바뀌지 않으므로 값을 제자리에서 생성할 수 있습니다.
+		struct alignas(64) Stream
+		{
+			static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+			struct Block
+			{
+				std::unique_ptr<std::byte[]> Memory;
+				size_t Size = 0;
+			};
+
+			std::mutex Mutex;
+			std::vector<Command> Commands;
+			std::vector<Block> Blocks;
+			size_t CurrentBlock = 0;
+			size_t Offset = 0;
+
+			void* Allocate(size_t size, size_t alignment)
+			{
+				for (; CurrentBlock < Blocks.size(); ++CurrentBlock, Offset = 0)
+				{
+					Block& block = Blocks[CurrentBlock];
+					std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.Memory.get());
+					size_t offset = ((base + Offset + alignment - 1) & ~(alignment - 1)) - base;
+					if (offset + size <= block.Size)
+					{
+						Offset = offset + size;
+						return block.Memory.get() + offset;
+					}
+				}
+
+				size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+				Blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+				CurrentBlock = Blocks.size() - 1;
+				Offset = 0;
+				return Allocate(size, alignment);
+			}
+
+			void Reset()
+			{
+				for (const Command& command : Commands)
+				{
+					if (command.Data)
+						command.DestroyData(command.Data);
+				}
+				Commands.clear();
+				CurrentBlock = 0;
+				Offset = 0;
+			}
+		};
+
+		// 재생 중 엔티티 하나에 대해 합쳐진 변경 내용
+		struct PendingEntity
+		{
+			Entity Target = INVALID_ENTITY;
+			bool Destroyed = false;
+			Signature Added;
+			Signature Removed;
+			Signature NewSignature;
+			Archetype* Source = nullptr;
+			std::uint32_t FirstValue = INVALID_VALUE;
+		};
+
+		// 엔티티별 컴포넌트 값 목록 (values 배열 안의 단일 연결 리스트)
+		struct PendingValue
+		{
+			ComponentType Type;
+			void* Data;
+			std::uint32_t Next;
+		};
+		static constexpr std::uint32_t INVALID_VALUE = std::numeric_limits<std::uint32_t>::max();
+
+		Stream& GetStream()
+		{
+			int worker = JobSystem::GetCurrentWorkerIndex();
+			return *mStreams[worker >= 0 ? static_cast<size_t>(worker) + 1 : 0];
+		}
+
+		void Record(const Command& command)
+		{
+			Stream& stream = GetStream();
+			{
+				std::lock_guard<std::mutex> lock(stream.Mutex);
+				stream.Commands.push_back(command);
+			}
+			mCommandCount.fetch_add(1, std::memory_order_release);
+		}
+
+		template<typename T>
+		void RecordAdd(ComponentType type, Entity entity, T&& component)
+		{
+			using Component = std::decay_t<T>;
+			Stream& stream = GetStream();
+			{
+				std::lock_guard<std::mutex> lock(stream.Mutex);
+				void* data = new (stream.Allocate(sizeof(Component), alignof(Component))) Component(std::forward<T>(component));
+				stream.Commands.push_back({ eCommand::AddComponent, type, entity, data,
+					[](void* ptr) { static_cast<Component*>(ptr)->~Component(); } });
+			}
+			mCommandCount.fetch_add(1, std::memory_order_release);
+		}
+
+		static void SetPendingValue(PendingEntity& entry, std::vector<PendingValue>& values, ComponentType type, void* data)
+		{
+			for (std::uint32_t i = entry.FirstValue; i != INVALID_VALUE; i = values[i].Next)
+			{
+				if (values[i].Type == type)
+				{
+					values[i].Data = data;
+					return;
+				}
+			}
+			if (!data)
+				return;
+			values.push_back({ type, data, entry.FirstValue });
+			entry.FirstValue = static_cast<std::uint32_t>(values.size() - 1);
+		}
+
+		// 기록된 값을 archetype의 handle 행으로 이동 생성합니다.
+		// previous(이전 아키타입)에 이미 있던 컴포넌트는 살아 있는 객체이므로 먼저 파괴한 뒤 덮어씁니다.
+		static void ConstructValues(ArchetypeManager& archetypeManager, const std::vector<PendingValue>& values,
+			const PendingEntity& entry, Archetype* archetype, ComponentHandle handle, const Archetype* previous)
+		{
+			for (std::uint32_t i = entry.FirstValue; i != INVALID_VALUE; i = values[i].Next)
+			{
+				const PendingValue& value = values[i];
+				if (!value.Data)
+					continue;
+				const ComponentInfo& info = archetypeManager.GetComponentInfo(value.Type);
+				void* dest = archetype->GetComponentPtr(value.Type, handle);
+				if (previous && previous->HasComponent(value.Type))
+					info.Destroy(dest);
+				info.MoveConstruct(dest, value.Data);
+			}
+		}
+
+		std::vector<std::unique_ptr<Stream>> mStreams;
+		std::atomic<std::uint32_t> mNextDeferredIndex{ 0 };
+		std::atomic<size_t> mCommandCount{ 0 };
+	};
+}
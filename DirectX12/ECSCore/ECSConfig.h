@@ -28,14 +28,33 @@
 
 using json = nlohmann::json;
 
+// 시스템이 DeclareAccess에 선언하지 않은 컴포넌트에 접근하면 실행 중에 오류를 보고합니다.
+#ifndef ECS_ACCESS_CHECK
+#ifdef _DEBUG
+#define ECS_ACCESS_CHECK 1
+#else
+#define ECS_ACCESS_CHECK 0
+#endif
+#endif
+
 namespace ECS
 {
 	// namespace Entity
-	using Entity = std::uint32_t;
+	// 하위 32비트는 슬롯 인덱스, 상위 32비트는 세대(generation) 번호입니다.
+	// 슬롯이 재활용될 때마다 세대가 증가하므로 파괴된 엔티티의 오래된 핸들은 새 엔티티와 구분됩니다.
+	using Entity = std::uint64_t;
 	static constexpr Entity INVALID_ENTITY = std::numeric_limits<Entity>::max();
-	static constexpr Entity MAX_ENTITIES = 5000;
 	using EntityHandle = std::size_t;
 
+	// 이 세대 번호는 EntityCommandBuffer가 만든 지연 생성 엔티티 표시용으로 예약되어 실제 엔티티에는 쓰이지 않습니다.
+	static constexpr std::uint32_t DEFERRED_ENTITY_GENERATION = std::numeric_limits<std::uint32_t>::max();
+	inline constexpr std::uint32_t GetEntityIndex(Entity entity) { return static_cast<std::uint32_t>(entity); }
+	inline constexpr std::uint32_t GetEntityGeneration(Entity entity) { return static_cast<std::uint32_t>(entity >> 32); }
+	inline constexpr Entity MakeEntity(std::uint32_t index, std::uint32_t generation)
+	{
+		return (static_cast<Entity>(generation) << 32) | index;
+	}
+
 	using ComponentType = std::uint8_t;
 	static constexpr ComponentType MAX_COMPONENTS = 32;
 	using ComponentHandle = std::size_t;
@@ -4,6 +4,7 @@
 #include "ECSEntity.h"
 #include "ECSArchetype.h"
 #include "ECSSystem.h"
+#include "ECSSnapshot.h"
 #include "WindowSystem.h"
 #include "ImGuiSystem.h"
 #include "BoundingVolumeUpdateSystem.h"
@@ -20,6 +21,7 @@ namespace ECS
 		mSingletonComponentManager = std::make_unique<SingletonComponentManager>();
 		mEntityManager = std::make_unique<EntityManager>();
 		mSystemManager = std::make_unique<SystemManager>();
+		mCommandBuffer = std::make_unique<EntityCommandBuffer>();
 
 		RegisterComponent<DX12_BoundingComponent>();
 		RegisterComponent<DX12_MeshComponent>();
@@ -105,13 +107,18 @@ namespace ECS
 	void Coordinator::DestroyEntity(Entity entity)
 	{
 		std::lock_guard<std::mutex> lock(mtx);
+		if (!mEntityManager->IsAlive(entity))
+		{
+			LOG_WARN("DestroyEntity called with a stale entity handle: {}", entity);
+			return;
+		}
 		mEntityManager->DestroyEntity(entity);
 		mArchetypeManager->EntityDestroyed(entity);
-		mSystemManager->EntityDestroyed(entity);
 	}
 	void Coordinator::Run()
 	{
 		mSystemManager->BeginPlayAllSystems();
+		PlaybackCommands(*mCommandBuffer);
 		while (true) // Replace with actual game loop condition
 		{
 			//#########################
@@ -121,18 +128,34 @@ namespace ECS
 			if (!WindowSystem::GetInstance().Sync())
 				break;
 			InputSystem::GetInstance().PreUpdate();
+			// 각 페이즈가 끝난 시점을 동기화 지점으로 삼아 기록된 구조 변경을 재생합니다.
 			mSystemManager->SyncAllSystems();
+			PlaybackCommands(*mCommandBuffer);
 			mSystemManager->PreUpdateAllSystems();
+			PlaybackCommands(*mCommandBuffer);
 			mSystemManager->UpdateAllSystems();
+			PlaybackCommands(*mCommandBuffer);
 			ImGuiSystem::GetInstance().RenderMultiViewport();
 			mSystemManager->LateUpdateAllSystems();
+			PlaybackCommands(*mCommandBuffer);
 			mSystemManager->FixedUpdateAllSystems();
+			PlaybackCommands(*mCommandBuffer);
 			mSystemManager->FinalUpdateAllSystems();
+			PlaybackCommands(*mCommandBuffer);
 		}
 		mSystemManager->EndPlayAllSystems();
-		SaveWorldToFile("world.json"); // Save the world state to a file at the end of the game loop
+		PlaybackCommands(*mCommandBuffer);
+		SaveWorldToFile("world.ecsw"); // Save the world state to a file at the end of the game loop
+#ifdef _DEBUG
+		SaveWorldToJson("world.json");
+#endif
 	}
-	void Coordinator::SaveWorldToFile(const std::string& filePath)
+	bool Coordinator::SaveWorldToFile(const std::string& filePath)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return WorldSnapshot::Save(filePath, *mArchetypeManager, GetSingletonComponent<TimeComponent>());
+	}
+	void Coordinator::SaveWorldToJson(const std::string& filePath)
 	{
 		json worldJson;
 
@@ -177,11 +200,8 @@ namespace ECS
 				const auto& signature = archetype->GetSignature();
 				for (ComponentType typeId = 0; typeId < MAX_COMPONENTS; ++typeId) {
 					if (signature.test(typeId)) {
-						// 3-1. 아키타입에서 해당 타입의 ComponentArray를 가져온다.
-						IComponentArray* componentArray = archetype->GetComponentArray(typeId);
-
-						// 3-2. 배열에게 "i번째 데이터를 이 JSON 객체에 추가해줘" 라고 명령한다.
-						componentArray->AddComponentToJson(i, componentsJson);
+						// 3-1. 아키타입에게 "i번째 엔티티의 typeId 컴포넌트를 이 JSON 객체에 추가해줘" 라고 명령한다.
+						archetype->AddComponentToJson(typeId, i, componentsJson);
 					}
 				}
 				entityJson["Components"] = componentsJson;
@@ -193,44 +213,9 @@ namespace ECS
 		std::ofstream file(filePath);
 		file << worldJson.dump(4); // 4는 들여쓰기 옵션
 	}
-	void Coordinator::LoadWorldFromFile(const std::string& filePath)
+	bool Coordinator::LoadWorldFromFile(const std::string& filePath)
 	{
-		//auto& coordinator = ECS::Coordinator::GetInstance();
-
-		//// 1. 기존 월드 초기화 (모든 엔티티, 컴포넌트 삭제)
-		//coordinator.DestroyAllEntities();
-
-		//// 2. JSON 파일 읽기
-		//std::ifstream file(filePath);
-		//json worldJson;
-		//file >> worldJson;
-
-		//// 3. 리소스 미리 로드하기
-		////    (엔티티 생성 전에 필요한 모든 리소스를 로드하여 핸들을 준비)
-		//auto& geoManager = coordinator.GetSingletonComponent<GeometryManager>();
-		//for (const auto& path : worldJson["Resources"]["Geometries"]) {
-		//	geoManager.LoadFromFile(path.get<std::string>(), device);
-		//}
-
-		//// 4. 싱글턴 컴포넌트 복원
-		//coordinator.GetSingletonComponent<TimeComponent>() = worldJson["Singletons"]["Time"];
-
-		//// 5. 엔티티 및 컴포넌트 생성
-		//for (const auto& entityJson : worldJson["Entities"]) {
-		//	// 5-1. 엔티티 생성
-		//	Entity entity = coordinator.CreateEntity(entityJson["ID"]); // ID를 지정하여 생성
-
-		//	// 5-2. 공유 컴포넌트 설정
-		//	size_t sharedId = entityJson["SharedComponentID"];
-		//	const auto& sharedProps = coordinator.GetSharedComponentValue(sharedId);
-		//	coordinator.SetSharedComponent(entity, sharedProps);
-
-		//	// 5-3. 일반 컴포넌트 추가
-		//	for (auto& [compName, compJson] : entityJson["Components"].items()) {
-		//		// 컴포넌트 이름(compName)을 보고 어떤 타입인지 판단하여
-		//		// from_json 함수로 데이터를 채운 뒤, AddComponent 호출
-		//		// 예: mLoadFunctions[compName](entity, compJson);
-		//	}
-		//}
+		std::lock_guard<std::mutex> lock(mtx);
+		return WorldSnapshot::Load(filePath, *mEntityManager, *mArchetypeManager, GetSingletonComponent<TimeComponent>());
 	}
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "ECSEntity.h"
 #include "ECSArchetype.h"
+#include "ECSQuery.h"
+#include "ECSCommandBuffer.h"
 #include "ECSSystem.h"
 
 namespace ECS
@@ -22,10 +24,22 @@ namespace ECS
 		void Init();
 		Entity CreateEntity();
 		void DestroyEntity(Entity entity);
+		bool IsAlive(Entity entity) const { return mEntityManager->IsAlive(entity); }
+
+		// 페이즈 도중의 구조 변경(생성/파괴/컴포넌트 추가·제거)을 기록하는 기본 버퍼. 각 페이즈가 끝날 때 재생됩니다.
+		EntityCommandBuffer& GetCommandBuffer() { return *mCommandBuffer; }
+		void PlaybackCommands(EntityCommandBuffer& commandBuffer)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			commandBuffer.Playback(*mEntityManager, *mArchetypeManager);
+		}
 		void Run();
 
-		void SaveWorldToFile(const std::string& filePath);
-		void LoadWorldFromFile(const std::string& filePath);
+		// 바이너리 스냅샷(ECSSnapshot.h)으로 저장/로드합니다.
+		bool SaveWorldToFile(const std::string& filePath);
+		bool LoadWorldFromFile(const std::string& filePath);
+		// 디버깅용 JSON 덤프. 모든 컴포넌트를 사람이 읽을 수 있는 형태로 기록하지만 느립니다.
+		void SaveWorldToJson(const std::string& filePath);
 
 		// Component methods
 		template<typename T>
@@ -49,8 +63,6 @@ namespace ECS
 			signature.set(mArchetypeManager->GetComponentType<T>(), true);
 			
 			mEntityManager->SetSignature(entity, signature);
-
-			mSystemManager->EntitySignatureChanged(entity, signature);
 		}
 
 		template<typename T>
@@ -62,19 +74,30 @@ namespace ECS
 			auto signature = mEntityManager->GetSignature(entity);
 			signature.set(mArchetypeManager->GetComponentType<T>(), false);
 			mEntityManager->SetSignature(entity, signature);
-
-			mSystemManager->EntitySignatureChanged(entity, signature);
 		}
 
+		// 쓰기용 참조. 쓰기 접근으로 검사하고, 엔티티가 속한 청크의 T 컬럼을 변경된 것으로 기록합니다.
+		// 청크 버전을 바꾸는 접근자는 이것뿐이므로, 읽기만 할 때는 GetComponent/GetComponentRead를 사용해야
+		// Changed<T>() 쿼리가 아무도 고치지 않은 청크를 다시 처리하지 않습니다.
 		template<typename T>
-		T& GetComponent(Entity entity)
+		T& GetComponentWrite(Entity entity)
 		{
-			return mArchetypeManager->GetComponent<T>(entity);
+			CheckAccess<T>(true);
+			return mArchetypeManager->GetComponentForWrite<T>(entity, ChangeVersion::Next());
 		}
 
+		// 읽기 전용 참조. 청크 버전은 바꾸지 않습니다.
 		template<typename T>
 		const T& GetComponent(Entity entity) const
 		{
+			return GetComponentRead<T>(entity);
+		}
+
+		// 읽기 전용 참조. 읽기 접근으로 검사하며 청크 버전은 바꾸지 않습니다.
+		template<typename T>
+		const T& GetComponentRead(Entity entity) const
+		{
+			CheckAccess<T>(false);
 			return mArchetypeManager->GetComponent<T>(entity);
 		}
 		
@@ -82,16 +105,36 @@ namespace ECS
 			return mArchetypeManager->GetAllArchetypes();
 		}
 
+		// Ts...를 모두 가진 엔티티를 청크 단위로 순회하는 쿼리
+		template<typename... Ts>
+		EntityQuery<Ts...> Query()
+		{
+			(CheckAccess<std::remove_const_t<Ts>>(!std::is_const_v<Ts>), ...);
+			return EntityQuery<Ts...>(mArchetypeManager.get());
+		}
+
+		// 매칭 아키타입 목록을 cache에 유지하며 재사용하는 쿼리 (ISystem::Query가 사용)
+		template<typename... Ts>
+		EntityQuery<Ts...> Query(QueryCache& cache, std::uint64_t writeVersion, std::uint64_t changedSince)
+		{
+			(CheckAccess<std::remove_const_t<Ts>>(!std::is_const_v<Ts>), ...);
+			return EntityQuery<Ts...>(mArchetypeManager.get(), cache.GetArchetypes(*mArchetypeManager), writeVersion, changedSince);
+		}
+
+		// Query와 같은 규칙으로 읽기 전용 접근은 GetSingletonComponent<const T>()로 요청합니다.
+		// const가 아닌 T는 쓰기 접근으로 검사됩니다.
 		template<typename T>
 		T& GetSingletonComponent()
 		{
-			return mSingletonComponentManager->GetComponent<T>();
+			CheckSingletonAccess<std::remove_const_t<T>>(!std::is_const_v<T>);
+			return mSingletonComponentManager->GetComponent<std::remove_const_t<T>>();
 		}
 
 		template<typename T>
 		const T& GetSingletonComponent() const
 		{
-			return mSingletonComponentManager->GetComponent<T>();
+			CheckSingletonAccess<std::remove_const_t<T>>(false);
+			return mSingletonComponentManager->GetComponent<std::remove_const_t<T>>();
 		}
 
 		template<typename T>
@@ -104,7 +147,11 @@ namespace ECS
 		template<typename T>
 		std::shared_ptr<T> RegisterSystem()
 		{
-			return mSystemManager->RegisterSystem<T>();
+			auto system = mSystemManager->RegisterSystem<T>();
+			SystemAccess access;
+			system->DeclareAccess(access);
+			mSystemManager->SetAccess<T>(access);
+			return system;
 		}
 
 		template<typename T>
@@ -114,10 +161,80 @@ namespace ECS
 		}
 	private:
 		Coordinator() = default;
+
+		// 실행 중인 시스템이 선언한 접근 범위를 벗어나면 보고합니다. (ECS_ACCESS_CHECK 빌드 전용)
+		template<typename T>
+		void CheckAccess(bool write) const
+		{
+#if ECS_ACCESS_CHECK
+			const SystemAccess* access = SystemAccess::GetCurrent();
+			if (!access)
+				return;
+			ComponentType type = mArchetypeManager->GetComponentType<T>();
+			if (write ? !access->CanWrite(type) : !access->CanRead(type))
+			{
+				LOG_ERROR("Undeclared {} access to component {}", write ? "write" : "read", T::GetName());
+				assert(false && "System accessed a component it did not declare.");
+			}
+#endif
+		}
+
+		template<typename T>
+		void CheckSingletonAccess(bool write) const
+		{
+#if ECS_ACCESS_CHECK
+			const SystemAccess* access = SystemAccess::GetCurrent();
+			if (!access)
+				return;
+			std::type_index type = typeid(T);
+			if (write ? !access->CanWriteSingleton(type) : !access->CanReadSingleton(type))
+			{
+				LOG_ERROR("Undeclared {} access to singleton component {}", write ? "write" : "read", T::GetName());
+				assert(false && "System accessed a singleton component it did not declare.");
+			}
+#endif
+		}
+
 		std::mutex mtx;
 		std::unique_ptr<EntityManager> mEntityManager;
 		std::unique_ptr<ArchetypeManager> mArchetypeManager;
 		std::unique_ptr<SingletonComponentManager> mSingletonComponentManager;
 		std::unique_ptr<SystemManager> mSystemManager;
+		std::unique_ptr<EntityCommandBuffer> mCommandBuffer;
 	};
-}
\ No newline at end of file
+}
+
+namespace ECS
+{
+	template<typename T>
+	inline SystemAccess& SystemAccess::Read()
+	{
+		return ReadType(Coordinator::GetInstance().GetComponentType<T>());
+	}
+
+	template<typename T>
+	inline SystemAccess& SystemAccess::Write()
+	{
+		return WriteType(Coordinator::GetInstance().GetComponentType<T>());
+	}
+
+	template<typename T>
+	inline void EntityCommandBuffer::AddComponent(Entity entity, T component)
+	{
+		RecordAdd(Coordinator::GetInstance().GetComponentType<T>(), entity, std::move(component));
+	}
+
+	template<typename T>
+	inline void EntityCommandBuffer::RemoveComponent(Entity entity)
+	{
+		Record({ eCommand::RemoveComponent, Coordinator::GetInstance().GetComponentType<T>(), entity, nullptr, nullptr });
+	}
+
+	template<typename... Ts>
+	inline EntityQuery<Ts...> ISystem::Query()
+	{
+		// 페이즈 밖(생성자 등)에서 호출되면 실행 버전이 없으므로 새 버전을 발급하고 모든 청크를 변경된 것으로 봅니다.
+		std::uint64_t writeVersion = mRunVersion != 0 ? mRunVersion : ChangeVersion::Next();
+		return Coordinator::GetInstance().Query<Ts...>(mQueryCache, writeVersion, mLastRunVersion);
+	}
+}
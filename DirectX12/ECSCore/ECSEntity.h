@@ -3,53 +3,106 @@
 
 namespace ECS
 {
+	// 엔티티 슬롯 테이블.
+	// 슬롯 정보(시그니처, 세대, 다음 빈 슬롯)는 고정 크기 페이지 단위로 필요할 때만 할당되므로
+	// 엔티티 수에 상한이 없고, 테이블이 커져도 기존 슬롯이 복사/이동되지 않습니다.
+	// 파괴된 슬롯은 페이지 안의 NextFree 필드로 연결된 침입형 free-list로 재활용하므로 엔티티마다 할당이 없습니다.
 	class EntityManager
 	{
 	public:
-		EntityManager()
-			: mLivingEntityCount(0)
-		{
-			for (Entity entity = 0; entity < MAX_ENTITIES; ++entity)
-				mAvailableEntities.push(entity);
-		}
+		static constexpr std::uint32_t PAGE_SIZE = 4096;
+		static constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
 
 		Entity CreateEntity()
 		{
-			assert(mLivingEntityCount < MAX_ENTITIES && "Too many entities in existence.");
+			std::uint32_t index;
+			if (mFreeHead != INVALID_INDEX)
+			{
+				index = mFreeHead;
+				mFreeHead = GetSlot(index).NextFree;
+			}
+			else
+			{
+				assert(mSlotCount < INVALID_INDEX && "Too many entities in existence.");
+				index = mSlotCount++;
+				if (index / PAGE_SIZE >= mPages.size())
+					mPages.emplace_back(std::make_unique<Page>());
+			}
 
-			Entity id = mAvailableEntities.front();
-			mAvailableEntities.pop();
+			Slot& slot = GetSlot(index);
+			slot.NextFree = INVALID_INDEX;
 			++mLivingEntityCount;
 
-			return id;
+			return MakeEntity(index, slot.Generation);
 		}
 
 		void DestroyEntity(Entity entity)
 		{
-			assert(entity < MAX_ENTITIES && "Entity out of range.");
+			assert(IsAlive(entity) && "Destroying an entity that is not alive.");
 
-			mSignatures[entity].reset();
-			mAvailableEntities.push(entity);
+			std::uint32_t index = GetEntityIndex(entity);
+			Slot& slot = GetSlot(index);
+			slot.EntitySignature.reset();
+			// 세대를 올려 이 슬롯을 가리키던 기존 핸들을 모두 무효화합니다.
+			if (++slot.Generation == DEFERRED_ENTITY_GENERATION)
+				slot.Generation = 0;
+			slot.NextFree = mFreeHead;
+			mFreeHead = index;
 			--mLivingEntityCount;
 		}
 
+		// 살아 있는 모든 엔티티를 파괴합니다. 세대 번호가 올라가므로 기존 핸들은 모두 무효가 됩니다.
+		void DestroyAllEntities()
+		{
+			std::vector<bool> isFree(mSlotCount, false);
+			for (std::uint32_t index = mFreeHead; index != INVALID_INDEX; index = GetSlot(index).NextFree)
+				isFree[index] = true;
+			for (std::uint32_t index = 0; index < mSlotCount; ++index)
+			{
+				if (!isFree[index])
+					DestroyEntity(MakeEntity(index, GetSlot(index).Generation));
+			}
+		}
+
+		bool IsAlive(Entity entity) const
+		{
+			std::uint32_t index = GetEntityIndex(entity);
+			return entity != INVALID_ENTITY
+				&& index < mSlotCount
+				&& GetSlot(index).Generation == GetEntityGeneration(entity);
+		}
+
 		void SetSignature(Entity entity, Signature signature)
 		{
-			assert(entity < MAX_ENTITIES && "Entity out of range.");
+			assert(IsAlive(entity) && "Entity is not alive.");
 
-			mSignatures[entity] = signature;
+			GetSlot(GetEntityIndex(entity)).EntitySignature = signature;
 		}
 
-		Signature GetSignature(Entity entity)
+		Signature GetSignature(Entity entity) const
 		{
-			assert(entity < MAX_ENTITIES && "Entity out of range.");
+			assert(IsAlive(entity) && "Entity is not alive.");
 
-			return mSignatures[entity];
+			return GetSlot(GetEntityIndex(entity)).EntitySignature;
 		}
 
+		std::uint32_t GetLivingEntityCount() const { return mLivingEntityCount; }
+
 	private:
-		std::queue<Entity> mAvailableEntities{};
-		std::array<Signature, static_cast<size_t>(MAX_ENTITIES)> mSignatures{};
-		uint32_t mLivingEntityCount{};
+		struct Slot
+		{
+			Signature EntitySignature;
+			std::uint32_t Generation = 0;
+			std::uint32_t NextFree = INVALID_INDEX;
+		};
+		using Page = std::array<Slot, PAGE_SIZE>;
+
+		Slot& GetSlot(std::uint32_t index) { return (*mPages[index / PAGE_SIZE])[index % PAGE_SIZE]; }
+		const Slot& GetSlot(std::uint32_t index) const { return (*mPages[index / PAGE_SIZE])[index % PAGE_SIZE]; }
+
+		std::vector<std::unique_ptr<Page>> mPages{};
+		std::uint32_t mSlotCount{};
+		std::uint32_t mFreeHead = INVALID_INDEX;
+		std::uint32_t mLivingEntityCount{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#pragma once
+// 표준 라이브러리만 사용하므로 ECS 외부(리소스 로더, Donut 캐시 등)에서도 그대로 include할 수 있습니다.
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ECS
+{
+	// 제출된 작업의 남은 개수를 세는 카운터. 0이 되면 해당 작업 묶음이 모두 끝난 것입니다.
+	// 작업이 던진 예외는 처음 하나만 보관했다가 JobSystem::Wait에서 다시 던집니다.
+	class JobCounter
+	{
+	public:
+		bool IsDone() const { return mCount.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+		std::atomic<int> mCount{ 0 };
+		std::mutex mExceptionMutex;
+		std::exception_ptr mException;
+	};
+
+	// 영구 워커 스레드 풀.
+	// 워커마다 자신의 deque를 가지며 자기 작업은 뒤에서(LIFO) 꺼내고,
+	// 일이 없으면 다른 워커의 deque 앞에서(FIFO) 훔쳐옵니다.
+	// Wait()를 호출한 스레드도 카운터가 0이 될 때까지 작업을 처리하므로 중첩 대기에서도 교착되지 않습니다.
+	class JobSystem
+	{
+	public:
+		static JobSystem& GetInstance()
+		{
+			static JobSystem instance;
+			return instance;
+		}
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) = delete;
+		JobSystem& operator=(JobSystem&&) = delete;
+
+		size_t GetWorkerCount() const { return mWorkers.size(); }
+		// 현재 스레드가 워커라면 그 인덱스, 아니면 -1
+		static int GetCurrentWorkerIndex() { return tWorkerIndex; }
+
+		void Submit(std::function<void()> func, JobCounter* counter = nullptr)
+		{
+			if (counter)
+				counter->mCount.fetch_add(1, std::memory_order_relaxed);
+
+			size_t queueIndex = tWorkerIndex >= 0
+				? static_cast<size_t>(tWorkerIndex)
+				: mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+			try
+			{
+				std::lock_guard<std::mutex> lock(mQueues[queueIndex]->Mutex);
+				mQueues[queueIndex]->Jobs.push_back({ std::move(func), counter });
+				// TryPop과 같은 큐 잠금 안에서 늘리므로 꺼내기가 먼저 반영되는 일이 없습니다.
+				mQueuedJobs.fetch_add(1, std::memory_order_release);
+			}
+			catch (...)
+			{
+				if (counter)
+					counter->mCount.fetch_sub(1, std::memory_order_relaxed);
+				throw;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+			}
+			mSleepCondition.notify_one();
+		}
+
+		// 카운터의 작업이 모두 끝날 때까지 다른 작업을 대신 처리하며 기다립니다.
+		// 작업 중 하나가 예외를 던졌다면 모든 작업이 끝난 뒤 그 예외를 다시 던집니다.
+		void Wait(JobCounter& counter)
+		{
+			WaitUntilDone(counter);
+			if (counter.mException)
+				std::rethrow_exception(std::exchange(counter.mException, nullptr));
+		}
+
+		// 결과를 std::future로 돌려받는 단발성 작업 (리소스 로더 등)
+		template<typename Func>
+		auto Async(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+		{
+			using Result = std::invoke_result_t<std::decay_t<Func>>;
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+			std::future<Result> future = task->get_future();
+			Submit([task]() { (*task)(); });
+			return future;
+		}
+
+		// [begin, end) 구간을 grainSize 단위로 나누어 func(first, last)를 병렬 실행합니다.
+		// 마지막 구간은 호출 스레드에서 직접 처리하고, 모든 구간이 끝날 때까지 반환하지 않습니다.
+		template<typename Func>
+		void ParallelFor(size_t begin, size_t end, size_t grainSize, Func&& func)
+		{
+			if (begin >= end)
+				return;
+			grainSize = std::max<size_t>(1, grainSize);
+			if (end - begin <= grainSize)
+			{
+				func(begin, end);
+				return;
+			}
+
+			JobCounter counter;
+			try
+			{
+				size_t first = begin;
+				for (; first + grainSize < end; first += grainSize)
+				{
+					size_t last = first + grainSize;
+					Submit([&func, first, last]() { func(first, last); }, &counter);
+				}
+				func(first, end);
+			}
+			catch (...)
+			{
+				// 제출된 구간들이 func와 counter를 참조하므로 모두 끝난 뒤에 예외를 전달합니다.
+				WaitUntilDone(counter);
+				throw;
+			}
+			Wait(counter);
+		}
+
+	private:
+		struct Job
+		{
+			std::function<void()> Func;
+			JobCounter* Counter = nullptr;
+		};
+
+		struct WorkQueue
+		{
+			std::mutex Mutex;
+			std::deque<Job> Jobs;
+		};
+
+		JobSystem()
+		{
+			unsigned int hardwareThreads = std::thread::hardware_concurrency();
+			size_t workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+
+			for (size_t i = 0; i < workerCount; ++i)
+				mQueues.emplace_back(std::make_unique<WorkQueue>());
+			for (size_t i = 0; i < workerCount; ++i)
+				mWorkers.emplace_back([this, i]() { WorkerLoop(static_cast<int>(i)); });
+		}
+
+		~JobSystem()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+				mStop = true;
+			}
+			mSleepCondition.notify_all();
+			for (auto& worker : mWorkers)
+				worker.join();
+		}
+
+		void WaitUntilDone(JobCounter& counter)
+		{
+			while (!counter.IsDone())
+			{
+				if (!TryRunOne(tWorkerIndex))
+					std::this_thread::yield();
+			}
+		}
+
+		void WorkerLoop(int index)
+		{
+			tWorkerIndex = index;
+			while (true)
+			{
+				if (TryRunOne(index))
+					continue;
+
+				std::unique_lock<std::mutex> lock(mSleepMutex);
+				mSleepCondition.wait(lock, [this]() {
+					return mStop || mQueuedJobs.load(std::memory_order_acquire) > 0;
+				});
+				if (mStop)
+					return;
+			}
+		}
+
+		bool TryPop(size_t queueIndex, bool steal, Job& job)
+		{
+			WorkQueue& queue = *mQueues[queueIndex];
+			std::lock_guard<std::mutex> lock(queue.Mutex);
+			if (queue.Jobs.empty())
+				return false;
+			if (steal)
+			{
+				job = std::move(queue.Jobs.front());
+				queue.Jobs.pop_front();
+			}
+			else
+			{
+				job = std::move(queue.Jobs.back());
+				queue.Jobs.pop_back();
+			}
+			mQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		bool TryRunOne(int workerIndex)
+		{
+			Job job;
+			bool found = workerIndex >= 0 && TryPop(static_cast<size_t>(workerIndex), false, job);
+			for (size_t i = 1; !found && i <= mQueues.size(); ++i)
+			{
+				size_t victim = (static_cast<size_t>(workerIndex + 1) + i) % mQueues.size();
+				found = TryPop(victim, true, job);
+			}
+			if (!found)
+				return false;
+
+			try
+			{
+				job.Func();
+			}
+			catch (...)
+			{
+				// 카운터 없는 작업은 예외를 받을 곳이 없으므로 std::thread와 같이 종료합니다.
+				// 결과나 예외가 필요하면 Async(std::future)나 카운터를 사용해야 합니다.
+				if (!job.Counter)
+					std::terminate();
+				std::lock_guard<std::mutex> lock(job.Counter->mExceptionMutex);
+				if (!job.Counter->mException)
+					job.Counter->mException = std::current_exception();
+			}
+			if (job.Counter)
+				job.Counter->mCount.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+
+		std::vector<std::unique_ptr<WorkQueue>> mQueues;
+		std::vector<std::thread> mWorkers;
+		std::atomic<size_t> mNextQueue{ 0 };
+		std::atomic<size_t> mQueuedJobs{ 0 };
+		std::mutex mSleepMutex;
+		std::condition_variable mSleepCondition;
+		bool mStop = false;
+
+		inline static thread_local int tWorkerIndex = -1;
+	};
+
+	// [0, count) 구간 병렬 실행을 std::function으로 받는 ECS 밖의 코드(EngineCore의 SkinnedParallelFor 등)에
+	// 넘길 수 있도록 JobSystem::ParallelFor를 감쌉니다. 반환된 함수는 jobSystem보다 오래 쓰면 안 됩니다.
+	using ParallelForFunction = std::function<void(size_t count, size_t grainSize,
+		const std::function<void(size_t first, size_t last)>& func)>;
+
+	inline ParallelForFunction MakeParallelForFunction(JobSystem& jobSystem = JobSystem::GetInstance())
+	{
+		return [&jobSystem](size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func) {
+			jobSystem.ParallelFor(0, count, grainSize, func);
+		};
+	}
+
+	// 의존 관계가 있는 작업 그래프.
+	// 선행 작업이 모두 끝난 노드만 JobSystem에 제출되며, Run()은 그래프 전체가 끝날 때까지 대기합니다.
+	class TaskGraph
+	{
+	public:
+		using TaskId = size_t;
+
+		TaskId AddTask(std::function<void()> func)
+		{
+			auto node = std::make_unique<Node>();
+			node->Func = std::move(func);
+			mNodes.emplace_back(std::move(node));
+			return mNodes.size() - 1;
+		}
+
+		// before가 끝난 뒤에 after가 실행되도록 간선을 추가합니다.
+		void AddDependency(TaskId before, TaskId after)
+		{
+			assert(before < mNodes.size() && after < mNodes.size() && before != after);
+			mNodes[before]->Dependents.push_back(after);
+			mNodes[after]->PredecessorCount++;
+		}
+
+		size_t GetTaskCount() const { return mNodes.size(); }
+
+		void Clear() { mNodes.clear(); }
+
+		void Run(JobSystem& jobSystem = JobSystem::GetInstance())
+		{
+			if (mNodes.empty())
+				return;
+
+			for (auto& node : mNodes)
+				node->Remaining.store(node->PredecessorCount, std::memory_order_relaxed);
+
+			JobCounter counter;
+			for (TaskId id = 0; id < mNodes.size(); ++id)
+			{
+				if (mNodes[id]->PredecessorCount == 0)
+					Schedule(jobSystem, counter, id);
+			}
+			jobSystem.Wait(counter);
+		}
+
+	private:
+		struct Node
+		{
+			std::function<void()> Func;
+			std::vector<TaskId> Dependents;
+			int PredecessorCount = 0;
+			std::atomic<int> Remaining{ 0 };
+		};
+
+		void Schedule(JobSystem& jobSystem, JobCounter& counter, TaskId id)
+		{
+			jobSystem.Submit([this, &jobSystem, &counter, id]() {
+				Node& node = *mNodes[id];
+				node.Func();
+				// 후속 작업을 먼저 제출한 뒤 이 작업의 카운트가 빠지므로 Run()이 너무 일찍 끝나지 않습니다.
+				for (TaskId dependent : node.Dependents)
+				{
+					if (mNodes[dependent]->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+						Schedule(jobSystem, counter, dependent);
+				}
+			}, &counter);
+		}
+
+		std::vector<std::unique_ptr<Node>> mNodes;
+	};
+}
@@ -0,0 +1,241 @@
+#pragma once
+#include "ECSArchetype.h"
+#include "ECSJobSystem.h"
+#include "ECSSystemAccess.h"
+
+namespace ECS
+{
+	// 시그니처에 매칭되는 아키타입 목록 캐시.
+	// ArchetypeManager의 아키타입 목록은 추가만 되므로, 마지막으로 확인한 이후 새로 생긴 아키타입만 검사합니다.
+	// 컴포넌트를 추가/제거하는 엔티티 단위 변경에는 아무 비용이 들지 않습니다.
+	class QueryCache
+	{
+	public:
+		void SetSignature(const Signature& signature)
+		{
+			mSignature = signature;
+			mArchetypes.clear();
+			mScannedCount = 0;
+		}
+		const Signature& GetSignature() const { return mSignature; }
+
+		const std::vector<Archetype*>& GetArchetypes(const ArchetypeManager& manager)
+		{
+			const auto& archetypes = manager.GetArchetypes();
+			for (; mScannedCount < archetypes.size(); ++mScannedCount)
+			{
+				Archetype* archetype = archetypes[mScannedCount];
+				if ((archetype->GetSignature() & mSignature) == mSignature)
+					mArchetypes.push_back(archetype);
+			}
+			return mArchetypes;
+		}
+
+	private:
+		Signature mSignature;
+		std::vector<Archetype*> mArchetypes;
+		size_t mScannedCount = 0;
+	};
+
+	// 컴포넌트 조합 Ts...를 모두 가진 아키타입들을 청크 단위로 순회하는 타입 쿼리.
+	// 엔티티마다 해시 조회를 하는 대신, 청크마다 컬럼 포인터를 한 번 구한 뒤 연속 메모리를 선형으로 순회합니다.
+	//
+	// 변경 추적: const가 아닌 Ts는 쓰기 접근으로 보고, 방문한 청크의 해당 컬럼에 쿼리의 쓰기 버전을 기록합니다.
+	// Changed<Us...>()를 지정하면 Us 중 하나라도 changedSince 이후에 바뀐 청크만 방문합니다.
+	// 시스템의 Query<Ts...>()는 changedSince로 같은 페이즈의 직전 실행 버전을 넘기므로,
+	// 하위 시스템은 지난 실행 이후 수정된 청크만 다시 계산할 수 있습니다.
+	//
+	// 사용 예:
+	//   coordinator.Query<TransformComponent, RigidBodyComponent>().ForEach(
+	//       [](TransformComponent& transform, RigidBodyComponent& rigidBody) { ... });
+	//   Query<const TransformComponent, BoundingVolumnComponent>().Changed<TransformComponent>().ForEach(...);
+	template<typename... Ts>
+	class EntityQuery
+	{
+	public:
+		explicit EntityQuery(ArchetypeManager* manager)
+			: EntityQuery(manager, manager->GetArchetypes(), ChangeVersion::Next(), 0)
+		{
+		}
+
+		// archetypes: 순회할 후보 아키타입 (QueryCache가 미리 걸러둔 목록 등)
+		// writeVersion: 쓰기 접근한 컬럼에 기록할 버전
+		// changedSince: Changed<Us...>() 필터의 기준 버전. 이 값보다 큰 버전이 기록된 청크만 통과합니다.
+		EntityQuery(ArchetypeManager* manager, const std::vector<Archetype*>& archetypes, std::uint64_t writeVersion, std::uint64_t changedSince)
+			: mManager(manager), mArchetypes(&archetypes), mWriteVersion(writeVersion), mChangedSince(changedSince)
+		{
+			(mSignature.set(manager->GetComponentType<std::remove_const_t<Ts>>()), ...);
+			((std::is_const_v<Ts> ? void() : mWriteTypes.push_back(manager->GetComponentType<std::remove_const_t<Ts>>())), ...);
+		}
+
+		// Us 중 하나라도 changedSince 이후에 쓰기 접근된 청크만 방문하도록 필터를 추가합니다.
+		template<typename... Us>
+		EntityQuery& Changed()
+		{
+			(mChangedFilter.push_back(mManager->GetComponentType<Us>()), ...);
+			return *this;
+		}
+
+		const Signature& GetSignature() const { return mSignature; }
+
+		bool Matches(const Archetype& archetype) const
+		{
+			return (archetype.GetSignature() & mSignature) == mSignature;
+		}
+
+		// func(Entity* entities, size_t count, Ts*... columns)
+		// SIMD 커널처럼 컬럼 배열 전체를 한 번에 다루는 경우에 사용합니다.
+		template<typename Func>
+		void ForEachChunk(Func&& func) const
+		{
+			for (Archetype* archetype : *mArchetypes)
+			{
+				if (archetype->GetEntityCount() == 0 || !Matches(*archetype))
+					continue;
+				for (size_t i = 0; i < archetype->GetChunkCount(); ++i)
+				{
+					ArchetypeChunk& chunk = archetype->GetChunk(i);
+					if (!PassesChangeFilter(*archetype, chunk))
+						continue;
+					MarkWrites(*archetype, chunk);
+					func(chunk.GetEntities(), chunk.GetCount(), archetype->template GetColumn<std::remove_const_t<Ts>>(chunk)...);
+				}
+			}
+		}
+
+		// func(Ts&...) 또는 func(Entity, Ts&...)
+		template<typename Func>
+		void ForEach(Func&& func) const
+		{
+			ForEachChunk([&func](Entity* entities, size_t count, Ts*... columns) {
+				ForEachRow(func, entities, count, columns...);
+			});
+		}
+
+		// ForEachChunk와 같지만 매칭된 청크들을 JobSystem 워커에 나누어 병렬로 처리합니다.
+		template<typename Func>
+		void ParallelForEachChunk(Func&& func, size_t chunksPerJob = 1) const
+		{
+			std::vector<std::pair<Archetype*, ArchetypeChunk*>> chunks = CollectChunks(true);
+			const SystemAccess* access = SystemAccess::GetCurrent();
+			JobSystem::GetInstance().ParallelFor(0, chunks.size(), chunksPerJob, [&](size_t first, size_t last) {
+				// 워커 스레드에서도 호출한 시스템의 접근 선언으로 검사되도록 전달합니다.
+				SystemAccess::Scope scope(access);
+				for (size_t i = first; i < last; ++i)
+				{
+					auto [archetype, chunk] = chunks[i];
+					func(chunk->GetEntities(), chunk->GetCount(), archetype->template GetColumn<std::remove_const_t<Ts>>(*chunk)...);
+				}
+			});
+		}
+
+		// ForEach와 같지만 매칭된 청크들을 JobSystem 워커에 나누어 병렬로 처리합니다.
+		// func는 서로 다른 엔티티에 대해 동시에 호출되므로 엔티티 밖의 상태를 쓰면 안 됩니다.
+		template<typename Func>
+		void ParallelForEach(Func&& func, size_t chunksPerJob = 1) const
+		{
+			ParallelForEachChunk([&func](Entity* entities, size_t count, Ts*... columns) {
+				ForEachRow(func, entities, count, columns...);
+			}, chunksPerJob);
+		}
+
+		// ParallelForEach와 같지만 func(Ts&...)는 행을 실제로 수정했는지를 bool로 반환합니다.
+		// 방문한 모든 청크 대신 true를 반환한 행이 있는 청크에만 쓰기 버전을 기록하므로,
+		// 정지한 강체처럼 대부분 그대로인 행이 하위 시스템의 Changed 필터를 통과하지 않습니다.
+		template<typename Func>
+		void ParallelForEachModified(Func&& func, size_t chunksPerJob = 1) const
+		{
+			std::vector<std::pair<Archetype*, ArchetypeChunk*>> chunks = CollectChunks(false);
+			const SystemAccess* access = SystemAccess::GetCurrent();
+			JobSystem::GetInstance().ParallelFor(0, chunks.size(), chunksPerJob, [&](size_t first, size_t last) {
+				SystemAccess::Scope scope(access);
+				for (size_t i = first; i < last; ++i)
+				{
+					auto [archetype, chunk] = chunks[i];
+					if (ModifyRows(func, chunk->GetCount(), archetype->template GetColumn<std::remove_const_t<Ts>>(*chunk)...))
+						MarkWrites(*archetype, *chunk);
+				}
+			});
+		}
+
+		size_t Count() const
+		{
+			size_t count = 0;
+			for (Archetype* archetype : *mArchetypes)
+			{
+				if (Matches(*archetype))
+					count += archetype->GetEntityCount();
+			}
+			return count;
+		}
+
+	private:
+		bool PassesChangeFilter(const Archetype& archetype, const ArchetypeChunk& chunk) const
+		{
+			if (mChangedFilter.empty())
+				return true;
+			for (ComponentType type : mChangedFilter)
+			{
+				if (archetype.GetChangeVersion(type, chunk) > mChangedSince)
+					return true;
+			}
+			return false;
+		}
+
+		// 변경 필터를 통과한 청크 목록. markWrites면 수집하면서 쓰기 버전도 기록합니다.
+		std::vector<std::pair<Archetype*, ArchetypeChunk*>> CollectChunks(bool markWrites) const
+		{
+			std::vector<std::pair<Archetype*, ArchetypeChunk*>> chunks;
+			for (Archetype* archetype : *mArchetypes)
+			{
+				if (archetype->GetEntityCount() == 0 || !Matches(*archetype))
+					continue;
+				for (size_t i = 0; i < archetype->GetChunkCount(); ++i)
+				{
+					ArchetypeChunk& chunk = archetype->GetChunk(i);
+					if (!PassesChangeFilter(*archetype, chunk))
+						continue;
+					if (markWrites)
+						MarkWrites(*archetype, chunk);
+					chunks.emplace_back(archetype, &chunk);
+				}
+			}
+			return chunks;
+		}
+
+		void MarkWrites(Archetype& archetype, ArchetypeChunk& chunk) const
+		{
+			for (ComponentType type : mWriteTypes)
+				archetype.MarkChanged(type, chunk, mWriteVersion);
+		}
+
+		template<typename Func>
+		static void ForEachRow(Func& func, Entity* entities, size_t count, Ts*... columns)
+		{
+			for (size_t row = 0; row < count; ++row)
+			{
+				if constexpr (std::is_invocable_v<Func&, Entity, Ts&...>)
+					func(entities[row], columns[row]...);
+				else
+					func(columns[row]...);
+			}
+		}
+
+		template<typename Func>
+		static bool ModifyRows(Func& func, size_t count, Ts*... columns)
+		{
+			bool modified = false;
+			for (size_t row = 0; row < count; ++row)
+				modified |= static_cast<bool>(func(columns[row]...));
+			return modified;
+		}
+
+		ArchetypeManager* mManager;
+		const std::vector<Archetype*>* mArchetypes;
+		Signature mSignature;
+		std::vector<ComponentType> mWriteTypes;
+		std::vector<ComponentType> mChangedFilter;
+		std::uint64_t mWriteVersion;
+		std::uint64_t mChangedSince;
+	};
+}
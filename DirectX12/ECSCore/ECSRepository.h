@@ -1,37 +1,100 @@
 #pragma once
 #include "ECSEntity.h"
+#include "ECSJobSystem.h"
 
 namespace ECS
 {
+	enum class eLoadState : std::uint8_t
+	{
+		Empty = 0,	// 할당되지 않았거나 해제된 핸들
+		Pending,	// 워커 스레드에서 로드 중
+		Ready,
+		Failed
+	};
+
+	// 리소스 저장소.
+	// 핸들 -> 리소스 테이블은 페이지 단위로 추가만 되는 슬롯 배열이라 슬롯 주소가 바뀌지 않습니다.
+	// 따라서 Get/GetState/IsLoaded는 락 없이 atomic 읽기만 하며, 로드/해제 같은 쓰기만 mtx로 직렬화합니다.
+	// LoadResourceInternal은 mtx 밖에서 호출되므로 느린 로드가 렌더 시스템의 Get()을 막지 않습니다.
+	// 핸들은 1부터 순서대로 발급되고 재사용되지 않습니다. (힙 저장소는 handle - 1을 디스크립터 인덱스로 사용)
 	template<typename T>
 	class IRepository {
 	public:
+		// LoadAsync가 돌려주는 future 형태의 핸들. 핸들은 바로 발급되고 상태가 Pending -> Ready/Failed로 바뀝니다.
+		class LoadFuture {
+		public:
+			LoadFuture() = default;
+
+			RepoHandle GetHandle() const { return mHandle; }
+			eLoadState GetState() const { return mRepository ? mRepository->GetState(mHandle) : eLoadState::Failed; }
+			bool IsReady() const { return GetState() == eLoadState::Ready; }
+			// 로드가 끝날 때까지 기다린 뒤 최종 상태를 돌려줍니다.
+			eLoadState Wait() const { return mRepository ? mRepository->WaitForLoad(mHandle) : eLoadState::Failed; }
+			// 로드가 끝날 때까지 기다린 뒤 리소스를 돌려줍니다. 실패하면 nullptr
+			T* Get() const { return Wait() == eLoadState::Ready ? mRepository->Get(mHandle) : nullptr; }
+
+		private:
+			friend class IRepository;
+			LoadFuture(IRepository* repository, RepoHandle handle) : mRepository(repository), mHandle(handle) {}
+
+			IRepository* mRepository = nullptr;
+			RepoHandle mHandle = 0;
+		};
+
+		eLoadState GetState(RepoHandle handle) const {
+			const Slot* slot = FindSlot(handle);
+			return slot ? slot->State.load(std::memory_order_acquire) : eLoadState::Empty;
+		}
+
 		bool IsLoaded(RepoHandle handle) const {
-			std::lock_guard<std::mutex> lock(mtx);
-			return mResourceStorage.find(handle) != mResourceStorage.end();
+			return GetState(handle) == eLoadState::Ready;
 		}
 
+		// 동기 로드. 같은 이름이 다른 스레드에서 로드 중이면 끝날 때까지 기다립니다.
 		RepoHandle Load(const std::string& name) {
-			std::lock_guard<std::mutex> lock(mtx);
-			auto it = mNameToHandle.find(name);
-			if (it != mNameToHandle.end()) {
-				mResourceStorage[it->second].refCount++;
-				return it->second;
+			RepoHandle handle = 0;
+			bool created = false;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				handle = AcquireByNameLocked(name);
+				if (handle == 0) {
+					handle = ReserveHandleLocked();
+					if (handle == 0)
+						return 0;
+					mNameToHandle[name] = handle;
+					created = true;
+				}
 			}
 
-			auto resource = std::make_unique<T>();
-			if (!LoadResourceInternal(name, resource.get()))
-			{
-				LOG_ERROR("Failed to load resource from name: {}", name);
+			if (created)
+				CompleteLoad(handle, name);
+			if (WaitForLoad(handle) != eLoadState::Ready) {
+				Release(handle);
 				return 0; // Return an invalid handle if loading fails
 			}
-
-			RepoHandle handle = mNextHandle++;
-			mResourceStorage[handle] = { std::move(resource), 1 };
-			mNameToHandle[name] = handle;
 			return handle;
 		}
 
+		// 비동기 로드. 핸들을 바로 발급하고 LoadResourceInternal은 JobSystem 워커에서 실행합니다.
+		// 비동기로 로드하는 저장소의 LoadResourceInternal은 스레드 안전해야 합니다.
+		LoadFuture LoadAsync(const std::string& name) {
+			RepoHandle handle = 0;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				handle = AcquireByNameLocked(name);
+				if (handle != 0)
+					return LoadFuture(this, handle);
+
+				handle = ReserveHandleLocked();
+				if (handle == 0)
+					return LoadFuture();
+				mNameToHandle[name] = handle;
+			}
+
+			JobSystem::GetInstance().Submit([this, handle, name]() { CompleteLoad(handle, name); }, &mLoadCounter);
+			return LoadFuture(this, handle);
+		}
+
 		RepoHandle Load() {
 			auto resource = std::make_unique<T>();
 			if (!LoadResourceInternal(resource.get()))
@@ -42,55 +105,76 @@ namespace ECS
 			RepoHandle handle;
 			{
 				std::lock_guard<std::mutex> lock(mtx);
-				handle = mNextHandle++;
-				mResourceStorage[handle] = { std::move(resource), 1 };
+				handle = ReserveHandleLocked();
 			}
-			
+			if (handle != 0)
+				Publish(handle, std::move(resource));
 			return handle;
 		}
 
+		// 락 없이 조회합니다. 로드 중이거나 실패한 핸들은 nullptr를 돌려줍니다.
 		T* Get(RepoHandle handle) {
-			std::lock_guard<std::mutex> lock(mtx);
-			auto it = mResourceStorage.find(handle);
-			if (it == mResourceStorage.end()) {
+			const Slot* slot = FindSlot(handle);
+			eLoadState state = slot ? slot->State.load(std::memory_order_acquire) : eLoadState::Empty;
+			if (state == eLoadState::Ready)
+				return slot->Resource.load(std::memory_order_relaxed);
+
+			if (state == eLoadState::Empty)
 				LOG_ERROR("Resource with handle {} not found", handle);
-				return nullptr;
-			}
+			return nullptr;
+		}
 
-			// it->second.refCount++;		// 현재는 Unique_ptr와 같이 활용 (혹여 Shared_ptr과 같이 활용하게 되는 시점에 다시 고민할 예정)
-			LOG_VERBOSE("Resource with handle {} accessed, refCount: {}", handle, it->second.refCount);
-			return it->second.resource.get();
+		// Pending이 아닐 때까지 기다린 뒤 상태를 돌려줍니다.
+		eLoadState WaitForLoad(RepoHandle handle) const {
+			const Slot* slot = FindSlot(handle);
+			if (!slot)
+				return eLoadState::Empty;
+			eLoadState state = slot->State.load(std::memory_order_acquire);
+			while (state == eLoadState::Pending) {
+				slot->State.wait(eLoadState::Pending, std::memory_order_acquire);
+				state = slot->State.load(std::memory_order_acquire);
+			}
+			return state;
 		}
 
 		void Release(RepoHandle handle) {
 			std::lock_guard<std::mutex> lock(mtx);
-			auto it = mResourceStorage.find(handle);
-			if (it == mResourceStorage.end()) return;
-
-			UnloadResource();
-			LOG_INFO("Resource with handle {} released, refCount: {}", handle, it->second.refCount);
-			if (--it->second.refCount <= 0) {
-				UnloadResource(handle, it->second.resource);
-				mResourceStorage.erase(it);
-				for (auto nameIt = mNameToHandle.begin(); nameIt != mNameToHandle.end(); ++nameIt) {
-					if (nameIt->second == handle) {
-						mNameToHandle.erase(nameIt);
-						break;
-					}
-				}
-			}
+			Slot* slot = FindSlot(handle);
+			if (!slot || slot->RefCount <= 0) return;
+
+			LOG_INFO("Resource with handle {} released, refCount: {}", handle, slot->RefCount);
+			if (--slot->RefCount > 0)
+				return;
+
+			// 로드 중인 핸들은 기다리지 않고, 워커가 결과를 기록할 때 참조가 0인 것을 보고 해제합니다.
+			if (slot->State.load(std::memory_order_acquire) != eLoadState::Pending)
+				DestroyLocked(handle, *slot);
 		}
 
+		// 진행 중인 비동기 로드를 모두 기다린 뒤 저장소를 비웁니다.
 		void Shutdown() {
+			JobSystem::GetInstance().Wait(mLoadCounter);
 			std::lock_guard<std::mutex> lock(mtx);
-			mResourceStorage.clear();
+			for (RepoHandle handle = 1; handle < mNextHandle; ++handle)
+				DestroySlot(*FindSlot(handle));
 			mNameToHandle.clear();
 			mNextHandle = 1;
 		}
 
 	protected:
 		IRepository() = default;
-		virtual ~IRepository() = default;
+		virtual ~IRepository() {
+			// 가상 함수인 LoadResourceInternal이 파생 클래스 소멸 후 불리지 않도록 Shutdown()을 먼저 호출해야 합니다.
+			assert(mLoadCounter.IsDone() && "Call Shutdown() before destroying a repository with pending loads.");
+			for (auto& page : mPages) {
+				Page* pagePtr = page.load(std::memory_order_relaxed);
+				if (!pagePtr)
+					break;
+				for (Slot& slot : *pagePtr)
+					DestroySlot(slot);
+				delete pagePtr;
+			}
+		}
 		// User-defined behavior
 		virtual bool LoadResourceInternal(const std::string& name, T* ptr)
 		{
@@ -105,21 +189,130 @@ namespace ECS
 			return true;
 		};
 
+		// 참조가 0이 되어 리소스를 파괴하기 직전에 mtx를 잡은 상태로 호출됩니다.
+		// 소멸자 외에 따로 해제할 것이 없는 리소스가 대부분이므로 기본 구현은 아무것도 하지 않고 false를 반환합니다.
 		virtual bool UnloadResource(ECS::RepoHandle handle)
 		{
-			// Default implementation does nothing, can be overridden by derived classes
-			LOG_ERROR("UnloadResource not implemented for type {}", typeid(T).name());
-			return true;
+			return false;
 		}
 
-		struct RepoEntry {
-			std::unique_ptr<T> resource;
-			int refCount = 1;
+		// 이름으로 로드된 핸들을 찾아 참조를 올립니다. 없으면 0 (mtx를 잡은 상태에서 호출)
+		RepoHandle AcquireByNameLocked(const std::string& name) {
+			auto it = mNameToHandle.find(name);
+			if (it == mNameToHandle.end())
+				return 0;
+			++FindSlot(it->second)->RefCount;
+			return it->second;
+		}
+
+		// 새 핸들을 Pending 상태, 참조 1로 발급합니다. (mtx를 잡은 상태에서 호출)
+		RepoHandle ReserveHandleLocked() {
+			std::uint32_t index = mNextHandle - 1;
+			if (index / PAGE_SIZE >= MAX_PAGES) {
+				LOG_ERROR("Repository handle table is full ({} handles)", MAX_PAGES * PAGE_SIZE);
+				return 0;
+			}
+			if (!mPages[index / PAGE_SIZE].load(std::memory_order_relaxed))
+				mPages[index / PAGE_SIZE].store(new Page(), std::memory_order_release);
+
+			RepoHandle handle = mNextHandle++;
+			Slot& slot = *FindSlot(handle);
+			slot.RefCount = 1;
+			slot.State.store(eLoadState::Pending, std::memory_order_release);
+			return handle;
+		}
+
+		// 리소스를 슬롯에 기록하고 Ready로 공개합니다. 공개 이후에는 락 없는 Get()으로 보입니다.
+		void Publish(RepoHandle handle, std::unique_ptr<T> resource) {
+			Slot& slot = *FindSlot(handle);
+			slot.Resource.store(resource.release(), std::memory_order_relaxed);
+			slot.State.store(eLoadState::Ready, std::memory_order_release);
+			slot.State.notify_all();
+		}
+
+	private:
+		static constexpr std::uint32_t PAGE_SIZE = 256;
+		static constexpr std::uint32_t MAX_PAGES = 4096;
+
+		struct Slot {
+			std::atomic<T*> Resource{ nullptr };
+			std::atomic<eLoadState> State{ eLoadState::Empty };
+			int RefCount = 0;	// mtx로 보호
 		};
+		using Page = std::array<Slot, PAGE_SIZE>;
+
+		Slot* FindSlot(RepoHandle handle) const {
+			if (handle == 0)
+				return nullptr;
+			std::uint32_t index = handle - 1;
+			if (index / PAGE_SIZE >= MAX_PAGES)
+				return nullptr;
+			Page* page = mPages[index / PAGE_SIZE].load(std::memory_order_acquire);
+			return page ? &(*page)[index % PAGE_SIZE] : nullptr;
+		}
 
+		// 로더가 예외를 던져도 슬롯을 Failed로 바꾸고 깨워야, 기다리는 스레드가 Pending에 영원히 묶이지 않습니다.
+		void CompleteLoad(RepoHandle handle, const std::string& name) {
+			std::unique_ptr<T> resource;
+			bool loaded = false;
+			try {
+				resource = std::make_unique<T>();
+				loaded = LoadResourceInternal(name, resource.get());
+				if (!loaded)
+					LOG_ERROR("Failed to load resource from name: {}", name);
+			}
+			catch (const std::exception& e) {
+				LOG_ERROR("Exception while loading resource {}: {}", name, e.what());
+			}
+			catch (...) {
+				LOG_ERROR("Unknown exception while loading resource {}", name);
+			}
+
+			std::lock_guard<std::mutex> lock(mtx);
+			Slot& slot = *FindSlot(handle);
+			if (loaded) {
+				Publish(handle, std::move(resource));
+			}
+			else {
+				// 실패한 이름은 매핑에서 지워 다음 Load가 다시 시도할 수 있게 합니다.
+				EraseNameLocked(handle);
+				slot.State.store(eLoadState::Failed, std::memory_order_release);
+				slot.State.notify_all();
+			}
+
+			// 로드 중에 모든 참조가 해제된 경우
+			if (slot.RefCount == 0)
+				DestroyLocked(handle, slot);
+		}
+
+		void DestroyLocked(RepoHandle handle, Slot& slot) {
+			if (slot.State.load(std::memory_order_acquire) == eLoadState::Ready)
+				UnloadResource(handle);
+			DestroySlot(slot);
+			EraseNameLocked(handle);
+		}
+
+		static void DestroySlot(Slot& slot) {
+			slot.State.store(eLoadState::Empty, std::memory_order_release);
+			delete slot.Resource.exchange(nullptr, std::memory_order_acq_rel);
+			slot.RefCount = 0;
+		}
+
+		void EraseNameLocked(RepoHandle handle) {
+			for (auto nameIt = mNameToHandle.begin(); nameIt != mNameToHandle.end(); ++nameIt) {
+				if (nameIt->second == handle) {
+					mNameToHandle.erase(nameIt);
+					break;
+				}
+			}
+		}
+
+		mutable std::array<std::atomic<Page*>, MAX_PAGES> mPages{};
+		JobCounter mLoadCounter;
+
+	protected:
 		mutable std::mutex mtx;
 		std::unordered_map<std::string, RepoHandle> mNameToHandle;
-		std::unordered_map<RepoHandle, RepoEntry> mResourceStorage;
 		RepoHandle mNextHandle = 1;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,399 @@
+#pragma once
+#include "ECSEntity.h"
+#include "ECSArchetype.h"
+#include "TimeComponent.h"
+#include <fstream>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ECS
+{
+	// 읽기 전용 메모리 맵 파일
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& filePath)
+		{
+			Close();
+#ifdef _WIN32
+			mFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (mFile == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+			{
+				Close();
+				return false;
+			}
+			mSize = static_cast<size_t>(size.QuadPart);
+			mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mMapping)
+			{
+				Close();
+				return false;
+			}
+			mData = static_cast<const std::byte*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+#else
+			int fd = open(filePath.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat status;
+			if (fstat(fd, &status) != 0 || status.st_size == 0)
+			{
+				close(fd);
+				return false;
+			}
+			mSize = static_cast<size_t>(status.st_size);
+			void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			mData = data == MAP_FAILED ? nullptr : static_cast<const std::byte*>(data);
+#endif
+			if (!mData)
+			{
+				Close();
+				return false;
+			}
+			return true;
+		}
+
+		void Close()
+		{
+#ifdef _WIN32
+			if (mData)
+				UnmapViewOfFile(mData);
+			if (mMapping)
+				CloseHandle(mMapping);
+			if (mFile != INVALID_HANDLE_VALUE)
+				CloseHandle(mFile);
+			mMapping = nullptr;
+			mFile = INVALID_HANDLE_VALUE;
+#else
+			if (mData)
+				munmap(const_cast<std::byte*>(mData), mSize);
+#endif
+			mData = nullptr;
+			mSize = 0;
+		}
+
+		const std::byte* GetData() const { return mData; }
+		size_t GetSize() const { return mSize; }
+
+	private:
+		const std::byte* mData = nullptr;
+		size_t mSize = 0;
+#ifdef _WIN32
+		HANDLE mFile = INVALID_HANDLE_VALUE;
+		HANDLE mMapping = nullptr;
+#endif
+	};
+
+	// 바이너리 월드 스냅샷.
+	// 아키타입마다 컴포넌트 컬럼을 통째로 기록하므로 로드는 엔티티 ID 발급과 청크 단위 memcpy만으로 끝납니다.
+	//
+	// 파일 구조 (리틀 엔디언, 모든 블록은 SNAPSHOT_ALIGNMENT 정렬)
+	//   SnapshotHeader
+	//   SnapshotComponentType x ComponentTypeCount   : 저장 당시 컴포넌트 타입 테이블 (파일 내 타입 ID = 인덱스)
+	//   { SnapshotArchetype, 컬럼 0 [Size * EntityCount], 컬럼 1, ... } x ArchetypeCount
+	//     컬럼은 시그니처 비트가 낮은 타입부터 순서대로 기록됩니다.
+	//
+	// trivially copyable 컴포넌트만 raw 메모리로 기록합니다. 그 외 컴포넌트는 스냅샷에서 제외되며
+	// 디버깅용 JSON 덤프(Coordinator::SaveWorldToJson)에서만 확인할 수 있습니다.
+	// 엔티티 ID와 공유 컴포넌트는 저장하지 않으며, 로드 시 새 ID가 발급됩니다.
+	class WorldSnapshot
+	{
+	public:
+		static constexpr std::uint32_t MAGIC = 0x57534345; // "ECSW"
+		static constexpr std::uint32_t VERSION = 1;
+		static constexpr size_t SNAPSHOT_ALIGNMENT = 16;
+		static constexpr size_t MAX_NAME_LENGTH = 64;
+		static_assert(MAX_COMPONENTS <= 64, "Snapshot stores signatures as 64-bit masks.");
+
+		struct SnapshotHeader
+		{
+			std::uint32_t Magic;
+			std::uint32_t Version;
+			std::uint32_t ComponentTypeCount;
+			std::uint32_t ArchetypeCount;
+			std::uint64_t EntityCount;
+			float DeltaTime;
+			float TotalTime;
+			float FixedDeltaTime;
+			std::uint32_t Padding;
+		};
+
+		struct SnapshotComponentType
+		{
+			char Name[MAX_NAME_LENGTH];
+			std::uint32_t Size;
+			std::uint32_t Alignment;
+		};
+
+		struct SnapshotArchetype
+		{
+			std::uint64_t Signature;
+			std::uint64_t EntityCount;
+		};
+
+		static bool Save(const std::string& filePath, ArchetypeManager& archetypeManager, const TimeComponent& time)
+		{
+			std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				LOG_ERROR("Failed to open world snapshot for writing: {}", filePath);
+				return false;
+			}
+
+			// 1. 타입 테이블. trivially copyable이 아닌 타입은 기록하지 않습니다.
+			std::vector<SnapshotComponentType> types;
+			Signature savable;
+			for (ComponentType type = 0; type < archetypeManager.GetComponentTypeCount(); ++type)
+			{
+				const ComponentInfo& info = archetypeManager.GetComponentInfo(type);
+				SnapshotComponentType entry{};
+				std::strncpy(entry.Name, info.Name, MAX_NAME_LENGTH - 1);
+				entry.Size = static_cast<std::uint32_t>(info.Size);
+				entry.Alignment = static_cast<std::uint32_t>(info.Alignment);
+				types.push_back(entry);
+				if (info.TriviallyCopyable)
+					savable.set(type);
+				else
+					LOG_WARN("World snapshot skips non-trivially-copyable component: {}", info.Name);
+			}
+
+			std::vector<Archetype*> archetypes;
+			std::uint64_t entityCount = 0;
+			for (Archetype* archetype : archetypeManager.GetArchetypes())
+			{
+				if (archetype->GetEntityCount() == 0 || (archetype->GetSignature() & savable).none())
+					continue;
+				archetypes.push_back(archetype);
+				entityCount += archetype->GetEntityCount();
+			}
+
+			SnapshotHeader header{};
+			header.Magic = MAGIC;
+			header.Version = VERSION;
+			header.ComponentTypeCount = static_cast<std::uint32_t>(types.size());
+			header.ArchetypeCount = static_cast<std::uint32_t>(archetypes.size());
+			header.EntityCount = entityCount;
+			header.DeltaTime = time.deltaTime;
+			header.TotalTime = time.totalTime;
+			header.FixedDeltaTime = time.fixedDeltaTime;
+
+			size_t offset = 0;
+			Write(file, offset, &header, sizeof(header));
+			Write(file, offset, types.data(), sizeof(SnapshotComponentType) * types.size());
+
+			// 2. 아키타입별 컬럼. 청크 안의 컬럼은 이미 연속 메모리이므로 청크마다 한 번씩 씁니다.
+			for (Archetype* archetype : archetypes)
+			{
+				Signature signature = archetype->GetSignature() & savable;
+				SnapshotArchetype block{ signature.to_ullong(), archetype->GetEntityCount() };
+				Pad(file, offset);
+				Write(file, offset, &block, sizeof(block));
+
+				for (ComponentType type = 0; type < types.size(); ++type)
+				{
+					if (!signature.test(type))
+						continue;
+					Pad(file, offset);
+					size_t size = archetypeManager.GetComponentInfo(type).Size;
+					for (size_t i = 0; i < archetype->GetChunkCount(); ++i)
+					{
+						ArchetypeChunk& chunk = archetype->GetChunk(i);
+						Write(file, offset, archetype->GetColumnPtr(type, chunk), size * chunk.GetCount());
+					}
+				}
+			}
+
+			if (!file)
+			{
+				LOG_ERROR("Failed to write world snapshot: {}", filePath);
+				return false;
+			}
+			return true;
+		}
+
+		// 파일 전체를 검증한 뒤 기존 엔티티를 모두 파괴하고 스냅샷의 엔티티를 생성합니다.
+		// 이름이 같고 크기가 일치하는 등록된 컴포넌트만 복원하며, 나머지 컬럼은 건너뜁니다.
+		static bool Load(const std::string& filePath, EntityManager& entityManager, ArchetypeManager& archetypeManager, TimeComponent& time)
+		{
+			MappedFile file;
+			if (!file.Open(filePath))
+			{
+				LOG_ERROR("Failed to open world snapshot: {}", filePath);
+				return false;
+			}
+
+			const std::byte* data = file.GetData();
+			const size_t fileSize = file.GetSize();
+			size_t offset = 0;
+
+			const SnapshotHeader* header = Read<SnapshotHeader>(data, fileSize, offset, 1);
+			if (!header || header->Magic != MAGIC || header->Version != VERSION)
+			{
+				LOG_ERROR("Invalid world snapshot header: {}", filePath);
+				return false;
+			}
+			if (header->ComponentTypeCount > MAX_COMPONENTS)
+			{
+				LOG_ERROR("Invalid world snapshot type table: {}", filePath);
+				return false;
+			}
+			const SnapshotComponentType* types = Read<SnapshotComponentType>(data, fileSize, offset, header->ComponentTypeCount);
+			if (!types)
+			{
+				LOG_ERROR("Invalid world snapshot type table: {}", filePath);
+				return false;
+			}
+			for (std::uint32_t fileType = 0; fileType < header->ComponentTypeCount; ++fileType)
+			{
+				if (types[fileType].Size == 0)
+				{
+					LOG_ERROR("Invalid world snapshot type table: {}", filePath);
+					return false;
+				}
+			}
+
+			// 1. 블록 검증. 월드를 지우기 전에 모든 블록의 시그니처와 컬럼 크기를 남은 파일 크기와 대조하므로
+			//    손상되거나 잘린 파일은 기존 월드를 건드리지 않고 실패합니다.
+			std::vector<const SnapshotArchetype*> blocks;
+			std::vector<const std::byte*> columns;
+			const std::uint64_t validTypeMask = header->ComponentTypeCount == 64 ? ~0ull : (1ull << header->ComponentTypeCount) - 1;
+			for (std::uint32_t i = 0; i < header->ArchetypeCount; ++i)
+			{
+				offset = Align(offset);
+				const SnapshotArchetype* block = Read<SnapshotArchetype>(data, fileSize, offset, 1);
+				if (!block || (block->Signature & ~validTypeMask) != 0)
+				{
+					LOG_ERROR("Corrupt world snapshot archetype block: {}", filePath);
+					return false;
+				}
+				blocks.push_back(block);
+
+				std::bitset<64> fileSignature(block->Signature);
+				for (std::uint32_t fileType = 0; fileType < header->ComponentTypeCount; ++fileType)
+				{
+					if (!fileSignature.test(fileType))
+						continue;
+					offset = Align(offset);
+					const std::byte* column = ReadColumn(data, fileSize, offset, types[fileType].Size, block->EntityCount);
+					if (!column)
+					{
+						LOG_ERROR("Truncated world snapshot: {}", filePath);
+						return false;
+					}
+					columns.push_back(column);
+				}
+			}
+
+			// 2. 파일 내 타입 ID -> 현재 등록된 타입 ID
+			std::array<ComponentType, MAX_COMPONENTS> remap;
+			remap.fill(INVALID_TYPE);
+			for (std::uint32_t fileType = 0; fileType < header->ComponentTypeCount; ++fileType)
+			{
+				std::string name(types[fileType].Name, strnlen(types[fileType].Name, MAX_NAME_LENGTH));
+				for (ComponentType type = 0; type < archetypeManager.GetComponentTypeCount(); ++type)
+				{
+					const ComponentInfo& info = archetypeManager.GetComponentInfo(type);
+					if (name != info.Name)
+						continue;
+					if (info.Size == types[fileType].Size && info.TriviallyCopyable)
+						remap[fileType] = type;
+					else
+						LOG_WARN("World snapshot component layout changed, skipping: {}", name);
+					break;
+				}
+			}
+
+			archetypeManager.RemoveAllEntities();
+			entityManager.DestroyAllEntities();
+			time.deltaTime = header->DeltaTime;
+			time.totalTime = header->TotalTime;
+			time.fixedDeltaTime = header->FixedDeltaTime;
+
+			// 3. 아키타입마다 엔티티를 한 번에 만들고 검증된 컬럼을 청크 단위로 복사합니다.
+			std::vector<Entity> entities;
+			size_t nextColumn = 0;
+			for (const SnapshotArchetype* block : blocks)
+			{
+				std::bitset<64> fileSignature(block->Signature);
+				Signature signature;
+				for (std::uint32_t fileType = 0; fileType < header->ComponentTypeCount; ++fileType)
+				{
+					if (fileSignature.test(fileType) && remap[fileType] != INVALID_TYPE)
+						signature.set(remap[fileType]);
+				}
+
+				const size_t count = static_cast<size_t>(block->EntityCount);
+				ComponentHandle first = 0;
+				Archetype* archetype = nullptr;
+				if (signature.any())
+				{
+					entities.resize(count);
+					for (size_t e = 0; e < count; ++e)
+					{
+						entities[e] = entityManager.CreateEntity();
+						entityManager.SetSignature(entities[e], signature);
+					}
+					archetype = archetypeManager.FindOrCreateArchetype(signature, 0);
+					first = archetypeManager.MoveEntities(entities.data(), count, nullptr, archetype);
+				}
+
+				for (std::uint32_t fileType = 0; fileType < header->ComponentTypeCount; ++fileType)
+				{
+					if (!fileSignature.test(fileType))
+						continue;
+					const std::byte* column = columns[nextColumn++];
+					if (archetype && remap[fileType] != INVALID_TYPE)
+						archetype->CopyColumnFrom(remap[fileType], first, column, count);
+				}
+			}
+			return true;
+		}
+
+	private:
+		static constexpr ComponentType INVALID_TYPE = std::numeric_limits<ComponentType>::max();
+
+		static size_t Align(size_t offset) { return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1); }
+
+		static void Write(std::ofstream& file, size_t& offset, const void* data, size_t size)
+		{
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			offset += size;
+		}
+
+		static void Pad(std::ofstream& file, size_t& offset)
+		{
+			static constexpr char zeros[SNAPSHOT_ALIGNMENT] = {};
+			Write(file, offset, zeros, Align(offset) - offset);
+		}
+
+		template<typename T>
+		static const T* Read(const std::byte* data, size_t fileSize, size_t& offset, size_t count)
+		{
+			return reinterpret_cast<const T*>(ReadColumn(data, fileSize, offset, sizeof(T), count));
+		}
+
+		// elementSize * count 바이트를 읽습니다. 곱셈 대신 나눗셈으로 남은 크기와 비교하므로 파일에 기록된 개수가 커도 넘치지 않습니다.
+		static const std::byte* ReadColumn(const std::byte* data, size_t fileSize, size_t& offset, size_t elementSize, std::uint64_t count)
+		{
+			if (offset > fileSize || count > (fileSize - offset) / elementSize)
+				return nullptr;
+			const std::byte* result = data + offset;
+			offset += elementSize * static_cast<size_t>(count);
+			return result;
+		}
+	};
+}
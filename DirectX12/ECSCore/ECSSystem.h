@@ -1,15 +1,29 @@
 #pragma once
 #include "ECSConfig.h"
-#include <future>
+#include "ECSJobSystem.h"
+#include "ECSSystemAccess.h"
+#include "ECSQuery.h"
 
 namespace ECS
 {
 	class Coordinator;
 
+	enum class eSystemPhase : std::uint8_t
+	{
+		BeginPlay = 0,
+		Sync,
+		PreUpdate,
+		Update,
+		LateUpdate,
+		FixedUpdate,
+		FinalUpdate,
+		EndPlay,
+		Count
+	};
+
 	class ISystem
 	{
 	public:
-		std::set<Entity> mEntities;
 		virtual void BeginPlay() {}
 		virtual void EndPlay() {}
 
@@ -19,8 +33,26 @@ namespace ECS
 		virtual void LateUpdate() {}
 		virtual void FixedUpdate() {}
 		virtual void FinalUpdate() {}
+
+		// 이 시스템이 읽고 쓰는 컴포넌트를 선언합니다. 재정의하지 않으면 다른 시스템과 병렬 실행되지 않습니다.
+		virtual void DeclareAccess(SystemAccess& access) {}
 		
 		virtual ~ISystem() = default;
+
+	protected:
+		// 시스템 시그니처에 매칭된 아키타입 캐시 위에서 Ts...를 순회하는 쿼리 (ECSCoordinator.h에서 정의)
+		template<typename... Ts>
+		EntityQuery<Ts...> Query();
+
+	private:
+		friend class SystemManager;
+		QueryCache mQueryCache;
+
+		// 변경 추적 버전. 페이즈마다 따로 두어 한 페이즈의 실행이 다른 페이즈가 봐야 할 변경을 소비하지 않게 합니다.
+		// mRunVersion: 현재 실행 중 쓰기 접근에 기록되는 버전, mLastRunVersion: 같은 페이즈의 직전 실행 버전
+		std::array<std::uint64_t, static_cast<size_t>(eSystemPhase::Count)> mPhaseVersions{};
+		std::uint64_t mRunVersion = 0;
+		std::uint64_t mLastRunVersion = 0;
 	};
 
 	class SystemManager
@@ -36,15 +68,8 @@ namespace ECS
 			// Create a pointer to the system and return it so it can be used externally
 			auto system = std::make_shared<T>();
 			mSystems.insert({ type, system });
-			mSystemBeginPlayTasks[type] = [system]() { system->BeginPlay(); };
-			mSystemEndPlayTasks[type] = [system]() { system->EndPlay(); };
-
-			mSystemSyncTasks[type] = [system]() { system->Sync(); };
-			mSystemPreUpdateTasks[type] = [system]() { system->PreUpdate(); };
-			mSystemUpdateTasks[type] = [system]() { system->Update(); };
-			mSystemLateUpdateTasks[type] = [system]() { system->LateUpdate(); };
-			mSystemFixedUpdateTasks[type] = [system]() { system->FixedUpdate(); };
-			mSystemFinalUpdateTasks[type] = [system]() { system->FinalUpdate(); };
+			mSystemEntries.push_back({ system, SystemAccess{} });
+			mPhaseGraphsDirty = true;
 
 			return system;
 		}
@@ -57,123 +82,98 @@ namespace ECS
 			assert(mSystems.find(type) != mSystems.end() && "System used before registered.");
 
 			// Set the signature for this system
-			mSignatures.insert({ type, signature });
+			mSystems[type]->mQueryCache.SetSignature(signature);
 		}
 
-		void EntityDestroyed(Entity entity)
+		template<typename T>
+		void SetAccess(const SystemAccess& access)
 		{
-			// Erase a destroyed entity from all system lists
-			// mEntities is a set so no check needed
-			for (auto const& pair : mSystems)
-			{
-				auto const& system = pair.second;
+			auto system = mSystems.find(std::type_index(typeid(T)));
+			assert(system != mSystems.end() && "System used before registered.");
 
-				system->mEntities.erase(entity);
+			for (auto& entry : mSystemEntries)
+			{
+				if (entry.System == system->second)
+					entry.Access = access;
 			}
+			mPhaseGraphsDirty = true;
 		}
 
-		void EntitySignatureChanged(Entity entity, Signature entitySignature)
+		inline void BeginPlayAllSystems() { RunPhase(eSystemPhase::BeginPlay); }
+		inline void SyncAllSystems() { RunPhase(eSystemPhase::Sync); }
+		inline void PreUpdateAllSystems() { RunPhase(eSystemPhase::PreUpdate); }
+		inline void UpdateAllSystems() { RunPhase(eSystemPhase::Update); }
+		inline void LateUpdateAllSystems() { RunPhase(eSystemPhase::LateUpdate); }
+		inline void FixedUpdateAllSystems() { RunPhase(eSystemPhase::FixedUpdate); }
+		inline void FinalUpdateAllSystems() { RunPhase(eSystemPhase::FinalUpdate); }
+		inline void EndPlayAllSystems() { RunPhase(eSystemPhase::EndPlay); }
+
+	private:
+		struct SystemEntry
+		{
+			std::shared_ptr<ISystem> System;
+			SystemAccess Access;
+		};
+
+		static void InvokePhase(ISystem& system, eSystemPhase phase)
 		{
-			// Notify each system that an entity's signature changed
-			for (auto const& pair : mSystems)
+			std::uint64_t& phaseVersion = system.mPhaseVersions[static_cast<size_t>(phase)];
+			system.mLastRunVersion = phaseVersion;
+			system.mRunVersion = phaseVersion = ChangeVersion::Next();
+
+			switch (phase)
 			{
-				auto const& type = pair.first;
-				auto const& system = pair.second;
-				auto const& systemSignature = mSignatures[type];
+			case eSystemPhase::BeginPlay:	system.BeginPlay(); break;
+			case eSystemPhase::Sync:		system.Sync(); break;
+			case eSystemPhase::PreUpdate:	system.PreUpdate(); break;
+			case eSystemPhase::Update:		system.Update(); break;
+			case eSystemPhase::LateUpdate:	system.LateUpdate(); break;
+			case eSystemPhase::FixedUpdate:	system.FixedUpdate(); break;
+			case eSystemPhase::FinalUpdate:	system.FinalUpdate(); break;
+			case eSystemPhase::EndPlay:		system.EndPlay(); break;
+			default: break;
+			}
+			system.mRunVersion = system.mLastRunVersion = 0;
+		}
 
-				if ((entitySignature & systemSignature) == systemSignature)
-				{
-					system->mEntities.insert(entity);
-				}
-				else
+		// 페이즈마다 시스템을 노드로 하는 DAG를 만듭니다.
+		// 등록 순서상 앞선 시스템과 접근이 충돌하면 간선을 추가하여 직렬화하고, 그 외에는 병렬로 실행됩니다.
+		void BuildPhaseGraphs()
+		{
+			for (size_t phaseIndex = 0; phaseIndex < mPhaseGraphs.size(); ++phaseIndex)
+			{
+				eSystemPhase phase = static_cast<eSystemPhase>(phaseIndex);
+				TaskGraph& graph = mPhaseGraphs[phaseIndex];
+				graph.Clear();
+				for (size_t i = 0; i < mSystemEntries.size(); ++i)
 				{
-					system->mEntities.erase(entity);
+					const SystemEntry* entry = &mSystemEntries[i];
+					graph.AddTask([entry, phase]() {
+						SystemAccess::Scope scope(entry->Access.IsDeclared() ? &entry->Access : nullptr);
+						InvokePhase(*entry->System, phase);
+					});
+					for (size_t j = 0; j < i; ++j)
+					{
+						if (mSystemEntries[j].Access.ConflictsWith(entry->Access))
+							graph.AddDependency(j, i);
+					}
 				}
 			}
+			mPhaseGraphsDirty = false;
 		}
 
-		inline void BeginPlayAllSystems()
+		// 매 프레임 스레드를 생성/join하던 std::async 대신 영구 워커 풀에서 페이즈 그래프를 실행합니다.
+		void RunPhase(eSystemPhase phase)
 		{
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemBeginPlayTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
-		}
-		inline void SyncAllSystems() {
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemSyncTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
-		}
-		inline void PreUpdateAllSystems() {
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemPreUpdateTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
-		}
-		inline void UpdateAllSystems() {
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemUpdateTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			// get은 순차적으로 처리
-			for (auto& fut : futures)
-				fut.get();
-			// {
-			// 	try {
-			// 		fut.get();
-			// 	}
-			// 	catch (const std::exception& e) {
-			// 		LOG_ERROR("Exception in system task: {}", e.what());
-			// 	}
-			// 	catch (...) {
-			// 		LOG_ERROR("Unknown exception in system task");
-			// 	}
-			// }
-		}
-		inline void LateUpdateAllSystems() {
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemLateUpdateTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
-		}
-		inline void FixedUpdateAllSystems() {
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemFixedUpdateTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
-		}
-		inline void FinalUpdateAllSystems() {
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemFinalUpdateTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
-		}
-		inline void EndPlayAllSystems()
-		{
-			std::vector<std::future<void>> futures;
-			for (auto& [_, task] : mSystemEndPlayTasks)
-				futures.emplace_back(std::async(std::launch::async, task));
-			for (auto& fut : futures)
-				fut.get();
+			if (mPhaseGraphsDirty)
+				BuildPhaseGraphs();
+			mPhaseGraphs[static_cast<size_t>(phase)].Run();
 		}
 
-	private:
-		std::unordered_map<std::type_index, Signature> mSignatures{};
 		std::unordered_map<std::type_index, std::shared_ptr<ISystem>> mSystems{};
 
-		std::unordered_map<std::type_index, std::function<void()>> mSystemBeginPlayTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemSyncTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemPreUpdateTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemUpdateTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemLateUpdateTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemFixedUpdateTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemFinalUpdateTasks;
-		std::unordered_map<std::type_index, std::function<void()>> mSystemEndPlayTasks;
+		std::vector<SystemEntry> mSystemEntries;
+		std::array<TaskGraph, static_cast<size_t>(eSystemPhase::Count)> mPhaseGraphs;
+		bool mPhaseGraphsDirty = true;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include "ECSConfig.h"
+
+namespace ECS
+{
+	// 시스템이 읽고 쓰는 컴포넌트/싱글턴 컴포넌트 목록.
+	// SystemManager는 이 선언을 보고 같은 페이즈 안에서 충돌하지 않는 시스템은 병렬로,
+	// 충돌하는 시스템은 등록 순서대로 직렬 실행되도록 의존 그래프를 만듭니다.
+	//
+	// 사용 예:
+	//   void DeclareAccess(ECS::SystemAccess& access) override {
+	//       access.Write<TransformComponent>().Read<RigidBodyComponent>().ReadSingleton<TimeComponent>();
+	//   }
+	class SystemAccess
+	{
+	public:
+		// 컴포넌트 타입 ID가 필요하므로 ECSCoordinator.h에서 정의합니다.
+		template<typename T> SystemAccess& Read();
+		template<typename T> SystemAccess& Write();
+
+		SystemAccess& ReadType(ComponentType type)
+		{
+			mDeclared = true;
+			mReads.set(type);
+			return *this;
+		}
+		SystemAccess& WriteType(ComponentType type)
+		{
+			mDeclared = true;
+			mWrites.set(type);
+			return *this;
+		}
+
+		// 어떤 컴포넌트에도 접근하지 않는 시스템임을 선언합니다. 다른 모든 시스템과 병렬로 실행될 수 있습니다.
+		SystemAccess& None()
+		{
+			mDeclared = true;
+			return *this;
+		}
+
+		template<typename T>
+		SystemAccess& ReadSingleton()
+		{
+			mDeclared = true;
+			mSingletonReads.emplace_back(typeid(T));
+			return *this;
+		}
+		template<typename T>
+		SystemAccess& WriteSingleton()
+		{
+			mDeclared = true;
+			mSingletonWrites.emplace_back(typeid(T));
+			return *this;
+		}
+
+		// DeclareAccess를 재정의하지 않은 시스템은 무엇을 건드리는지 알 수 없으므로 다른 모든 시스템과 충돌합니다.
+		bool IsDeclared() const { return mDeclared; }
+		const Signature& GetReads() const { return mReads; }
+		const Signature& GetWrites() const { return mWrites; }
+
+		bool CanRead(ComponentType type) const { return mReads.test(type) || mWrites.test(type); }
+		bool CanWrite(ComponentType type) const { return mWrites.test(type); }
+		bool CanReadSingleton(std::type_index type) const { return Contains(mSingletonReads, type) || Contains(mSingletonWrites, type); }
+		bool CanWriteSingleton(std::type_index type) const { return Contains(mSingletonWrites, type); }
+
+		bool ConflictsWith(const SystemAccess& other) const
+		{
+			if (!mDeclared || !other.mDeclared)
+				return true;
+			if ((mWrites & (other.mReads | other.mWrites)).any() || (other.mWrites & mReads).any())
+				return true;
+			return Overlaps(mSingletonWrites, other.mSingletonReads) || Overlaps(mSingletonWrites, other.mSingletonWrites)
+				|| Overlaps(other.mSingletonWrites, mSingletonReads);
+		}
+
+		// 현재 스레드에서 실행 중인 시스템의 접근 선언 (ECS_ACCESS_CHECK 검사용)
+		static const SystemAccess* GetCurrent() { return tCurrent; }
+
+		class Scope
+		{
+		public:
+			explicit Scope(const SystemAccess* access) : mPrevious(tCurrent) { tCurrent = access; }
+			~Scope() { tCurrent = mPrevious; }
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+		private:
+			const SystemAccess* mPrevious;
+		};
+
+	private:
+		static bool Contains(const std::vector<std::type_index>& types, std::type_index type)
+		{
+			return std::find(types.begin(), types.end(), type) != types.end();
+		}
+		static bool Overlaps(const std::vector<std::type_index>& lhs, const std::vector<std::type_index>& rhs)
+		{
+			for (const auto& type : lhs)
+			{
+				if (std::find(rhs.begin(), rhs.end(), type) != rhs.end())
+					return true;
+			}
+			return false;
+		}
+
+		bool mDeclared = false;
+		Signature mReads;
+		Signature mWrites;
+		std::vector<std::type_index> mSingletonReads;
+		std::vector<std::type_index> mSingletonWrites;
+
+		inline static thread_local const SystemAccess* tCurrent = nullptr;
+	};
+}
@@ -27,13 +27,15 @@ public:
 		sSystem->release();
     }
     
+    void DeclareAccess(ECS::SystemAccess& access) override {
+        access.Read<FMODAudioComponent>();
+    }
+
     void Update() override {
-        auto& coordinator = ECS::Coordinator::GetInstance();
         sSystem->update();
-        for (ECS::Entity entity : mEntities) {
-            auto& component = coordinator.GetComponent<FMODAudioComponent>(entity);
+        Query<const FMODAudioComponent>().ForEach([](const FMODAudioComponent& component) {
             FMODAudioRepository::Play(component.handle, component.volume);
-        }
+        });
     }
 
 private:
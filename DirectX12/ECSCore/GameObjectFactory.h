@@ -24,7 +24,7 @@ public:
         }
         // ...
         LOG_WARN("Unknown game object type requested: {}", objectType);
-        return 0; // Invalid Entity
+        return ECS::INVALID_ENTITY;
     }
 
 private:
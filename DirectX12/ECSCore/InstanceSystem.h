@@ -4,18 +4,15 @@
 
 class InstanceSystem : public ECS::ISystem {
 public:
+	// 인스턴스 데이터는 DX12_SceneSystem이 직접 관리하므로 아직 이 시스템이 접근하는 컴포넌트는 없습니다.
+	void DeclareAccess(ECS::SystemAccess& access) override {
+		access.None();
+	}
+
 	void Update() override {
-		auto& coordinator = ECS::Coordinator::GetInstance();
-		for (ECS::Entity entity : mEntities) {
-			auto& rb = coordinator.GetComponent<InstanceComponent>(entity);
-		}
 	}
 
 	void FinalUpdate() override {
-		auto& coordinator = ECS::Coordinator::GetInstance();
-		for (ECS::Entity entity : mEntities) {
-
-		}
 	}
 
 private:
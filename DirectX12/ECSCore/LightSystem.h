@@ -4,14 +4,16 @@
 
 class LightSystem : public ECS::ISystem {
 public:
+    void DeclareAccess(ECS::SystemAccess& access) override {
+        access.Write<LightComponent>();
+    }
+
     void Update() override {
-        auto& coordinator = ECS::Coordinator::GetInstance();
-        for (ECS::Entity entity : mEntities) {
-            auto& light = coordinator.GetComponent<LightComponent>(entity);
+        Query<LightComponent>().ForEach([](LightComponent& light) {
 
             // 1. Light의 위치나 방향 변화 반영
             // 2. ShadowComponent 생성 or 제거
             // 3. GPU 버퍼로 빌드
-        }
+        });
     }
 };
\ No newline at end of file
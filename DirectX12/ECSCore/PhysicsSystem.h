@@ -6,51 +6,57 @@
 
 class PhysicsSystem : public ECS::ISystem {
 public:
+	void DeclareAccess(ECS::SystemAccess& access) override {
+		access.Write<TransformComponent>().Write<RigidBodyComponent>().Read<GravityComponent>().ReadSingleton<TimeComponent>();
+	}
+
+	// 가속도와 중력이 모두 없는 강체는 속도가 그대로이므로 그런 행만 있는 청크에는 변경 버전을 남기지 않습니다.
 	void Update() override {
 		auto& coordinator = ECS::Coordinator::GetInstance();
-		const auto& time = coordinator.GetSingletonComponent<TimeComponent>();
-		for (ECS::Entity entity : mEntities) {
-			auto& rigidBody = coordinator.GetComponent<RigidBodyComponent>(entity);
-			if (rigidBody.Acceleration.x == 0.0f && rigidBody.Acceleration.y == 0.0f && rigidBody.Acceleration.z &&
-				rigidBody.AngularAcceleration.x == 0.0f && rigidBody.AngularAcceleration.y == 0.0f && rigidBody.AngularAcceleration.z)
-				continue;
-
-			rigidBody.Velocity.x += rigidBody.Acceleration.x * time.deltaTime;
-			rigidBody.Velocity.y += rigidBody.Acceleration.y * time.deltaTime;
-			rigidBody.Velocity.z += rigidBody.Acceleration.z * time.deltaTime;
-
-			rigidBody.AngularVelocity.x += rigidBody.AngularAcceleration.x * time.deltaTime;
-			rigidBody.AngularVelocity.y += rigidBody.AngularAcceleration.y * time.deltaTime;
-			rigidBody.AngularVelocity.z += rigidBody.AngularAcceleration.z * time.deltaTime;
-
-			if (!rigidBody.UseGravity)
-				continue;
-			const auto& gravity = coordinator.GetComponent<GravityComponent>(entity);
-			rigidBody.Velocity += gravity.Force * time.deltaTime;
-		}
+		const auto& time = coordinator.GetSingletonComponent<const TimeComponent>();
+		Query<const TransformComponent, RigidBodyComponent, const GravityComponent>().ParallelForEachModified(
+			[&time](const TransformComponent&, RigidBodyComponent& rigidBody, const GravityComponent& gravity) {
+				const bool accelerating = !IsZero(rigidBody.Acceleration) || !IsZero(rigidBody.AngularAcceleration);
+				const bool falling = rigidBody.UseGravity && !IsZero(gravity.Force);
+				if (!accelerating && !falling)
+					return false;
+
+				rigidBody.Velocity.x += rigidBody.Acceleration.x * time.deltaTime;
+				rigidBody.Velocity.y += rigidBody.Acceleration.y * time.deltaTime;
+				rigidBody.Velocity.z += rigidBody.Acceleration.z * time.deltaTime;
+
+				rigidBody.AngularVelocity.x += rigidBody.AngularAcceleration.x * time.deltaTime;
+				rigidBody.AngularVelocity.y += rigidBody.AngularAcceleration.y * time.deltaTime;
+				rigidBody.AngularVelocity.z += rigidBody.AngularAcceleration.z * time.deltaTime;
+
+				if (falling)
+					rigidBody.Velocity += gravity.Force * time.deltaTime;
+				return true;
+		});
 	}
 
+	// 실제로 움직인 강체가 있는 청크만 TransformComponent 변경으로 기록되어
+	// WorldMatrixUpdateSystem/BoundingVolumeUpdateSystem이 정지한 물체의 청크를 다시 계산하지 않습니다.
 	void FinalUpdate() override {
 		auto& coordinator = ECS::Coordinator::GetInstance();
-		const auto& time = coordinator.GetSingletonComponent<TimeComponent>();
-		for (ECS::Entity entity : mEntities) {
-			auto& rigidBody = coordinator.GetComponent<RigidBodyComponent>(entity);
-			if (rigidBody.Velocity.x == 0.0f && rigidBody.Velocity.y == 0.0f && rigidBody.Velocity.z == 0.0f &&
-				rigidBody.AngularVelocity.x == 0.0f && rigidBody.AngularVelocity.y == 0.0f && rigidBody.AngularVelocity.z == 0.0f)
-				continue;
-
-			auto& transform = coordinator.GetComponent<TransformComponent>(entity);
-			
-			transform.Position.x += rigidBody.Velocity.x * time.deltaTime;
-			transform.Position.y += rigidBody.Velocity.y * time.deltaTime;
-			transform.Position.z += rigidBody.Velocity.z * time.deltaTime;
-
-			transform.Rotation.x += rigidBody.AngularVelocity.x * time.deltaTime;
-			transform.Rotation.y += rigidBody.AngularVelocity.y * time.deltaTime;
-			transform.Rotation.z += rigidBody.AngularVelocity.z * time.deltaTime;
-
-			transform.Dirty = true;
-		}
+		const auto& time = coordinator.GetSingletonComponent<const TimeComponent>();
+		Query<TransformComponent, const RigidBodyComponent, const GravityComponent>().ParallelForEachModified(
+			[&time](TransformComponent& transform, const RigidBodyComponent& rigidBody, const GravityComponent&) {
+				if (IsZero(rigidBody.Velocity) && IsZero(rigidBody.AngularVelocity))
+					return false;
+
+				transform.Position.x += rigidBody.Velocity.x * time.deltaTime;
+				transform.Position.y += rigidBody.Velocity.y * time.deltaTime;
+				transform.Position.z += rigidBody.Velocity.z * time.deltaTime;
+
+				transform.Rotation.x += rigidBody.AngularVelocity.x * time.deltaTime;
+				transform.Rotation.y += rigidBody.AngularVelocity.y * time.deltaTime;
+				transform.Rotation.z += rigidBody.AngularVelocity.z * time.deltaTime;
+				return true;
+		});
 	}
 private:
+	static bool IsZero(const float3& v) {
+		return v.x == 0.0f && v.y == 0.0f && v.z == 0.0f;
+	}
 };
\ No newline at end of file
@@ -9,16 +9,16 @@
 
 class PlayerControlSystem : public ECS::ISystem {
 public:
+    void DeclareAccess(ECS::SystemAccess& access) override {
+        access.Read<TransformComponent>().Write<RigidBodyComponent>().Read<PlayerControlComponent>().ReadSingleton<TimeComponent>();
+    }
+
     void Update() override {
         auto& coordinator = ECS::Coordinator::GetInstance();
         auto& input = InputSystem::GetInstance();
-        const auto& time = coordinator.GetSingletonComponent<TimeComponent>();
-
-        for (auto const& entity : mEntities) {
-            auto& transform = coordinator.GetComponent<TransformComponent>(entity);
-            auto& rigidBody = coordinator.GetComponent<RigidBodyComponent>(entity);
-            auto& control = coordinator.GetComponent<PlayerControlComponent>(entity);
+        const auto& time = coordinator.GetSingletonComponent<const TimeComponent>();
 
+        Query<RigidBodyComponent, const PlayerControlComponent>().ForEach([&](RigidBodyComponent& rigidBody, const PlayerControlComponent& control) {
             float3 moveDir = { 0.0f, 0.0f, 0.0f };
 
 			if (input.IsKeyDown('A')) moveDir.x -= 1.0f;
@@ -39,6 +39,6 @@ public:
 			if (input.IsKeyDown('s')) moveDir.y -= 1.0f;
 
 			rigidBody.Velocity = moveDir * control.moveSpeed * time.deltaTime;
-        }
+        });
     }
 };
\ No newline at end of file
@@ -6,14 +6,17 @@
 
 class RenderDataSyncSystem : public ECS::ISystem {
 public:
+	void DeclareAccess(ECS::SystemAccess& access) override {
+		access.Write<TransformComponent>().Write<RigidBodyComponent>().Read<GravityComponent>().ReadSingleton<TimeComponent>();
+	}
+
 	void Update() override {
 		auto& coordinator = ECS::Coordinator::GetInstance();
-		const auto& time = coordinator.GetSingletonComponent<TimeComponent>();
-		for (ECS::Entity entity : mEntities) {
-			auto& rigidBody = coordinator.GetComponent<RigidBodyComponent>(entity);
+		const auto& time = coordinator.GetSingletonComponent<const TimeComponent>();
+		Query<RigidBodyComponent>().ForEach([&](ECS::Entity entity, RigidBodyComponent& rigidBody) {
 			if (rigidBody.Acceleration.x == 0.0f && rigidBody.Acceleration.y == 0.0f && rigidBody.Acceleration.z &&
 				rigidBody.AngularAcceleration.x == 0.0f && rigidBody.AngularAcceleration.y == 0.0f && rigidBody.AngularAcceleration.z)
-				continue;
+				return;
 
 			rigidBody.Velocity.x += rigidBody.Acceleration.x * time.deltaTime;
 			rigidBody.Velocity.y += rigidBody.Acceleration.y * time.deltaTime;
@@ -24,22 +27,19 @@ public:
 			rigidBody.AngularVelocity.z += rigidBody.AngularAcceleration.z * time.deltaTime;
 
 			if (!rigidBody.UseGravity)
-				continue;
-			const auto& gravity = coordinator.GetComponent<GravityComponent>(entity);
+				return;
+			const auto& gravity = coordinator.GetComponentRead<GravityComponent>(entity);
 			rigidBody.Velocity += gravity.Force * time.deltaTime;
-		}
+		});
 	}
 
 	void FinalUpdate() override {
 		auto& coordinator = ECS::Coordinator::GetInstance();
-		const auto& time = coordinator.GetSingletonComponent<TimeComponent>();
-		for (ECS::Entity entity : mEntities) {
-			auto& rigidBody = coordinator.GetComponent<RigidBodyComponent>(entity);
+		const auto& time = coordinator.GetSingletonComponent<const TimeComponent>();
+		Query<TransformComponent, const RigidBodyComponent>().ForEach([&](TransformComponent& transform, const RigidBodyComponent& rigidBody) {
 			if (rigidBody.Velocity.x == 0.0f && rigidBody.Velocity.y == 0.0f && rigidBody.Velocity.z == 0.0f &&
 				rigidBody.AngularVelocity.x == 0.0f && rigidBody.AngularVelocity.y == 0.0f && rigidBody.AngularVelocity.z == 0.0f)
-				continue;
-
-			auto& transform = coordinator.GetComponent<TransformComponent>(entity);
+				return;
 
 			transform.Position.x += rigidBody.Velocity.x * time.deltaTime;
 			transform.Position.y += rigidBody.Velocity.y * time.deltaTime;
@@ -48,9 +48,7 @@ public:
 			transform.Rotation.x += rigidBody.AngularVelocity.x * time.deltaTime;
 			transform.Rotation.y += rigidBody.AngularVelocity.y * time.deltaTime;
 			transform.Rotation.z += rigidBody.AngularVelocity.z * time.deltaTime;
-
-			transform.Dirty = true;
-		}
+		});
 	}
 private:
 };
\ No newline at end of file
@@ -32,6 +32,10 @@ public:
         mTimer.Tick(); // Initialize the timer
     }
 
+    void DeclareAccess(ECS::SystemAccess& access) override {
+        access.WriteSingleton<TimeComponent>();
+    }
+
     void Update() override {
 
     }
@@ -57,13 +61,16 @@ private:
 
 class AnimationTimeSystem : public ECS::ISystem {
 public:
+    void DeclareAccess(ECS::SystemAccess& access) override {
+        access.Write<AnimationTimeComponent>().ReadSingleton<TimeComponent>();
+    }
+
     void Update() override {
         auto& coordinator = ECS::Coordinator::GetInstance();
-        const auto& time = coordinator.GetSingletonComponent<TimeComponent>();
+        const auto& time = coordinator.GetSingletonComponent<const TimeComponent>();
 
-        for (auto entity : mEntities) {
-            auto& anim = coordinator.GetComponent<AnimationTimeComponent>(entity);
+        Query<AnimationTimeComponent>().ForEach([&time](AnimationTimeComponent& anim) {
             anim.localTime += time.deltaTime * anim.speed;
-        }
+        });
     }
 };
\ No newline at end of file
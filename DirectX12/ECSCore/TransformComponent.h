@@ -7,6 +7,7 @@ struct TransformComponent {
 	float3 Scale;
 	float3 Rotation;
     float4 RotationQuat;
+	// 레거시 InstanceComponent 경로 전용. ECS 시스템은 청크 변경 버전(EntityQuery::Changed)으로 변경을 추적합니다.
 	bool Dirty = true;
 };
 
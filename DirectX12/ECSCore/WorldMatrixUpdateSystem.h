@@ -4,42 +4,156 @@
 
 class WorldMatrixUpdateSystem : public ECS::ISystem {
 public:
+	void DeclareAccess(ECS::SystemAccess& access) override {
+		access.Write<TransformComponent>().Read<CFGInstanceComponent>().Read<TextureScaleComponent>().Write<InstanceData>();
+	}
+
+	// 지난 Update 이후 트랜스폼/옵션/텍스처 스케일이 바뀐 청크만 다시 계산합니다.
+	// 이 시스템이 RotationQuat을 기록하며 남긴 버전은 다음 실행의 기준 버전과 같으므로 다시 걸리지 않습니다.
 	void Update() override {
-		auto& coordinator = ECS::Coordinator::GetInstance();
-		for (ECS::Entity entity : mEntities) {
-			auto& transform = coordinator.GetComponent<TransformComponent>(entity);
-			if (!transform.Dirty)
-				continue;
-
-			auto& boundingVolumn = coordinator.GetComponent<BoundingVolumnComponent>(entity);
-			auto& mesh = coordinator.GetComponent<DX12_MeshComponent>(entity);
-			auto& cfg = coordinator.GetComponent<CFGInstanceComponent>(entity);
-			auto& textureScale = coordinator.GetComponent<TextureScaleComponent>(entity);
-			auto& instanceData = coordinator.GetComponent<InstanceData>(entity);
-
-			float rx = DirectX::XMConvertToRadians(transform.Rotation.x);
-			float ry = DirectX::XMConvertToRadians(transform.Rotation.y);
-			float rz = DirectX::XMConvertToRadians(transform.Rotation.z);
-			transform.RotationQuat = DirectX::XMQuaternionRotationRollPitchYaw(rx, ry, rz);
-
-			DirectX::XMMATRIX rotX = DirectX::XMMatrixRotationX(rx);
-			DirectX::XMMATRIX rotY = DirectX::XMMatrixRotationY(ry);
-			DirectX::XMMATRIX rotZ = DirectX::XMMatrixRotationZ(rz);
-
-			DirectX::XMMATRIX rot = rotX * rotY * rotZ;
-			if (cfg.Option & eCFGInstanceComponent::UseQuat)
-				rot = DirectX::XMMatrixRotationQuaternion(transform.RotationQuat);
-
-			DirectX::XMMATRIX world
-				= DirectX::XMMatrixScaling(transform.Scale.x, transform.Scale.y, transform.Scale.z)
-				* rot
-				* DirectX::XMMatrixTranslation(transform.Position.x, transform.Position.y, transform.Position.z);
-			DirectX::XMMATRIX texTransform = DirectX::XMMatrixScaling(textureScale.TextureScale.x, textureScale.TextureScale.y, textureScale.TextureScale.z);
-			DirectX::XMVECTOR det = DirectX::XMMatrixDeterminant(world);
-
-			instanceData.World = DirectX::XMMatrixTranspose(world);
-			instanceData.TexTransform = DirectX::XMMatrixTranspose(texTransform);
-			instanceData.WorldInvTranspose = DirectX::XMMatrixInverse(&det, world);
+		Query<TransformComponent, const CFGInstanceComponent, const TextureScaleComponent, InstanceData>()
+			.Changed<TransformComponent, CFGInstanceComponent, TextureScaleComponent>()
+			.ParallelForEachChunk(
+			[](ECS::Entity*, size_t count, TransformComponent* transforms, const CFGInstanceComponent* cfgs, const TextureScaleComponent* textureScales, InstanceData* instances) {
+				UpdateChunk(count, transforms, cfgs, textureScales, instances);
+			});
+	}
+
+	// 청크 하나의 행을 SIMD 레인 수만큼씩 묶어 처리합니다.
+	static void UpdateChunk(size_t count, TransformComponent* transforms, const CFGInstanceComponent* cfgs, const TextureScaleComponent* textureScales, InstanceData* instances) {
+		size_t rows[LANES];
+		size_t lanes = 0;
+		for (size_t row = 0; row < count; ++row) {
+			// 텍스처 변환은 대각 행렬이라 전치해도 같으므로 바로 기록합니다.
+			const float3& textureScale = textureScales[row].TextureScale;
+			instances[row].TexTransform = DirectX::XMMatrixScaling(textureScale.x, textureScale.y, textureScale.z);
+
+			rows[lanes++] = row;
+			if (lanes == LANES) {
+				UpdateBatch(rows, transforms, cfgs, instances);
+				lanes = 0;
+			}
+		}
+		if (lanes > 0) {
+			// 남는 레인은 마지막 행을 반복합니다. 같은 값을 한 번 더 쓸 뿐이므로 결과에는 영향이 없습니다.
+			for (size_t lane = lanes; lane < LANES; ++lane)
+				rows[lane] = rows[lanes - 1];
+			UpdateBatch(rows, transforms, cfgs, instances);
+		}
+	}
+
+private:
+	static constexpr size_t LANES = 4;
+
+	// 엔티티 4개를 XMVECTOR의 각 레인에 하나씩 실어(SoA) 동시에 계산합니다.
+	// world = S * R * T 구조를 이용해 일반 4x4 역행렬 대신 3x3 부분 R^T * S^-1과 이동 부분 -t * R^T * S^-1을 바로 구합니다.
+	// 결과는 기존 스칼라 경로와 같습니다.
+	//   World             = transpose(S * R * T)
+	//   WorldInvTranspose = inverse(S * R * T)  (셰이더의 행렬 packing 때문에 전치하지 않은 값을 저장)
+	//   R = RotationX * RotationY * RotationZ, UseQuat이면 RollPitchYaw 쿼터니언의 회전 (= RotationZ * RotationX * RotationY)
+	static void UpdateBatch(const size_t (&rows)[LANES], TransformComponent* transforms, const CFGInstanceComponent* cfgs, InstanceData* instances) {
+		using namespace DirectX;
+
+		TransformComponent* t[LANES] = { &transforms[rows[0]], &transforms[rows[1]], &transforms[rows[2]], &transforms[rows[3]] };
+		auto gather = [&t](auto project) {
+			return XMVectorSet(project(*t[0]), project(*t[1]), project(*t[2]), project(*t[3]));
+		};
+
+		XMVECTOR px = gather([](const TransformComponent& c) { return c.Position.x; });
+		XMVECTOR py = gather([](const TransformComponent& c) { return c.Position.y; });
+		XMVECTOR pz = gather([](const TransformComponent& c) { return c.Position.z; });
+		XMVECTOR sx = gather([](const TransformComponent& c) { return c.Scale.x; });
+		XMVECTOR sy = gather([](const TransformComponent& c) { return c.Scale.y; });
+		XMVECTOR sz = gather([](const TransformComponent& c) { return c.Scale.z; });
+
+		// 반각의 sin/cos만 구하고 전각 값은 배각 공식으로 얻습니다. (도 -> 라디안 변환과 1/2을 한 번에 곱함)
+		const XMVECTOR halfRadians = XMVectorReplicate(XM_PI / 360.0f);
+		XMVECTOR sp, cp, sy2, cy2, sr, cr;
+		XMVectorSinCos(&sp, &cp, XMVectorMultiply(gather([](const TransformComponent& c) { return c.Rotation.x; }), halfRadians));   // pitch
+		XMVectorSinCos(&sy2, &cy2, XMVectorMultiply(gather([](const TransformComponent& c) { return c.Rotation.y; }), halfRadians)); // yaw
+		XMVectorSinCos(&sr, &cr, XMVectorMultiply(gather([](const TransformComponent& c) { return c.Rotation.z; }), halfRadians));   // roll
+
+		// XMQuaternionRotationRollPitchYaw와 같은 식
+		XMVECTOR qx = XMVectorAdd(XMVectorMultiply(XMVectorMultiply(cr, sp), cy2), XMVectorMultiply(XMVectorMultiply(sr, cp), sy2));
+		XMVECTOR qy = XMVectorSubtract(XMVectorMultiply(XMVectorMultiply(cr, cp), sy2), XMVectorMultiply(XMVectorMultiply(sr, sp), cy2));
+		XMVECTOR qz = XMVectorSubtract(XMVectorMultiply(XMVectorMultiply(sr, cp), cy2), XMVectorMultiply(XMVectorMultiply(cr, sp), sy2));
+		XMVECTOR qw = XMVectorAdd(XMVectorMultiply(XMVectorMultiply(cr, cp), cy2), XMVectorMultiply(XMVectorMultiply(sr, sp), sy2));
+
+		// sin(2x) = 2 sin(x) cos(x), cos(2x) = 1 - 2 sin(x)^2
+		const XMVECTOR one = XMVectorSplatOne();
+		const XMVECTOR two = XMVectorReplicate(2.0f);
+		XMVECTOR sa = XMVectorMultiply(two, XMVectorMultiply(sp, cp)), ca = XMVectorNegativeMultiplySubtract(two, XMVectorMultiply(sp, sp), one);
+		XMVECTOR sb = XMVectorMultiply(two, XMVectorMultiply(sy2, cy2)), cb = XMVectorNegativeMultiplySubtract(two, XMVectorMultiply(sy2, sy2), one);
+		XMVECTOR sc = XMVectorMultiply(two, XMVectorMultiply(sr, cr)), cc = XMVectorNegativeMultiplySubtract(two, XMVectorMultiply(sr, sr), one);
+
+		// 오일러 경로: RotationX(a) * RotationY(b) * RotationZ(c)
+		XMVECTOR sasb = XMVectorMultiply(sa, sb);
+		XMVECTOR casb = XMVectorMultiply(ca, sb);
+		XMVECTOR r[3][3] = {
+			{ XMVectorMultiply(cb, cc), XMVectorMultiply(cb, sc), XMVectorNegate(sb) },
+			{ XMVectorSubtract(XMVectorMultiply(sasb, cc), XMVectorMultiply(ca, sc)), XMVectorAdd(XMVectorMultiply(sasb, sc), XMVectorMultiply(ca, cc)), XMVectorMultiply(sa, cb) },
+			{ XMVectorAdd(XMVectorMultiply(casb, cc), XMVectorMultiply(sa, sc)), XMVectorSubtract(XMVectorMultiply(casb, sc), XMVectorMultiply(sa, cc)), XMVectorMultiply(ca, cb) },
+		};
+
+		// 쿼터니언 경로: RotationZ(c) * RotationX(a) * RotationY(b). UseQuat인 레인만 이 값으로 바꿉니다.
+		XMVECTOR useQuat = XMVectorSelectControl(
+			(cfgs[rows[0]].Option & eCFGInstanceComponent::UseQuat) ? 1 : 0,
+			(cfgs[rows[1]].Option & eCFGInstanceComponent::UseQuat) ? 1 : 0,
+			(cfgs[rows[2]].Option & eCFGInstanceComponent::UseQuat) ? 1 : 0,
+			(cfgs[rows[3]].Option & eCFGInstanceComponent::UseQuat) ? 1 : 0);
+		if (XMVector4NotEqualInt(useQuat, XMVectorZero())) {
+			XMVECTOR scsa = XMVectorMultiply(sc, sa);
+			XMVECTOR ccsa = XMVectorMultiply(cc, sa);
+			XMVECTOR q[3][3] = {
+				{ XMVectorAdd(XMVectorMultiply(cc, cb), XMVectorMultiply(scsa, sb)), XMVectorMultiply(sc, ca), XMVectorSubtract(XMVectorMultiply(scsa, cb), XMVectorMultiply(cc, sb)) },
+				{ XMVectorSubtract(XMVectorMultiply(ccsa, sb), XMVectorMultiply(sc, cb)), XMVectorMultiply(cc, ca), XMVectorAdd(XMVectorMultiply(sc, sb), XMVectorMultiply(ccsa, cb)) },
+				{ XMVectorMultiply(ca, sb), XMVectorNegate(sa), XMVectorMultiply(ca, cb) },
+			};
+			for (int i = 0; i < 3; ++i)
+				for (int j = 0; j < 3; ++j)
+					r[i][j] = XMVectorSelect(r[i][j], q[i][j], useQuat);
+		}
+
+		// world의 3x3 부분 S * R (i행에 scale_i를 곱함)
+		XMVECTOR s[3] = { sx, sy, sz };
+		XMVECTOR m[3][3];
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				m[i][j] = XMVectorMultiply(s[i], r[i][j]);
+
+		// 역행렬의 3x3 부분 U = R^T * S^-1, 이동 부분 w = -t * U
+		XMVECTOR invS[3] = { XMVectorReciprocal(sx), XMVectorReciprocal(sy), XMVectorReciprocal(sz) };
+		XMVECTOR u[3][3];
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				u[i][j] = XMVectorMultiply(r[j][i], invS[j]);
+		XMVECTOR w[3];
+		for (int j = 0; j < 3; ++j)
+			w[j] = XMVectorNegate(XMVectorMultiplyAdd(px, u[0][j], XMVectorMultiplyAdd(py, u[1][j], XMVectorMultiply(pz, u[2][j]))));
+
+		// SoA -> 엔티티별 행으로 전치해서 기록합니다.
+		const XMVECTOR zero = XMVectorZero();
+		XMMATRIX worldRows[3] = {
+			XMMatrixTranspose(XMMATRIX(m[0][0], m[1][0], m[2][0], px)),
+			XMMatrixTranspose(XMMATRIX(m[0][1], m[1][1], m[2][1], py)),
+			XMMatrixTranspose(XMMATRIX(m[0][2], m[1][2], m[2][2], pz)),
+		};
+		XMMATRIX inverseRows[4] = {
+			XMMatrixTranspose(XMMATRIX(u[0][0], u[0][1], u[0][2], zero)),
+			XMMatrixTranspose(XMMATRIX(u[1][0], u[1][1], u[1][2], zero)),
+			XMMatrixTranspose(XMMATRIX(u[2][0], u[2][1], u[2][2], zero)),
+			XMMatrixTranspose(XMMATRIX(w[0], w[1], w[2], one)),
+		};
+		XMMATRIX quats = XMMatrixTranspose(XMMATRIX(qx, qy, qz, qw));
+
+		for (size_t lane = 0; lane < LANES; ++lane) {
+			InstanceData& instance = instances[rows[lane]];
+			for (int i = 0; i < 3; ++i)
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(instance.World.m[i]), worldRows[i].r[lane]);
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(instance.World.m[3]), g_XMIdentityR3);
+			for (int i = 0; i < 4; ++i)
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(instance.WorldInvTranspose.m[i]), inverseRows[i].r[lane]);
+			XMStoreFloat4(&t[lane]->RotationQuat, quats.r[lane]);
 		}
 	}
-};
\ No newline at end of file
+};
@@ -119,7 +119,7 @@ void LoadScene() {
     auto ball1 = GameObjectFactory::GetInstance().CreateGameObject("BouncingBall");
     auto ball2 = GameObjectFactory::GetInstance().CreateGameObject("BouncingBall");
 
-    auto& ball1Transform = ECS::Coordinator::GetInstance().GetComponent<TransformComponent>(ball1);
+    auto& ball1Transform = ECS::Coordinator::GetInstance().GetComponentWrite<TransformComponent>(ball1);
     ball1Transform.Position = { -5.f, 10.f, 0.f };
 }
 
@@ -1,14 +1,336 @@
 #include "pch.h"
 #include "LoadM3d.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace DirectX;
 
+namespace
+{
+	// .m3db layout.  Every section starts on a 4 byte boundary.
+	//
+	//	M3dbHeader
+	//	M3dbMaterial[NumMaterials], then the material strings
+	//	M3DLoader::Subset[NumMaterials]
+	//	NumVertices vertices of VertexStride bytes: SkinnedVertex if NumBones > 0, Vertex otherwise
+	//	std::uint32_t indices[NumTriangles * 3]
+	//	XMFLOAT4X4 boneOffsets[NumBones]
+	//	int boneIndexToParentIndex[NumBones]
+	//	per clip: name length, name, keyframe count of every bone, M3dbKeyframe[]
+	constexpr char M3dbMagic[4] = { 'M', '3', 'D', 'B' };
+	constexpr std::uint32_t M3dbVersion = 1;
+
+	struct M3dbHeader
+	{
+		char Magic[4];
+		std::uint32_t Version;
+		std::uint32_t NumMaterials;
+		std::uint32_t NumVertices;
+		std::uint32_t NumTriangles;
+		std::uint32_t NumBones;
+		std::uint32_t NumAnimationClips;
+		std::uint32_t VertexStride;
+	};
+
+	struct M3dbMaterial
+	{
+		XMFLOAT4 DiffuseAlbedo;
+		XMFLOAT3 FresnelR0;
+		float Roughness;
+		std::uint32_t AlphaClip;
+		std::uint32_t NameLength;
+		std::uint32_t MaterialTypeNameLength;
+		std::uint32_t DiffuseMapNameLength;
+		std::uint32_t NormalMapNameLength;
+	};
+
+	// Keyframe has a user-provided destructor, so it is not trivially copyable and
+	// is copied field by field from this record.
+	struct M3dbKeyframe
+	{
+		float TimePos;
+		XMFLOAT3 Translation;
+		XMFLOAT3 Scale;
+		XMFLOAT4 RotationQuat;
+	};
+
+	static_assert(sizeof(M3dbHeader) == 32, "M3dbHeader layout changed");
+	static_assert(sizeof(M3dbMaterial) == 52, "M3dbMaterial layout changed");
+	static_assert(sizeof(M3dbKeyframe) == 44, "M3dbKeyframe layout changed");
+	static_assert(std::is_trivially_copyable<M3DLoader::Subset>::value, "Subset is copied as raw bytes");
+	static_assert(std::is_trivially_copyable<GeometryGenerator::Vertex>::value, "Vertex is copied as raw bytes");
+	static_assert(std::is_trivially_copyable<GeometryGenerator::SkinnedVertex>::value, "SkinnedVertex is copied as raw bytes");
+
+	class M3dbWriter
+	{
+	public:
+		void Write(const void* data, size_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+			mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+		}
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			Write(&value, sizeof(T));
+		}
+
+		template<typename T>
+		void WriteArray(const std::vector<T>& values)
+		{
+			Write(values.data(), values.size() * sizeof(T));
+		}
+
+		void Align()
+		{
+			mBuffer.resize((mBuffer.size() + 3) & ~size_t(3), 0);
+		}
+
+		bool Save(const std::string& filename)const
+		{
+			std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+			fout.write(mBuffer.data(), std::streamsize(mBuffer.size()));
+			return bool(fout);
+		}
+
+	private:
+		std::vector<char> mBuffer;
+	};
+
+	// Bounds-checked cursor over a mapped .m3db file.  Values are copied out with memcpy,
+	// so the file contents need no particular alignment.
+	class M3dbReader
+	{
+	public:
+		M3dbReader(const BYTE* data, size_t size)
+			: mData(data), mSize(size) {}
+
+		bool Read(void* dst, size_t size)
+		{
+			if (size > mSize - mOffset)
+			{
+				mOffset = mSize;
+				return false;
+			}
+			if (size > 0)
+				std::memcpy(dst, mData + mOffset, size);
+			mOffset += size;
+			return true;
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			return Read(&value, sizeof(T));
+		}
+
+		template<typename T>
+		bool ReadArray(std::vector<T>& values, size_t count)
+		{
+			if (count > (mSize - mOffset) / sizeof(T))
+			{
+				mOffset = mSize;
+				return false;
+			}
+			values.resize(count);
+			return Read(values.data(), count * sizeof(T));
+		}
+
+		bool ReadString(std::string& value, size_t length)
+		{
+			if (length > mSize - mOffset)
+			{
+				mOffset = mSize;
+				return false;
+			}
+			value.assign(reinterpret_cast<const char*>(mData + mOffset), length);
+			mOffset += length;
+			return true;
+		}
+
+		void Align()
+		{
+			mOffset = std::min(mSize, (mOffset + 3) & ~size_t(3));
+		}
+
+	private:
+		const BYTE* mData = nullptr;
+		size_t mSize = 0;
+		size_t mOffset = 0;
+	};
+
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string& filename)
+		{
+#ifdef _WIN32
+			mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (mFile == INVALID_HANDLE_VALUE)
+				return;
+
+			LARGE_INTEGER fileSize{};
+			if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+				return;
+
+			mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mMapping)
+				return;
+
+			mData = static_cast<const BYTE*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+			if (mData)
+				mSize = size_t(fileSize.QuadPart);
+#else
+			int fd = open(filename.c_str(), O_RDONLY);
+			if (fd < 0)
+				return;
+
+			struct stat st {};
+			if (fstat(fd, &st) == 0 && st.st_size > 0)
+			{
+				void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data != MAP_FAILED)
+				{
+					mData = static_cast<const BYTE*>(data);
+					mSize = size_t(st.st_size);
+				}
+			}
+			close(fd);
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifdef _WIN32
+			if (mData)
+				UnmapViewOfFile(mData);
+			if (mMapping)
+				CloseHandle(mMapping);
+			if (mFile != INVALID_HANDLE_VALUE)
+				CloseHandle(mFile);
+#else
+			if (mData)
+				munmap(const_cast<BYTE*>(mData), mSize);
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const BYTE* Data()const { return mData; }
+		size_t Size()const { return mSize; }
+
+	private:
+		const BYTE* mData = nullptr;
+		size_t mSize = 0;
+#ifdef _WIN32
+		HANDLE mFile = INVALID_HANDLE_VALUE;
+		HANDLE mMapping = nullptr;
+#endif
+	};
+
+	bool ReadM3dbHeader(M3dbReader& reader, M3dbHeader& header)
+	{
+		return reader.Read(header)
+			&& std::memcmp(header.Magic, M3dbMagic, sizeof(M3dbMagic)) == 0
+			&& header.Version == M3dbVersion;
+	}
+
+	bool ReadM3dbMaterials(M3dbReader& reader, UINT numMaterials, std::vector<M3DLoader::M3dMaterial>& mats)
+	{
+		std::vector<M3dbMaterial> records;
+		if (!reader.ReadArray(records, numMaterials))
+			return false;
+
+		mats.resize(numMaterials);
+		for (UINT i = 0; i < numMaterials; ++i)
+		{
+			const M3dbMaterial& record = records[i];
+			mats[i].DiffuseAlbedo = record.DiffuseAlbedo;
+			mats[i].FresnelR0 = record.FresnelR0;
+			mats[i].Roughness = record.Roughness;
+			mats[i].AlphaClip = record.AlphaClip != 0;
+
+			if (!reader.ReadString(mats[i].Name, record.NameLength) ||
+				!reader.ReadString(mats[i].MaterialTypeName, record.MaterialTypeNameLength) ||
+				!reader.ReadString(mats[i].DiffuseMapName, record.DiffuseMapNameLength) ||
+				!reader.ReadString(mats[i].NormalMapName, record.NormalMapNameLength))
+				return false;
+		}
+		reader.Align();
+		return true;
+	}
+
+	// SkinnedData walks the hierarchy in index order and reads the parent's transform for every bone after the root,
+	// so the root must have no parent and every other bone must point to an earlier one.
+	bool ValidateM3dbBoneHierarchy(const std::vector<int>& boneIndexToParentIndex)
+	{
+		for (size_t i = 0; i < boneIndexToParentIndex.size(); ++i)
+		{
+			int parentIndex = boneIndexToParentIndex[i];
+			if (i == 0 ? parentIndex != -1 : (parentIndex < 0 || size_t(parentIndex) >= i))
+				return false;
+		}
+		return true;
+	}
+
+	bool ReadM3dbAnimationClips(M3dbReader& reader, UINT numBones, UINT numAnimationClips,
+		std::unordered_map<std::string, AnimationClip>& animations)
+	{
+		std::vector<std::uint32_t> keyframeCounts;
+		std::vector<M3dbKeyframe> keyframes;
+
+		for (UINT clipIndex = 0; clipIndex < numAnimationClips; ++clipIndex)
+		{
+			std::uint32_t nameLength = 0;
+			std::string clipName;
+			if (!reader.Read(nameLength) || !reader.ReadString(clipName, nameLength))
+				return false;
+			reader.Align();
+
+			if (!reader.ReadArray(keyframeCounts, numBones))
+				return false;
+
+			AnimationClip& clip = animations[clipName];
+			clip.BoneAnimations.resize(numBones);
+
+			for (UINT boneIndex = 0; boneIndex < numBones; ++boneIndex)
+			{
+				// BoneAnimation::Interpolate reads the first and last keyframe without checking.
+				if (keyframeCounts[boneIndex] == 0 ||
+					!reader.ReadArray(keyframes, keyframeCounts[boneIndex]))
+					return false;
+
+				std::vector<Keyframe>& dst = clip.BoneAnimations[boneIndex].Keyframes;
+				dst.resize(keyframes.size());
+				for (size_t i = 0; i < keyframes.size(); ++i)
+				{
+					dst[i].TimePos = keyframes[i].TimePos;
+					dst[i].Translation = keyframes[i].Translation;
+					dst[i].Scale = keyframes[i].Scale;
+					dst[i].RotationQuat = keyframes[i].RotationQuat;
+				}
+			}
+		}
+		return true;
+	}
+}
+
 bool M3DLoader::LoadM3d(const std::string& filename,
 	std::vector<GeometryGenerator::Vertex>& vertices,
 	std::vector<std::uint32_t>& indices,
 	std::vector<Subset>& subsets,
 	std::vector<M3dMaterial>& mats)
 {
+	if (IsM3db(filename))
+		return LoadM3db(filename, vertices, indices, subsets, mats);
+
 	std::ifstream fin(filename);
 
 	UINT numMaterials = 0;
@@ -45,6 +367,9 @@ bool M3DLoader::LoadM3d(const std::string& filename,
 	std::vector<M3dMaterial>& mats,
 	SkinnedData& skinInfo)
 {
+	if (IsM3db(filename))
+		return LoadM3db(filename, vertices, indices, subsets, mats, skinInfo);
+
 	std::ifstream fin(filename);
 
 	UINT numMaterials = 0;
@@ -83,6 +408,207 @@ bool M3DLoader::LoadM3d(const std::string& filename,
 	return false;
 }
 
+bool M3DLoader::LoadM3db(const std::string& filename,
+	std::vector<GeometryGenerator::Vertex>& vertices,
+	std::vector<std::uint32_t>& indices,
+	std::vector<Subset>& subsets,
+	std::vector<M3dMaterial>& mats)
+{
+	MappedFile file(filename);
+	M3dbReader reader(file.Data(), file.Size());
+
+	M3dbHeader header{};
+	if (!ReadM3dbHeader(reader, header) ||
+		!ReadM3dbMaterials(reader, header.NumMaterials, mats) ||
+		!reader.ReadArray(subsets, header.NumMaterials))
+		return false;
+
+	if (header.NumBones == 0)
+	{
+		if (header.VertexStride != sizeof(GeometryGenerator::Vertex) ||
+			!reader.ReadArray(vertices, header.NumVertices))
+			return false;
+	}
+	else
+	{
+		// A skinned model loaded as a static mesh keeps only the static attributes.
+		std::vector<GeometryGenerator::SkinnedVertex> skinnedVertices;
+		if (header.VertexStride != sizeof(GeometryGenerator::SkinnedVertex) ||
+			!reader.ReadArray(skinnedVertices, header.NumVertices))
+			return false;
+
+		vertices.resize(skinnedVertices.size());
+		for (size_t i = 0; i < skinnedVertices.size(); ++i)
+		{
+			vertices[i].Position = skinnedVertices[i].Position;
+			vertices[i].Normal = skinnedVertices[i].Normal;
+			vertices[i].TexC = skinnedVertices[i].TexC;
+			vertices[i].TangentU = skinnedVertices[i].TangentU;
+		}
+	}
+
+	return reader.ReadArray(indices, size_t(header.NumTriangles) * 3);
+}
+
+bool M3DLoader::LoadM3db(const std::string& filename,
+	std::vector<GeometryGenerator::SkinnedVertex>& vertices,
+	std::vector<std::uint32_t>& indices,
+	std::vector<Subset>& subsets,
+	std::vector<M3dMaterial>& mats,
+	SkinnedData& skinInfo)
+{
+	MappedFile file(filename);
+	M3dbReader reader(file.Data(), file.Size());
+
+	M3dbHeader header{};
+	if (!ReadM3dbHeader(reader, header) ||
+		header.NumBones == 0 ||
+		header.VertexStride != sizeof(GeometryGenerator::SkinnedVertex))
+		return false;
+
+	std::vector<XMFLOAT4X4> boneOffsets;
+	std::vector<int> boneIndexToParentIndex;
+	std::unordered_map<std::string, AnimationClip> animations;
+
+	if (!ReadM3dbMaterials(reader, header.NumMaterials, mats) ||
+		!reader.ReadArray(subsets, header.NumMaterials) ||
+		!reader.ReadArray(vertices, header.NumVertices) ||
+		!reader.ReadArray(indices, size_t(header.NumTriangles) * 3) ||
+		!reader.ReadArray(boneOffsets, header.NumBones) ||
+		!reader.ReadArray(boneIndexToParentIndex, header.NumBones) ||
+		!ValidateM3dbBoneHierarchy(boneIndexToParentIndex) ||
+		!ReadM3dbAnimationClips(reader, header.NumBones, header.NumAnimationClips, animations))
+		return false;
+
+	skinInfo.Set(boneIndexToParentIndex, boneOffsets, animations);
+
+	return true;
+}
+
+bool M3DLoader::ConvertM3dToM3db(const std::string& m3dFilename, const std::string& m3dbFilename)
+{
+	std::ifstream fin(m3dFilename);
+	if (!fin)
+		return false;
+
+	UINT numMaterials = 0;
+	UINT numVertices = 0;
+	UINT numTriangles = 0;
+	UINT numBones = 0;
+	UINT numAnimationClips = 0;
+
+	std::string ignore;
+
+	fin >> ignore; // file header text
+	fin >> ignore >> numMaterials;
+	fin >> ignore >> numVertices;
+	fin >> ignore >> numTriangles;
+	fin >> ignore >> numBones;
+	fin >> ignore >> numAnimationClips;
+
+	std::vector<M3dMaterial> mats;
+	std::vector<Subset> subsets;
+	std::vector<GeometryGenerator::Vertex> vertices;
+	std::vector<GeometryGenerator::SkinnedVertex> skinnedVertices;
+	std::vector<std::uint32_t> indices;
+	std::vector<XMFLOAT4X4> boneOffsets;
+	std::vector<int> boneIndexToParentIndex;
+	std::unordered_map<std::string, AnimationClip> animations;
+
+	ReadMaterials(fin, numMaterials, mats);
+	ReadSubsetTable(fin, numMaterials, subsets);
+	if (numBones > 0)
+		ReadSkinnedVertices(fin, numVertices, skinnedVertices);
+	else
+		ReadVertices(fin, numVertices, vertices);
+	ReadTriangles(fin, numTriangles, indices);
+	if (numBones > 0)
+	{
+		ReadBoneOffsets(fin, numBones, boneOffsets);
+		ReadBoneHierarchy(fin, numBones, boneIndexToParentIndex);
+		ReadAnimationClips(fin, numBones, numAnimationClips, animations);
+	}
+
+	if (fin.fail())
+		return false;
+
+	M3dbWriter writer;
+
+	M3dbHeader header{};
+	std::memcpy(header.Magic, M3dbMagic, sizeof(M3dbMagic));
+	header.Version = M3dbVersion;
+	header.NumMaterials = numMaterials;
+	header.NumVertices = numVertices;
+	header.NumTriangles = numTriangles;
+	header.NumBones = numBones;
+	header.NumAnimationClips = numBones > 0 ? (UINT)animations.size() : 0;
+	header.VertexStride = numBones > 0 ? sizeof(GeometryGenerator::SkinnedVertex) : sizeof(GeometryGenerator::Vertex);
+	writer.Write(header);
+
+	for (const M3dMaterial& mat : mats)
+	{
+		M3dbMaterial record{};
+		record.DiffuseAlbedo = mat.DiffuseAlbedo;
+		record.FresnelR0 = mat.FresnelR0;
+		record.Roughness = mat.Roughness;
+		record.AlphaClip = mat.AlphaClip ? 1 : 0;
+		record.NameLength = (std::uint32_t)mat.Name.size();
+		record.MaterialTypeNameLength = (std::uint32_t)mat.MaterialTypeName.size();
+		record.DiffuseMapNameLength = (std::uint32_t)mat.DiffuseMapName.size();
+		record.NormalMapNameLength = (std::uint32_t)mat.NormalMapName.size();
+		writer.Write(record);
+	}
+	for (const M3dMaterial& mat : mats)
+	{
+		writer.Write(mat.Name.data(), mat.Name.size());
+		writer.Write(mat.MaterialTypeName.data(), mat.MaterialTypeName.size());
+		writer.Write(mat.DiffuseMapName.data(), mat.DiffuseMapName.size());
+		writer.Write(mat.NormalMapName.data(), mat.NormalMapName.size());
+	}
+	writer.Align();
+
+	writer.WriteArray(subsets);
+	if (numBones > 0)
+		writer.WriteArray(skinnedVertices);
+	else
+		writer.WriteArray(vertices);
+	writer.WriteArray(indices);
+	writer.WriteArray(boneOffsets);
+	writer.WriteArray(boneIndexToParentIndex);
+
+	for (const auto& animation : animations)
+	{
+		const AnimationClip& clip = animation.second;
+
+		writer.Write((std::uint32_t)animation.first.size());
+		writer.Write(animation.first.data(), animation.first.size());
+		writer.Align();
+
+		for (const BoneAnimation& boneAnimation : clip.BoneAnimations)
+			writer.Write((std::uint32_t)boneAnimation.Keyframes.size());
+
+		for (const BoneAnimation& boneAnimation : clip.BoneAnimations)
+		{
+			for (const Keyframe& keyframe : boneAnimation.Keyframes)
+			{
+				M3dbKeyframe record;
+				record.TimePos = keyframe.TimePos;
+				record.Translation = keyframe.Translation;
+				record.Scale = keyframe.Scale;
+				record.RotationQuat = keyframe.RotationQuat;
+				writer.Write(record);
+			}
+		}
+	}
+
+	return writer.Save(m3dbFilename);
+}
+
+bool M3DLoader::IsM3db(const std::string& filename)
+{
+	return std::filesystem::path(filename).extension() == ".m3db";
+}
+
 void M3DLoader::ReadMaterials(std::ifstream& fin, UINT numMaterials, std::vector<M3dMaterial>& mats)
 {
 	std::string ignore;
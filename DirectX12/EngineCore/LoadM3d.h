@@ -44,6 +44,27 @@ public:
         std::vector<M3dMaterial>& mats,
         SkinnedData& skinInfo);
 
+    // Binary .m3db models hold the same data as the text format, stored as raw arrays.
+    // The file is memory-mapped and copied straight into the output vectors, so loading
+    // involves no token parsing. LoadM3d forwards files with the .m3db extension here.
+    static bool LoadM3db(const std::string& filename,
+        std::vector<GeometryGenerator::Vertex>& vertices,
+        std::vector<std::uint32_t>& indices,
+        std::vector<Subset>& subsets,
+        std::vector<M3dMaterial>& mats);
+    static bool LoadM3db(const std::string& filename,
+        std::vector<GeometryGenerator::SkinnedVertex>& vertices,
+        std::vector<std::uint32_t>& indices,
+        std::vector<Subset>& subsets,
+        std::vector<M3dMaterial>& mats,
+        SkinnedData& skinInfo);
+
+    // Converts a text .m3d file to the binary .m3db format. Models with bones are stored
+    // with skinned vertices, others with static vertices.
+    static bool ConvertM3dToM3db(const std::string& m3dFilename, const std::string& m3dbFilename);
+
+    static bool IsM3db(const std::string& filename);
+
 private:
     static void ReadMaterials(std::ifstream& fin, UINT numMaterials, std::vector<M3dMaterial>& mats);
     static void ReadSubsetTable(std::ifstream& fin, UINT numSubsets, std::vector<Subset>& subsets);
@@ -3,6 +3,15 @@
 
 using namespace DirectX;
 
+namespace
+{
+	// How many keyframes a cursor steps forward before the search falls back to a binary search.
+	const UINT MaxCursorSteps = 4;
+
+	// How many poses one job evaluates in SkinnedData::EvaluatePoses.
+	const size_t PosesPerJob = 8;
+}
+
 Keyframe::Keyframe()
 	: TimePos(0.0f),
 	Translation(0.0f, 0.0f, 0.0f),
@@ -30,53 +39,67 @@ float BoneAnimation::GetEndTime()const
 }
 
 void BoneAnimation::Interpolate(float t, XMFLOAT4X4& M)const
+{
+	UINT cursor = 0;
+	XMVECTOR S, P, Q;
+	Sample(t, cursor, S, P, Q);
+
+	XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+}
+
+void BoneAnimation::Sample(float t, UINT& cursor, XMVECTOR& S, XMVECTOR& P, XMVECTOR& Q)const
 {
 	if (t <= Keyframes.front().TimePos)
 	{
-		XMVECTOR S = XMLoadFloat3(&Keyframes.front().Scale);
-		XMVECTOR P = XMLoadFloat3(&Keyframes.front().Translation);
-		XMVECTOR Q = XMLoadFloat4(&Keyframes.front().RotationQuat);
-
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		cursor = 0;
+		S = XMLoadFloat3(&Keyframes.front().Scale);
+		P = XMLoadFloat3(&Keyframes.front().Translation);
+		Q = XMLoadFloat4(&Keyframes.front().RotationQuat);
+		return;
 	}
-	else if (t >= Keyframes.back().TimePos)
+
+	if (t >= Keyframes.back().TimePos)
 	{
-		XMVECTOR S = XMLoadFloat3(&Keyframes.back().Scale);
-		XMVECTOR P = XMLoadFloat3(&Keyframes.back().Translation);
-		XMVECTOR Q = XMLoadFloat4(&Keyframes.back().RotationQuat);
+		S = XMLoadFloat3(&Keyframes.back().Scale);
+		P = XMLoadFloat3(&Keyframes.back().Translation);
+		Q = XMLoadFloat4(&Keyframes.back().RotationQuat);
+		return;
+	}
 
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+	// Find the keyframe i with Keyframes[i].TimePos < t <= Keyframes[i + 1].TimePos,
+	// first by stepping forward from the cursor, then by a binary search.
+	UINT last = (UINT)Keyframes.size() - 1;
+	UINT i = cursor;
+	if (i < last && Keyframes[i].TimePos < t)
+	{
+		for (UINT step = 0; step < MaxCursorSteps && Keyframes[i + 1].TimePos < t; ++step)
+			++i;
 	}
-	else
+
+	if (i >= last || !(Keyframes[i].TimePos < t) || Keyframes[i + 1].TimePos < t)
 	{
-		for (UINT i = 0; i < Keyframes.size() - 1; ++i)
-		{
-			if (t >= Keyframes[i].TimePos && t <= Keyframes[i + 1].TimePos)
-			{
-				float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i + 1].TimePos - Keyframes[i].TimePos);
+		auto next = std::lower_bound(Keyframes.begin(), Keyframes.end(), t,
+			[](const Keyframe& keyframe, float time) { return keyframe.TimePos < time; });
+		i = (UINT)(next - Keyframes.begin()) - 1;
+	}
 
-				XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
-				XMVECTOR s1 = XMLoadFloat3(&Keyframes[i + 1].Scale);
+	cursor = i;
 
-				XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
-				XMVECTOR p1 = XMLoadFloat3(&Keyframes[i + 1].Translation);
+	float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i + 1].TimePos - Keyframes[i].TimePos);
 
-				XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
-				XMVECTOR q1 = XMLoadFloat4(&Keyframes[i + 1].RotationQuat);
+	XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
+	XMVECTOR s1 = XMLoadFloat3(&Keyframes[i + 1].Scale);
 
-				XMVECTOR S = XMVectorLerp(s0, s1, lerpPercent);
-				XMVECTOR P = XMVectorLerp(p0, p1, lerpPercent);
-				XMVECTOR Q = XMQuaternionSlerp(q0, q1, lerpPercent);
+	XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
+	XMVECTOR p1 = XMLoadFloat3(&Keyframes[i + 1].Translation);
 
-				XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-				XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+	XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
+	XMVECTOR q1 = XMLoadFloat4(&Keyframes[i + 1].RotationQuat);
 
-				break;
-			}
-		}
-	}
+	S = XMVectorLerp(s0, s1, lerpPercent);
+	P = XMVectorLerp(p0, p1, lerpPercent);
+	Q = XMQuaternionSlerp(q0, q1, lerpPercent);
 }
 
 float AnimationClip::GetClipStartTime()const
@@ -137,45 +160,138 @@ void SkinnedData::Set(std::vector<int>& boneHierarchy,
 	mAnimations = animations;
 }
 
-void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos, std::vector<XMFLOAT4X4>& finalTransforms)const
+const AnimationClip* SkinnedData::FindClip(const std::string& clipName)const
 {
-	UINT numBones = mBoneOffsets.size();
-
-	std::vector<XMFLOAT4X4> toParentTransforms(numBones);
-
-	// Interpolate all the bones of this clip at the given time instance.
 	auto clip = mAnimations.find(clipName);
-	clip->second.Interpolate(timePos, toParentTransforms);
+	return clip != mAnimations.end() ? &clip->second : nullptr;
+}
 
-	//
-	// Traverse the hierarchy and transform all the bones to the root space.
-	//
+void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos, std::vector<XMFLOAT4X4>& finalTransforms)const
+{
+	AnimationLayer layer;
+	layer.Clip = FindClip(clipName);
+	layer.TimePos = timePos;
 
-	std::vector<XMFLOAT4X4> toRootTransforms(numBones);
+	// One state per thread keeps this entry point free of allocations as well.
+	thread_local SkinnedPoseState state;
+	GetFinalTransforms(&layer, 1, state, finalTransforms);
+}
 
-	// The root bone has index 0.  The root bone has no parent, so its toRootTransform
-	// is just its local bone transform.
-	toRootTransforms[0] = toParentTransforms[0];
+void SkinnedData::GetFinalTransforms(const AnimationLayer* layers, UINT layerCount, SkinnedPoseState& state,
+	std::vector<XMFLOAT4X4>& finalTransforms)const
+{
+	UINT numBones = (UINT)mBoneOffsets.size();
 
-	// Now find the toRootTransform of the children.
-	for (UINT i = 1; i < numBones; ++i)
+	// Start the cursors of a layer over when its clip changes.
+	if (state.KeyframeCursors.size() != (size_t)layerCount * numBones)
 	{
-		XMMATRIX toParent = XMLoadFloat4x4(&toParentTransforms[i]);
-
-		int parentIndex = mBoneHierarchy[i];
-		XMMATRIX parentToRoot = XMLoadFloat4x4(&toRootTransforms[parentIndex]);
+		state.KeyframeCursors.assign((size_t)layerCount * numBones, 0);
+		state.LayerClips.assign(layerCount, nullptr);
+	}
 
-		XMMATRIX toRoot = XMMatrixMultiply(toParent, parentToRoot);
+	for (UINT layer = 0; layer < layerCount; ++layer)
+	{
+		if (state.LayerClips[layer] != layers[layer].Clip)
+		{
+			state.LayerClips[layer] = layers[layer].Clip;
+			std::fill_n(state.KeyframeCursors.begin() + (size_t)layer * numBones, numBones, 0);
+		}
+	}
 
-		XMStoreFloat4x4(&toRootTransforms[i], toRoot);
+	float totalWeight = 0.0f;
+	for (UINT layer = 0; layer < layerCount; ++layer)
+	{
+		if (layers[layer].Clip && layers[layer].Weight > 0.0f)
+			totalWeight += layers[layer].Weight;
 	}
 
-	// Premultiply by the bone offset transform to get the final transform.
+	state.ToRootTransforms.resize(numBones);
+	finalTransforms.resize(numBones);
+
+	XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Parents come before their children, so the root space transform of the parent 
+	// is known when a bone is reached.
 	for (UINT i = 0; i < numBones; ++i)
 	{
+		// Blend the layers: scale and translation linearly, rotations by a normalized
+		// sum in the hemisphere of the first one.  A single layer is used as it is.
+		XMVECTOR S = XMVectorSplatOne();
+		XMVECTOR P = XMVectorZero();
+		XMVECTOR Q = XMQuaternionIdentity();
+		UINT blendedLayers = 0;
+
+		for (UINT layer = 0; layer < layerCount; ++layer)
+		{
+			const AnimationClip* clip = layers[layer].Clip;
+			if (!clip || layers[layer].Weight <= 0.0f || i >= clip->BoneAnimations.size())
+				continue;
+
+			XMVECTOR s, p, q;
+			UINT& cursor = state.KeyframeCursors[(size_t)layer * numBones + i];
+			clip->BoneAnimations[i].Sample(layers[layer].TimePos, cursor, s, p, q);
+
+			if (layers[layer].Weight == totalWeight)
+			{
+				S = s;
+				P = p;
+				Q = q;
+				blendedLayers = 1;
+				break;
+			}
+
+			XMVECTOR w = XMVectorReplicate(layers[layer].Weight / totalWeight);
+			if (blendedLayers == 0)
+			{
+				S = XMVectorMultiply(s, w);
+				P = XMVectorMultiply(p, w);
+				Q = XMVectorMultiply(q, w);
+			}
+			else
+			{
+				if (XMVectorGetX(XMQuaternionDot(Q, q)) < 0.0f)
+					q = XMVectorNegate(q);
+
+				S = XMVectorMultiplyAdd(s, w, S);
+				P = XMVectorMultiplyAdd(p, w, P);
+				Q = XMVectorMultiplyAdd(q, w, Q);
+			}
+			++blendedLayers;
+		}
+
+		if (blendedLayers > 1)
+			Q = XMQuaternionNormalize(Q);
+
+		XMMATRIX toRoot = XMMatrixAffineTransformation(S, zero, Q, P);
+		if (i > 0)
+		{
+			int parentIndex = mBoneHierarchy[i];
+			XMMATRIX parentToRoot = XMLoadFloat4x4(&state.ToRootTransforms[parentIndex]);
+			toRoot = XMMatrixMultiply(toRoot, parentToRoot);
+		}
+		XMStoreFloat4x4(&state.ToRootTransforms[i], toRoot);
+
+		// Premultiply by the bone offset transform to get the final transform.
 		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
-		XMMATRIX toRoot = XMLoadFloat4x4(&toRootTransforms[i]);
 		XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
 		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
 	}
-}
\ No newline at end of file
+}
+
+void SkinnedData::EvaluatePoses(const SkinnedPoseTask* tasks, size_t taskCount,
+	const SkinnedParallelFor& parallelFor)
+{
+	auto evaluate = [tasks](size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; ++i)
+		{
+			const SkinnedPoseTask& task = tasks[i];
+			task.Skeleton->GetFinalTransforms(task.Layers, task.LayerCount, *task.State, *task.FinalTransforms);
+		}
+	};
+
+	if (parallelFor)
+		parallelFor(taskCount, PosesPerJob, evaluate);
+	else
+		evaluate(0, taskCount);
+}
@@ -2,6 +2,9 @@
 
 #ifndef SKINNEDDATA_H
 #define SKINNEDDATA_H
+
+#include <functional>
+
 ///<summary>
 /// A Keyframe defines the bone transformation at an instant in time.
 ///</summary>
@@ -30,6 +33,11 @@ struct BoneAnimation
 
 	void Interpolate(float t, DirectX::XMFLOAT4X4& M)const;
 
+	// Samples the bone's scale, translation and rotation at time t.  The cursor is the 
+	// keyframe found by the previous call; when t moves forward it is reused instead of
+	// searching the keyframes again.
+	void Sample(float t, UINT& cursor, DirectX::XMVECTOR& S, DirectX::XMVECTOR& P, DirectX::XMVECTOR& Q)const;
+
 	std::vector<Keyframe> Keyframes;
 };
 
@@ -48,6 +56,52 @@ struct AnimationClip
 	std::vector<BoneAnimation> BoneAnimations;
 };
 
+///<summary>
+/// One clip contributing to a pose.  The layers of a pose are blended by 
+/// their weights, which do not need to sum to one.
+///</summary>
+struct AnimationLayer
+{
+	const AnimationClip* Clip = nullptr;
+	float TimePos = 0.0f;
+	float Weight = 1.0f;
+};
+
+///<summary>
+/// The evaluation state of one character: a keyframe cursor per layer and 
+/// bone, and scratch space for the hierarchy pass.  Keep one per character
+/// and reuse it every frame, so that evaluating a pose does not allocate.
+///</summary>
+struct SkinnedPoseState
+{
+	std::vector<const AnimationClip*> LayerClips;
+	std::vector<UINT> KeyframeCursors;
+	std::vector<DirectX::XMFLOAT4X4> ToRootTransforms;
+};
+
+class SkinnedData;
+
+///<summary>
+/// A pose to evaluate with SkinnedData::EvaluatePoses.
+///</summary>
+struct SkinnedPoseTask
+{
+	const SkinnedData* Skeleton = nullptr;
+	const AnimationLayer* Layers = nullptr;
+	UINT LayerCount = 0;
+	SkinnedPoseState* State = nullptr;
+	std::vector<DirectX::XMFLOAT4X4>* FinalTransforms = nullptr;
+};
+
+///<summary>
+/// Calls func(first, last) for consecutive ranges of at most grainSize that cover
+/// [0, count), possibly on several threads, and returns when all ranges are done.
+/// EngineCore has no job system of its own, so the caller provides one, for 
+/// example ECS::MakeParallelForFunction().
+///</summary>
+typedef std::function<void(size_t count, size_t grainSize,
+	const std::function<void(size_t first, size_t last)>& func)> SkinnedParallelFor;
+
 class SkinnedData
 {
 public:
@@ -62,12 +116,27 @@ public:
 		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
 		std::unordered_map<std::string, AnimationClip>& animations);
 
+	// Returns nullptr if there is no clip with that name.  The pointer stays 
+	// valid until Set is called again.
+	const AnimationClip* FindClip(const std::string& clipName)const;
+
 	// In a real project, you'd want to cache the result if there was a chance
 	// that you were calling this several times with the same clipName at 
 	// the same timePos.
 	void GetFinalTransforms(const std::string& clipName, float timePos,
 		std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
 
+	// Blends the layers into one pose and writes the final transforms.  The 
+	// cursors in 'state' speed up the keyframe search when the layer times 
+	// advance from one call to the next.
+	void GetFinalTransforms(const AnimationLayer* layers, UINT layerCount, SkinnedPoseState& state,
+		std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
+
+	// Evaluates many poses, in parallel when 'parallelFor' is given and on the 
+	// calling thread otherwise.  Each task needs its own state and output.
+	static void EvaluatePoses(const SkinnedPoseTask* tasks, size_t taskCount,
+		const SkinnedParallelFor& parallelFor = nullptr);
+
 private:
 	// Gives parentIndex of ith bone.
 	std::vector<int> mBoneHierarchy;
@@ -0,0 +1,254 @@
+#include "pch.h"
+
+#include <chrono>
+#include <cstdio>
+
+// Converts text .m3d models to the binary .m3db format that M3DLoader::LoadM3d reads through a memory map.
+//
+//	M3dConverter <input.m3d> [output.m3db]
+//	M3dConverter --benchmark <input.m3d>
+//
+// The benchmark converts the model to a temporary file, times the text and binary loaders, checks that
+// both return the same data and that corrupted binaries are rejected.
+
+namespace
+{
+	int gFailureCount = 0;
+
+	template<typename Func>
+	double MeasureBest(int repeat, Func&& func)
+	{
+		double best = 1e30;
+		for (int i = 0; i < repeat; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			func();
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (ms < best)
+				best = ms;
+		}
+		return best;
+	}
+
+	void Check(bool condition, const char* what)
+	{
+		std::printf("  %-52s %s\n", what, condition ? "ok" : "FAILED");
+		if (!condition)
+			++gFailureCount;
+	}
+
+	struct SkinnedModel
+	{
+		std::vector<GeometryGenerator::SkinnedVertex> Vertices;
+		std::vector<std::uint32_t> Indices;
+		std::vector<M3DLoader::Subset> Subsets;
+		std::vector<M3DLoader::M3dMaterial> Materials;
+		SkinnedData SkinInfo;
+
+		bool Load(const std::string& filename)
+		{
+			*this = SkinnedModel();
+			return M3DLoader::LoadM3d(filename, Vertices, Indices, Subsets, Materials, SkinInfo);
+		}
+	};
+
+	template<typename T>
+	bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	bool SameMaterials(const std::vector<M3DLoader::M3dMaterial>& a, const std::vector<M3DLoader::M3dMaterial>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (a[i].Name != b[i].Name || a[i].MaterialTypeName != b[i].MaterialTypeName ||
+				a[i].DiffuseMapName != b[i].DiffuseMapName || a[i].NormalMapName != b[i].NormalMapName ||
+				a[i].Roughness != b[i].Roughness || a[i].AlphaClip != b[i].AlphaClip ||
+				std::memcmp(&a[i].DiffuseAlbedo, &b[i].DiffuseAlbedo, sizeof(a[i].DiffuseAlbedo)) != 0 ||
+				std::memcmp(&a[i].FresnelR0, &b[i].FresnelR0, sizeof(a[i].FresnelR0)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// Samples every clip of both skeletons and compares the final bone transforms.
+	bool SameAnimation(const SkinnedData& a, const SkinnedData& b, const std::vector<std::string>& clipNames)
+	{
+		if (a.BoneCount() != b.BoneCount())
+			return false;
+
+		std::vector<DirectX::XMFLOAT4X4> transformsA(a.BoneCount());
+		std::vector<DirectX::XMFLOAT4X4> transformsB(b.BoneCount());
+		for (const std::string& clipName : clipNames)
+		{
+			float endTime = a.GetClipEndTime(clipName);
+			if (endTime != b.GetClipEndTime(clipName))
+				return false;
+			for (float t = 0.0f; t <= endTime; t += endTime / 64.0f + 0.001f)
+			{
+				a.GetFinalTransforms(clipName, t, transformsA);
+				b.GetFinalTransforms(clipName, t, transformsB);
+				if (!SameBytes(transformsA, transformsB))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Offsets of the bone hierarchy and of the first clip's keyframe counts, and the clip names, following the layout
+	// written by ConvertM3dToM3db.  SkinnedData does not list its clips, so the names are taken from the file.
+	struct M3dbLayout
+	{
+		size_t BoneHierarchy = 0;
+		size_t FirstKeyframeCounts = 0;
+		std::vector<std::string> ClipNames;
+	};
+
+	M3dbLayout FindLayout(const SkinnedModel& model, const std::vector<char>& bytes)
+	{
+		auto align = [](size_t offset) { return (offset + 3) & ~size_t(3); };
+		const size_t boneCount = model.SkinInfo.BoneCount();
+
+		size_t offset = 32 + model.Materials.size() * 52;
+		for (const M3DLoader::M3dMaterial& mat : model.Materials)
+			offset += mat.Name.size() + mat.MaterialTypeName.size() + mat.DiffuseMapName.size() + mat.NormalMapName.size();
+		offset = align(offset);
+		offset += model.Subsets.size() * sizeof(M3DLoader::Subset);
+		offset += model.Vertices.size() * sizeof(GeometryGenerator::SkinnedVertex);
+		offset += model.Indices.size() * sizeof(std::uint32_t);
+		offset += boneCount * sizeof(DirectX::XMFLOAT4X4);
+
+		M3dbLayout layout;
+		layout.BoneHierarchy = offset;
+		offset += boneCount * sizeof(int);
+
+		while (offset + sizeof(std::uint32_t) <= bytes.size())
+		{
+			std::uint32_t nameLength = 0;
+			std::memcpy(&nameLength, bytes.data() + offset, sizeof(nameLength));
+			layout.ClipNames.emplace_back(bytes.data() + offset + sizeof(nameLength), nameLength);
+			offset = align(offset + sizeof(nameLength) + nameLength);
+			if (layout.ClipNames.size() == 1)
+				layout.FirstKeyframeCounts = offset;
+
+			size_t keyframeCount = 0;
+			for (size_t i = 0; i < boneCount; ++i)
+			{
+				std::uint32_t count = 0;
+				std::memcpy(&count, bytes.data() + offset + i * sizeof(count), sizeof(count));
+				keyframeCount += count;
+			}
+			offset += boneCount * sizeof(std::uint32_t) + keyframeCount * 44;
+		}
+		return layout;
+	}
+
+	std::vector<char> ReadBytes(const std::string& filename)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		return std::vector<char>((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+	}
+
+	bool LoadPatched(const std::vector<char>& bytes, size_t offset, std::int32_t value, const std::string& filename)
+	{
+		std::vector<char> patched = bytes;
+		std::memcpy(patched.data() + offset, &value, sizeof(value));
+		std::ofstream(filename, std::ios::binary | std::ios::trunc).write(patched.data(), std::streamsize(patched.size()));
+
+		SkinnedModel model;
+		return model.Load(filename);
+	}
+
+	int RunBenchmark(const std::string& m3dFilename)
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path();
+		const std::string m3dbFilename = (directory / "M3dConverterBenchmark.m3db").string();
+		const std::string corruptFilename = (directory / "M3dConverterCorrupt.m3db").string();
+
+		std::printf("[M3d] text parser vs memory-mapped binary, %s\n", m3dFilename.c_str());
+
+		bool converted = false;
+		double convertMs = MeasureBest(1, [&]() { converted = M3DLoader::ConvertM3dToM3db(m3dFilename, m3dbFilename); });
+		std::printf("  %-52s %10.2f ms\n", "ConvertM3dToM3db", convertMs);
+		Check(converted, "conversion succeeds");
+		if (!converted)
+			return 1;
+
+		SkinnedModel text;
+		SkinnedModel binary;
+		bool textLoaded = true;
+		bool binaryLoaded = true;
+		double textMs = MeasureBest(5, [&]() { textLoaded &= text.Load(m3dFilename); });
+		std::printf("  %-52s %10.2f ms\n", "LoadM3d (text)", textMs);
+		double binaryMs = MeasureBest(5, [&]() { binaryLoaded &= binary.Load(m3dbFilename); });
+		std::printf("  %-52s %10.2f ms\n", "LoadM3d (.m3db)", binaryMs);
+		std::printf("  %zu vertices, %zu triangles, %u bones\n", text.Vertices.size(), text.Indices.size() / 3, text.SkinInfo.BoneCount());
+
+		const std::vector<char> bytes = ReadBytes(m3dbFilename);
+		const M3dbLayout layout = FindLayout(text, bytes);
+
+		Check(textLoaded && binaryLoaded, "both loaders succeed");
+		Check(SameBytes(text.Vertices, binary.Vertices) && SameBytes(text.Indices, binary.Indices) &&
+			SameBytes(text.Subsets, binary.Subsets), "binary geometry matches the text model");
+		Check(SameMaterials(text.Materials, binary.Materials), "binary materials match the text model");
+		Check(!layout.ClipNames.empty() && SameAnimation(text.SkinInfo, binary.SkinInfo, layout.ClipNames), "binary animation matches the text model");
+
+		std::vector<GeometryGenerator::Vertex> staticVertices;
+		std::vector<std::uint32_t> staticIndices;
+		std::vector<M3DLoader::Subset> staticSubsets;
+		std::vector<M3DLoader::M3dMaterial> staticMaterials;
+		bool staticLoaded = M3DLoader::LoadM3d(m3dbFilename, staticVertices, staticIndices, staticSubsets, staticMaterials);
+		Check(staticLoaded && staticVertices.size() == text.Vertices.size() && staticIndices == text.Indices,
+			"skinned .m3db loads as a static mesh");
+
+		Check(!LoadPatched(bytes, layout.BoneHierarchy, 0, corruptFilename), "root bone with a parent is rejected");
+		if (text.SkinInfo.BoneCount() > 1)
+		{
+			const size_t lastBone = layout.BoneHierarchy + (text.SkinInfo.BoneCount() - 1) * sizeof(int);
+			Check(!LoadPatched(bytes, lastBone, std::int32_t(text.SkinInfo.BoneCount() - 1), corruptFilename), "bone parented to itself is rejected");
+			Check(!LoadPatched(bytes, lastBone, std::int32_t(text.SkinInfo.BoneCount()), corruptFilename), "parent index past the bone count is rejected");
+		}
+		if (!layout.ClipNames.empty())
+			Check(!LoadPatched(bytes, layout.FirstKeyframeCounts, 0, corruptFilename), "bone without keyframes is rejected");
+		std::vector<char> truncated(bytes.begin(), bytes.end() - 16);
+		std::ofstream(corruptFilename, std::ios::binary | std::ios::trunc).write(truncated.data(), std::streamsize(truncated.size()));
+		Check(!SkinnedModel().Load(corruptFilename), "truncated file is rejected");
+
+		std::filesystem::remove(m3dbFilename);
+		std::filesystem::remove(corruptFilename);
+
+		if (gFailureCount > 0)
+		{
+			std::printf("%d check(s) failed\n", gFailureCount);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 3 && std::string(argv[1]) == "--benchmark")
+		return RunBenchmark(argv[2]);
+
+	if (argc != 2 && argc != 3)
+	{
+		std::printf("usage: M3dConverter <input.m3d> [output.m3db]\n");
+		std::printf("       M3dConverter --benchmark <input.m3d>\n");
+		return 1;
+	}
+
+	const std::string m3dFilename = argv[1];
+	const std::string m3dbFilename = argc == 3 ? std::string(argv[2]) : std::filesystem::path(m3dFilename).replace_extension(".m3db").string();
+	if (!M3DLoader::ConvertM3dToM3db(m3dFilename, m3dbFilename))
+	{
+		std::printf("failed to convert %s\n", m3dFilename.c_str());
+		return 1;
+	}
+
+	std::printf("%s -> %s\n", m3dFilename.c_str(), m3dbFilename.c_str());
+	return 0;
+}
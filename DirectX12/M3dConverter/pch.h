@@ -0,0 +1,9 @@
+#pragma once
+
+#ifdef _DEBUG
+#pragma comment(lib, "EngineCore\\Debug\\EngineCore.lib")
+#else
+#pragma comment(lib, "EngineCore\\Release\\EngineCore.lib")
+#endif
+
+#include "../EngineCore/EngineCorePch.h"
@@ -31,6 +31,169 @@ namespace ShaderMake
 static const char* g_BlobSignature = "NVSP";
 static size_t g_BlobSignatureSize = 4;
 
+static const char* g_BlobIndexSignature = "NVSI";
+static const uint32_t g_BlobIndexVersion = 2;
+
+static const uint64_t g_FnvPrime = 1099511628211ull;
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= g_FnvPrime;
+    }
+
+    return hash;
+}
+
+uint64_t HashPermutationKey(const char* permutationKey, size_t permutationKeySize)
+{
+    return HashBytes(FnvOffsetBasis, permutationKey, permutationKeySize);
+}
+
+uint64_t HashShaderConstants(const ShaderConstant* constants, uint32_t numConstants)
+{
+    uint64_t hash = FnvOffsetBasis;
+    for (uint32_t n = 0; n < numConstants; n++)
+    {
+        const ShaderConstant& constant = constants[n];
+        hash = HashBytes(hash, constant.name, strlen(constant.name));
+        hash = HashBytes(hash, "=", 1);
+        hash = HashBytes(hash, constant.value, strlen(constant.value));
+        if (n + 1 < numConstants)
+            hash = HashBytes(hash, " ", 1);
+    }
+
+    return hash;
+}
+
+static bool SkipPrefix(const char*& key, const char* keyEnd, const char* prefix, size_t prefixSize)
+{
+    if (size_t(keyEnd - key) < prefixSize || memcmp(key, prefix, prefixSize) != 0)
+        return false;
+
+    key += prefixSize;
+
+    return true;
+}
+
+// Compares a stored key with "NAME1=VALUE1 NAME2=VALUE2 ..." built from the constants, without building the string
+static bool PermutationKeyEquals(const char* key, size_t keySize, const ShaderConstant* constants, uint32_t numConstants)
+{
+    const char* keyEnd = key + keySize;
+    for (uint32_t n = 0; n < numConstants; n++)
+    {
+        const ShaderConstant& constant = constants[n];
+        if (n > 0 && !SkipPrefix(key, keyEnd, " ", 1))
+            return false;
+        if (!SkipPrefix(key, keyEnd, constant.name, strlen(constant.name)))
+            return false;
+        if (!SkipPrefix(key, keyEnd, "=", 1))
+            return false;
+        if (!SkipPrefix(key, keyEnd, constant.value, strlen(constant.value)))
+            return false;
+    }
+
+    return key == keyEnd;
+}
+
+// Returns the entry at the given offset if it fits into the first "limit" bytes of the blob
+static const ShaderBlobEntry* GetEntry(const void* blob, uint64_t limit, uint64_t offset)
+{
+    if (offset < g_BlobSignatureSize || limit < sizeof(ShaderBlobEntry) || offset > limit - sizeof(ShaderBlobEntry))
+        return nullptr;
+
+    const ShaderBlobEntry* header = reinterpret_cast<const ShaderBlobEntry*>(static_cast<const char*>(blob) + offset);
+    if (header->dataSize == 0 || limit - offset - sizeof(ShaderBlobEntry) < uint64_t(header->permutationSize) + header->dataSize)
+        return nullptr;
+
+    return header;
+}
+
+static bool ReadIndexFooter(const void* blob, size_t blobSize, ShaderBlobIndexFooter& footer)
+{
+    if (blobSize < g_BlobSignatureSize + sizeof(ShaderBlobEntry) + sizeof(ShaderBlobIndexFooter))
+        return false;
+
+    memcpy(&footer, static_cast<const char*>(blob) + blobSize - sizeof(ShaderBlobIndexFooter), sizeof(ShaderBlobIndexFooter));
+
+    if (memcmp(footer.signature, g_BlobIndexSignature, sizeof(footer.signature)) != 0 || footer.version != g_BlobIndexVersion)
+        return false;
+
+    if (footer.slotCount == 0 || (footer.slotCount & (footer.slotCount - 1)) != 0)
+        return false;
+
+    // The index must end exactly where the footer starts
+    uint64_t indexSize = uint64_t(footer.slotCount) * sizeof(ShaderBlobIndexSlot);
+    uint64_t footerOffset = blobSize - sizeof(ShaderBlobIndexFooter);
+
+    return footer.indexOffset >= g_BlobSignatureSize + sizeof(ShaderBlobEntry) && footer.indexOffset <= footerOffset && footerOffset - footer.indexOffset == indexSize;
+}
+
+// O(1) lookup through the index. Sets "hasIndex" to false if the blob has no valid index.
+static const ShaderBlobEntry* FindEntryInIndex(const void* blob, size_t blobSize, uint64_t permutationHash, bool& hasIndex)
+{
+    ShaderBlobIndexFooter footer;
+    hasIndex = ReadIndexFooter(blob, blobSize, footer);
+    if (!hasIndex)
+        return nullptr;
+
+    const char* slots = static_cast<const char*>(blob) + footer.indexOffset;
+    const uint32_t mask = footer.slotCount - 1;
+
+    // Entries end at the terminator right before the index
+    const uint64_t entriesEnd = footer.indexOffset - sizeof(ShaderBlobEntry);
+
+    for (uint32_t probe = 0; probe < footer.slotCount; probe++)
+    {
+        ShaderBlobIndexSlot slot;
+        memcpy(&slot, slots + ((permutationHash + probe) & mask) * sizeof(ShaderBlobIndexSlot), sizeof(slot));
+
+        if (slot.entryOffset == 0)
+            return nullptr; // empty slot, the permutation is not in the blob
+
+        if (slot.hash == permutationHash)
+            return GetEntry(blob, entriesEnd, slot.entryOffset);
+    }
+
+    return nullptr;
+}
+
+// Linear search through the entries, used for blobs written without an index.
+// Compares the keys with "permutationKey" if it is set, otherwise the key hashes with "permutationHash".
+static const ShaderBlobEntry* FindEntryLinear(const void* blob, size_t blobSize, const std::string* permutationKey, uint64_t permutationHash)
+{
+    uint64_t offset = g_BlobSignatureSize;
+    while (const ShaderBlobEntry* header = GetEntry(blob, blobSize, offset))
+    {
+        const char* entryPermutation = reinterpret_cast<const char*>(header) + sizeof(ShaderBlobEntry);
+
+        bool match = permutationKey
+            ? header->permutationSize == permutationKey->size() && memcmp(entryPermutation, permutationKey->data(), permutationKey->size()) == 0
+            : HashPermutationKey(entryPermutation, header->permutationSize) == permutationHash;
+
+        if (match)
+            return header;
+
+        offset += sizeof(ShaderBlobEntry) + header->permutationSize + header->dataSize;
+    }
+
+    return nullptr; // went through the blob, permutation not found
+}
+
+static bool IsPermutationBlob(const void* blob, size_t blobSize)
+{
+    return blobSize >= g_BlobSignatureSize && memcmp(blob, g_BlobSignature, g_BlobSignatureSize) == 0;
+}
+
+static void GetEntryBinary(const ShaderBlobEntry* header, const void** pBinary, size_t* pSize)
+{
+    *pBinary = reinterpret_cast<const char*>(header) + sizeof(ShaderBlobEntry) + header->permutationSize;
+    *pSize = header->dataSize;
+}
+
 bool FindPermutationInBlob(const void* blob, size_t blobSize, const ShaderConstant* constants, uint32_t numConstants, const void** pBinary, size_t* pSize)
 {
     if (!blob || blobSize < g_BlobSignatureSize)
@@ -39,7 +202,7 @@ bool FindPermutationInBlob(const void* blob, size_t blobSize, const ShaderConsta
     if (!pBinary || !pSize)
         return false;
 
-    if (memcmp(blob, g_BlobSignature, g_BlobSignatureSize) != 0)
+    if (!IsPermutationBlob(blob, blobSize))
     {
         if (numConstants == 0)
         {
@@ -52,47 +215,70 @@ bool FindPermutationInBlob(const void* blob, size_t blobSize, const ShaderConsta
             return false; // this blob is not a permutation blob, but the caller requested a permutation
     }
 
-    blob = static_cast<const char*>(blob) + g_BlobSignatureSize;
-    blobSize -= g_BlobSignatureSize;
+    bool hasIndex;
+    const uint64_t permutationHash = HashShaderConstants(constants, numConstants);
+    const ShaderBlobEntry* header = FindEntryInIndex(blob, blobSize, permutationHash, hasIndex);
 
-    std::stringstream ss;
-    for (uint32_t n = 0; n < numConstants; n++)
+    if (hasIndex)
     {
-        const ShaderConstant& constant = constants[n];
-        ss << constant.name << "=" << constant.value;
-        if (n + 1 < numConstants)
-            ss << " ";
+        // The hash only selects the candidate, the key itself must match
+        if (!header || !PermutationKeyEquals(reinterpret_cast<const char*>(header) + sizeof(ShaderBlobEntry), header->permutationSize, constants, numConstants))
+            return false;
     }
-    std::string permutation = ss.str();
-
-    while (blobSize > sizeof(ShaderBlobEntry))
+    else
     {
-        const ShaderBlobEntry* header = static_cast<const ShaderBlobEntry*>(blob);
+        std::string permutation;
+        for (uint32_t n = 0; n < numConstants; n++)
+        {
+            const ShaderConstant& constant = constants[n];
+            permutation.append(constant.name).append("=").append(constant.value);
+            if (n + 1 < numConstants)
+                permutation.append(" ");
+        }
 
-        if (header->dataSize == 0)
-            return false; // last header in the blob is empty
+        header = FindEntryLinear(blob, blobSize, &permutation, 0);
+    }
 
-        if (blobSize < sizeof(ShaderBlobEntry) + header->dataSize + header->permutationSize)
-            return false; // insufficient bytes in the blob, cannot continue
+    if (!header)
+        return false;
 
-        const char* entryPermutation = static_cast<const char*>(blob) + sizeof(ShaderBlobEntry);
+    GetEntryBinary(header, pBinary, pSize);
 
-        if ((header->permutationSize == permutation.size()) && ((permutation.size() == 0) || (strncmp(entryPermutation, permutation.data(), permutation.size()) == 0)))
-        {
-            const char* binary = static_cast<const char*>(blob) + sizeof(ShaderBlobEntry) + header->permutationSize;
+    return true;
+}
 
-            *pBinary = binary;
-            *pSize = header->dataSize;
+bool FindPermutationInBlobByHash(const void* blob, size_t blobSize, uint64_t permutationHash, const void** pBinary, size_t* pSize)
+{
+    if (!blob || blobSize < g_BlobSignatureSize)
+        return false;
 
-            return true;
-        }
+    if (!pBinary || !pSize)
+        return false;
 
-        size_t offset = sizeof(ShaderBlobEntry) + header->dataSize + header->permutationSize;
-        blob = static_cast<const char*>(blob) + offset;
-        blobSize -= offset;
+    if (!IsPermutationBlob(blob, blobSize))
+    {
+        if (permutationHash == FnvOffsetBasis)
+        {
+            *pBinary = blob;
+            *pSize = blobSize;
+
+            return true; // this blob is not a permutation blob, and the default permutation is requested
+        }
+        else
+            return false;
     }
 
-    return false; // went through the blob, permutation not found
+    bool hasIndex;
+    const ShaderBlobEntry* header = FindEntryInIndex(blob, blobSize, permutationHash, hasIndex);
+    if (!hasIndex)
+        header = FindEntryLinear(blob, blobSize, nullptr, permutationHash);
+
+    if (!header)
+        return false;
+
+    GetEntryBinary(header, pBinary, pSize);
+
+    return true;
 }
 
 void EnumeratePermutationsInBlob(const void* blob, size_t blobSize, std::vector<std::string>& permutations)
@@ -180,7 +366,8 @@ bool WritePermutation(
     void* context,
     const std::string& permutationKey,
     const void* binary,
-    size_t binarySize)
+    size_t binarySize,
+    ShaderBlobIndex* index)
 {
     ShaderBlobEntry binaryEntry{};
     binaryEntry.permutationSize = (uint32_t)permutationKey.size();
@@ -190,6 +377,55 @@ bool WritePermutation(
     success = write(&binaryEntry, sizeof(binaryEntry), context);
     success &= write(permutationKey.data(), binaryEntry.permutationSize, context);
     success &= write(binary, binarySize, context);
+
+    if (success && index)
+    {
+        index->entries.push_back({ HashPermutationKey(permutationKey.data(), permutationKey.size()), index->offset });
+        index->offset += sizeof(binaryEntry) + binaryEntry.permutationSize + binaryEntry.dataSize;
+    }
+
+    return success;
+}
+
+bool WritePermutationIndex(
+    WriteFileCallback write,
+    void* context,
+    const ShaderBlobIndex& index)
+{
+    // At most half full, so that probe sequences stay short
+    uint32_t slotCount = 1;
+    while (slotCount < index.entries.size() * 2)
+        slotCount *= 2;
+
+    std::vector<ShaderBlobIndexSlot> slots(slotCount, ShaderBlobIndexSlot{});
+    for (const ShaderBlobIndex::Entry& entry : index.entries)
+    {
+        uint64_t slot = entry.hash & (slotCount - 1);
+        while (slots[slot].entryOffset != 0)
+        {
+            if (slots[slot].hash == entry.hash)
+                return false; // lookups by hash can't tell these permutations apart
+
+            slot = (slot + 1) & (slotCount - 1);
+        }
+
+        slots[slot].hash = entry.hash;
+        slots[slot].entryOffset = entry.offset;
+    }
+
+    ShaderBlobEntry terminator{};
+
+    ShaderBlobIndexFooter footer{};
+    footer.indexOffset = index.offset + sizeof(terminator);
+    footer.slotCount = slotCount;
+    footer.permutationCount = (uint32_t)index.entries.size();
+    footer.version = g_BlobIndexVersion;
+    memcpy(footer.signature, g_BlobIndexSignature, sizeof(footer.signature));
+
+    bool success;
+    success = write(&terminator, sizeof(terminator), context);
+    success &= write(slots.data(), slots.size() * sizeof(ShaderBlobIndexSlot), context);
+    success &= write(&footer, sizeof(footer), context);
     return success;
 }
 
@@ -42,6 +42,63 @@ struct ShaderBlobEntry
     uint32_t dataSize;
 };
 
+// Blob layout:
+//   "NVSP"
+//   { ShaderBlobEntry, permutation key, binary } for each permutation
+//   ShaderBlobEntry { 0, 0 }                  - terminator, readers of the original layout stop here
+//   ShaderBlobIndexSlot[slotCount]            - open addressing hash table, slotCount is a power of 2
+//   ShaderBlobIndexFooter
+// The index is optional: blobs without a valid footer are searched linearly.
+
+struct ShaderBlobIndexSlot
+{
+    uint64_t hash;
+    uint64_t entryOffset; // offset of the ShaderBlobEntry from the start of the blob, 0 for an empty slot
+};
+
+struct ShaderBlobIndexFooter
+{
+    uint64_t indexOffset;
+    uint32_t slotCount;
+    uint32_t permutationCount;
+    uint32_t version;
+    char signature[4];
+};
+
+// Collects the entry offsets written by "WritePermutation" for "WritePermutationIndex"
+struct ShaderBlobIndex
+{
+    struct Entry
+    {
+        uint64_t hash;
+        uint64_t offset;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t offset = 4; // bytes written so far, starts after the signature
+};
+
+// FNV-1a, stable between runs and platforms. Start with "FnvOffsetBasis" and chain calls to hash several values.
+constexpr uint64_t FnvOffsetBasis = 14695981039346656037ull;
+
+uint64_t HashBytes(
+    uint64_t hash,
+    const void* data,
+    size_t size
+);
+
+// FNV-1a hash of the permutation key "NAME1=VALUE1 NAME2=VALUE2 ...".
+// Both functions return the same value for the same permutation, so the hash can be computed once and reused.
+uint64_t HashPermutationKey(
+    const char* permutationKey,
+    size_t permutationKeySize
+);
+
+uint64_t HashShaderConstants(
+    const ShaderConstant* constants,
+    uint32_t numConstants
+);
+
 bool FindPermutationInBlob(
     const void* blob,
     size_t blobSize,
@@ -51,6 +108,16 @@ bool FindPermutationInBlob(
     size_t* pSize
 );
 
+// Looks the permutation up by a precomputed "HashShaderConstants" value without comparing the key.
+// Hashes are unique within a blob (ShaderMake refuses to write colliding keys).
+bool FindPermutationInBlobByHash(
+    const void* blob,
+    size_t blobSize,
+    uint64_t permutationHash,
+    const void** pBinary,
+    size_t* pSize
+);
+
 void EnumeratePermutationsInBlob(
     const void* blob,
     size_t blobSize,
@@ -76,7 +143,16 @@ bool WritePermutation(
     void* context,
 	const std::string& permutationKey,
 	const void* binary,
-	size_t binarySize
+	size_t binarySize,
+    ShaderBlobIndex* index = nullptr
+);
+
+// Writes the terminator, the hash index and the footer after the last permutation.
+// Fails if two permutation keys have the same hash.
+bool WritePermutationIndex(
+    WriteFileCallback write,
+    void* context,
+    const ShaderBlobIndex& index
 );
 
 } // namespace ShaderMake
\ No newline at end of file
@@ -45,6 +45,8 @@ THE SOFTWARE.
 
     #include <wrl/client.h>
     using Microsoft::WRL::ComPtr;
+
+    #include <process.h> // _getpid
 #else
     #include <unistd.h>
     #include <limits.h>
@@ -61,11 +63,13 @@ namespace fs = filesystem;
 #define USE_GLOBAL_OPTIMIZATION_LEVEL 0xFF
 #define SPIRV_SPACES_NUM 8
 #define PDB_DIR "PDB"
+#define BUILD_CACHE_VERSION 1 // bump if the same inputs start producing different outputs
 
 #ifdef _MSC_VER
     #define popen _popen
     #define pclose _pclose
     #define putenv _putenv
+    #define getpid _getpid
 #endif
 
 enum Platform : uint8_t
@@ -93,6 +97,7 @@ struct Options
     const char* compiler = nullptr;
     const char* outputExt = nullptr;
     const char* vulkanMemoryLayout = nullptr;
+    const char* cacheDir = nullptr;
     uint32_t sRegShift = 100; // must be first (or change "DxcCompile" code)
     uint32_t tRegShift = 200;
     uint32_t bRegShift = 300;
@@ -151,6 +156,8 @@ struct TaskData
     string profile;
     string outputFileWithoutExt;
     string combinedDefines;
+    string blobName;
+    uint64_t cacheKey = 0;
     uint32_t optimizationLevel = 3;
 };
 
@@ -158,10 +165,27 @@ struct BlobEntry
 {
     string permutationFileWithoutExt;
     string combinedDefines;
+    uint64_t cacheKey = 0;
+};
+
+struct FileRecord
+{
+    int64_t time = 0;
+    uintmax_t size = 0;
+    uint64_t hash = 0;
+    vector<string> includes; // names found by the "#include" scan
+    bool isChecked = false; // validated against the file system during this run
 };
 
 Options g_Options;
-map<fs::path, fs::file_time_type> g_HierarchicalUpdateTimes;
+map<fs::path, FileRecord> g_FileRecords;
+map<fs::path, uint64_t> g_HierarchicalHashes;
+map<string, uint64_t> g_OutputKeys;
+map<string, uint64_t> g_BlobKeys;
+map<string, string> g_PdbFiles; // PDB written with the output, the name is chosen by the compiler
+mutex g_OutputKeysMutex; // guards "g_OutputKeys" and "g_PdbFiles"
+uint64_t g_OptionsHash;
+fs::path g_CacheDir;
 map<string, vector<BlobEntry>> g_ShaderBlobs;
 vector<TaskData> g_TaskData;
 mutex g_TaskMutex;
@@ -220,6 +244,14 @@ Naming convention:
 inline uint32_t HashToUint(size_t hash)
 { return uint32_t(hash) ^ (uint32_t(hash >> 32)); }
 
+// "ShaderMake::HashBytes" is FNV-1a, stable between runs and platforms (unlike "std::hash")
+inline uint64_t HashString(uint64_t hash, const string& s)
+{ return ShaderMake::HashBytes(hash, s.c_str(), s.size() + 1); } // '\0' separates consecutive strings
+
+template<typename T>
+inline uint64_t HashValue(uint64_t hash, const T& value)
+{ return ShaderMake::HashBytes(hash, &value, sizeof(value)); }
+
 inline string PathToString(fs::path path)
 { return path.lexically_normal().make_preferred().string(); }
 
@@ -470,11 +502,459 @@ void DumpShader(const TaskData& taskData, const uint8_t* data, size_t dataSize)
     }
 }
 
+//=====================================================================================================================
+// BUILD CACHE
+//=====================================================================================================================
+
+/*
+Every permutation gets a key hashed from:
+    - the contents of the source file and of all files it includes (found by the "#include" scan)
+    - the source path relative to the config file, entry point, profile, defines and optimization level
+    - the compiler and ShaderMake executables and the options affecting the output
+Outputs are rebuilt only if the key recorded for them in "ShaderMake.<platform>.cache" (in the output directory) differs,
+so timestamps changed by a branch switch don't cause a rebuild. The same file also keeps size, time, hash and includes of
+every scanned file, so unchanged files are neither read nor scanned again. With "--PDB" it also keeps the name of the PDB
+written with every output, so a deleted PDB is rebuilt too.
+With "--cacheDir" compiled outputs are also stored as "<cacheDir>/<platform>/<key><ext>" and reused by any build tree.
+Outputs of blob permutations are needed to rebuild a blob when one of its permutations changes. Without "--binary" they are
+deleted after the blob is created only if they can be restored from "--cacheDir", otherwise they stay in the output directory.
+*/
+
+fs::path GetBuildCacheFile()
+{ return fs::path(g_Options.outputDir) / (string("ShaderMake.") + g_Options.platformName + ".cache"); }
+
+string GetBuildCacheSignature()
+{ return "ShaderMake build cache " + to_string(BUILD_CACHE_VERSION); }
+
+// Returns the record of the file, re-reading it only if its size or time has changed
+const FileRecord* GetFileRecord(const fs::path& file, bool scanIncludes)
+{
+    static const basic_regex<char> includePattern("\\s*#include\\s+[\"<]([^>\"]+)[>\"].*");
+
+    auto found = g_FileRecords.find(file);
+    if (found != g_FileRecords.end() && found->second.isChecked)
+        return &found->second;
+
+    error_code ec;
+    int64_t time = fs::last_write_time(file, ec).time_since_epoch().count();
+    if (ec)
+        return nullptr;
+
+    uintmax_t size = fs::file_size(file, ec);
+    if (ec)
+        return nullptr;
+
+    FileRecord& record = g_FileRecords[file];
+    record.isChecked = true;
+    if (record.time == time && record.size == size)
+        return &record;
+
+    ifstream stream(file, ios::binary);
+    if (!stream.is_open())
+    {
+        g_FileRecords.erase(file);
+        return nullptr;
+    }
+
+    string content((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+
+    record.time = time;
+    record.size = size;
+    record.hash = ShaderMake::HashBytes(ShaderMake::FnvOffsetBasis, content.data(), content.size());
+    record.includes.clear();
+
+    if (scanIncludes)
+    {
+        istringstream lines(content);
+        for (string line; getline(lines, line);)
+        {
+            match_results<const char*> matchResult;
+            regex_match(line.c_str(), matchResult, includePattern);
+            if (!matchResult.empty())
+                record.includes.push_back(matchResult[1]);
+        }
+    }
+
+    return &record;
+}
+
+void LoadBuildCache()
+{
+    ifstream stream(GetBuildCacheFile());
+    if (!stream.is_open())
+        return;
+
+    string line;
+    if (!getline(stream, line) || line != GetBuildCacheSignature())
+        return;
+
+    FileRecord* record = nullptr;
+    string output;
+    while (getline(stream, line))
+    {
+        if (line.size() < 2)
+            continue;
+
+        istringstream ss(line.substr(2));
+        string name;
+        if (line[0] == 'F')
+        {
+            FileRecord fileRecord;
+            ss >> fileRecord.time >> fileRecord.size >> hex >> fileRecord.hash;
+            getline(ss >> ws, name);
+
+            record = &(g_FileRecords[name] = fileRecord);
+        }
+        else if (line[0] == 'I' && record)
+            record->includes.push_back(line.substr(2));
+        else if (line[0] == 'O' || line[0] == 'B')
+        {
+            uint64_t key = 0;
+            ss >> hex >> key;
+            getline(ss >> ws, name);
+
+            (line[0] == 'O' ? g_OutputKeys : g_BlobKeys)[name] = key;
+            output = line[0] == 'O' ? name : string();
+        }
+        else if (line[0] == 'P' && !output.empty())
+            g_PdbFiles[output] = line.substr(2);
+    }
+}
+
+void SaveBuildCache()
+{
+    ofstream stream(GetBuildCacheFile(), ios::trunc);
+    if (!stream.is_open())
+    {
+        Printf(YELLOW "WARNING: Can't write the build cache file '%s'!\n", PathToString(GetBuildCacheFile()).c_str());
+        return;
+    }
+
+    stream << GetBuildCacheSignature() << "\n";
+
+    // Records of files not visited during this run are dropped
+    for (const auto& [file, record] : g_FileRecords)
+    {
+        if (!record.isChecked)
+            continue;
+
+        stream << "F " << dec << record.time << " " << record.size << " " << hex << record.hash << " " << file.string() << "\n";
+        for (const string& include : record.includes)
+            stream << "I " << include << "\n";
+    }
+
+    for (const auto& [name, key] : g_OutputKeys)
+    {
+        stream << "O " << hex << key << " " << name << "\n";
+
+        auto pdb = g_PdbFiles.find(name);
+        if (pdb != g_PdbFiles.end())
+            stream << "P " << pdb->second << "\n";
+    }
+
+    for (const auto& [name, key] : g_BlobKeys)
+        stream << "B " << hex << key << " " << name << "\n";
+}
+
+// Hashes everything that affects the output besides the config line
+bool InitBuildCache(const char* self)
+{
+    LoadBuildCache();
+
+    const FileRecord* compiler = GetFileRecord(g_Options.compiler, false);
+    const FileRecord* tool = GetFileRecord(self, false);
+    if (!compiler || !tool)
+    {
+        Printf(RED "ERROR: Can't read '%s' or '%s'!\n", g_Options.compiler, self);
+        return false;
+    }
+
+    uint64_t hash = HashValue(ShaderMake::FnvOffsetBasis, BUILD_CACHE_VERSION);
+    hash = HashValue(hash, compiler->hash);
+    hash = HashValue(hash, tool->hash);
+    hash = HashValue(hash, g_Options.platform);
+    hash = HashString(hash, g_Options.shaderModel);
+    hash = HashString(hash, g_Options.vulkanVersion);
+    hash = HashString(hash, g_Options.vulkanMemoryLayout ? g_Options.vulkanMemoryLayout : "");
+    hash = HashValue(hash, g_Options.sRegShift);
+    hash = HashValue(hash, g_Options.tRegShift);
+    hash = HashValue(hash, g_Options.bRegShift);
+    hash = HashValue(hash, g_Options.uRegShift);
+
+    const bool flags[] = {
+        g_Options.warningsAreErrors,
+        g_Options.allResourcesBound,
+        g_Options.pdb,
+        g_Options.embedPdb,
+        g_Options.stripReflection,
+        g_Options.matrixRowMajor,
+        g_Options.hlsl2021,
+        g_Options.useAPI,
+        g_Options.slang,
+        g_Options.slangHlsl,
+        g_Options.noRegShifts,
+    };
+    hash = ShaderMake::HashBytes(hash, flags, sizeof(flags));
+
+    for (const string& define : g_Options.defines)
+        hash = HashString(hash, define);
+    for (const string& ext : g_Options.spirvExtensions)
+        hash = HashString(hash, ext);
+    for (const string& options : g_Options.compilerOptions)
+        hash = HashString(hash, options);
+
+    g_OptionsHash = hash;
+
+    // PDBs and embedded debug info refer to absolute paths of the build tree
+    if (g_Options.cacheDir && !g_Options.pdb && !g_Options.embedPdb)
+    {
+        g_CacheDir = fs::path(g_Options.cacheDir) / g_Options.platformName;
+
+        error_code ec;
+        fs::create_directories(g_CacheDir, ec);
+        if (ec)
+        {
+            Printf(YELLOW "WARNING: Can't create cache directory '%s', the cache is disabled!\n", PathToString(g_CacheDir).c_str());
+            g_CacheDir.clear();
+        }
+    }
+
+    return true;
+}
+
+// Files written by "DumpShader" or by the compiler for the task
+void GetTaskOutputFiles(const TaskData& taskData, vector<string>& files)
+{
+    string file = taskData.outputFileWithoutExt + g_OutputExt;
+
+    if (g_Options.binary || g_Options.binaryBlob || (g_Options.headerBlob && !taskData.combinedDefines.empty()))
+        files.push_back(file);
+
+    if (g_Options.header || (g_Options.headerBlob && taskData.combinedDefines.empty()))
+        files.push_back(file + ".h");
+}
+
+// PDBs are written for DXBC and DXIL only, their names are chosen by the compiler
+bool HasPdbOutput()
+{ return g_Options.pdb && !g_Options.slang && g_Options.platform != SPIRV; }
+
+// Called from worker threads after the PDB of the task is written
+void StorePdbFile(const TaskData& taskData, const string& file)
+{
+    lock_guard<mutex> guard(g_OutputKeysMutex);
+    g_PdbFiles[taskData.outputFileWithoutExt] = file;
+}
+
+// Reads the PDB name from the debug name part ("ILDN") of a DXBC/DXIL container
+bool GetPdbName(const uint8_t* data, size_t size, string& name)
+{
+    const size_t headerSize = 32; // "DXBC", digest, version, container size, part count
+    if (size < headerSize || memcmp(data, "DXBC", 4) != 0)
+        return false;
+
+    uint32_t partCount;
+    memcpy(&partCount, data + 28, sizeof(partCount));
+
+    for (size_t i = 0; i < partCount && headerSize + (i + 1) * sizeof(uint32_t) <= size; i++)
+    {
+        uint32_t partOffset;
+        memcpy(&partOffset, data + headerSize + i * sizeof(uint32_t), sizeof(partOffset));
+
+        // Part: fourcc, part size, then "ShaderDebugName" { flags, name length } followed by the name
+        const size_t nameOffset = size_t(partOffset) + 12;
+        if (nameOffset > size || memcmp(data + partOffset, "ILDN", 4) != 0)
+            continue;
+
+        uint16_t nameLength;
+        memcpy(&nameLength, data + partOffset + 10, sizeof(nameLength));
+        if (nameLength == 0 || nameOffset + nameLength > size)
+            return false;
+
+        name.assign((const char*)data + nameOffset, nameLength);
+
+        return true;
+    }
+
+    return false;
+}
+
+fs::path GetCachedFile(const TaskData& taskData, const string& file)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)taskData.cacheKey);
+
+    return g_CacheDir / (key + file.substr(taskData.outputFileWithoutExt.size()));
+}
+
+uint64_t GetBlobKey(const vector<BlobEntry>& entries)
+{
+    uint64_t hash = ShaderMake::FnvOffsetBasis;
+    for (const BlobEntry& entry : entries)
+        hash = HashValue(hash, entry.cacheKey);
+
+    return hash;
+}
+
+bool IsTaskUpToDate(const TaskData& taskData)
+{
+    auto found = g_OutputKeys.find(taskData.outputFileWithoutExt);
+    if (found == g_OutputKeys.end() || found->second != taskData.cacheKey)
+        return false;
+
+    vector<string> files;
+    GetTaskOutputFiles(taskData, files);
+    for (const string& file : files)
+    {
+        if (!fs::exists(file))
+            return false;
+    }
+
+    if (HasPdbOutput())
+    {
+        auto pdb = g_PdbFiles.find(taskData.outputFileWithoutExt);
+        if (pdb == g_PdbFiles.end() || !fs::exists(pdb->second))
+            return false;
+    }
+
+    return true;
+}
+
+bool IsBlobUpToDate(const string& blobName, uint64_t blobKey)
+{
+    auto found = g_BlobKeys.find(blobName);
+    if (found == g_BlobKeys.end() || found->second != blobKey)
+        return false;
+
+    string file = blobName + g_OutputExt;
+    if (g_Options.binaryBlob && !fs::exists(file))
+        return false;
+    if (g_Options.headerBlob && !fs::exists(file + ".h"))
+        return false;
+
+    return true;
+}
+
+bool RestoreTaskFromCache(const TaskData& taskData)
+{
+    if (g_CacheDir.empty())
+        return false;
+
+    vector<string> files;
+    GetTaskOutputFiles(taskData, files);
+    for (const string& file : files)
+    {
+        if (!fs::exists(GetCachedFile(taskData, file)))
+            return false;
+    }
+
+    for (const string& file : files)
+    {
+        error_code ec;
+        fs::copy_file(GetCachedFile(taskData, file), file, fs::copy_options::overwrite_existing, ec);
+        if (ec)
+            return false;
+    }
+
+    g_OutputKeys[taskData.outputFileWithoutExt] = taskData.cacheKey;
+
+    return true;
+}
+
+// Called from worker threads after a successful compilation
+void StoreTaskInCache(const TaskData& taskData)
+{
+    {
+        lock_guard<mutex> guard(g_OutputKeysMutex);
+        g_OutputKeys[taskData.outputFileWithoutExt] = taskData.cacheKey;
+    }
+
+    if (g_CacheDir.empty())
+        return;
+
+    vector<string> files;
+    GetTaskOutputFiles(taskData, files);
+    for (const string& file : files)
+    {
+        // Copy under a name unique to the process and thread and rename, so other build trees never see a partially written file
+        fs::path cachedFile = GetCachedFile(taskData, file);
+        fs::path tempFile = cachedFile;
+        tempFile += "." + to_string(getpid()) + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+
+        error_code ec;
+        fs::copy_file(file, tempFile, fs::copy_options::overwrite_existing, ec);
+        if (!ec)
+            fs::rename(tempFile, cachedFile, ec);
+        if (ec)
+            fs::remove(tempFile, ec);
+    }
+}
+
+// True if outputs of all permutations were built, restored or found up to date during this run
+bool AreBlobEntriesReady(const vector<BlobEntry>& entries)
+{
+    for (const BlobEntry& entry : entries)
+    {
+        auto found = g_OutputKeys.find(entry.permutationFileWithoutExt);
+        if (found == g_OutputKeys.end() || found->second != entry.cacheKey)
+            return false;
+    }
+
+    return true;
+}
+
+// Drops tasks with up-to-date outputs and restores outputs of the remaining tasks from the cache directory.
+// Blobs with up-to-date outputs are dropped too, the others need outputs of all their permutations.
+// Keys of outputs to be rebuilt are forgotten, so a failed build is never taken for an up-to-date one.
+uint32_t FilterTasks()
+{
+    for (auto it = g_ShaderBlobs.begin(); it != g_ShaderBlobs.end();)
+    {
+        if (!g_Options.force && IsBlobUpToDate(it->first, GetBlobKey(it->second)))
+            it = g_ShaderBlobs.erase(it);
+        else
+        {
+            g_BlobKeys.erase(it->first);
+            ++it;
+        }
+    }
+
+    uint32_t restoredTaskCount = 0;
+    auto isDone = [&](const TaskData& taskData)
+    {
+        bool isBlobPending = !taskData.blobName.empty() && g_ShaderBlobs.find(taskData.blobName) != g_ShaderBlobs.end();
+        if (!isBlobPending && !g_Options.binary && !g_Options.header)
+            return true;
+
+        if (!g_Options.force)
+        {
+            if (IsTaskUpToDate(taskData))
+                return true;
+
+            if (RestoreTaskFromCache(taskData))
+            {
+                restoredTaskCount++;
+                return true;
+            }
+        }
+
+        g_OutputKeys.erase(taskData.outputFileWithoutExt);
+        g_PdbFiles.erase(taskData.outputFileWithoutExt);
+
+        return false;
+    };
+
+    g_TaskData.erase(remove_if(g_TaskData.begin(), g_TaskData.end(), isDone), g_TaskData.end());
+
+    return restoredTaskCount;
+}
+
 void UpdateProgress(const TaskData& taskData, bool isSucceeded, bool willRetry, const char* message)
 {
     // IMPORTANT: do not split into several "Printf" calls because multi-threading access to the console can mess up the order
     if (isSucceeded)
     {
+        StoreTaskInCache(taskData);
+
         float progress = 100.0f * float(++g_ProcessedTaskCount) / float(g_OriginalTaskCount);
 
         if (message)
@@ -618,6 +1098,7 @@ bool Options::Parse(int32_t argc, const char** argv)
             OPT_STRING('D', "define", &unused, "Macro definition(s) in forms 'M=value' or 'M'", AddGlobalDefine, (intptr_t)this, 0),
         OPT_GROUP("Other options:"),
             OPT_BOOLEAN('f', "force", &force, "Treat all source files as modified", nullptr, 0, 0),
+            OPT_STRING(0, "cacheDir", &cacheDir, "Directory with compiled outputs shared between build trees (not used with PDBs)", nullptr, 0, 0),
             OPT_STRING(0, "sourceDir", &sourceDir, "Source code directory", nullptr, 0, 0),
             OPT_STRING(0, "relaxedInclude", &unused, "Include file(s) not invoking re-compilation", AddRelaxedInclude, (intptr_t)this, 0),
             OPT_STRING(0, "outputExt", &outputExt, "Extension for output files, default is one of .dxbc, .dxil, .spirv", nullptr, 0, 0),
@@ -1063,6 +1544,8 @@ void FxcCompile()
             {
                 fwrite(pdb->GetBufferPointer(), pdb->GetBufferSize(), 1, fp);
                 fclose(fp);
+
+                StorePdbFile(taskData, file);
             }
         }
 
@@ -1332,6 +1815,8 @@ void DxcCompile()
                     {
                         fwrite(pdb->GetBufferPointer(), pdb->GetBufferSize(), 1, fp);
                         fclose(fp);
+
+                        StorePdbFile(taskData, fs::path(file).string());
                     }
                 }
             }
@@ -1410,6 +1895,8 @@ void ExeCompile()
         }
 
         bool convertBinaryOutputToHeader = false;
+        bool readPdbName = false;
+        bool removeBinaryOutput = false;
         string outputFile = taskData.outputFileWithoutExt + g_OutputExt;
 
         // Building command line
@@ -1510,9 +1997,15 @@ void ExeCompile()
             {
                 cmd << " -nologo";
 
-                // Output file
+                // Output file (also needed to read the name of the PDB)
+                readPdbName = HasPdbOutput();
                 if (g_Options.binary || g_Options.binaryBlob || (g_Options.headerBlob && !taskData.combinedDefines.empty()))
                     cmd << " -Fo " << EscapePath(outputFile);
+                else if (readPdbName)
+                {
+                    cmd << " -Fo " << EscapePath(outputFile);
+                    removeBinaryOutput = true;
+                }
                 if (g_Options.header || (g_Options.headerBlob && taskData.combinedDefines.empty()))
                 {
                     string name = GetShaderName(taskData.outputFileWithoutExt);
@@ -1682,6 +2175,18 @@ void ExeCompile()
                 isSucceeded = false;
         }
 
+        // The compiler names the PDB after the shader hash, the name is stored in the binary
+        if (isSucceeded && readPdbName)
+        {
+            vector<uint8_t> buffer;
+            string pdbName;
+            if (ReadBinaryFile(outputFile.c_str(), buffer) && GetPdbName(buffer.data(), buffer.size(), pdbName))
+                StorePdbFile(taskData, fs::path(taskData.outputFileWithoutExt).parent_path().string() + "/" + PDB_DIR + "/" + pdbName);
+        }
+
+        if (removeBinaryOutput)
+            fs::remove(outputFile);
+
         // Update progress
         UpdateProgress(taskData, isSucceeded, willRetry, msg.str().c_str());
     }
@@ -1691,20 +2196,23 @@ void ExeCompile()
 // MAIN
 //=====================================================================================================================
 
-bool GetHierarchicalUpdateTime(const fs::path& file, list<fs::path>& callStack, fs::file_time_type& outTime)
+// "outCycleDepth" receives the smallest call stack depth (0 = the root) of an include skipped as a cycle in this subtree,
+// or SIZE_MAX if there is none. A hash that skipped one of its ancestors misses the content of that ancestor and of
+// everything it includes, so it is only valid for this call stack and must not be memoized.
+bool GetHierarchicalHash(const fs::path& file, list<fs::path>& callStack, uint64_t& outHash, size_t& outCycleDepth)
 {
-    static const basic_regex<char> includePattern("\\s*#include\\s+[\"<]([^>\"]+)[>\"].*");
+    outCycleDepth = SIZE_MAX;
 
-    auto found = g_HierarchicalUpdateTimes.find(file);
-    if (found != g_HierarchicalUpdateTimes.end())
+    auto found = g_HierarchicalHashes.find(file);
+    if (found != g_HierarchicalHashes.end())
     {
-        outTime = found->second;
+        outHash = found->second;
 
         return true;
     }
 
-    ifstream stream(file);
-    if (!stream.is_open())
+    const FileRecord* record = GetFileRecord(file, true);
+    if (!record)
     {
         Printf(RED "ERROR: Can't open file '%s', included in:\n", PathToString(file).c_str());
         for (const fs::path& otherFile : callStack)
@@ -1715,17 +2223,14 @@ bool GetHierarchicalUpdateTime(const fs::path& file, list<fs::path>& callStack,
 
     callStack.push_front(file);
 
+    size_t depth = callStack.size() - 1;
+    size_t cycleDepth = SIZE_MAX;
     fs::path path = file.parent_path();
-    fs::file_time_type hierarchicalUpdateTime = fs::last_write_time(file);
+    uint64_t hierarchicalHash = record->hash;
 
-    for (string line; getline(stream, line);)
+    for (const string& include : record->includes)
     {
-        match_results<const char*> matchResult;
-        regex_match(line.c_str(), matchResult, includePattern);
-        if (matchResult.empty())
-            continue;
-
-        fs::path includeName = string(matchResult[1]);
+        fs::path includeName = include;
         if (find(g_Options.relaxedIncludes.begin(), g_Options.relaxedIncludes.end(), includeName) != g_Options.relaxedIncludes.end())
             continue;
 
@@ -1755,22 +2260,49 @@ bool GetHierarchicalUpdateTime(const fs::path& file, list<fs::path>& callStack,
             return false;
         }
 
-        fs::file_time_type dependencyTime;
-        if (!GetHierarchicalUpdateTime(includeFile, callStack, dependencyTime))
+        // Already being hashed up the call stack (guarded by "#pragma once" or an include guard)
+        includeFile = includeFile.lexically_normal();
+        auto cycle = find(callStack.begin(), callStack.end(), includeFile);
+        if (cycle != callStack.end())
+        {
+            cycleDepth = min(cycleDepth, size_t(distance(cycle, callStack.end())) - 1);
+            continue;
+        }
+
+        uint64_t dependencyHash;
+        size_t dependencyCycleDepth;
+        if (!GetHierarchicalHash(includeFile, callStack, dependencyHash, dependencyCycleDepth))
             return false;
 
-        hierarchicalUpdateTime = max(dependencyTime, hierarchicalUpdateTime);
+        cycleDepth = min(cycleDepth, dependencyCycleDepth);
+
+        hierarchicalHash = HashString(hierarchicalHash, include);
+        hierarchicalHash = HashValue(hierarchicalHash, dependencyHash);
     }
 
     callStack.pop_front();
 
-    g_HierarchicalUpdateTimes[file] = hierarchicalUpdateTime;
-    outTime = hierarchicalUpdateTime;
+    // Cycles back to this file are complete here: every file of the cycle has been hashed below it
+    if (cycleDepth >= depth)
+    {
+        g_HierarchicalHashes[file] = hierarchicalHash;
+        cycleDepth = SIZE_MAX;
+    }
+
+    outHash = hierarchicalHash;
+    outCycleDepth = cycleDepth;
 
     return true;
 }
 
-bool ProcessConfigLine(uint32_t lineIndex, const string& line, const fs::file_time_type& configTime)
+bool GetHierarchicalHash(const fs::path& file, list<fs::path>& callStack, uint64_t& outHash)
+{
+    size_t cycleDepth;
+
+    return GetHierarchicalHash(file, callStack, outHash, cycleDepth);
+}
+
+bool ProcessConfigLine(uint32_t lineIndex, const string& line)
 {
     // Tokenize
     string lineCopy = line;
@@ -1828,98 +2360,33 @@ bool ProcessConfigLine(uint32_t lineIndex, const string& line, const fs::file_ti
         outputDir /= configLine.outputDir;
 
     // Create intermediate output directories
-    bool force = g_Options.force;
     fs::path endPath = outputDir / shaderName.parent_path();
     if (g_Options.pdb)
         endPath /= PDB_DIR;
     if (endPath.string() != "" && !fs::exists(endPath))
-    {
         fs::create_directories(endPath);
-        force = true;
-    }
-
-    // Early out if no changes detected
-    fs::file_time_type zero; // constructor sets to 0
-    fs::file_time_type outputTime = zero;
-
-    {
-        fs::path outputFile = outputDir / permutationName;
-
-        outputFile += g_OutputExt;
-        if (g_Options.binary)
-        {
-            force |= !fs::exists(outputFile);
-            if (!force)
-            {
-                if (outputTime == zero)
-                    outputTime = fs::last_write_time(outputFile);
-                else
-                    outputTime = min(outputTime, fs::last_write_time(outputFile));
-            }
-        }
-
-        outputFile += ".h";
-        if (g_Options.header)
-        {
-            force |= !fs::exists(outputFile);
-            if (!force)
-            {
-                if (outputTime == zero)
-                    outputTime = fs::last_write_time(outputFile);
-                else
-                    outputTime = min(outputTime, fs::last_write_time(outputFile));
-            }
-        }
-    }
-
-    {
-        fs::path outputFile = outputDir / shaderName;
-
-        outputFile += g_OutputExt;
-        if (g_Options.binaryBlob)
-        {
-            force |= !fs::exists(outputFile);
-            if (!force)
-            {
-                if (outputTime == zero)
-                    outputTime = fs::last_write_time(outputFile);
-                else
-                    outputTime = min(outputTime, fs::last_write_time(outputFile));
-            }
-        }
-
-        outputFile += ".h";
-        if (g_Options.headerBlob)
-        {
-            force |= !fs::exists(outputFile);
-            if (!force)
-            {
-                if (outputTime == zero)
-                    outputTime = fs::last_write_time(outputFile);
-                else
-                    outputTime = min(outputTime, fs::last_write_time(outputFile));
-            }
-        }
-    }
 
-    if (!force)
-    {
-        list<fs::path> callStack;
-        fs::file_time_type sourceTime;
-        fs::path sourceFile = g_Options.configFile.parent_path() / g_Options.sourceDir / configLine.source;
-        if (!GetHierarchicalUpdateTime(sourceFile, callStack, sourceTime))
-            return false;
-
-        sourceTime = max(sourceTime, configTime);
-        if (outputTime > sourceTime)
-            return true;
-    }
+    // Hash the source and its includes
+    list<fs::path> callStack;
+    uint64_t sourceHash;
+    fs::path sourceFile = g_Options.configFile.parent_path() / g_Options.sourceDir / configLine.source;
+    if (!GetHierarchicalHash(sourceFile, callStack, sourceHash))
+        return false;
 
     // Prepare a task
     string outputFileWithoutExt = PathToString(outputDir / permutationName);
     uint32_t optimizationLevel = configLine.optimizationLevel == USE_GLOBAL_OPTIMIZATION_LEVEL ? g_Options.optimizationLevel : configLine.optimizationLevel;
     optimizationLevel = min(optimizationLevel, 3u);
 
+    // Up-to-date outputs are dropped later by "FilterTasks", when all blob permutations are known
+    uint64_t cacheKey = HashString(g_OptionsHash, configLine.source);
+    cacheKey = HashValue(cacheKey, sourceHash);
+    cacheKey = HashString(cacheKey, configLine.entryPoint);
+    cacheKey = HashString(cacheKey, configLine.profile);
+    cacheKey = HashString(cacheKey, combinedDefines);
+    cacheKey = HashValue(cacheKey, optimizationLevel);
+    cacheKey = HashString(cacheKey, GetShaderName(outputFileWithoutExt)); // the name of the array in headers
+
     TaskData& taskData = g_TaskData.emplace_back();
     taskData.source = configLine.source;
     taskData.entryPoint = configLine.entryPoint;
@@ -1928,6 +2395,7 @@ bool ProcessConfigLine(uint32_t lineIndex, const string& line, const fs::file_ti
     taskData.outputFileWithoutExt = outputFileWithoutExt;
     taskData.defines = configLine.defines;
     taskData.optimizationLevel = optimizationLevel;
+    taskData.cacheKey = cacheKey;
 
     // Gather blobs
     if (g_Options.IsBlob())
@@ -1938,17 +2406,20 @@ bool ProcessConfigLine(uint32_t lineIndex, const string& line, const fs::file_ti
         BlobEntry entry;
         entry.permutationFileWithoutExt = outputFileWithoutExt;
         entry.combinedDefines = combinedDefines;
+        entry.cacheKey = cacheKey;
         entries.push_back(entry);
+
+        taskData.blobName = blobName;
     }
 
     return true;
 }
 
-bool ExpandPermutations(uint32_t lineIndex, const string& line, const fs::file_time_type& configTime)
+bool ExpandPermutations(uint32_t lineIndex, const string& line)
 {
     size_t opening = line.find('{');
     if (opening == string::npos)
-        return ProcessConfigLine(lineIndex, line, configTime);
+        return ProcessConfigLine(lineIndex, line);
 
     size_t closing = line.find('}', opening);
     if (closing == string::npos)
@@ -1966,7 +2437,7 @@ bool ExpandPermutations(uint32_t lineIndex, const string& line, const fs::file_t
             comma = closing;
 
         string newConfig = line.substr(0, opening) + line.substr(current, comma - current) + line.substr(closing + 1);
-        if (!ExpandPermutations(lineIndex, newConfig, configTime))
+        if (!ExpandPermutations(lineIndex, newConfig))
             return false;
 
         current = comma + 1;
@@ -2012,6 +2483,7 @@ bool CreateBlob(const string& blobName, const vector<BlobEntry>& entries, bool u
     }
 
     bool success = true;
+    ShaderMake::ShaderBlobIndex index;
 
     // Collect individual permutations
     for (const BlobEntry& entry : entries)
@@ -2022,7 +2494,7 @@ bool CreateBlob(const string& blobName, const vector<BlobEntry>& entries, bool u
         vector<uint8_t> fileData;
         if (ReadBinaryFile(file.c_str(), fileData))
         {
-            if (!ShaderMake::WritePermutation(writeFileCallback, &outputContext, entry.combinedDefines, fileData.data(), fileData.size()))
+            if (!ShaderMake::WritePermutation(writeFileCallback, &outputContext, entry.combinedDefines, fileData.data(), fileData.size(), &index))
             {
                 Printf(RED "ERROR: Failed to write a shader permutation into '%s'!\n", outputFile.c_str());
                 success = false;
@@ -2035,6 +2507,13 @@ bool CreateBlob(const string& blobName, const vector<BlobEntry>& entries, bool u
             break;
     }
 
+    // Write the permutation hash index
+    if (success && !ShaderMake::WritePermutationIndex(writeFileCallback, &outputContext, index))
+    {
+        Printf(RED "ERROR: Failed to write the permutation index into '%s' (write error or permutation hash collision)!\n", outputFile.c_str());
+        success = false;
+    }
+
     if (useTextOutput)
         outputContext.WriteTextEpilog();
 
@@ -2123,10 +2602,11 @@ int32_t main(int32_t argc, const char** argv)
     }
 #endif
 
-    { // Gather shader permutations
-        fs::file_time_type configTime = fs::last_write_time(g_Options.configFile);
-        configTime = max(configTime, fs::last_write_time(self));
+    // Load the build cache
+    if (!InitBuildCache(self))
+        return 1;
 
+    { // Gather shader permutations
         ifstream configStream(g_Options.configFile);
 
         string line;
@@ -2175,41 +2655,49 @@ int32_t main(int32_t argc, const char** argv)
             }
             else if (blocks.back())
             {
-                if (!ExpandPermutations(lineIndex, line, configTime))
+                if (!ExpandPermutations(lineIndex, line))
                     return 1;
             }
         }
     }
 
+    // Skip unchanged permutations
+    uint32_t restoredTaskCount = FilterTasks();
+
     // Process tasks
-    if (!g_TaskData.empty())
+    if (!g_TaskData.empty() || !g_ShaderBlobs.empty())
     {
-        Printf(WHITE "Using compiler: %s\n", g_Options.compiler);
-
         g_OriginalTaskCount = (uint32_t)g_TaskData.size();
         g_ProcessedTaskCount = 0;
         g_FailedTaskCount = 0;
 
-        // Retry limit for compilation task sub-process failures that can occur when threading
-        g_TaskRetryCount = g_Options.retryCount;
+        if (!g_TaskData.empty())
+        {
+            Printf(WHITE "Using compiler: %s\n", g_Options.compiler);
 
-        uint32_t threadsNum = max(g_Options.serial ? 1 : thread::hardware_concurrency(), 1u);
+            // Retry limit for compilation task sub-process failures that can occur when threading
+            g_TaskRetryCount = g_Options.retryCount;
 
-        vector<thread> threads(threadsNum);
-        for (uint32_t i = 0; i < threadsNum; i++)
-        {
-            if (!g_Options.useAPI)
-                threads[i] = thread(ExeCompile);
+            uint32_t threadsNum = max(g_Options.serial ? 1 : thread::hardware_concurrency(), 1u);
+
+            vector<thread> threads(threadsNum);
+            for (uint32_t i = 0; i < threadsNum; i++)
+            {
+                if (!g_Options.useAPI)
+                    threads[i] = thread(ExeCompile);
 #ifdef WIN32
-            else if (g_Options.platform == DXBC)
-                threads[i] = thread(FxcCompile);
-            else
-                threads[i] = thread(DxcCompile);
+                else if (g_Options.platform == DXBC)
+                    threads[i] = thread(FxcCompile);
+                else
+                    threads[i] = thread(DxcCompile);
 #endif
+            }
+
+            for (uint32_t i = 0; i < threadsNum; i++)
+                threads[i].join();
         }
 
-        for (uint32_t i = 0; i < threadsNum; i++)
-            threads[i].join();
+        SaveBuildCache();
 
         // If a fatal error or a termination request happened, don't proceed to the blob building.
         if (g_Terminate)
@@ -2221,7 +2709,12 @@ int32_t main(int32_t argc, const char** argv)
             // If a blob would contain one entry with no defines, just skip it:
             // the individual file's output name is the same as the blob, and we're done here.
             if (blobEntries.size() == 1 && blobEntries[0].combinedDefines.empty())
+            {
+                if (AreBlobEntriesReady(blobEntries))
+                    g_BlobKeys[blobName] = GetBlobKey(blobEntries);
+
                 continue;
+            }
 
             // Validate that the blob doesn't contain any shaders with empty defines.
             // In such case, that individual shader's output file is the same as the blob output file, which wouldn't work.
@@ -2247,11 +2740,14 @@ int32_t main(int32_t argc, const char** argv)
                 return 1;
             }
 
+            bool isBlobCreated = true;
             if (g_Options.binaryBlob)
             {
                 bool result = CreateBlob(blobName, blobEntries, false);
                 if (!result && !g_Options.continueOnError)
                     return 1;
+
+                isBlobCreated &= result;
             }
 
             if (g_Options.headerBlob)
@@ -2259,23 +2755,41 @@ int32_t main(int32_t argc, const char** argv)
                 bool result = CreateBlob(blobName, blobEntries, true);
                 if (!result && !g_Options.continueOnError)
                     return 1;
+
+                isBlobCreated &= result;
             }
 
-            if (!g_Options.binary)
+            if (isBlobCreated && AreBlobEntriesReady(blobEntries))
+                g_BlobKeys[blobName] = GetBlobKey(blobEntries);
+
+            // Without the cache directory the next build needs them to rebuild the blob if only some permutations change
+            if (!g_Options.binary && !g_CacheDir.empty())
                 RemoveIntermediateBlobFiles(blobEntries);
         }
 
+        SaveBuildCache();
+
         // Report failed tasks
+        if (restoredTaskCount)
+            Printf(WHITE "%u task(s) restored from the cache.\n", restoredTaskCount);
+
         if (g_FailedTaskCount)
             Printf(YELLOW "WARNING: %u task(s) failed to complete!\n", g_FailedTaskCount.load());
-        else
+        else if (g_OriginalTaskCount)
             Printf(WHITE "%d task(s) completed successfully.\n", g_OriginalTaskCount);
 
         uint64_t end = Timer_GetTicks();
         Printf(WHITE "Elapsed time %.2f ms\n", Timer_ConvertTicksToMilliseconds(end - start));
     }
     else
+    {
+        SaveBuildCache();
+
+        if (restoredTaskCount)
+            Printf(WHITE "%u task(s) restored from the cache.\n", restoredTaskCount);
+
         Printf(WHITE "All %s shaders are up to date.\n", g_Options.platformName);
+    }
 
     return (g_Terminate || g_FailedTaskCount) ? 1 : 0;
 }
@@ -2086,8 +2086,10 @@ void MyApp::UpdateSkinnedCB()
 {
 	auto currSkinnedCB = mCurrFrameResource->SkinnedCB.get();
 
-	// We only have one skinned model being animated.
-	mSkinnedModelInst->UpdateSkinnedAnimation(mTimer.DeltaTime());
+	// We only have one skinned model being animated.  More models would add
+	// their tasks here, and the job system evaluates them in parallel.
+	SkinnedPoseTask task = mSkinnedModelInst->UpdateSkinnedAnimation(mTimer.DeltaTime());
+	SkinnedData::EvaluatePoses(&task, 1, mSkinnedParallelFor);
 
 	SkinnedConstants skinnedConstants;
 	std::copy(
@@ -11,6 +11,7 @@
 #include "CSAdd.h"
 #include "ShadowMap.h"
 #include "SsaoMap.h"
+#include "../ECSCore/ECSJobSystem.h"
 #include <string>
 #include <array>
 
@@ -63,12 +64,15 @@ private:
 		std::vector<DirectX::XMFLOAT4X4> FinalTransforms;
 		std::string ClipName;
 		float TimePos = 0.0f;
-
-		// Called every frame and increments the time position, interpolates the 
-		// animations for each bone based on the current animation clip, and 
-		// generates the final transforms which are ultimately set to the effect
-		// for processing in the vertex shader.
-		void UpdateSkinnedAnimation(float dt)
+		AnimationLayer Layer;
+		SkinnedPoseState PoseState;
+
+		// Called every frame and increments the time position.  Returns the task
+		// that interpolates the animations for each bone based on the current 
+		// animation clip and generates the final transforms, which are ultimately
+		// set to the effect for processing in the vertex shader.  The tasks of all
+		// models are evaluated together with SkinnedData::EvaluatePoses.
+		SkinnedPoseTask UpdateSkinnedAnimation(float dt)
 		{
 			TimePos += dt;
 
@@ -76,8 +80,16 @@ private:
 			if (TimePos > SkinnedInfo.GetClipEndTime(ClipName))
 				TimePos = 0.0f;
 
-			// Compute the final transforms for this time position.
-			SkinnedInfo.GetFinalTransforms(ClipName, TimePos, FinalTransforms);
+			Layer.Clip = SkinnedInfo.FindClip(ClipName);
+			Layer.TimePos = TimePos;
+
+			SkinnedPoseTask task;
+			task.Skeleton = &SkinnedInfo;
+			task.Layers = &Layer;
+			task.LayerCount = 1;
+			task.State = &PoseState;
+			task.FinalTransforms = &FinalTransforms;
+			return task;
 		}
 	};
 
@@ -301,4 +313,5 @@ private:
 	// Temp
 	std::unique_ptr<SkinnedModelInstance> mSkinnedModelInst;
 	std::vector<M3DLoader::M3dMaterial> mSkinnedMats;
+	SkinnedParallelFor mSkinnedParallelFor = ECS::MakeParallelForFunction();
 };
\ No newline at end of file